@@ -98,6 +98,8 @@ AC_DEFUN([NON_ESSENTIAL_PROGRAMS_TO_BE_COMPILED],
     CISTEM_OPTIONAL_PROGRAM([append_stacks], [ENABLE_APPENDSTACKS], [append_stacks])
     CISTEM_OPTIONAL_PROGRAM([convert_star_to_binary], [ENABLE_CONVERTSTARTOBINARY], [convert_star_to_binary])
     CISTEM_OPTIONAL_PROGRAM([convert_binary_to_star], [ENABLE_CONVERTBINARYTOSTAR], [convert_binary_to_star])
+    CISTEM_OPTIONAL_PROGRAM([database_benchmark], [ENABLE_DATABASEBENCHMARK], [database_benchmark])
+    CISTEM_OPTIONAL_PROGRAM([cistem_bench], [ENABLE_CISTEMBENCH], [cistem_bench])
     CISTEM_OPTIONAL_PROGRAM([convert_eer_to_mrc], [ENABLE_CONVERTEERTOMRC], [convert_eer_to_mrc])
     CISTEM_OPTIONAL_PROGRAM([azimuthal_average], [ENABLE_AZIMUTHALAVERAGE], [azimuthal_average])
     CISTEM_OPTIONAL_PROGRAM([normalize_stack], [ENABLE_NORMALIZESTACK], [normalize_stack])
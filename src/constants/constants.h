@@ -53,6 +53,7 @@ constexpr int   number_of_output_images     = 8; //mip, psi, theta, phi, pixel,
 constexpr int   MAX_ALLOWED_NUMBER_OF_PEAKS = 1000; // An error will be thrown and job aborted if this number of peaks is exceeded in the make template results block
 constexpr float MAX_BINNING_FACTOR          = 10.f; // The maximum binning factor allowed for the template matching search image
 constexpr float MIN_VALUE_TO_MIP            = -0.5f; // The minimum value to be considered for the MIP, saves i/o but must be lower than the lowest likely mip value
+constexpr int   cpu_batch_size              = 4; // Projections correlated together by each thread in the CPU search, each costs one padded copy of the search image
 
 /**
  * @brief Used to encode search information in result arrays passed from client to server, 
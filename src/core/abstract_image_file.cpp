@@ -8,3 +8,9 @@ AbstractImageFile::AbstractImageFile(std::string wanted_filename, bool overwrite
 
 AbstractImageFile::~AbstractImageFile( ) {
 }
+
+void AbstractImageFile::ReadSlicesFromDiskThreadSafe(int start_slice, int end_slice, float* output_array) {
+    wxMutexLocker lock(mutex_protecting_reads);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+    ReadSlicesFromDisk(start_slice, end_slice, output_array);
+}
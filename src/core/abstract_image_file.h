@@ -1,5 +1,8 @@
 class AbstractImageFile {
 
+  protected:
+    wxMutex mutex_protecting_reads;
+
   public:
     wxFileName filename;
 
@@ -21,6 +24,9 @@ class AbstractImageFile {
     virtual void ReadSliceFromDisk(int slice_number, float* output_array)                = 0;
     virtual void ReadSlicesFromDisk(int start_slice, int end_slice, float* output_array) = 0;
 
+    // May be called concurrently from several threads. Formats that can't read without shared state are serialized here.
+    virtual void ReadSlicesFromDiskThreadSafe(int start_slice, int end_slice, float* output_array);
+
     virtual void WriteSliceToDisk(int slice_number, float* input_array)                = 0;
     virtual void WriteSlicesToDisk(int start_slice, int end_slice, float* input_array) = 0;
 
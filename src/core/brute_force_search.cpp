@@ -32,7 +32,7 @@ BruteForceSearch::~BruteForceSearch( ) {
 void BruteForceSearch::Init(float (*function_to_minimize)(void* parameters, float[]), void* wanted_parameters, int num_dim, float wanted_starting_value[], float wanted_half_range[], float wanted_step_size[], bool should_minimise_at_every_step, bool should_print_progress_bar, int wanted_desired_num_threads) {
     MyDebugAssertFalse(is_in_memory, "Brute force search object is already setup");
     MyDebugAssertTrue(num_dim > 0, "Bad number of dimensions: %i", num_dim);
-    MyDebugAssertTrue(num_dim <= 16, "Recent versions of BruteForceSearch (with threading) may not work with more than 16 dimensions");
+    MyDebugAssertTrue(num_dim <= maximum_number_of_dimensions, "BruteForceSearch (with threading) supports at most %i dimensions, got %i", maximum_number_of_dimensions, num_dim);
 
     // Local variables
     float* current_values = new float[num_dim];
@@ -152,7 +152,7 @@ void BruteForceSearch::Run(float** all_valuesp, float** all_scoresp, int* num_va
 
     // Private variables
     // DNM: Switch to a fixed dimensioned array so that OpenMP will make copies automatically
-    float  current_values[16];
+    float  current_values[maximum_number_of_dimensions];
     float* accuracy_for_local_minimization       = new float[number_of_dimensions];
     float* current_values_for_local_minimization = new float[number_of_dimensions];
     // DNM: New arrays for holding the values at each step, the scores from each step,
@@ -207,7 +207,7 @@ void BruteForceSearch::Run(float** all_valuesp, float** all_scoresp, int* num_va
     //numThreads = ReturnAppropriateNumberOfThreads(desired_num_threads);
     numThreads = CheckNumberOfThreads(desired_num_threads);
 
-    if ( numThreads > 1 && ! minimise_at_every_step ) {
+    if ( numThreads > 1 ) {
         wxPrintf("\nRunning brute-force search with %i OpenMP threads\n", numThreads);
     }
 
@@ -216,20 +216,20 @@ void BruteForceSearch::Run(float** all_valuesp, float** all_scoresp, int* num_va
     }
 
     // start the brute-force search iterations
-    // DNM the minimizer did not work right with threads, so just run it normally
+    // The local minimizations are independent of each other, so they run in parallel as well. Each thread needs its own
+    // starting values, which are kept in a fixed dimensioned array so that OpenMP makes the copies.
     if ( minimise_at_every_step ) {
+        float thread_values_for_local_minimization[maximum_number_of_dimensions];
+
+#pragma omp parallel for schedule(dynamic) default(none) num_threads(numThreads) shared(all_values, all_local_best_values, all_scores, num_iterations_completed, my_progress_bar, accuracy_for_local_minimization) private(current_iteration, thread_values_for_local_minimization, i)
         for ( current_iteration = 0; current_iteration < num_iterations; current_iteration++ ) {
             // what values for the parameters should we try now?
             // DNM: switch to getting from the list
-            //IncrementCurrentValues(current_values,search_completed);
             for ( i = 0; i < number_of_dimensions; i++ )
-                current_values[i] = all_values[number_of_dimensions * current_iteration + i];
+                thread_values_for_local_minimization[i] = all_values[number_of_dimensions * current_iteration + i];
 
             ConjugateGradient local_minimizer;
-            for ( i = 0; i < number_of_dimensions; i++ ) {
-                current_values_for_local_minimization[i] = current_values[i];
-            }
-            local_minimizer.Init(target_function, parameters, number_of_dimensions, current_values_for_local_minimization, accuracy_for_local_minimization);
+            local_minimizer.Init(target_function, parameters, number_of_dimensions, thread_values_for_local_minimization, accuracy_for_local_minimization);
             local_minimizer.Run( );
             // DNM: store the results
             all_scores[current_iteration] = local_minimizer.GetBestScore( );
@@ -238,6 +238,7 @@ void BruteForceSearch::Run(float** all_valuesp, float** all_scoresp, int* num_va
 
             // Progress
             if ( print_progress_bar ) {
+#pragma omp atomic
                 num_iterations_completed++;
                 my_progress_bar->Update(num_iterations_completed);
             }
@@ -18,6 +18,9 @@ class BruteForceSearch {
     int    desired_num_threads;
 
   public:
+    // The threaded search keeps per-thread copies of the parameter values in fixed-size arrays
+    static constexpr int maximum_number_of_dimensions = 16;
+
     // Constructors & destructors
     BruteForceSearch( );
     ~BruteForceSearch( );
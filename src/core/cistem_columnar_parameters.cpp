@@ -0,0 +1,706 @@
+#include "core_headers.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using c_ft = cistem::fundamental_type::Enum;
+
+// When adding a new column to cisTEMParameterLine, add it to one of the tables below - nothing else in this file needs to change.
+
+namespace {
+
+struct FloatColumnDescriptor {
+    long bitmask_identifier;
+    float cisTEMParameterLine::*value;
+    bool cisTEMParameterMask::*is_wanted;
+    bool                       is_in_statistics; // included by ReturnParameterAverages / ReturnParameterVariances
+};
+
+struct IntegerColumnDescriptor {
+    long bitmask_identifier;
+    int cisTEMParameterLine::*value;
+    bool cisTEMParameterMask::*is_wanted;
+};
+
+struct StringColumnDescriptor {
+    long bitmask_identifier;
+    wxString cisTEMParameterLine::*value;
+    bool cisTEMParameterMask::*is_wanted;
+};
+
+const FloatColumnDescriptor float_columns[] = {
+        {PSI, &cisTEMParameterLine::psi, &cisTEMParameterMask::psi, true},
+        {THETA, &cisTEMParameterLine::theta, &cisTEMParameterMask::theta, true},
+        {PHI, &cisTEMParameterLine::phi, &cisTEMParameterMask::phi, true},
+        {X_SHIFT, &cisTEMParameterLine::x_shift, &cisTEMParameterMask::x_shift, true},
+        {Y_SHIFT, &cisTEMParameterLine::y_shift, &cisTEMParameterMask::y_shift, true},
+        {DEFOCUS_1, &cisTEMParameterLine::defocus_1, &cisTEMParameterMask::defocus_1, true},
+        {DEFOCUS_2, &cisTEMParameterLine::defocus_2, &cisTEMParameterMask::defocus_2, true},
+        {DEFOCUS_ANGLE, &cisTEMParameterLine::defocus_angle, &cisTEMParameterMask::defocus_angle, true},
+        {PHASE_SHIFT, &cisTEMParameterLine::phase_shift, &cisTEMParameterMask::phase_shift, true},
+        {OCCUPANCY, &cisTEMParameterLine::occupancy, &cisTEMParameterMask::occupancy, true},
+        {LOGP, &cisTEMParameterLine::logp, &cisTEMParameterMask::logp, true},
+        {SIGMA, &cisTEMParameterLine::sigma, &cisTEMParameterMask::sigma, true},
+        {SCORE, &cisTEMParameterLine::score, &cisTEMParameterMask::score, true},
+        {SCORE_CHANGE, &cisTEMParameterLine::score_change, &cisTEMParameterMask::score_change, true},
+        {PIXEL_SIZE, &cisTEMParameterLine::pixel_size, &cisTEMParameterMask::pixel_size, true},
+        {MICROSCOPE_VOLTAGE, &cisTEMParameterLine::microscope_voltage_kv, &cisTEMParameterMask::microscope_voltage_kv, true},
+        {MICROSCOPE_CS, &cisTEMParameterLine::microscope_spherical_aberration_mm, &cisTEMParameterMask::microscope_spherical_aberration_mm, true},
+        {AMPLITUDE_CONTRAST, &cisTEMParameterLine::amplitude_contrast, &cisTEMParameterMask::amplitude_contrast, true},
+        {BEAM_TILT_X, &cisTEMParameterLine::beam_tilt_x, &cisTEMParameterMask::beam_tilt_x, true},
+        {BEAM_TILT_Y, &cisTEMParameterLine::beam_tilt_y, &cisTEMParameterMask::beam_tilt_y, true},
+        {IMAGE_SHIFT_X, &cisTEMParameterLine::image_shift_x, &cisTEMParameterMask::image_shift_x, true},
+        {IMAGE_SHIFT_Y, &cisTEMParameterLine::image_shift_y, &cisTEMParameterMask::image_shift_y, true},
+        {PRE_EXPOSURE, &cisTEMParameterLine::pre_exposure, &cisTEMParameterMask::pre_exposure, false},
+        {TOTAL_EXPOSURE, &cisTEMParameterLine::total_exposure, &cisTEMParameterMask::total_exposure, false},
+        {ORIGINAL_X_POSITION, &cisTEMParameterLine::original_x_position, &cisTEMParameterMask::original_x_position, false},
+        {ORIGINAL_Y_POSITION, &cisTEMParameterLine::original_y_position, &cisTEMParameterMask::original_y_position, false}};
+
+const IntegerColumnDescriptor integer_columns[] = {
+        {IMAGE_IS_ACTIVE, &cisTEMParameterLine::image_is_active, &cisTEMParameterMask::image_is_active},
+        {BEST_2D_CLASS, &cisTEMParameterLine::best_2d_class, &cisTEMParameterMask::best_2d_class},
+        {BEAM_TILT_GROUP, &cisTEMParameterLine::beam_tilt_group, &cisTEMParameterMask::beam_tilt_group},
+        {PARTICLE_GROUP, &cisTEMParameterLine::particle_group, &cisTEMParameterMask::particle_group},
+        {ASSIGNED_SUBSET, &cisTEMParameterLine::assigned_subset, &cisTEMParameterMask::assigned_subset}};
+
+const StringColumnDescriptor string_columns[] = {
+        {STACK_FILENAME, &cisTEMParameterLine::stack_filename, &cisTEMParameterMask::stack_filename},
+        {ORIGINAL_IMAGE_FILENAME, &cisTEMParameterLine::original_image_filename, &cisTEMParameterMask::original_image_filename},
+        {REFERENCE_3D_FILENAME, &cisTEMParameterLine::reference_3d_filename, &cisTEMParameterMask::reference_3d_filename}};
+
+const int number_of_float_columns   = sizeof(float_columns) / sizeof(FloatColumnDescriptor);
+const int number_of_integer_columns = sizeof(integer_columns) / sizeof(IntegerColumnDescriptor);
+const int number_of_string_columns  = sizeof(string_columns) / sizeof(StringColumnDescriptor);
+
+const char columnar_file_magic[8] = "cisTEMC";
+
+inline long RoundUpToAlignment(long offset) {
+    return (offset + CISTEM_COLUMNAR_FILE_ALIGNMENT - 1) / CISTEM_COLUMNAR_FILE_ALIGNMENT * CISTEM_COLUMNAR_FILE_ALIGNMENT;
+}
+
+// Zero padding up to wanted_offset, so that the next section starts where the directory says it does
+void WritePaddingUpTo(FILE* output_file, long& current_offset, long wanted_offset) {
+    static const char padding[CISTEM_COLUMNAR_FILE_ALIGNMENT] = {0};
+    MyDebugAssertTrue(wanted_offset >= current_offset && wanted_offset - current_offset <= CISTEM_COLUMNAR_FILE_ALIGNMENT, "Bad padding %li -> %li", current_offset, wanted_offset);
+    fwrite(padding, 1, wanted_offset - current_offset, output_file);
+    current_offset = wanted_offset;
+}
+
+// The weight of each line in the statistics, 1 if the line is counted and 0 if not - this keeps the column scans free of branches
+long FillStatisticsWeights(const int* image_is_active, long number_of_lines, bool only_active, std::vector<float>& weights) {
+    weights.assign(number_of_lines, 1.0f);
+    if ( only_active == false || image_is_active == NULL )
+        return number_of_lines;
+
+    long number_summed = 0;
+    for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+        if ( image_is_active[line_counter] < 0 )
+            weights[line_counter] = 0.0f;
+        else
+            number_summed++;
+    }
+
+    return number_summed;
+}
+
+void SumColumn(const float* column, const float* weights, long number_of_lines, double& sum, double& sum_of_squares) {
+    double local_sum            = 0.0;
+    double local_sum_of_squares = 0.0;
+
+#pragma omp simd reduction(+ : local_sum, local_sum_of_squares)
+    for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+        double weighted_value = weights[line_counter] * column[line_counter];
+        local_sum += weighted_value;
+        local_sum_of_squares += weighted_value * column[line_counter];
+    }
+
+    sum            = local_sum;
+    sum_of_squares = local_sum_of_squares;
+}
+
+void SumColumn(const int* column, const float* weights, long number_of_lines, double& sum, double& sum_of_squares) {
+    double local_sum            = 0.0;
+    double local_sum_of_squares = 0.0;
+
+#pragma omp simd reduction(+ : local_sum, local_sum_of_squares)
+    for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+        double weighted_value = double(weights[line_counter]) * column[line_counter];
+        local_sum += weighted_value;
+        local_sum_of_squares += weighted_value * column[line_counter];
+    }
+
+    sum            = local_sum;
+    sum_of_squares = local_sum_of_squares;
+}
+
+void SumColumn(const unsigned int* column, const float* weights, long number_of_lines, double& sum, double& sum_of_squares) {
+    double local_sum            = 0.0;
+    double local_sum_of_squares = 0.0;
+
+#pragma omp simd reduction(+ : local_sum, local_sum_of_squares)
+    for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+        double weighted_value = double(weights[line_counter]) * column[line_counter];
+        local_sum += weighted_value;
+        local_sum_of_squares += weighted_value * column[line_counter];
+    }
+
+    sum            = local_sum;
+    sum_of_squares = local_sum_of_squares;
+}
+
+} // namespace
+
+// These two cisTEMParameters functions live here, next to the column tables they share with the reader
+
+void cisTEMParameters::WriteTocisTEMColumnarFile(wxString wanted_filename, int first_image_to_write, int last_image_to_write) {
+    if ( wanted_filename.IsSameAs("/dev/null") )
+        return; // see WriteTocisTEMBinaryFile
+
+    if ( first_image_to_write == -1 )
+        first_image_to_write = 1;
+    if ( last_image_to_write == -1 )
+        last_image_to_write = INT_MAX;
+
+    std::vector<int> lines_to_write;
+    lines_to_write.reserve(all_parameters.GetCount( ));
+
+    for ( long line_counter = 0; line_counter < all_parameters.GetCount( ); line_counter++ ) {
+        if ( long(all_parameters[line_counter].position_in_stack) >= first_image_to_write && long(all_parameters[line_counter].position_in_stack) <= last_image_to_write )
+            lines_to_write.push_back(int(line_counter));
+    }
+
+    long number_of_lines = long(lines_to_write.size( ));
+
+    // the position in stack is always written, as the index is built on it
+
+    std::vector<cisTEMColumnarColumnEntry> column_directory;
+    cisTEMColumnarColumnEntry              new_entry;
+
+    new_entry.bitmask_identifier = POSITION_IN_STACK;
+    new_entry.data_type          = c_ft::integer_unsigned_t;
+    new_entry.bytes_per_value    = sizeof(unsigned int);
+    column_directory.push_back(new_entry);
+
+    for ( int column_counter = 0; column_counter < number_of_integer_columns; column_counter++ ) {
+        if ( parameters_to_write.*integer_columns[column_counter].is_wanted == true ) {
+            new_entry.bitmask_identifier = integer_columns[column_counter].bitmask_identifier;
+            new_entry.data_type          = c_ft::integer_t;
+            new_entry.bytes_per_value    = sizeof(int);
+            column_directory.push_back(new_entry);
+        }
+    }
+
+    for ( int column_counter = 0; column_counter < number_of_float_columns; column_counter++ ) {
+        if ( parameters_to_write.*float_columns[column_counter].is_wanted == true ) {
+            new_entry.bitmask_identifier = float_columns[column_counter].bitmask_identifier;
+            new_entry.data_type          = c_ft::float_t;
+            new_entry.bytes_per_value    = sizeof(float);
+            column_directory.push_back(new_entry);
+        }
+    }
+
+    // filenames are usually shared by many particles, so each distinct one is stored once
+
+    std::unordered_map<wxString, int, wxStringHash, wxStringEqual> string_indices;
+    std::vector<std::string>                                       string_table;
+    std::vector<std::vector<int>>                                  string_column_values;
+    long                                                           number_of_string_characters = 0;
+
+    for ( int column_counter = 0; column_counter < number_of_string_columns; column_counter++ ) {
+        if ( parameters_to_write.*string_columns[column_counter].is_wanted == true ) {
+            new_entry.bitmask_identifier = string_columns[column_counter].bitmask_identifier;
+            new_entry.data_type          = c_ft::variable_length_t;
+            new_entry.bytes_per_value    = sizeof(int);
+            column_directory.push_back(new_entry);
+
+            string_column_values.push_back(std::vector<int>(number_of_lines));
+            std::vector<int>& current_values = string_column_values.back( );
+
+            for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+                const wxString& current_string = all_parameters[lines_to_write[line_counter]].*string_columns[column_counter].value;
+                auto            found_string   = string_indices.find(current_string);
+
+                if ( found_string == string_indices.end( ) ) {
+                    found_string = string_indices.emplace(current_string, int(string_table.size( ))).first;
+                    string_table.push_back(std::string(current_string.ToUTF8( ).data( )));
+                    number_of_string_characters += string_table.back( ).size( );
+                }
+
+                current_values[line_counter] = found_string->second;
+            }
+        }
+    }
+
+    // work out where everything goes..
+
+    cisTEMColumnarFileHeader header;
+    memcpy(header.magic, columnar_file_magic, sizeof(header.magic));
+    header.version           = CISTEM_COLUMNAR_FILE_VERSION;
+    header.number_of_columns = int(column_directory.size( ));
+    header.number_of_lines   = number_of_lines;
+
+    long current_offset = RoundUpToAlignment(sizeof(cisTEMColumnarFileHeader) + column_directory.size( ) * sizeof(cisTEMColumnarColumnEntry));
+
+    for ( auto& column_entry : column_directory ) {
+        column_entry.offset = current_offset;
+        current_offset      = RoundUpToAlignment(current_offset + number_of_lines * column_entry.bytes_per_value);
+    }
+
+    header.string_table_offset = current_offset;
+    current_offset             = RoundUpToAlignment(current_offset + sizeof(long) * (string_table.size( ) + 2) + number_of_string_characters);
+    header.index_offset        = current_offset;
+    header.file_size           = header.index_offset + number_of_lines * sizeof(int);
+
+    // ..and write it
+
+    FILE* columnar_file = fopen(wanted_filename.ToStdString( ).c_str( ), "wb");
+
+    if ( columnar_file == NULL ) {
+        MyPrintWithDetails("Error: Can't open %s for writing\n", wanted_filename);
+        DEBUG_ABORT;
+    }
+
+    fwrite(&header, sizeof(cisTEMColumnarFileHeader), 1, columnar_file);
+    fwrite(column_directory.data( ), sizeof(cisTEMColumnarColumnEntry), column_directory.size( ), columnar_file);
+    current_offset = sizeof(cisTEMColumnarFileHeader) + column_directory.size( ) * sizeof(cisTEMColumnarColumnEntry);
+
+    std::vector<float>        float_values(number_of_lines);
+    std::vector<int>          integer_values(number_of_lines);
+    std::vector<unsigned int> unsigned_values(number_of_lines);
+    int                       string_column_counter = 0;
+
+    for ( auto& column_entry : column_directory ) {
+        WritePaddingUpTo(columnar_file, current_offset, column_entry.offset);
+
+        if ( column_entry.bitmask_identifier == POSITION_IN_STACK ) {
+            for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+                unsigned_values[line_counter] = all_parameters[lines_to_write[line_counter]].position_in_stack;
+            }
+            fwrite(unsigned_values.data( ), sizeof(unsigned int), number_of_lines, columnar_file);
+        }
+        else if ( column_entry.data_type == c_ft::variable_length_t ) {
+            fwrite(string_column_values[string_column_counter].data( ), sizeof(int), number_of_lines, columnar_file);
+            string_column_counter++;
+        }
+        else if ( column_entry.data_type == c_ft::integer_t ) {
+            for ( int column_counter = 0; column_counter < number_of_integer_columns; column_counter++ ) {
+                if ( integer_columns[column_counter].bitmask_identifier == column_entry.bitmask_identifier ) {
+                    for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+                        integer_values[line_counter] = all_parameters[lines_to_write[line_counter]].*integer_columns[column_counter].value;
+                    }
+                }
+            }
+            fwrite(integer_values.data( ), sizeof(int), number_of_lines, columnar_file);
+        }
+        else {
+            for ( int column_counter = 0; column_counter < number_of_float_columns; column_counter++ ) {
+                if ( float_columns[column_counter].bitmask_identifier == column_entry.bitmask_identifier ) {
+                    for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+                        float_values[line_counter] = all_parameters[lines_to_write[line_counter]].*float_columns[column_counter].value;
+                    }
+                }
+            }
+            fwrite(float_values.data( ), sizeof(float), number_of_lines, columnar_file);
+        }
+
+        current_offset += number_of_lines * column_entry.bytes_per_value;
+    }
+
+    // string table
+
+    WritePaddingUpTo(columnar_file, current_offset, header.string_table_offset);
+
+    long              number_of_strings = long(string_table.size( ));
+    std::vector<long> string_offsets(number_of_strings + 1);
+    string_offsets[0] = 0;
+    for ( long string_counter = 0; string_counter < number_of_strings; string_counter++ ) {
+        string_offsets[string_counter + 1] = string_offsets[string_counter] + long(string_table[string_counter].size( ));
+    }
+
+    fwrite(&number_of_strings, sizeof(long), 1, columnar_file);
+    fwrite(string_offsets.data( ), sizeof(long), number_of_strings + 1, columnar_file);
+    for ( auto& current_string : string_table ) {
+        fwrite(current_string.data( ), 1, current_string.size( ), columnar_file);
+    }
+    current_offset += sizeof(long) * (number_of_strings + 2) + number_of_string_characters;
+
+    // index of lines by position in stack
+
+    WritePaddingUpTo(columnar_file, current_offset, header.index_offset);
+
+    std::vector<int> index(number_of_lines);
+    for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+        index[line_counter] = int(line_counter);
+    }
+    std::stable_sort(index.begin( ), index.end( ), [&](int first_line, int second_line) { return all_parameters[lines_to_write[first_line]].position_in_stack < all_parameters[lines_to_write[second_line]].position_in_stack; });
+    fwrite(index.data( ), sizeof(int), number_of_lines, columnar_file);
+
+    fclose(columnar_file);
+}
+
+void cisTEMParameters::ReadFromcisTEMColumnarFile(wxString wanted_filename, bool exclude_negative_film_numbers, int first_image_to_read, int last_image_to_read) {
+    cisTEMColumnarParameterReader columnar_reader;
+
+    if ( columnar_reader.Open(wanted_filename) == false ) {
+        MyPrintWithDetails("Error: Can't read %s\n", wanted_filename);
+        DEBUG_ABORT;
+    }
+
+    columnar_reader.ReadLines(all_parameters, exclude_negative_film_numbers, first_image_to_read, last_image_to_read);
+    parameters_that_were_read = columnar_reader.parameters_that_were_read;
+    statistics_were_read      = false; // the statistics are scans over the columns of the reader
+}
+
+cisTEMColumnarParameterReader::cisTEMColumnarParameterReader( ) {
+    memory_map_address                 = NULL;
+    memory_map_size_in_bytes           = 0;
+    header                             = NULL;
+    column_directory                   = NULL;
+    string_offsets                     = NULL;
+    string_characters                  = NULL;
+    lines_ordered_by_position_in_stack = NULL;
+    number_of_strings                  = 0;
+}
+
+cisTEMColumnarParameterReader::~cisTEMColumnarParameterReader( ) {
+    Close( );
+}
+
+bool cisTEMColumnarParameterReader::IsColumnarFile(wxString wanted_filename) {
+    wxFileName columnar_filename(wanted_filename);
+    return columnar_filename.GetExt( ) == "cistemc";
+}
+
+bool cisTEMColumnarParameterReader::Open(wxString wanted_filename) {
+    Close( );
+
+    int file_descriptor = open(wanted_filename.ToStdString( ).c_str( ), O_RDONLY);
+    if ( file_descriptor < 0 ) {
+        MyPrintWithDetails("Error: Can't open %s\n", wanted_filename);
+        return false;
+    }
+
+    struct stat file_status;
+    if ( fstat(file_descriptor, &file_status) != 0 || long(file_status.st_size) < long(sizeof(cisTEMColumnarFileHeader)) ) {
+        close(file_descriptor);
+        MyPrintWithDetails("Error: %s is too short to be a columnar parameter file\n", wanted_filename);
+        return false;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    void* mapped_address = mmap(NULL, size_t(file_status.st_size), PROT_READ, MAP_SHARED, file_descriptor, 0);
+    close(file_descriptor);
+
+    if ( mapped_address == MAP_FAILED ) {
+        MyPrintWithDetails("Error: Can't memory map %s\n", wanted_filename);
+        return false;
+    }
+
+    memory_map_address       = static_cast<char*>(mapped_address);
+    memory_map_size_in_bytes = long(file_status.st_size);
+    filename                 = wanted_filename;
+    header                   = reinterpret_cast<const cisTEMColumnarFileHeader*>(memory_map_address);
+
+    // check everything the directory points to is inside the file and every offset and index is in range, so nothing later has to
+
+    bool is_valid = memcmp(header->magic, columnar_file_magic, sizeof(header->magic)) == 0 && header->version == CISTEM_COLUMNAR_FILE_VERSION && header->file_size == memory_map_size_in_bytes && header->number_of_lines >= 0 && header->number_of_lines <= memory_map_size_in_bytes / long(sizeof(int)) && header->number_of_columns >= 0;
+    is_valid      = is_valid && long(sizeof(cisTEMColumnarFileHeader) + header->number_of_columns * sizeof(cisTEMColumnarColumnEntry)) <= memory_map_size_in_bytes;
+
+    long columns_that_were_read = 0;
+
+    if ( is_valid == true ) {
+        column_directory = reinterpret_cast<const cisTEMColumnarColumnEntry*>(memory_map_address + sizeof(cisTEMColumnarFileHeader));
+
+        for ( int column_counter = 0; column_counter < header->number_of_columns; column_counter++ ) {
+            const cisTEMColumnarColumnEntry& column_entry = column_directory[column_counter];
+            is_valid                                      = is_valid && column_entry.bytes_per_value == 4 && column_entry.offset % 4 == 0 && column_entry.offset >= 0 && column_entry.offset + header->number_of_lines * column_entry.bytes_per_value <= memory_map_size_in_bytes;
+            columns_that_were_read |= column_entry.bitmask_identifier;
+        }
+    }
+
+    if ( is_valid == true ) {
+        is_valid = header->string_table_offset >= 0 && header->string_table_offset % sizeof(long) == 0 && header->string_table_offset + long(sizeof(long)) <= memory_map_size_in_bytes;
+    }
+
+    if ( is_valid == true ) {
+        // the number_of_strings + 1 offsets have to fit in the file before any pointer is formed from them
+        number_of_strings = *reinterpret_cast<const long*>(memory_map_address + header->string_table_offset);
+        is_valid          = number_of_strings >= 0 && number_of_strings < (memory_map_size_in_bytes - header->string_table_offset - long(sizeof(long))) / long(sizeof(long));
+    }
+
+    if ( is_valid == true ) {
+        string_offsets    = reinterpret_cast<const long*>(memory_map_address + header->string_table_offset + sizeof(long));
+        string_characters = reinterpret_cast<const char*>(string_offsets + number_of_strings + 1);
+
+        // every string has to lie within the characters, as ReturnString and ReturnLine use the offsets as they are
+        long number_of_characters = memory_map_size_in_bytes - (string_characters - memory_map_address);
+        is_valid                  = string_offsets[0] >= 0 && string_offsets[number_of_strings] <= number_of_characters;
+        for ( long string_counter = 0; string_counter < number_of_strings && is_valid == true; string_counter++ ) {
+            is_valid = string_offsets[string_counter] <= string_offsets[string_counter + 1];
+        }
+    }
+
+    if ( is_valid == true ) {
+        is_valid = header->index_offset >= 0 && header->index_offset % sizeof(int) == 0 && header->index_offset + header->number_of_lines * long(sizeof(int)) <= memory_map_size_in_bytes;
+    }
+
+    if ( is_valid == true ) {
+        // the index is used to look up lines, so every entry has to be one
+        lines_ordered_by_position_in_stack = reinterpret_cast<const int*>(memory_map_address + header->index_offset);
+        for ( long line_counter = 0; line_counter < header->number_of_lines && is_valid == true; line_counter++ ) {
+            is_valid = lines_ordered_by_position_in_stack[line_counter] >= 0 && lines_ordered_by_position_in_stack[line_counter] < header->number_of_lines;
+        }
+    }
+
+    if ( is_valid == false ) {
+        MyPrintWithDetails("Error: %s is not a valid columnar parameter file\n", wanted_filename);
+        Close( );
+        return false;
+    }
+
+    parameters_that_were_read.SetActiveParameters(columns_that_were_read);
+
+    float_columns_in_file.resize(number_of_float_columns);
+    for ( int column_counter = 0; column_counter < number_of_float_columns; column_counter++ ) {
+        float_columns_in_file[column_counter] = ReturnFloatColumn(float_columns[column_counter].bitmask_identifier);
+    }
+
+    integer_columns_in_file.resize(number_of_integer_columns);
+    for ( int column_counter = 0; column_counter < number_of_integer_columns; column_counter++ ) {
+        integer_columns_in_file[column_counter] = ReturnIntegerColumn(integer_columns[column_counter].bitmask_identifier);
+    }
+
+    string_columns_in_file.resize(number_of_string_columns);
+    for ( int column_counter = 0; column_counter < number_of_string_columns; column_counter++ ) {
+        const cisTEMColumnarColumnEntry* column_entry = ReturnColumnEntry(string_columns[column_counter].bitmask_identifier);
+        string_columns_in_file[column_counter]        = (column_entry != NULL && column_entry->data_type == c_ft::variable_length_t) ? reinterpret_cast<const int*>(memory_map_address + column_entry->offset) : NULL;
+    }
+
+    return true;
+}
+
+void cisTEMColumnarParameterReader::Close( ) {
+    if ( memory_map_address != NULL ) {
+        munmap(memory_map_address, size_t(memory_map_size_in_bytes));
+    }
+
+    memory_map_address                 = NULL;
+    memory_map_size_in_bytes           = 0;
+    header                             = NULL;
+    column_directory                   = NULL;
+    string_offsets                     = NULL;
+    string_characters                  = NULL;
+    lines_ordered_by_position_in_stack = NULL;
+    number_of_strings                  = 0;
+
+    float_columns_in_file.clear( );
+    integer_columns_in_file.clear( );
+    string_columns_in_file.clear( );
+}
+
+const cisTEMColumnarColumnEntry* cisTEMColumnarParameterReader::ReturnColumnEntry(long bitmask_identifier) const {
+    if ( header == NULL )
+        return NULL;
+
+    for ( int column_counter = 0; column_counter < header->number_of_columns; column_counter++ ) {
+        if ( column_directory[column_counter].bitmask_identifier == bitmask_identifier )
+            return &column_directory[column_counter];
+    }
+
+    return NULL;
+}
+
+const float* cisTEMColumnarParameterReader::ReturnFloatColumn(long bitmask_identifier) const {
+    const cisTEMColumnarColumnEntry* column_entry = ReturnColumnEntry(bitmask_identifier);
+    if ( column_entry == NULL || column_entry->data_type != c_ft::float_t )
+        return NULL;
+    return reinterpret_cast<const float*>(memory_map_address + column_entry->offset);
+}
+
+const int* cisTEMColumnarParameterReader::ReturnIntegerColumn(long bitmask_identifier) const {
+    const cisTEMColumnarColumnEntry* column_entry = ReturnColumnEntry(bitmask_identifier);
+    if ( column_entry == NULL || column_entry->data_type != c_ft::integer_t )
+        return NULL;
+    return reinterpret_cast<const int*>(memory_map_address + column_entry->offset);
+}
+
+const unsigned int* cisTEMColumnarParameterReader::ReturnPositionInStackColumn( ) const {
+    const cisTEMColumnarColumnEntry* column_entry = ReturnColumnEntry(POSITION_IN_STACK);
+    if ( column_entry == NULL || column_entry->data_type != c_ft::integer_unsigned_t )
+        return NULL;
+    return reinterpret_cast<const unsigned int*>(memory_map_address + column_entry->offset);
+}
+
+wxString cisTEMColumnarParameterReader::ReturnString(long bitmask_identifier, long line_number) const {
+    MyDebugAssertTrue(line_number >= 0 && line_number < ReturnNumberOfLines( ), "Line number out of range (%li)", line_number);
+
+    const cisTEMColumnarColumnEntry* column_entry = ReturnColumnEntry(bitmask_identifier);
+    if ( column_entry == NULL || column_entry->data_type != c_ft::variable_length_t )
+        return wxEmptyString;
+
+    int string_index = reinterpret_cast<const int*>(memory_map_address + column_entry->offset)[line_number];
+    if ( string_index < 0 || string_index >= number_of_strings )
+        return wxEmptyString;
+
+    return wxString::FromUTF8(string_characters + string_offsets[string_index], string_offsets[string_index + 1] - string_offsets[string_index]);
+}
+
+void cisTEMColumnarParameterReader::ReturnLinesInPositionRange(int first_image, int last_image, std::vector<long>& line_numbers) const {
+    line_numbers.clear( );
+
+    const unsigned int* position_in_stack = ReturnPositionInStackColumn( );
+    if ( position_in_stack == NULL )
+        return;
+
+    unsigned int first_position = (first_image < 0) ? 0 : (unsigned int)(first_image);
+    unsigned int last_position  = (last_image < 0) ? UINT_MAX : (unsigned int)(last_image);
+
+    const int* first_in_index = lines_ordered_by_position_in_stack;
+    const int* last_in_index  = lines_ordered_by_position_in_stack + ReturnNumberOfLines( );
+    const int* index_position = std::lower_bound(first_in_index, last_in_index, first_position, [position_in_stack](int line_number, unsigned int wanted_position) { return position_in_stack[line_number] < wanted_position; });
+
+    for ( ; index_position != last_in_index && position_in_stack[*index_position] <= last_position; ++index_position ) {
+        line_numbers.push_back(*index_position);
+    }
+
+    // hand the lines back in the order they are in the file, as the other readers would
+    std::sort(line_numbers.begin( ), line_numbers.end( ));
+}
+
+void cisTEMColumnarParameterReader::ReturnLine(long line_number, cisTEMParameterLine& line_to_fill) const {
+    MyDebugAssertTrue(line_number >= 0 && line_number < ReturnNumberOfLines( ), "Line number out of range (%li)", line_number);
+
+    line_to_fill.SetAllToZero( );
+
+    const unsigned int* position_in_stack = ReturnPositionInStackColumn( );
+    if ( position_in_stack != NULL )
+        line_to_fill.position_in_stack = position_in_stack[line_number];
+
+    for ( int column_counter = 0; column_counter < number_of_integer_columns; column_counter++ ) {
+        if ( integer_columns_in_file[column_counter] != NULL )
+            line_to_fill.*integer_columns[column_counter].value = integer_columns_in_file[column_counter][line_number];
+    }
+
+    for ( int column_counter = 0; column_counter < number_of_float_columns; column_counter++ ) {
+        if ( float_columns_in_file[column_counter] != NULL )
+            line_to_fill.*float_columns[column_counter].value = float_columns_in_file[column_counter][line_number];
+    }
+
+    for ( int column_counter = 0; column_counter < number_of_string_columns; column_counter++ ) {
+        if ( string_columns_in_file[column_counter] != NULL ) {
+            int string_index = string_columns_in_file[column_counter][line_number];
+            if ( string_index >= 0 && string_index < number_of_strings )
+                line_to_fill.*string_columns[column_counter].value = wxString::FromUTF8(string_characters + string_offsets[string_index], string_offsets[string_index + 1] - string_offsets[string_index]);
+        }
+    }
+}
+
+void cisTEMColumnarParameterReader::ReadLines(ArrayOfcisTEMParameterLines& lines_to_fill, bool exclude_negative_film_numbers, int first_image, int last_image) const {
+    MyDebugAssertTrue(IsOpen( ), "No file is open");
+
+    std::vector<long> line_numbers;
+
+    if ( first_image == -1 && last_image == -1 ) {
+        line_numbers.resize(ReturnNumberOfLines( ));
+        for ( long line_counter = 0; line_counter < ReturnNumberOfLines( ); line_counter++ ) {
+            line_numbers[line_counter] = line_counter;
+        }
+    }
+    else
+        ReturnLinesInPositionRange(first_image, last_image, line_numbers);
+
+    lines_to_fill.Clear( );
+    lines_to_fill.Alloc(line_numbers.size( ));
+
+    cisTEMParameterLine temp_line;
+
+    for ( long line_counter = 0; line_counter < long(line_numbers.size( )); line_counter++ ) {
+        ReturnLine(line_numbers[line_counter], temp_line);
+        if ( temp_line.image_is_active >= 0 || exclude_negative_film_numbers == false )
+            lines_to_fill.Add(temp_line);
+    }
+}
+
+cisTEMParameterLine cisTEMColumnarParameterReader::ReturnParameterAverages(bool only_average_active) const {
+    cisTEMParameterLine average_values;
+    std::vector<float>  weights;
+    double              sum;
+    double              sum_of_squares;
+
+    long number_of_lines = ReturnNumberOfLines( );
+    long number_summed   = FillStatisticsWeights(ReturnIntegerColumn(IMAGE_IS_ACTIVE), number_of_lines, only_average_active, weights);
+
+    if ( number_summed == 0 )
+        return average_values;
+
+    if ( ReturnPositionInStackColumn( ) != NULL ) {
+        SumColumn(ReturnPositionInStackColumn( ), weights.data( ), number_of_lines, sum, sum_of_squares);
+        average_values.position_in_stack = sum / double(number_summed);
+    }
+
+    if ( ReturnIntegerColumn(IMAGE_IS_ACTIVE) != NULL ) {
+        SumColumn(ReturnIntegerColumn(IMAGE_IS_ACTIVE), weights.data( ), number_of_lines, sum, sum_of_squares);
+        average_values.image_is_active = sum / double(number_summed);
+    }
+
+    for ( int column_counter = 0; column_counter < number_of_float_columns; column_counter++ ) {
+        if ( float_columns[column_counter].is_in_statistics == true && float_columns_in_file[column_counter] != NULL ) {
+            SumColumn(float_columns_in_file[column_counter], weights.data( ), number_of_lines, sum, sum_of_squares);
+            average_values.*float_columns[column_counter].value = sum / double(number_summed);
+        }
+    }
+
+    return average_values;
+}
+
+cisTEMParameterLine cisTEMColumnarParameterReader::ReturnParameterVariances(bool only_average_active) const {
+    cisTEMParameterLine variance_values;
+    std::vector<float>  weights;
+    double              sum;
+    double              sum_of_squares;
+
+    long number_of_lines = ReturnNumberOfLines( );
+    long number_summed   = FillStatisticsWeights(ReturnIntegerColumn(IMAGE_IS_ACTIVE), number_of_lines, only_average_active, weights);
+
+    if ( number_summed == 0 )
+        return variance_values;
+
+    // as in cisTEMParameters::ReturnParameterVariances, the variance is the mean square minus the square of the mean
+
+    if ( ReturnPositionInStackColumn( ) != NULL ) {
+        SumColumn(ReturnPositionInStackColumn( ), weights.data( ), number_of_lines, sum, sum_of_squares);
+        variance_values.position_in_stack = sum_of_squares / double(number_summed) - powf(sum / double(number_summed), 2);
+    }
+
+    if ( ReturnIntegerColumn(IMAGE_IS_ACTIVE) != NULL ) {
+        SumColumn(ReturnIntegerColumn(IMAGE_IS_ACTIVE), weights.data( ), number_of_lines, sum, sum_of_squares);
+        variance_values.image_is_active = sum_of_squares / double(number_summed) - powf(sum / double(number_summed), 2);
+    }
+
+    for ( int column_counter = 0; column_counter < number_of_float_columns; column_counter++ ) {
+        if ( float_columns[column_counter].is_in_statistics == true && float_columns_in_file[column_counter] != NULL ) {
+            SumColumn(float_columns_in_file[column_counter], weights.data( ), number_of_lines, sum, sum_of_squares);
+            variance_values.*float_columns[column_counter].value = sum_of_squares / double(number_summed) - powf(sum / double(number_summed), 2);
+        }
+    }
+
+    return variance_values;
+}
+
+float cisTEMColumnarParameterReader::ReturnAverageSigma(bool exclude_negative_film_numbers) const {
+    std::vector<float> weights;
+    double             sum;
+    double             sum_of_squares;
+
+    const float* sigma = ReturnFloatColumn(SIGMA);
+    long         number_of_lines = ReturnNumberOfLines( );
+    long         number_summed   = FillStatisticsWeights(ReturnIntegerColumn(IMAGE_IS_ACTIVE), number_of_lines, exclude_negative_film_numbers, weights);
+
+    if ( sigma == NULL || number_summed == 0 )
+        return 0.0;
+
+    SumColumn(sigma, weights.data( ), number_of_lines, sum, sum_of_squares);
+    return sum / double(number_summed);
+}
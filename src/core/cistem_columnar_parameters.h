@@ -0,0 +1,97 @@
+/*  \brief  cisTEMColumnarParameterReader class - read-only, memory mapped access to a columnar cisTEM parameter file (.cistemc)
+
+	A columnar file stores one contiguous, typed array per parameter instead of one record per particle. A job can then read only
+	the rows and columns it needs, straight from the page cache that all jobs on a node share, and statistics over the whole
+	dataset are plain scans over a few arrays. Filenames are kept once in a string table, and the filename columns hold indices
+	into it. An index of the lines ordered by position_in_stack lets a range of particles be found without looking at the other lines.
+
+	Files are written by cisTEMParameters::WriteTocisTEMColumnarFile( ), and cisTEMParameters::ReadFromcisTEMStarFile( ) reads them
+	when the extension is "cistemc".
+
+	Layout (native endianness, every section starts on a 64 byte boundary) :-
+
+	  header            cisTEMColumnarFileHeader
+	  column directory  number_of_columns x cisTEMColumnarColumnEntry
+	  columns           number_of_lines values each, filename columns are int indices into the string table
+	  string table      long number_of_strings, long offsets[number_of_strings + 1], characters (UTF-8, not terminated)
+	  index             number_of_lines int line numbers, ordered by position_in_stack
+*/
+
+#define CISTEM_COLUMNAR_FILE_VERSION 1
+#define CISTEM_COLUMNAR_FILE_ALIGNMENT 64
+
+struct cisTEMColumnarFileHeader {
+    char magic[8]; // "cisTEMC"
+    int  version;
+    int  number_of_columns;
+    long number_of_lines;
+    long string_table_offset;
+    long index_offset;
+    long file_size;
+};
+
+struct cisTEMColumnarColumnEntry {
+    long bitmask_identifier; // as defined at the top of cistem_parameters.h
+    int  data_type; // cistem::fundamental_type::Enum, variable_length_t for filenames
+    int  bytes_per_value;
+    long offset;
+};
+
+class cisTEMColumnarParameterReader {
+
+    char* memory_map_address;
+    long  memory_map_size_in_bytes;
+
+    const cisTEMColumnarFileHeader*  header;
+    const cisTEMColumnarColumnEntry* column_directory;
+    const long*                      string_offsets;
+    const char*                      string_characters;
+    const int*                       lines_ordered_by_position_in_stack;
+    long                             number_of_strings;
+
+    // columns of the file in the order of the column tables in cistem_columnar_parameters.cpp, NULL where a column is not in the file
+    std::vector<const float*> float_columns_in_file;
+    std::vector<const int*>   integer_columns_in_file;
+    std::vector<const int*>   string_columns_in_file;
+
+    const cisTEMColumnarColumnEntry* ReturnColumnEntry(long bitmask_identifier) const;
+
+  public:
+    wxString            filename;
+    cisTEMParameterMask parameters_that_were_read;
+
+    cisTEMColumnarParameterReader( );
+    ~cisTEMColumnarParameterReader( );
+
+    cisTEMColumnarParameterReader(const cisTEMColumnarParameterReader&)            = delete;
+    cisTEMColumnarParameterReader& operator=(const cisTEMColumnarParameterReader&) = delete;
+
+    static bool IsColumnarFile(wxString wanted_filename);
+
+    bool Open(wxString wanted_filename);
+    void Close( );
+
+    inline bool IsOpen( ) const { return memory_map_address != NULL; }
+
+    inline long ReturnNumberOfLines( ) const { return (header == NULL) ? 0 : header->number_of_lines; }
+
+    // NULL if the column is not in the file
+    const float*        ReturnFloatColumn(long bitmask_identifier) const;
+    const int*          ReturnIntegerColumn(long bitmask_identifier) const;
+    const unsigned int* ReturnPositionInStackColumn( ) const;
+
+    wxString ReturnString(long bitmask_identifier, long line_number) const;
+
+    // Line numbers (in file order) of the particles with first_image <= position_in_stack <= last_image, found through the index
+    void ReturnLinesInPositionRange(int first_image, int last_image, std::vector<long>& line_numbers) const;
+
+    void ReturnLine(long line_number, cisTEMParameterLine& line_to_fill) const;
+
+    // Fill an array of lines as cisTEMStarFileReader does. With first_image and last_image set, only that range of particles is read.
+    void ReadLines(ArrayOfcisTEMParameterLines& lines_to_fill, bool exclude_negative_film_numbers = false, int first_image = -1, int last_image = -1) const;
+
+    // The same statistics as the cisTEMParameters functions of the same name, calculated by scanning the columns
+    cisTEMParameterLine ReturnParameterAverages(bool only_average_active = true) const;
+    cisTEMParameterLine ReturnParameterVariances(bool only_average_active = true) const;
+    float               ReturnAverageSigma(bool exclude_negative_film_numbers = false) const;
+};
@@ -1,5 +1,6 @@
 #include "core_headers.h"
 #include <wx/arrimpl.cpp> // this is a magic incantation which must be done!
+#include <array>
 WX_DEFINE_OBJARRAY(ArrayOfcisTEMParameterLines);
 
 using c_ft = cistem::fundamental_type::Enum;
@@ -59,11 +60,12 @@ Add a header for your variable to the block below which looks like :-
 
 	if (parameters_to_write.total_exposure == true) 					data_line += " TOTEXP ";
 
-Finally, add it to the loop that writes the actual data, which currently ends at line ~1325 and looks like :-
+Finally, add it to AppendStarFileDataLine, which formats the actual data and looks like :-
 
-	if (parameters_to_write.total_exposure == true) data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].total_exposure);
+	if ( parameters_to_write.total_exposure == true )
+		append_float("%7.2f ", parameters.total_exposure);
 
-Change parameters_to_write.total_exposure and all_parameters[particle_counter].total_exposure to your variable, and change "%7.2f " to whatever formatting is
+Change parameters_to_write.total_exposure and parameters.total_exposure to your variable, and change "%7.2f " to whatever formatting is
 suitable for your variable.
 
 cistem_star_file_reader.h
@@ -96,7 +98,10 @@ Add it to the block which currently ends ~line 675 and looks like this :-
 change the comment to be your variable, change  total_exposure_column to be your column variable (thisis on 3 lines), and temp_parameters.total_exposure (2 different places)to be your variable, change the = set the variable
 to the default value that should be taken if the column does not exist.
 
-3.Change cisTEMStarFileReader::ReadFile.  Add to the section which currently ends at line ~1085 and looks like :-
+Add it to cisTEMStarFileReader::ExtractParametersFromTokens as well, which does the same for memory mapped files, using read_float / read_integer / read_filename
+and the same default value.
+
+3.Change cisTEMStarFileReader::SetColumnFromHeaderLabel.  Add to the chain which currently ends with :-
 
 		if (current_line.StartsWith("_cisTEMStackFilename ") == true)
 		{
@@ -131,6 +136,11 @@ Change the section that currently ends at line ~1690 and add your variable.  E.g
 
 Change TOTAL_EXPOSURE to your bitwise type and temp_parameters.total_exposure to your variable.  You will have to change the SafelyReadFromBinaryBufferInto function to be the correct data type.
 
+cistem_columnar_parameters.cpp
+------------------------------
+
+Add your variable to one of the column tables at the top of the file (float_columns, integer_columns or string_columns).
+
 console_test.cpp
 ----------------
 
@@ -480,6 +490,8 @@ cisTEMParameterLine::~cisTEMParameterLine( ) {
 
 cisTEMParameters::cisTEMParameters( ) {
     parameters_that_were_read.SetAllToFalse( );
+    write_statistics_to_file = false;
+    statistics_were_read     = false;
 }
 
 cisTEMParameters::~cisTEMParameters( ) {
@@ -558,10 +570,17 @@ void cisTEMParameters::ReadFromcisTEMStarFile(wxString wanted_filename, bool exc
     if ( star_filename.GetExt( ) == "cistem" ) {
         ReadFromcisTEMBinaryFile(wanted_filename, exclude_negative_film_numbers);
     }
+    else if ( star_filename.GetExt( ) == "cistemc" ) {
+        ReadFromcisTEMColumnarFile(wanted_filename, exclude_negative_film_numbers);
+    }
     else {
         all_parameters.Clear( );
         cisTEMStarFileReader star_reader(wanted_filename, &all_parameters, exclude_negative_film_numbers);
         parameters_that_were_read = star_reader.parameters_that_were_read;
+        statistics_were_read      = star_reader.statistics_were_read;
+        statistics_from_file      = star_reader.statistics_from_file;
+        if ( statistics_were_read == true )
+            statistics_from_file.ReplaceColumnsNotInFile(parameters_that_were_read, all_parameters);
     }
 }
 
@@ -570,6 +589,10 @@ void cisTEMParameters::ReadFromcisTEMBinaryFile(wxString wanted_filename, bool e
     cisTEMStarFileReader star_reader;
     star_reader.ReadBinaryFile(wanted_filename, &all_parameters, exclude_negative_film_numbers);
     parameters_that_were_read = star_reader.parameters_that_were_read;
+    statistics_were_read      = star_reader.statistics_were_read;
+    statistics_from_file      = star_reader.statistics_from_file;
+    if ( statistics_were_read == true )
+        statistics_from_file.ReplaceColumnsNotInFile(parameters_that_were_read, all_parameters);
 }
 
 void cisTEMParameters::AddCommentToHeader(wxString comment_to_add) {
@@ -584,6 +607,7 @@ void cisTEMParameters::AddCommentToHeader(wxString comment_to_add) {
 void cisTEMParameters::ClearAll( ) {
     header_comments.Clear( );
     all_parameters.Clear( );
+    statistics_were_read = false;
 }
 
 void cisTEMParameters::SetAllReference3DFilename(wxString wanted_filename) {
@@ -1138,10 +1162,121 @@ void cisTEMParameters::WriteTocisTEMBinaryFile(wxString wanted_filename, int fir
             fwrite(&all_parameters[particle_counter].original_y_position, sizeof(float), 1, cisTEM_bin_file);
     }
 
+    // after the last line, where readers that do not know about it stop reading
+    if ( write_statistics_to_file == true ) {
+        cisTEMParameterStatistics written_statistics;
+        written_statistics.Calculate(all_parameters, parameters_to_write.image_is_active, first_image_to_write, last_image_to_write);
+        written_statistics.WriteToBinaryFile(cisTEM_bin_file);
+    }
+
     fclose(cisTEM_bin_file);
     delete[] output_buffer;
 }
 
+namespace {
+
+// Number of data lines each thread formats at a time in WriteTocisTEMStarFile
+constexpr long star_file_lines_per_thread = 16384;
+
+// Right justifies a quoted filename in 50 characters, as wxString::Format("%50s ", wxString::Format("'%s'", filename)) does
+void AppendQuotedFilename(const wxString& wanted_filename, std::string& output) {
+    wxString quoted_filename = "'" + wanted_filename + "'";
+    if ( quoted_filename.length( ) < 50 )
+        output.append(50 - quoted_filename.length( ), ' ');
+    output += quoted_filename.ToStdString( );
+    output += ' ';
+}
+
+// One data line of a star file, with the same formatting as the header labels written in WriteTocisTEMStarFile expect
+void AppendStarFileDataLine(const cisTEMParameterLine& parameters, const cisTEMParameterMask& parameters_to_write, std::string& output) {
+    char number_buffer[64];
+
+    auto append_float = [&](const char* format, float value) {
+        snprintf(number_buffer, sizeof(number_buffer), format, value);
+        output += number_buffer;
+    };
+
+    auto append_integer = [&](const char* format, int value) {
+        snprintf(number_buffer, sizeof(number_buffer), format, value);
+        output += number_buffer;
+    };
+
+    if ( parameters_to_write.position_in_stack == true )
+        append_integer("%8u ", parameters.position_in_stack);
+    if ( parameters_to_write.psi == true )
+        append_float("%7.2f ", parameters.psi);
+    if ( parameters_to_write.theta == true )
+        append_float("%7.2f ", parameters.theta);
+    if ( parameters_to_write.phi == true )
+        append_float("%7.2f ", parameters.phi);
+    if ( parameters_to_write.x_shift == true )
+        append_float("%9.2f ", parameters.x_shift);
+    if ( parameters_to_write.y_shift == true )
+        append_float("%9.2f ", parameters.y_shift);
+    if ( parameters_to_write.defocus_1 == true )
+        append_float("%8.1f ", parameters.defocus_1);
+    if ( parameters_to_write.defocus_2 == true )
+        append_float("%8.1f ", parameters.defocus_2);
+    if ( parameters_to_write.defocus_angle == true )
+        append_float("%7.2f ", parameters.defocus_angle);
+    if ( parameters_to_write.phase_shift == true )
+        append_float("%7.2f ", parameters.phase_shift);
+    if ( parameters_to_write.image_is_active == true )
+        append_integer("%5i ", parameters.image_is_active);
+    if ( parameters_to_write.occupancy == true )
+        append_float("%7.2f ", parameters.occupancy);
+    if ( parameters_to_write.logp == true )
+        append_integer("%9i ", myroundint(parameters.logp));
+    if ( parameters_to_write.sigma == true )
+        append_float("%10.4f ", parameters.sigma);
+    if ( parameters_to_write.score == true )
+        append_float("%7.2f ", parameters.score);
+    if ( parameters_to_write.score_change == true )
+        append_float("%7.2f ", parameters.score_change);
+    if ( parameters_to_write.pixel_size == true )
+        append_float("%8.5f ", parameters.pixel_size);
+    if ( parameters_to_write.microscope_voltage_kv == true )
+        append_float("%7.2f ", parameters.microscope_voltage_kv);
+    if ( parameters_to_write.microscope_spherical_aberration_mm == true )
+        append_float("%7.2f ", parameters.microscope_spherical_aberration_mm);
+    if ( parameters_to_write.amplitude_contrast == true )
+        append_float("%7.4f ", parameters.amplitude_contrast);
+    if ( parameters_to_write.beam_tilt_x == true )
+        append_float("%7.3f ", parameters.beam_tilt_x);
+    if ( parameters_to_write.beam_tilt_y == true )
+        append_float("%7.3f ", parameters.beam_tilt_y);
+    if ( parameters_to_write.image_shift_x == true )
+        append_float("%7.3f ", parameters.image_shift_x);
+    if ( parameters_to_write.image_shift_y == true )
+        append_float("%7.3f ", parameters.image_shift_y);
+    if ( parameters_to_write.best_2d_class == true )
+        append_integer("%5i ", parameters.best_2d_class);
+    if ( parameters_to_write.beam_tilt_group == true )
+        append_integer("%5i ", parameters.beam_tilt_group);
+    if ( parameters_to_write.stack_filename == true )
+        AppendQuotedFilename(parameters.stack_filename, output);
+    if ( parameters_to_write.original_image_filename == true )
+        AppendQuotedFilename(parameters.original_image_filename, output);
+    if ( parameters_to_write.reference_3d_filename == true )
+        AppendQuotedFilename(parameters.reference_3d_filename, output);
+    if ( parameters_to_write.particle_group == true )
+        append_integer("%8u ", parameters.particle_group);
+    if ( parameters_to_write.assigned_subset == true )
+        append_integer("%8i ", parameters.assigned_subset);
+    if ( parameters_to_write.pre_exposure == true )
+        append_float("%7.2f ", parameters.pre_exposure);
+    if ( parameters_to_write.total_exposure == true )
+        append_float("%7.2f ", parameters.total_exposure);
+    if ( parameters_to_write.original_x_position == true )
+        append_float("%8.2f ", parameters.original_x_position);
+    if ( parameters_to_write.original_y_position == true )
+        append_float("%8.2f ", parameters.original_y_position);
+
+    output += "\n";
+}
+
+} // namespace
+
 void cisTEMParameters::WriteTocisTEMStarFile(wxString wanted_filename, int first_line_to_write, int last_line_to_write, int first_image_to_write, int last_image_to_write) {
 
     wxFileName cisTEM_star_filename = wanted_filename;
@@ -1149,7 +1284,6 @@ void cisTEMParameters::WriteTocisTEMStarFile(wxString wanted_filename, int first
         return; // if the user gave us /dev/null, they didn't intend to write anything - let's stop here. This saves trouble later on -some OSes will throw errors when we try to write to /dev/null
 
     //cisTEM_star_filename.SetExt("star");
-    long particle_counter;
 
     FILE* cisTEM_star_file = fopen(cisTEM_star_filename.GetFullPath( ).ToStdString( ).c_str( ), "w");
 
@@ -1179,6 +1313,12 @@ void cisTEMParameters::WriteTocisTEMStarFile(wxString wanted_filename, int first
     if ( last_image_to_write == -1 )
         last_image_to_write = INT_MAX;
 
+    if ( write_statistics_to_file == true ) {
+        cisTEMParameterStatistics written_statistics;
+        written_statistics.Calculate(all_parameters, parameters_to_write.image_is_active, first_image_to_write, last_image_to_write, first_line_to_write, last_line_to_write);
+        fprintf(cisTEM_star_file, "%s\n", written_statistics.ReturnStarFileComment( ).ToStdString( ).c_str( ));
+    }
+
     int column_counter = 1;
 
     // Write headers
@@ -1442,352 +1582,339 @@ void cisTEMParameters::WriteTocisTEMStarFile(wxString wanted_filename, int first
 
     fprintf(cisTEM_star_file, "%s", data_line.ToStdString( ).c_str( ));
 
-    // write the data..
+    // write the data.. the lines are formatted in parallel, a block at a time, and written in order
 
-    for ( particle_counter = first_line_to_write; particle_counter <= last_line_to_write; particle_counter++ ) {
-        if ( all_parameters[particle_counter].position_in_stack < first_image_to_write || all_parameters[particle_counter].position_in_stack > last_image_to_write )
-            continue;
-        data_line = "";
+    long number_of_lines_to_format = last_line_to_write - first_line_to_write + 1;
+    int  number_of_threads         = ReturnAppropriateNumberOfThreads(int(std::min(number_of_lines_to_format / star_file_lines_per_thread + 1, 64L)));
 
-        if ( parameters_to_write.position_in_stack == true )
-            data_line += wxString::Format("%8u ", all_parameters[particle_counter].position_in_stack);
-        if ( parameters_to_write.psi == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].psi);
-        if ( parameters_to_write.theta == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].theta);
-        if ( parameters_to_write.phi == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].phi);
-        if ( parameters_to_write.x_shift == true )
-            data_line += wxString::Format("%9.2f ", all_parameters[particle_counter].x_shift);
-        if ( parameters_to_write.y_shift == true )
-            data_line += wxString::Format("%9.2f ", all_parameters[particle_counter].y_shift);
-        if ( parameters_to_write.defocus_1 == true )
-            data_line += wxString::Format("%8.1f ", all_parameters[particle_counter].defocus_1);
-        if ( parameters_to_write.defocus_2 == true )
-            data_line += wxString::Format("%8.1f ", all_parameters[particle_counter].defocus_2);
-        if ( parameters_to_write.defocus_angle == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].defocus_angle);
-        if ( parameters_to_write.phase_shift == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].phase_shift);
-        if ( parameters_to_write.image_is_active == true )
-            data_line += wxString::Format("%5i ", all_parameters[particle_counter].image_is_active);
-        if ( parameters_to_write.occupancy == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].occupancy);
-        if ( parameters_to_write.logp == true )
-            data_line += wxString::Format("%9i ", myroundint(all_parameters[particle_counter].logp));
-        if ( parameters_to_write.sigma == true )
-            data_line += wxString::Format("%10.4f ", all_parameters[particle_counter].sigma);
-        if ( parameters_to_write.score == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].score);
-        if ( parameters_to_write.score_change == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].score_change);
-        if ( parameters_to_write.pixel_size == true )
-            data_line += wxString::Format("%8.5f ", all_parameters[particle_counter].pixel_size);
-        if ( parameters_to_write.microscope_voltage_kv == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].microscope_voltage_kv);
-        if ( parameters_to_write.microscope_spherical_aberration_mm == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].microscope_spherical_aberration_mm);
-        if ( parameters_to_write.amplitude_contrast == true )
-            data_line += wxString::Format("%7.4f ", all_parameters[particle_counter].amplitude_contrast);
-        if ( parameters_to_write.beam_tilt_x == true )
-            data_line += wxString::Format("%7.3f ", all_parameters[particle_counter].beam_tilt_x);
-        if ( parameters_to_write.beam_tilt_y == true )
-            data_line += wxString::Format("%7.3f ", all_parameters[particle_counter].beam_tilt_y);
-        if ( parameters_to_write.image_shift_x == true )
-            data_line += wxString::Format("%7.3f ", all_parameters[particle_counter].image_shift_x);
-        if ( parameters_to_write.image_shift_y == true )
-            data_line += wxString::Format("%7.3f ", all_parameters[particle_counter].image_shift_y);
-        if ( parameters_to_write.best_2d_class == true )
-            data_line += wxString::Format("%5i ", all_parameters[particle_counter].best_2d_class);
-        if ( parameters_to_write.beam_tilt_group == true )
-            data_line += wxString::Format("%5i ", all_parameters[particle_counter].beam_tilt_group);
-        if ( parameters_to_write.stack_filename == true )
-            data_line += wxString::Format("%50s ", wxString::Format("'%s'", all_parameters[particle_counter].stack_filename));
-        if ( parameters_to_write.original_image_filename == true )
-            data_line += wxString::Format("%50s ", wxString::Format("'%s'", all_parameters[particle_counter].original_image_filename));
-        if ( parameters_to_write.reference_3d_filename == true )
-            data_line += wxString::Format("%50s ", wxString::Format("'%s'", all_parameters[particle_counter].reference_3d_filename));
-        if ( parameters_to_write.particle_group == true )
-            data_line += wxString::Format("%8u ", all_parameters[particle_counter].particle_group);
-        if ( parameters_to_write.assigned_subset == true )
-            data_line += wxString::Format("%8i ", all_parameters[particle_counter].assigned_subset);
-        if ( parameters_to_write.pre_exposure == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].pre_exposure);
-        if ( parameters_to_write.total_exposure == true )
-            data_line += wxString::Format("%7.2f ", all_parameters[particle_counter].total_exposure);
-        if ( parameters_to_write.original_x_position == true )
-            data_line += wxString::Format("%8.2f ", all_parameters[particle_counter].original_x_position);
-        if ( parameters_to_write.original_y_position == true )
-            data_line += wxString::Format("%8.2f ", all_parameters[particle_counter].original_y_position);
+    std::vector<std::string> formatted_parts(number_of_threads);
+
+    for ( long block_start = first_line_to_write; block_start <= last_line_to_write; block_start += number_of_threads * star_file_lines_per_thread ) {
+        long block_end = std::min(block_start + number_of_threads * star_file_lines_per_thread - 1, long(last_line_to_write));
 
-        data_line += "\n";
+#pragma omp parallel for schedule(static, 1) num_threads(number_of_threads)
+        for ( int part_counter = 0; part_counter < number_of_threads; part_counter++ ) {
+            long part_start = block_start + part_counter * star_file_lines_per_thread;
+            long part_end   = std::min(part_start + star_file_lines_per_thread - 1, block_end);
+
+            formatted_parts[part_counter].clear( );
+            for ( long line_counter = part_start; line_counter <= part_end; line_counter++ ) {
+                if ( all_parameters[line_counter].position_in_stack < first_image_to_write || all_parameters[line_counter].position_in_stack > last_image_to_write )
+                    continue;
+                AppendStarFileDataLine(all_parameters[line_counter], parameters_to_write, formatted_parts[part_counter]);
+            }
+        }
 
-        fprintf(cisTEM_star_file, "%s", data_line.ToStdString( ).c_str( ));
+        for ( int part_counter = 0; part_counter < number_of_threads; part_counter++ ) {
+            fwrite(formatted_parts[part_counter].data( ), 1, formatted_parts[part_counter].size( ), cisTEM_star_file);
+        }
     }
 
     fclose(cisTEM_star_file);
 }
 
-cisTEMParameterLine cisTEMParameters::ReturnParameterAverages(bool only_average_active) {
-    cisTEMParameterLine average_values;
-
-    long   average_position_in_stack                  = 0;
-    long   average_image_is_active                    = 0;
-    double average_psi                                = 0.0;
-    double average_theta                              = 0.0;
-    double average_phi                                = 0.0;
-    double average_x_shift                            = 0.0;
-    double average_y_shift                            = 0.0;
-    double average_defocus_1                          = 0.0;
-    double average_defocus_2                          = 0.0;
-    double average_defocus_angle                      = 0.0;
-    double average_phase_shift                        = 0.0;
-    double average_occupancy                          = 0.0;
-    double average_logp                               = 0;
-    double average_sigma                              = 0.0;
-    double average_score                              = 0.0;
-    double average_score_change                       = 0.0;
-    double average_pixel_size                         = 0.0;
-    double average_microscope_voltage_kv              = 0.0;
-    double average_microscope_spherical_aberration_mm = 0.0;
-    double average_amplitude_contrast                 = 0.0;
-    double average_beam_tilt_x                        = 0.0;
-    double average_beam_tilt_y                        = 0.0;
-    double average_image_shift_x                      = 0.0;
-    double average_image_shift_y                      = 0.0;
-
-    long number_summed = 0;
+namespace {
 
-    for ( long counter = 0; counter < all_parameters.GetCount( ); counter++ ) {
-        if ( ReturnImageIsActive(counter) >= 0 || only_average_active == false ) {
-            average_position_in_stack += ReturnPositionInStack(counter);
-            average_image_is_active += ReturnImageIsActive(counter);
-            average_psi += ReturnPsi(counter);
-            average_theta += ReturnTheta(counter);
-            average_phi += ReturnPhi(counter);
-            average_x_shift += ReturnXShift(counter);
-            average_y_shift += ReturnYShift(counter);
-            average_defocus_1 += ReturnDefocus1(counter);
-            average_defocus_2 += ReturnDefocus2(counter);
-            average_defocus_angle += ReturnDefocusAngle(counter);
-            average_phase_shift += ReturnPhaseShift(counter);
-            average_occupancy += ReturnOccupancy(counter);
-            average_logp += ReturnLogP(counter);
-            average_sigma += ReturnSigma(counter);
-            average_score += ReturnScore(counter);
-            average_score_change += ReturnScoreChange(counter);
-            average_pixel_size += ReturnPixelSize(counter);
-            average_microscope_voltage_kv += ReturnMicroscopekV(counter);
-            average_microscope_spherical_aberration_mm += ReturnMicroscopeCs(counter);
-            average_amplitude_contrast += ReturnAmplitudeContrast(counter);
-            average_beam_tilt_x += ReturnBeamTiltX(counter);
-            average_beam_tilt_y += ReturnBeamTiltY(counter);
-            average_image_shift_x += ReturnImageShiftX(counter);
-            average_image_shift_y += ReturnImageShiftY(counter);
-
-            number_summed++;
+// Number of lines reduced by each task of cisTEMParameterStatistics::Calculate and cisTEMParameters::ReturnColumnStatistics
+constexpr long statistics_lines_per_block = 16384;
+
+// The float columns of cisTEMParameterStatistics, after position_in_stack and image_is_active, with their entries in cisTEMParameterMask
+
+struct StatisticsFloatColumn {
+    float cisTEMParameterLine::*value;
+    bool  cisTEMParameterMask::*is_in_mask;
+};
+
+const StatisticsFloatColumn statistics_float_columns[] = {
+        {&cisTEMParameterLine::psi,                                &cisTEMParameterMask::psi},
+        {&cisTEMParameterLine::theta,                              &cisTEMParameterMask::theta},
+        {&cisTEMParameterLine::phi,                                &cisTEMParameterMask::phi},
+        {&cisTEMParameterLine::x_shift,                            &cisTEMParameterMask::x_shift},
+        {&cisTEMParameterLine::y_shift,                            &cisTEMParameterMask::y_shift},
+        {&cisTEMParameterLine::defocus_1,                          &cisTEMParameterMask::defocus_1},
+        {&cisTEMParameterLine::defocus_2,                          &cisTEMParameterMask::defocus_2},
+        {&cisTEMParameterLine::defocus_angle,                      &cisTEMParameterMask::defocus_angle},
+        {&cisTEMParameterLine::phase_shift,                        &cisTEMParameterMask::phase_shift},
+        {&cisTEMParameterLine::occupancy,                          &cisTEMParameterMask::occupancy},
+        {&cisTEMParameterLine::logp,                               &cisTEMParameterMask::logp},
+        {&cisTEMParameterLine::sigma,                              &cisTEMParameterMask::sigma},
+        {&cisTEMParameterLine::score,                              &cisTEMParameterMask::score},
+        {&cisTEMParameterLine::score_change,                       &cisTEMParameterMask::score_change},
+        {&cisTEMParameterLine::pixel_size,                         &cisTEMParameterMask::pixel_size},
+        {&cisTEMParameterLine::microscope_voltage_kv,              &cisTEMParameterMask::microscope_voltage_kv},
+        {&cisTEMParameterLine::microscope_spherical_aberration_mm, &cisTEMParameterMask::microscope_spherical_aberration_mm},
+        {&cisTEMParameterLine::amplitude_contrast,                 &cisTEMParameterMask::amplitude_contrast},
+        {&cisTEMParameterLine::beam_tilt_x,                        &cisTEMParameterMask::beam_tilt_x},
+        {&cisTEMParameterLine::beam_tilt_y,                        &cisTEMParameterMask::beam_tilt_y},
+        {&cisTEMParameterLine::image_shift_x,                      &cisTEMParameterMask::image_shift_x},
+        {&cisTEMParameterLine::image_shift_y,                      &cisTEMParameterMask::image_shift_y}};
+
+constexpr int number_of_statistics_float_columns = sizeof(statistics_float_columns) / sizeof(statistics_float_columns[0]);
+constexpr int number_of_statistics_columns       = number_of_statistics_float_columns + 2;
+
+// Magic and version of the statistics trailer of a binary file, which is followed by the number of lines, the number of columns and
+// then the averages and variances as doubles
+constexpr char statistics_trailer_magic[8]   = "cisTEMS";
+constexpr int  statistics_trailer_version    = 1;
+constexpr long statistics_trailer_size_bytes = 8 + 2 * sizeof(int) + sizeof(long) + 2 * number_of_statistics_columns * sizeof(double);
+
+inline double ReturnStatisticsColumnValue(const cisTEMParameterLine& line, int column) {
+    if ( column == 0 )
+        return double(line.position_in_stack);
+    else if ( column == 1 )
+        return double(line.image_is_active);
+    else
+        return double(line.*statistics_float_columns[column - 2].value);
+}
+
+inline bool StatisticsColumnIsInMask(const cisTEMParameterMask& mask, int column) {
+    if ( column == 0 )
+        return mask.position_in_stack;
+    else if ( column == 1 )
+        return mask.image_is_active;
+    else
+        return mask.*statistics_float_columns[column - 2].is_in_mask;
+}
+
+inline void SetStatisticsColumnValue(cisTEMParameterLine& line, int column, double value) {
+    if ( column == 0 )
+        line.position_in_stack = value;
+    else if ( column == 1 )
+        line.image_is_active = value;
+    else
+        line.*statistics_float_columns[column - 2].value = value;
+}
+
+// Reduce lines first_line to last_line in blocks, in parallel, with add_line(line, statistics) adding a line to the statistics of its
+// block. The blocks are merged in order, so the result does not depend on the number of threads.
+template <int number_of_columns, typename AddLine>
+std::array<cisTEMRunningStatistics, number_of_columns> ReduceLinesInBlocks(const ArrayOfcisTEMParameterLines& lines, long first_line, long last_line, AddLine add_line) {
+    std::array<cisTEMRunningStatistics, number_of_columns> merged_statistics;
+
+    long number_of_lines = last_line - first_line + 1;
+    if ( number_of_lines <= 0 )
+        return merged_statistics;
+
+    long number_of_blocks  = (number_of_lines + statistics_lines_per_block - 1) / statistics_lines_per_block;
+    int  number_of_threads = ReturnAppropriateNumberOfThreads(int(std::min(number_of_blocks, 64L)));
+
+    std::vector<std::array<cisTEMRunningStatistics, number_of_columns>> block_statistics(number_of_blocks);
+
+#pragma omp parallel for schedule(static) num_threads(number_of_threads)
+    for ( long block_counter = 0; block_counter < number_of_blocks; block_counter++ ) {
+        long block_start = first_line + block_counter * statistics_lines_per_block;
+        long block_end   = std::min(block_start + statistics_lines_per_block - 1, last_line);
+
+        for ( long line_counter = block_start; line_counter <= block_end; line_counter++ ) {
+            add_line(lines.Item(line_counter), block_statistics[block_counter]);
+        }
+    }
+
+    for ( long block_counter = 0; block_counter < number_of_blocks; block_counter++ ) {
+        for ( int column_counter = 0; column_counter < number_of_columns; column_counter++ ) {
+            merged_statistics[column_counter].Merge(block_statistics[block_counter][column_counter]);
         }
     }
 
-    if ( number_summed > 0 ) {
-        average_values.position_in_stack                  = average_position_in_stack / double(number_summed);
-        average_values.image_is_active                    = average_image_is_active / double(number_summed);
-        average_values.psi                                = average_psi / double(number_summed);
-        average_values.theta                              = average_theta / double(number_summed);
-        average_values.phi                                = average_phi / double(number_summed);
-        average_values.x_shift                            = average_x_shift / double(number_summed);
-        average_values.y_shift                            = average_y_shift / double(number_summed);
-        average_values.defocus_1                          = average_defocus_1 / double(number_summed);
-        average_values.defocus_2                          = average_defocus_2 / double(number_summed);
-        average_values.defocus_angle                      = average_defocus_angle / double(number_summed);
-        average_values.phase_shift                        = average_phase_shift / double(number_summed);
-        average_values.occupancy                          = average_occupancy / double(number_summed);
-        average_values.logp                               = average_logp / double(number_summed);
-        average_values.sigma                              = average_sigma / double(number_summed);
-        average_values.score                              = average_score / double(number_summed);
-        average_values.score_change                       = average_score_change / double(number_summed);
-        average_values.pixel_size                         = average_pixel_size / double(number_summed);
-        average_values.microscope_voltage_kv              = average_microscope_voltage_kv / double(number_summed);
-        average_values.microscope_spherical_aberration_mm = average_microscope_spherical_aberration_mm / double(number_summed);
-        average_values.amplitude_contrast                 = average_amplitude_contrast / double(number_summed);
-        average_values.beam_tilt_x                        = average_beam_tilt_x / double(number_summed);
-        average_values.beam_tilt_y                        = average_beam_tilt_y / double(number_summed);
-        average_values.image_shift_x                      = average_image_shift_x / double(number_summed);
-        average_values.image_shift_y                      = average_image_shift_y / double(number_summed);
-    }
-
-    return average_values;
+    return merged_statistics;
 }
 
-cisTEMParameterLine cisTEMParameters::ReturnParameterVariances(bool only_average_active) {
+} // namespace
 
-    cisTEMParameterLine average_values;
-    average_values = ReturnParameterAverages(only_average_active);
-
-    cisTEMParameterLine variance_values;
-
-    long   variance_position_in_stack                  = 0;
-    long   variance_image_is_active                    = 0;
-    double variance_psi                                = 0.0;
-    double variance_theta                              = 0.0;
-    double variance_phi                                = 0.0;
-    double variance_x_shift                            = 0.0;
-    double variance_y_shift                            = 0.0;
-    double variance_defocus_1                          = 0.0;
-    double variance_defocus_2                          = 0.0;
-    double variance_defocus_angle                      = 0.0;
-    double variance_phase_shift                        = 0.0;
-    double variance_occupancy                          = 0.0;
-    double variance_logp                               = 0;
-    double variance_sigma                              = 0.0;
-    double variance_score                              = 0.0;
-    double variance_score_change                       = 0.0;
-    double variance_pixel_size                         = 0.0;
-    double variance_microscope_voltage_kv              = 0.0;
-    double variance_microscope_spherical_aberration_mm = 0.0;
-    double variance_amplitude_contrast                 = 0.0;
-    double variance_beam_tilt_x                        = 0.0;
-    double variance_beam_tilt_y                        = 0.0;
-    double variance_image_shift_x                      = 0.0;
-    double variance_image_shift_y                      = 0.0;
-
-    long number_summed = 0;
+cisTEMParameterStatistics::cisTEMParameterStatistics( ) {
+    Clear( );
+}
 
-    for ( long counter = 0; counter < all_parameters.GetCount( ); counter++ ) {
-        if ( ReturnImageIsActive(counter) >= 0 || only_average_active == false ) {
-            variance_position_in_stack += powf(ReturnPositionInStack(counter), 2);
-            variance_image_is_active += powf(ReturnImageIsActive(counter), 2);
-            variance_psi += powf(ReturnPsi(counter), 2);
-            variance_theta += powf(ReturnTheta(counter), 2);
-            variance_phi += powf(ReturnPhi(counter), 2);
-            variance_x_shift += powf(ReturnXShift(counter), 2);
-            variance_y_shift += powf(ReturnYShift(counter), 2);
-            variance_defocus_1 += powf(ReturnDefocus1(counter), 2);
-            variance_defocus_2 += powf(ReturnDefocus2(counter), 2);
-            variance_defocus_angle += powf(ReturnDefocusAngle(counter), 2);
-            variance_phase_shift += powf(ReturnPhaseShift(counter), 2);
-            variance_occupancy += powf(ReturnOccupancy(counter), 2);
-            variance_logp += powf(ReturnLogP(counter), 2);
-            variance_sigma += powf(ReturnSigma(counter), 2);
-            variance_score += powf(ReturnScore(counter), 2);
-            variance_score_change += powf(ReturnScoreChange(counter), 2);
-            variance_pixel_size += powf(ReturnPixelSize(counter), 2);
-            variance_microscope_voltage_kv += powf(ReturnMicroscopekV(counter), 2);
-            variance_microscope_spherical_aberration_mm += powf(ReturnMicroscopeCs(counter), 2);
-            variance_amplitude_contrast += powf(ReturnAmplitudeContrast(counter), 2);
-            variance_beam_tilt_x += powf(ReturnBeamTiltX(counter), 2);
-            variance_beam_tilt_y += powf(ReturnBeamTiltY(counter), 2);
-            variance_image_shift_x += powf(ReturnImageShiftX(counter), 2);
-            variance_image_shift_y += powf(ReturnImageShiftY(counter), 2);
-
-            number_summed++;
+void cisTEMParameterStatistics::Clear( ) {
+    number_of_lines = 0;
+    averages.SetAllToZero( );
+    variances.SetAllToZero( );
+}
+
+void cisTEMParameterStatistics::Calculate(const ArrayOfcisTEMParameterLines& lines, bool only_active, int first_image, int last_image, long first_line, long last_line) {
+    Clear( );
+
+    if ( first_line < 0 )
+        first_line = 0;
+    if ( last_line == -1 || last_line >= long(lines.GetCount( )) )
+        last_line = long(lines.GetCount( )) - 1;
+
+    bool         select_by_position = (first_image != -1 || last_image != -1);
+    unsigned int lowest_position    = (first_image == -1) ? 0 : (unsigned int)(std::max(first_image, 0));
+    unsigned int highest_position   = (last_image == -1) ? UINT_MAX : (unsigned int)(std::max(last_image, 0));
+
+    std::array<cisTEMRunningStatistics, number_of_statistics_columns> column_statistics;
+
+    column_statistics = ReduceLinesInBlocks<number_of_statistics_columns>(lines, first_line, last_line, [&](const cisTEMParameterLine& line, std::array<cisTEMRunningStatistics, number_of_statistics_columns>& statistics) {
+        if ( only_active && line.image_is_active < 0 )
+            return;
+        if ( select_by_position && (line.position_in_stack < lowest_position || line.position_in_stack > highest_position) )
+            return;
+
+        for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+            statistics[column_counter].AddValue(ReturnStatisticsColumnValue(line, column_counter));
         }
+    });
+
+    number_of_lines = column_statistics[0].number_of_values;
+    if ( number_of_lines == 0 )
+        return;
+
+    for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+        SetStatisticsColumnValue(averages, column_counter, column_statistics[column_counter].mean);
+        SetStatisticsColumnValue(variances, column_counter, column_statistics[column_counter].ReturnVariance( ));
+    }
+}
+
+wxString cisTEMParameterStatistics::ReturnStarFileComment( ) const {
+    // %.9g keeps every bit of a float, so a job reading the comment gets the values that were calculated
+    wxString comment = wxString::Format("%s %i %li %i", star_file_comment_prefix, statistics_trailer_version, number_of_lines, number_of_statistics_columns);
+
+    for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+        comment += wxString::Format(" %.9g", ReturnStatisticsColumnValue(averages, column_counter));
     }
 
-    if ( number_summed > 0 ) {
-        variance_values.position_in_stack                  = variance_position_in_stack / double(number_summed);
-        variance_values.image_is_active                    = variance_image_is_active / double(number_summed);
-        variance_values.psi                                = variance_psi / double(number_summed);
-        variance_values.theta                              = variance_theta / double(number_summed);
-        variance_values.phi                                = variance_phi / double(number_summed);
-        variance_values.x_shift                            = variance_x_shift / double(number_summed);
-        variance_values.y_shift                            = variance_y_shift / double(number_summed);
-        variance_values.defocus_1                          = variance_defocus_1 / double(number_summed);
-        variance_values.defocus_2                          = variance_defocus_2 / double(number_summed);
-        variance_values.defocus_angle                      = variance_defocus_angle / double(number_summed);
-        variance_values.phase_shift                        = variance_phase_shift / double(number_summed);
-        variance_values.occupancy                          = variance_occupancy / double(number_summed);
-        variance_values.logp                               = variance_logp / double(number_summed);
-        variance_values.sigma                              = variance_sigma / double(number_summed);
-        variance_values.score                              = variance_score / double(number_summed);
-        variance_values.score_change                       = variance_score_change / double(number_summed);
-        variance_values.pixel_size                         = variance_pixel_size / double(number_summed);
-        variance_values.microscope_voltage_kv              = variance_microscope_voltage_kv / double(number_summed);
-        variance_values.microscope_spherical_aberration_mm = variance_microscope_spherical_aberration_mm / double(number_summed);
-        variance_values.amplitude_contrast                 = variance_amplitude_contrast / double(number_summed);
-        variance_values.beam_tilt_x                        = variance_beam_tilt_x / double(number_summed);
-        variance_values.beam_tilt_y                        = variance_beam_tilt_y / double(number_summed);
-        variance_values.image_shift_x                      = variance_image_shift_x / double(number_summed);
-        variance_values.image_shift_y                      = variance_image_shift_y / double(number_summed);
-    }
-
-    variance_values.position_in_stack -= powf(average_values.position_in_stack, 2);
-    variance_values.image_is_active -= powf(average_values.image_is_active, 2);
-    variance_values.psi -= powf(average_values.psi, 2);
-    variance_values.theta -= powf(average_values.theta, 2);
-    variance_values.phi -= powf(average_values.phi, 2);
-    variance_values.x_shift -= powf(average_values.x_shift, 2);
-    variance_values.y_shift -= powf(average_values.y_shift, 2);
-    variance_values.defocus_1 -= powf(average_values.defocus_1, 2);
-    variance_values.defocus_2 -= powf(average_values.defocus_2, 2);
-    variance_values.defocus_angle -= powf(average_values.defocus_angle, 2);
-    variance_values.phase_shift -= powf(average_values.phase_shift, 2);
-    variance_values.occupancy -= powf(average_values.occupancy, 2);
-    variance_values.logp -= powf(average_values.logp, 2);
-    variance_values.sigma -= powf(average_values.sigma, 2);
-    variance_values.score -= powf(average_values.score, 2);
-    variance_values.score_change -= powf(average_values.score_change, 2);
-    variance_values.pixel_size -= powf(average_values.pixel_size, 2);
-    variance_values.microscope_voltage_kv -= powf(average_values.microscope_voltage_kv, 2);
-    variance_values.microscope_spherical_aberration_mm -= powf(average_values.microscope_spherical_aberration_mm, 2);
-    variance_values.amplitude_contrast -= powf(average_values.amplitude_contrast, 2);
-    variance_values.beam_tilt_x -= powf(average_values.beam_tilt_x, 2);
-    variance_values.beam_tilt_y -= powf(average_values.beam_tilt_y, 2);
-    variance_values.image_shift_x -= powf(average_values.image_shift_x, 2);
-    variance_values.image_shift_y -= powf(average_values.image_shift_y, 2);
-
-    return variance_values;
+    for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+        comment += wxString::Format(" %.9g", ReturnStatisticsColumnValue(variances, column_counter));
+    }
+
+    return comment;
 }
 
-float cisTEMParameters::ReturnAverageSigma(bool exclude_negative_film_numbers) {
-    double sum           = 0;
-    long   number_summed = 0;
+bool cisTEMParameterStatistics::SetFromStarFileComment(const char* line_first, const char* line_last) {
+    long prefix_length = strlen(star_file_comment_prefix);
 
-    for ( long counter = 0; counter < all_parameters.GetCount( ); counter++ ) {
-        if ( ReturnImageIsActive(counter) >= 0 || ! exclude_negative_film_numbers ) {
-            sum += ReturnSigma(counter);
-            number_summed++;
-        }
+    if ( line_last - line_first <= prefix_length || strncmp(line_first, star_file_comment_prefix, prefix_length) != 0 )
+        return false;
+
+    // strtod / strtol stop at the first character that is not part of a number, the line is copied so that it ends there
+    std::string         comment(line_first + prefix_length, line_last);
+    const char*         current_position = comment.c_str( );
+    char*               end_of_value;
+    std::vector<double> values;
+
+    while ( true ) {
+        double value = strtod(current_position, &end_of_value);
+        if ( end_of_value == current_position )
+            break;
+        values.push_back(value);
+        current_position = end_of_value;
     }
 
-    if ( number_summed > 0 )
-        return sum / double(number_summed);
-    else
-        return 0.0;
+    if ( long(values.size( )) != 3 + 2 * number_of_statistics_columns || int(values[0]) != statistics_trailer_version || int(values[2]) != number_of_statistics_columns )
+        return false;
+
+    number_of_lines = long(values[1]);
+
+    for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+        SetStatisticsColumnValue(averages, column_counter, values[3 + column_counter]);
+        SetStatisticsColumnValue(variances, column_counter, values[3 + number_of_statistics_columns + column_counter]);
+    }
+
+    return true;
 }
 
-float cisTEMParameters::ReturnAverageOccupancy(bool exclude_negative_film_numbers) {
-    double sum           = 0;
-    long   number_summed = 0;
+void cisTEMParameterStatistics::WriteToBinaryFile(FILE* binary_file) const {
+    int    version           = statistics_trailer_version;
+    int    number_of_columns = number_of_statistics_columns;
+    double value;
 
-    for ( long counter = 0; counter < all_parameters.GetCount( ); counter++ ) {
-        if ( ReturnImageIsActive(counter) >= 0 || ! exclude_negative_film_numbers ) {
-            sum += ReturnOccupancy(counter);
-            number_summed++;
-        }
+    fwrite(statistics_trailer_magic, sizeof(char), 8, binary_file);
+    fwrite(&version, sizeof(int), 1, binary_file);
+    fwrite(&number_of_columns, sizeof(int), 1, binary_file);
+    fwrite(&number_of_lines, sizeof(long), 1, binary_file);
+
+    for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+        value = ReturnStatisticsColumnValue(averages, column_counter);
+        fwrite(&value, sizeof(double), 1, binary_file);
     }
 
-    if ( number_summed > 0 )
-        return float(sum / double(number_summed));
-    else
-        return 0.0f;
+    for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+        value = ReturnStatisticsColumnValue(variances, column_counter);
+        fwrite(&value, sizeof(double), 1, binary_file);
+    }
 }
 
-float cisTEMParameters::ReturnAverageScore(bool exclude_negative_film_numbers) {
-    double sum           = 0;
-    long   number_summed = 0;
+bool cisTEMParameterStatistics::SetFromBinaryTrailer(const char* trailer, long trailer_size) {
+    int version;
+    int number_of_columns;
 
-    for ( long counter = 0; counter < all_parameters.GetCount( ); counter++ ) {
-        if ( ReturnImageIsActive(counter) >= 0 || ! exclude_negative_film_numbers ) {
-            sum += ReturnScore(counter);
-            number_summed++;
+    if ( trailer_size != statistics_trailer_size_bytes || memcmp(trailer, statistics_trailer_magic, 8) != 0 )
+        return false;
+
+    memcpy(&version, trailer + 8, sizeof(int));
+    memcpy(&number_of_columns, trailer + 8 + sizeof(int), sizeof(int));
+
+    if ( version != statistics_trailer_version || number_of_columns != number_of_statistics_columns )
+        return false;
+
+    memcpy(&number_of_lines, trailer + 8 + 2 * sizeof(int), sizeof(long));
+
+    const char* values = trailer + 8 + 2 * sizeof(int) + sizeof(long);
+    double      value;
+
+    for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+        memcpy(&value, values + column_counter * sizeof(double), sizeof(double));
+        SetStatisticsColumnValue(averages, column_counter, value);
+        memcpy(&value, values + (number_of_statistics_columns + column_counter) * sizeof(double), sizeof(double));
+        SetStatisticsColumnValue(variances, column_counter, value);
+    }
+
+    return true;
+}
+
+void cisTEMParameterStatistics::ReplaceColumnsNotInFile(const cisTEMParameterMask& columns_in_file, const ArrayOfcisTEMParameterLines& lines_read) {
+    // a reader gives every line the same value for a column that is not in the file, whatever the writer had in memory
+    for ( int column_counter = 0; column_counter < number_of_statistics_columns; column_counter++ ) {
+        if ( StatisticsColumnIsInMask(columns_in_file, column_counter) == false ) {
+            SetStatisticsColumnValue(averages, column_counter, (lines_read.GetCount( ) > 0) ? ReturnStatisticsColumnValue(lines_read.Item(0), column_counter) : 0.0);
+            SetStatisticsColumnValue(variances, column_counter, 0.0);
         }
     }
+}
 
-    if ( number_summed > 0 )
-        return sum / double(number_summed);
+cisTEMParameterStatistics cisTEMParameters::ReturnParameterStatistics(bool only_average_active) {
+    cisTEMParameterStatistics parameter_statistics;
+    parameter_statistics.Calculate(all_parameters, only_average_active);
+    return parameter_statistics;
+}
+
+cisTEMParameterStatistics cisTEMParameters::ReturnStoredOrCalculatedParameterStatistics( ) {
+    if ( statistics_were_read == true )
+        return statistics_from_file;
     else
-        return 0.0;
+        return ReturnParameterStatistics(true);
+}
+
+cisTEMRunningStatistics cisTEMParameters::ReturnColumnStatistics(float cisTEMParameterLine::*column, bool only_active) {
+    std::array<cisTEMRunningStatistics, 1> column_statistics;
+
+    column_statistics = ReduceLinesInBlocks<1>(all_parameters, 0, long(all_parameters.GetCount( )) - 1, [&](const cisTEMParameterLine& line, std::array<cisTEMRunningStatistics, 1>& statistics) {
+        if ( line.image_is_active >= 0 || only_active == false )
+            statistics[0].AddValue(line.*column);
+    });
+
+    return column_statistics[0];
+}
+
+cisTEMParameterLine cisTEMParameters::ReturnParameterAverages(bool only_average_active) {
+    return ReturnParameterStatistics(only_average_active).averages;
+}
+
+cisTEMParameterLine cisTEMParameters::ReturnParameterVariances(bool only_average_active) {
+    return ReturnParameterStatistics(only_average_active).variances;
+}
+
+float cisTEMParameters::ReturnAverageSigma(bool exclude_negative_film_numbers) {
+    return ReturnColumnStatistics(&cisTEMParameterLine::sigma, exclude_negative_film_numbers).mean;
+}
+
+float cisTEMParameters::ReturnAverageOccupancy(bool exclude_negative_film_numbers) {
+    return ReturnColumnStatistics(&cisTEMParameterLine::occupancy, exclude_negative_film_numbers).mean;
+}
+
+float cisTEMParameters::ReturnAverageScore(bool exclude_negative_film_numbers) {
+    return ReturnColumnStatistics(&cisTEMParameterLine::score, exclude_negative_film_numbers).mean;
 }
 
 bool cisTEMParameters::ContainsMultipleParticleGroups( ) {
@@ -2051,6 +2178,7 @@ float cisTEMParameters::ReturnScoreThreshold(float wanted_percentage, bool exclu
     float threshold;
     float percentage;
     float min, max;
+    float score;
 
     min = ReturnMinScore(exclude_negative_film_numbers);
     max = ReturnMaxScore(exclude_negative_film_numbers);
@@ -2060,17 +2188,35 @@ float cisTEMParameters::ReturnScoreThreshold(float wanted_percentage, bool exclu
     if ( increment == 0.0 )
         return min;
 
+    // The thresholds fall from max to min, and a line counts at every threshold from the first one its score reaches. Rather than
+    // summing over all lines for every threshold, the occupancy of each line is added to the bin of that first threshold, and the
+    // bins are summed as the thresholds are tried.
+    auto threshold_of_bin = [&](int bin) { return float(bin) * increment + max; };
+
+    std::vector<double> occupancy_in_bin(number_of_bins, 0.0);
+
+    for ( line = 0; line < all_parameters.GetCount( ); line++ ) {
+        if ( ReturnImageIsActive(line) >= 0 || ! exclude_negative_film_numbers ) {
+            score = ReturnScore(line);
+            if ( ! (score >= threshold_of_bin(number_of_bins - 1)) )
+                continue; // below every threshold
+            i = std::max(0, std::min(number_of_bins - 1, int(ceilf((score - max) / increment))));
+            while ( i > 0 && score >= threshold_of_bin(i - 1) )
+                i--;
+            while ( score < threshold_of_bin(i) )
+                i++;
+            occupancy_in_bin[i] += ReturnOccupancy(line);
+        }
+    }
+
+    double sum_of_occupancies = 0.0;
+
     //wxPrintf("min = %f, max = %f, increment = %f\n", min, max, increment);
     for ( i = 0; i < number_of_bins; i++ ) {
-        sum_occ   = 0.0;
-        threshold = float(i) * increment + max;
+        sum_of_occupancies += occupancy_in_bin[i];
+        sum_occ   = sum_of_occupancies;
+        threshold = threshold_of_bin(i);
 
-        for ( line = 0; line < all_parameters.GetCount( ); line++ ) {
-            if ( ReturnImageIsActive(line) >= 0 || ! exclude_negative_film_numbers ) {
-                if ( ReturnScore(line) >= threshold )
-                    sum_occ += ReturnOccupancy(line);
-            }
-        }
         percentage = sum_occ / all_parameters.GetCount( ) / average_occ;
 
         //	wxPrintf("sum_occ = %f : threshold = %f\n", sum_occ, threshold);
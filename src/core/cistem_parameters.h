@@ -140,6 +140,81 @@ class cisTEMParameterMask {
 
 WX_DECLARE_OBJARRAY(cisTEMParameterLine, ArrayOfcisTEMParameterLines);
 
+// Count, mean and sum of squared deviations from the mean of a set of values, updated one value at a time (Welford). Two of them
+// can be merged (Chan et al.), so a long set can be reduced in blocks on several threads, and merging the blocks in order gives the
+// same result whatever the number of threads.
+class cisTEMRunningStatistics {
+
+  public:
+    long   number_of_values;
+    double mean;
+    double sum_of_squared_deviations;
+
+    cisTEMRunningStatistics( ) { Reset( ); }
+
+    inline void Reset( ) {
+        number_of_values          = 0;
+        mean                      = 0.0;
+        sum_of_squared_deviations = 0.0;
+    }
+
+    inline void AddValue(double value) {
+        number_of_values++;
+        double delta = value - mean;
+        mean += delta / double(number_of_values);
+        sum_of_squared_deviations += delta * (value - mean);
+    }
+
+    inline void Merge(const cisTEMRunningStatistics& other) {
+        if ( other.number_of_values == 0 )
+            return;
+        if ( number_of_values == 0 ) {
+            *this = other;
+            return;
+        }
+
+        long   merged_number_of_values = number_of_values + other.number_of_values;
+        double delta                   = other.mean - mean;
+
+        mean += delta * double(other.number_of_values) / double(merged_number_of_values);
+        sum_of_squared_deviations += other.sum_of_squared_deviations + delta * delta * double(number_of_values) * double(other.number_of_values) / double(merged_number_of_values);
+        number_of_values = merged_number_of_values;
+    }
+
+    // the population variance, as cisTEMParameters::ReturnParameterVariances( ) has always returned
+    inline double ReturnVariance( ) const { return (number_of_values > 0) ? sum_of_squared_deviations / double(number_of_values) : 0.0; }
+};
+
+// Averages and variances of the numeric columns of a set of parameter lines, the columns of cisTEMParameters::ReturnParameterAverages( ).
+// With cisTEMParameters::write_statistics_to_file set, the statistics of the active lines that are written are stored in the file, as a
+// comment line before the data block of a star file and after the last line of a binary file, where earlier readers do not look.
+// They are calculated from the values in memory, before a star file rounds them to the precision of its columns.
+class cisTEMParameterStatistics {
+
+  public:
+    long                number_of_lines; // number of lines that went into the statistics
+    cisTEMParameterLine averages;
+    cisTEMParameterLine variances;
+
+    static constexpr const char* star_file_comment_prefix = "# cisTEM parameter statistics";
+
+    cisTEMParameterStatistics( );
+
+    void Clear( );
+
+    // Statistics over lines first_line to last_line (-1 for the last line), skipping inactive lines when only_active is true, and lines
+    // outside first_image <= position_in_stack <= last_image when either of those is set (-1 for no limit). Blocks of lines are reduced in parallel.
+    void Calculate(const ArrayOfcisTEMParameterLines& lines, bool only_active = true, int first_image = -1, int last_image = -1, long first_line = 0, long last_line = -1);
+
+    wxString ReturnStarFileComment( ) const;
+    bool     SetFromStarFileComment(const char* line_first, const char* line_last);
+    void     WriteToBinaryFile(FILE* binary_file) const;
+    bool     SetFromBinaryTrailer(const char* trailer, long trailer_size);
+
+    // Columns that were not written take the value the reader gave every line
+    void ReplaceColumnsNotInFile(const cisTEMParameterMask& columns_in_file, const ArrayOfcisTEMParameterLines& lines_read);
+};
+
 class cisTEMParameters {
 
   public:
@@ -149,6 +224,10 @@ class cisTEMParameters {
     cisTEMParameterMask parameters_to_write;
     cisTEMParameterMask parameters_that_were_read;
 
+    bool                      write_statistics_to_file; // the writers store the statistics of the active lines they write, off by default
+    bool                      statistics_were_read; // the file that was read had stored statistics, they are in statistics_from_file
+    cisTEMParameterStatistics statistics_from_file;
+
     // for defocus dependance
 
     float average_defocus;
@@ -160,6 +239,7 @@ class cisTEMParameters {
 
     void ReadFromcisTEMStarFile(wxString wanted_filename, bool exclude_negative_film_numbers = false);
     void ReadFromcisTEMBinaryFile(wxString wanted_filename, bool exclude_negative_film_numbers = false);
+    void ReadFromcisTEMColumnarFile(wxString wanted_filename, bool exclude_negative_film_numbers = false, int first_image_to_read = -1, int last_image_to_read = -1);
 
     void ReadFromFrealignParFile(wxString wanted_filename,
                                  float    wanted_pixel_size         = 0.0f,
@@ -177,6 +257,7 @@ class cisTEMParameters {
     int  ReturnNumberOfParametersToWrite( );
     int  ReturnNumberOfLinesToWrite(int first_image_to_write, int last_image_to_write);
     void WriteTocisTEMBinaryFile(wxString wanted_filename, int first_image_to_write = -1, int last_image_to_write = -1);
+    void WriteTocisTEMColumnarFile(wxString wanted_filename, int first_image_to_write = -1, int last_image_to_write = -1);
 
     void AddCommentToHeader(wxString comment_to_add);
     void WriteTocisTEMStarFile(wxString wanted_filename, int first_line_to_write = -1, int last_line_to_write = -1, int first_image_to_write = -1, int last_image_to_write = -1);
@@ -283,4 +364,14 @@ class cisTEMParameters {
 
     cisTEMParameterLine ReturnParameterAverages(bool only_average_active = true);
     cisTEMParameterLine ReturnParameterVariances(bool only_average_active = true);
+
+    // Averages and variances in one parallel pass over the lines
+    cisTEMParameterStatistics ReturnParameterStatistics(bool only_average_active = true);
+
+    // The statistics of the active lines as stored in the file that was read, if it had them, otherwise calculated. Meant for jobs
+    // that read a file written for them and do not change the lines before asking.
+    cisTEMParameterStatistics ReturnStoredOrCalculatedParameterStatistics( );
+
+  private:
+    cisTEMRunningStatistics ReturnColumnStatistics(float cisTEMParameterLine::*column, bool only_active);
 };
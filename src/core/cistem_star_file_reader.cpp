@@ -1,5 +1,11 @@
 #include "core_headers.h"
 
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 using c_ft = cistem::fundamental_type::Enum;
 
 //TODO : Currently, any strings with spaces will cause the star file (but not binary) reader to break - needs to be fixed.
@@ -8,6 +14,148 @@ using c_ft = cistem::fundamental_type::Enum;
 // ----------------------
 // See top of cistem_parameters.cpp for documentation describing how to add a new column
 
+namespace {
+
+// The data lines of a mapped star file are split into chunks of about this many bytes, which are parsed in parallel
+constexpr long star_file_bytes_per_chunk = 1024 * 1024;
+
+// The characters wxString::Trim( ) removes
+inline bool IsStarFileWhitespace(char character) {
+    return character == ' ' || character == '\t' || character == '\r' || character == '\n' || character == '\v' || character == '\f';
+}
+
+// Returns the next line of the buffer as [line_first, line_last), trimmed as ReadTextFile trims its lines, and false at the end of the buffer
+bool ReturnNextTrimmedLine(const char*& current_position, const char* end_of_buffer, const char*& line_first, const char*& line_last) {
+    if ( current_position >= end_of_buffer )
+        return false;
+
+    const char* line_end = static_cast<const char*>(memchr(current_position, '\n', end_of_buffer - current_position));
+    if ( line_end == NULL )
+        line_end = end_of_buffer;
+
+    line_first = current_position;
+    line_last  = line_end;
+    while ( line_first < line_last && IsStarFileWhitespace(*line_first) )
+        line_first++;
+    while ( line_last > line_first && IsStarFileWhitespace(*(line_last - 1)) )
+        line_last--;
+
+    current_position = (line_end < end_of_buffer) ? line_end + 1 : end_of_buffer;
+    return true;
+}
+
+inline bool LineContains(const char* line_first, const char* line_last, const char* wanted_text) {
+    return std::search(line_first, line_last, wanted_text, wanted_text + strlen(wanted_text)) != line_last;
+}
+
+// Splits on the delimiters wxStringTokenizer uses by default
+void SplitLineIntoTokens(const char* line_first, const char* line_last, std::vector<std::pair<const char*, const char*>>& tokens) {
+    tokens.clear( );
+
+    const char* current_position = line_first;
+    while ( current_position < line_last ) {
+        while ( current_position < line_last && (*current_position == ' ' || *current_position == '\t' || *current_position == '\r') )
+            current_position++;
+        if ( current_position == line_last )
+            break;
+
+        const char* token_first = current_position;
+        while ( current_position < line_last && *current_position != ' ' && *current_position != '\t' && *current_position != '\r' )
+            current_position++;
+        tokens.push_back(std::make_pair(token_first, current_position));
+    }
+}
+
+// UTF-8, falling back to Latin-1 as wxConvAuto (used by wxTextFile) does
+wxString TokenToString(const char* token_first, const char* token_last) {
+    wxString converted_string(token_first, wxConvUTF8, token_last - token_first);
+    if ( converted_string.IsEmpty( ) == true && token_last > token_first )
+        converted_string = wxString(token_first, wxConvISO8859_1, token_last - token_first);
+    return converted_string;
+}
+
+// As wxString::ToDouble( ) - the whole token has to be a number that is in range
+bool TokenToDouble(const char* token_first, const char* token_last, double& value) {
+    char        short_buffer[64];
+    std::string long_buffer;
+    const char* null_terminated_token;
+    long        token_length = token_last - token_first;
+
+    if ( token_length == 0 )
+        return false;
+
+    if ( token_length < long(sizeof(short_buffer)) ) {
+        memcpy(short_buffer, token_first, token_length);
+        short_buffer[token_length] = 0;
+        null_terminated_token      = short_buffer;
+    }
+    else {
+        long_buffer.assign(token_first, token_length);
+        null_terminated_token = long_buffer.c_str( );
+    }
+
+    char* end_of_number;
+    errno = 0;
+    value = strtod(null_terminated_token, &end_of_number);
+    return end_of_number == null_terminated_token + token_length && errno != ERANGE;
+}
+
+// As wxString::ToLong( )
+bool TokenToLong(const char* token_first, const char* token_last, long& value) {
+    char        short_buffer[64];
+    std::string long_buffer;
+    const char* null_terminated_token;
+    long        token_length = token_last - token_first;
+
+    if ( token_length == 0 )
+        return false;
+
+    if ( token_length < long(sizeof(short_buffer)) ) {
+        memcpy(short_buffer, token_first, token_length);
+        short_buffer[token_length] = 0;
+        null_terminated_token      = short_buffer;
+    }
+    else {
+        long_buffer.assign(token_first, token_length);
+        null_terminated_token = long_buffer.c_str( );
+    }
+
+    char* end_of_number;
+    errno = 0;
+    value = strtol(null_terminated_token, &end_of_number, 10);
+    return end_of_number == null_terminated_token + token_length && errno != ERANGE;
+}
+
+// True if a \r is not followed by a \n
+bool BufferHasLoneCarriageReturns(const char* first_character, const char* end_of_buffer) {
+    const char* current_position = first_character;
+    while ( current_position < end_of_buffer ) {
+        current_position = static_cast<const char*>(memchr(current_position, '\r', end_of_buffer - current_position));
+        if ( current_position == NULL )
+            return false;
+        if ( current_position + 1 == end_of_buffer || *(current_position + 1) != '\n' )
+            return true;
+        current_position += 2;
+    }
+    return false;
+}
+
+bool FileCanBeMemoryMapped(const wxString& wanted_filename) {
+    struct stat file_status;
+    return stat(wanted_filename.ToStdString( ).c_str( ), &file_status) == 0 && S_ISREG(file_status.st_mode) && file_status.st_size > 0;
+}
+
+struct StarFileChunk {
+    const char*                      first_character;
+    const char*                      last_character; // one past the end, always just after a line break or at the end of the file
+    std::vector<cisTEMParameterLine> parameter_lines;
+    bool                             reached_end_of_data; // a blank line ends the data block, as in ReadTextFile
+    bool                             failed;
+    wxString                         error_message;
+};
+
+} // namespace
+
 cisTEMStarFileReader::cisTEMStarFileReader( ) {
     Reset( );
 }
@@ -42,6 +190,7 @@ void cisTEMStarFileReader::Reset( ) {
     ResetColumnPositions( );
 
     parameters_that_were_read.SetAllToFalse( );
+    statistics_were_read = false;
 }
 
 void cisTEMStarFileReader::ResetColumnPositions( ) {
@@ -148,7 +297,8 @@ void cisTEMStarFileReader::Close( ) {
         binary_file_size        = -1;
     }
 
-    binary_file_size = 0;
+    binary_file_size     = 0;
+    statistics_were_read = false;
 }
 
 bool cisTEMStarFileReader::ExtractParametersFromLine(wxString& wanted_line, wxString* error_string, bool exclude_negative_film_numbers) {
@@ -681,7 +831,232 @@ bool cisTEMStarFileReader::ExtractParametersFromLine(wxString& wanted_line, wxSt
     return true;
 }
 
+void cisTEMStarFileReader::SetColumnFromHeaderLabel(wxString& current_line) {
+    // Is it a label we want? Either way, it takes up a column.
+
+    if ( current_line.StartsWith("_cisTEMPositionInStack ") == true ) {
+        if ( position_in_stack_column != -1 )
+            wxPrintf("Warning :: _cisTEMPositionInStack occurs more than once. I will take the last occurrence\n");
+        position_in_stack_column                    = current_column;
+        parameters_that_were_read.position_in_stack = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMAnglePsi ") == true ) {
+        if ( psi_column != -1 )
+            wxPrintf("Warning :: _cisTEMAnglePsi occurs more than once. I will take the last occurrence\n");
+        psi_column                    = current_column;
+        parameters_that_were_read.psi = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMAngleTheta ") == true ) {
+        if ( theta_column != -1 )
+            wxPrintf("Warning :: _cisTEMAngleTheta occurs more than once. I will take the last occurrence\n");
+        theta_column                    = current_column;
+        parameters_that_were_read.theta = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMAnglePhi ") == true ) {
+        if ( phi_column != -1 )
+            wxPrintf("Warning :: _cisTEMAnglePhi occurs more than once. I will take the last occurrence\n");
+        phi_column                    = current_column;
+        parameters_that_were_read.phi = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMXShift ") == true ) {
+        if ( x_shift_column != -1 )
+            wxPrintf("Warning :: _cisTEMXShift occurs more than once. I will take the last occurrence\n");
+        x_shift_column                    = current_column;
+        parameters_that_were_read.x_shift = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMYShift ") == true ) {
+        if ( y_shift_column != -1 )
+            wxPrintf("Warning :: _cisTEMYShift occurs more than once. I will take the last occurrence\n");
+        y_shift_column                    = current_column;
+        parameters_that_were_read.y_shift = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMDefocus1 ") == true ) {
+        if ( defocus_1_column != -1 )
+            wxPrintf("Warning :: _cisTEMDefocus1 occurs more than once. I will take the last occurrence\n");
+        defocus_1_column                    = current_column;
+        parameters_that_were_read.defocus_1 = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMDefocus2 ") == true ) {
+        if ( defocus_2_column != -1 )
+            wxPrintf("Warning :: _cisTEMDefocus2 occurs more than once. I will take the last occurrence\n");
+        defocus_2_column                    = current_column;
+        parameters_that_were_read.defocus_2 = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMDefocusAngle ") == true ) {
+        if ( defocus_angle_column != -1 )
+            wxPrintf("Warning :: _cisTEMDefocusAngle occurs more than once. I will take the last occurrence\n");
+        defocus_angle_column                    = current_column;
+        parameters_that_were_read.defocus_angle = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMPhaseShift ") == true ) {
+        if ( phase_shift_column != -1 )
+            wxPrintf("Warning :: _cisTEMPhaseShift occurs more than once. I will take the last occurrence\n");
+        phase_shift_column                    = current_column;
+        parameters_that_were_read.phase_shift = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMImageActivity ") == true ) {
+        if ( image_is_active_column != -1 )
+            wxPrintf("Warning :: _cisTEMImageActivity occurs more than once. I will take the last occurrence\n");
+        image_is_active_column                    = current_column;
+        parameters_that_were_read.image_is_active = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMOccupancy ") == true ) {
+        if ( occupancy_column != -1 )
+            wxPrintf("Warning :: _cisTEMOccupancy occurs more than once. I will take the last occurrence\n");
+        occupancy_column                    = current_column;
+        parameters_that_were_read.occupancy = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMLogP ") == true ) {
+        if ( logp_column != -1 )
+            wxPrintf("Warning :: _cisTEMLogP occurs more than once. I will take the last occurrence\n");
+        logp_column                    = current_column;
+        parameters_that_were_read.logp = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMSigma ") == true ) {
+        if ( sigma_column != -1 )
+            wxPrintf("Warning :: _cisTEMSigma occurs more than once. I will take the last occurrence\n");
+        sigma_column                    = current_column;
+        parameters_that_were_read.sigma = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMScore ") == true ) {
+        if ( score_column != -1 )
+            wxPrintf("Warning :: _cisTEMScore occurs more than once. I will take the last occurrence\n");
+        score_column                    = current_column;
+        parameters_that_were_read.score = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMScoreChange ") == true ) {
+        if ( score_change_column != -1 )
+            wxPrintf("Warning :: _cisTEMScoreChange occurs more than once. I will take the last occurrence\n");
+        score_change_column                    = current_column;
+        parameters_that_were_read.score_change = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMPixelSize ") == true ) {
+        if ( pixel_size_column != -1 )
+            wxPrintf("Warning :: _cisTEMPixelSize occurs more than once. I will take the last occurrence\n");
+        pixel_size_column                    = current_column;
+        parameters_that_were_read.pixel_size = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMMicroscopeVoltagekV ") == true ) {
+        if ( microscope_voltage_kv_column != -1 )
+            wxPrintf("Warning :: _cisTEMMicroscopeVoltagekV occurs more than once. I will take the last occurrence\n");
+        microscope_voltage_kv_column                    = current_column;
+        parameters_that_were_read.microscope_voltage_kv = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMMicroscopeCsMM ") == true ) {
+        if ( microscope_spherical_aberration_mm_column != -1 )
+            wxPrintf("Warning :: _cisTEMMicroscopeCsMM occurs more than once. I will take the last occurrence\n");
+        microscope_spherical_aberration_mm_column                    = current_column;
+        parameters_that_were_read.microscope_spherical_aberration_mm = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMAmplitudeContrast ") == true ) {
+        if ( amplitude_contrast_column != -1 )
+            wxPrintf("Warning :: _cisTEMAmplitudeContrast occurs more than once. I will take the last occurrence\n");
+        amplitude_contrast_column                    = current_column;
+        parameters_that_were_read.amplitude_contrast = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMBeamTiltX ") == true ) {
+        if ( beam_tilt_x_column != -1 )
+            wxPrintf("Warning :: _cisTEMBeamTiltX occurs more than once. I will take the last occurrence\n");
+        beam_tilt_x_column                    = current_column;
+        parameters_that_were_read.beam_tilt_x = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMBeamTiltY ") == true ) {
+        if ( beam_tilt_y_column != -1 )
+            wxPrintf("Warning :: _cisTEMBeamTiltY occurs more than once. I will take the last occurrence\n");
+        beam_tilt_y_column                    = current_column;
+        parameters_that_were_read.beam_tilt_y = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMImageShiftX ") == true ) {
+        if ( image_shift_x_column != -1 )
+            wxPrintf("Warning :: _cisTEMImageShiftX occurs more than once. I will take the last occurrence\n");
+        image_shift_x_column                    = current_column;
+        parameters_that_were_read.image_shift_x = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMImageShiftY ") == true ) {
+        if ( image_shift_y_column != -1 )
+            wxPrintf("Warning :: _cisTEMImageShiftY occurs more than once. I will take the last occurrence\n");
+        image_shift_y_column                    = current_column;
+        parameters_that_were_read.image_shift_y = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMBest2DClass ") == true ) {
+        if ( best_2d_class_column != -1 )
+            wxPrintf("Warning :: _cisTEMBest2DClass occurs more than once. I will take the last occurrence\n");
+        best_2d_class_column                    = current_column;
+        parameters_that_were_read.best_2d_class = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMBeamTiltGroup ") == true ) {
+        if ( beam_tilt_group_column != -1 )
+            wxPrintf("Warning :: _cisTEMBeamTiltGroup occurs more than once. I will take the last occurrence\n");
+        beam_tilt_group_column                    = current_column;
+        parameters_that_were_read.beam_tilt_group = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMParticleGroup ") == true ) {
+        if ( particle_group_column != -1 )
+            wxPrintf("Warning :: _cisTEMParticleGroup occurs more than once. I will take the last occurrence\n");
+        particle_group_column                    = current_column;
+        parameters_that_were_read.particle_group = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMAssignedSubset ") == true ) {
+        if ( assigned_subset_column != -1 )
+            wxPrintf("Warning :: _cisTEMAssignedSubset occurs more than once. I will take the last occurrence\n");
+        assigned_subset_column                    = current_column;
+        parameters_that_were_read.assigned_subset = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMPreExposure ") == true ) {
+        if ( pre_exposure_column != -1 )
+            wxPrintf("Warning :: _cisTEMPreExposure occurs more than once. I will take the last occurrence\n");
+        pre_exposure_column                    = current_column;
+        parameters_that_were_read.pre_exposure = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMTotalExposure ") == true ) {
+        if ( total_exposure_column != -1 )
+            wxPrintf("Warning :: _cisTEMTotalExposure occurs more than once. I will take the last occurrence\n");
+        total_exposure_column                    = current_column;
+        parameters_that_were_read.total_exposure = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMOriginalXPosition") == true ) {
+        if ( original_x_position_column != -1 )
+            wxPrintf("Warning :: _cisTEMOriginalXPosition occurs more than once. I will take the last occurrence\n");
+        original_x_position_column                    = current_column;
+        parameters_that_were_read.original_x_position = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMOriginalYPosition") == true ) {
+        if ( original_y_position_column != -1 )
+            wxPrintf("Warning :: _cisTEMOriginalYPosition occurs more than once. I will take the last occurrence\n");
+        original_y_position_column                    = current_column;
+        parameters_that_were_read.original_y_position = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMReference3DFilename ") == true ) {
+        if ( reference_3d_filename_column != -1 )
+            wxPrintf("Warning :: _cisTEMReference3DFilename occurs more than once. I will take the last occurrence\n");
+        reference_3d_filename_column                    = current_column;
+        parameters_that_were_read.reference_3d_filename = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMOriginalImageFilename ") == true ) {
+        if ( original_image_filename_column != -1 )
+            wxPrintf("Warning :: _cisTEMOriginalImageFilename occurs more than once. I will take the last occurrence\n");
+        original_image_filename_column                    = current_column;
+        parameters_that_were_read.original_image_filename = true;
+    }
+    else if ( current_line.StartsWith("_cisTEMStackFilename ") == true ) {
+        if ( stack_filename_column != -1 )
+            wxPrintf("Warning :: _cisTEMStackFilename occurs more than once. I will take the last occurrence\n");
+        stack_filename_column                    = current_column;
+        parameters_that_were_read.stack_filename = true;
+    }
+
+    current_column++;
+}
+
 bool cisTEMStarFileReader::ReadTextFile(wxString wanted_filename, wxString* error_string, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer, bool exclude_negative_film_numbers) {
+    // Regular files are memory mapped and their data lines parsed in parallel, anything else (a pipe, say) is read line by line here
+    if ( FileCanBeMemoryMapped(wanted_filename) == true )
+        return ReadMappedTextFile(wanted_filename, error_string, alternate_cached_parameters_pointer, exclude_negative_film_numbers);
+    else
+        return ReadTextFileLineByLine(wanted_filename, error_string, alternate_cached_parameters_pointer, exclude_negative_film_numbers);
+}
+
+bool cisTEMStarFileReader::ReadTextFileLineByLine(wxString wanted_filename, wxString* error_string, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer, bool exclude_negative_film_numbers) {
     Open(wanted_filename, alternate_cached_parameters_pointer);
     wxString current_line;
 
@@ -700,6 +1075,11 @@ bool cisTEMStarFileReader::ReadTextFile(wxString wanted_filename, wxString* erro
         current_line = input_text_file->GetNextLine( );
         current_line = current_line.Trim(true);
         current_line = current_line.Trim(false);
+        if ( current_line.StartsWith(cisTEMParameterStatistics::star_file_comment_prefix) == true ) {
+            std::string comment  = current_line.ToStdString( );
+            statistics_were_read = statistics_from_file.SetFromStarFileComment(comment.c_str( ), comment.c_str( ) + comment.length( ));
+            continue;
+        }
         if ( current_line.Find("data_") != wxNOT_FOUND ) {
             found_valid_data_block = true;
             break;
@@ -754,218 +1134,7 @@ bool cisTEMStarFileReader::ReadTextFile(wxString wanted_filename, wxString* erro
 
         // otherwise it is a label, is it a label we want though?
 
-        if ( current_line.StartsWith("_cisTEMPositionInStack ") == true ) {
-            if ( position_in_stack_column != -1 )
-                wxPrintf("Warning :: _cisTEMPositionInStack occurs more than once. I will take the last occurrence\n");
-            position_in_stack_column                    = current_column;
-            parameters_that_were_read.position_in_stack = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMAnglePsi ") == true ) {
-            if ( psi_column != -1 )
-                wxPrintf("Warning :: _cisTEMAnglePsi occurs more than once. I will take the last occurrence\n");
-            psi_column                    = current_column;
-            parameters_that_were_read.psi = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMAngleTheta ") == true ) {
-            if ( theta_column != -1 )
-                wxPrintf("Warning :: _cisTEMAngleTheta occurs more than once. I will take the last occurrence\n");
-            theta_column                    = current_column;
-            parameters_that_were_read.theta = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMAnglePhi ") == true ) {
-            if ( phi_column != -1 )
-                wxPrintf("Warning :: _cisTEMAnglePhi occurs more than once. I will take the last occurrence\n");
-            phi_column                    = current_column;
-            parameters_that_were_read.phi = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMXShift ") == true ) {
-            if ( x_shift_column != -1 )
-                wxPrintf("Warning :: _cisTEMXShift occurs more than once. I will take the last occurrence\n");
-            x_shift_column                    = current_column;
-            parameters_that_were_read.x_shift = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMYShift ") == true ) {
-            if ( y_shift_column != -1 )
-                wxPrintf("Warning :: _cisTEMYShift occurs more than once. I will take the last occurrence\n");
-            y_shift_column                    = current_column;
-            parameters_that_were_read.y_shift = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMDefocus1 ") == true ) {
-            if ( defocus_1_column != -1 )
-                wxPrintf("Warning :: _cisTEMDefocus1 occurs more than once. I will take the last occurrence\n");
-            defocus_1_column                    = current_column;
-            parameters_that_were_read.defocus_1 = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMDefocus2 ") == true ) {
-            if ( defocus_2_column != -1 )
-                wxPrintf("Warning :: _cisTEMDefocus2 occurs more than once. I will take the last occurrence\n");
-            defocus_2_column                    = current_column;
-            parameters_that_were_read.defocus_2 = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMDefocusAngle ") == true ) {
-            if ( defocus_angle_column != -1 )
-                wxPrintf("Warning :: _cisTEMDefocusAngle occurs more than once. I will take the last occurrence\n");
-            defocus_angle_column                    = current_column;
-            parameters_that_were_read.defocus_angle = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMPhaseShift ") == true ) {
-            if ( phase_shift_column != -1 )
-                wxPrintf("Warning :: _cisTEMPhaseShift occurs more than once. I will take the last occurrence\n");
-            phase_shift_column                    = current_column;
-            parameters_that_were_read.phase_shift = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMImageActivity ") == true ) {
-            if ( image_is_active_column != -1 )
-                wxPrintf("Warning :: _cisTEMImageActivity occurs more than once. I will take the last occurrence\n");
-            image_is_active_column                    = current_column;
-            parameters_that_were_read.image_is_active = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMOccupancy ") == true ) {
-            if ( occupancy_column != -1 )
-                wxPrintf("Warning :: _cisTEMOccupancy occurs more than once. I will take the last occurrence\n");
-            occupancy_column                    = current_column;
-            parameters_that_were_read.occupancy = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMLogP ") == true ) {
-            if ( logp_column != -1 )
-                wxPrintf("Warning :: _cisTEMLogP occurs more than once. I will take the last occurrence\n");
-            logp_column                    = current_column;
-            parameters_that_were_read.logp = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMSigma ") == true ) {
-            if ( sigma_column != -1 )
-                wxPrintf("Warning :: _cisTEMSigma occurs more than once. I will take the last occurrence\n");
-            sigma_column                    = current_column;
-            parameters_that_were_read.sigma = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMScore ") == true ) {
-            if ( score_column != -1 )
-                wxPrintf("Warning :: _cisTEMScore occurs more than once. I will take the last occurrence\n");
-            score_column                    = current_column;
-            parameters_that_were_read.score = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMScoreChange ") == true ) {
-            if ( score_change_column != -1 )
-                wxPrintf("Warning :: _cisTEMScoreChange occurs more than once. I will take the last occurrence\n");
-            score_change_column                    = current_column;
-            parameters_that_were_read.score_change = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMPixelSize ") == true ) {
-            if ( pixel_size_column != -1 )
-                wxPrintf("Warning :: _cisTEMPixelSize occurs more than once. I will take the last occurrence\n");
-            pixel_size_column                    = current_column;
-            parameters_that_were_read.pixel_size = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMMicroscopeVoltagekV ") == true ) {
-            if ( microscope_voltage_kv_column != -1 )
-                wxPrintf("Warning :: _cisTEMMicroscopeVoltagekV occurs more than once. I will take the last occurrence\n");
-            microscope_voltage_kv_column                    = current_column;
-            parameters_that_were_read.microscope_voltage_kv = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMMicroscopeCsMM ") == true ) {
-            if ( microscope_spherical_aberration_mm_column != -1 )
-                wxPrintf("Warning :: _cisTEMMicroscopeCsMM occurs more than once. I will take the last occurrence\n");
-            microscope_spherical_aberration_mm_column                    = current_column;
-            parameters_that_were_read.microscope_spherical_aberration_mm = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMAmplitudeContrast ") == true ) {
-            if ( amplitude_contrast_column != -1 )
-                wxPrintf("Warning :: _cisTEMAmplitudeContrast occurs more than once. I will take the last occurrence\n");
-            amplitude_contrast_column                    = current_column;
-            parameters_that_were_read.amplitude_contrast = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMBeamTiltX ") == true ) {
-            if ( beam_tilt_x_column != -1 )
-                wxPrintf("Warning :: _cisTEMBeamTiltX occurs more than once. I will take the last occurrence\n");
-            beam_tilt_x_column                    = current_column;
-            parameters_that_were_read.beam_tilt_x = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMBeamTiltY ") == true ) {
-            if ( beam_tilt_y_column != -1 )
-                wxPrintf("Warning :: _cisTEMBeamTiltY occurs more than once. I will take the last occurrence\n");
-            beam_tilt_y_column                    = current_column;
-            parameters_that_were_read.beam_tilt_y = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMImageShiftX ") == true ) {
-            if ( image_shift_x_column != -1 )
-                wxPrintf("Warning :: _cisTEMImageShiftX occurs more than once. I will take the last occurrence\n");
-            image_shift_x_column                    = current_column;
-            parameters_that_were_read.image_shift_x = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMImageShiftY ") == true ) {
-            if ( image_shift_y_column != -1 )
-                wxPrintf("Warning :: _cisTEMImageShiftY occurs more than once. I will take the last occurrence\n");
-            image_shift_y_column                    = current_column;
-            parameters_that_were_read.image_shift_y = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMBest2DClass ") == true ) {
-            if ( best_2d_class_column != -1 )
-                wxPrintf("Warning :: _cisTEMBest2DClass occurs more than once. I will take the last occurrence\n");
-            best_2d_class_column                    = current_column;
-            parameters_that_were_read.best_2d_class = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMBeamTiltGroup ") == true ) {
-            if ( beam_tilt_group_column != -1 )
-                wxPrintf("Warning :: _cisTEMBeamTiltGroup occurs more than once. I will take the last occurrence\n");
-            beam_tilt_group_column                    = current_column;
-            parameters_that_were_read.beam_tilt_group = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMParticleGroup ") == true ) {
-            if ( particle_group_column != -1 )
-                wxPrintf("Warning :: _cisTEMParticleGroup occurs more than once. I will take the last occurrence\n");
-            particle_group_column                    = current_column;
-            parameters_that_were_read.particle_group = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMAssignedSubset ") == true ) {
-            if ( assigned_subset_column != -1 )
-                wxPrintf("Warning :: _cisTEMAssignedSubset occurs more than once. I will take the last occurrence\n");
-            assigned_subset_column                    = current_column;
-            parameters_that_were_read.assigned_subset = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMPreExposure ") == true ) {
-            if ( pre_exposure_column != -1 )
-                wxPrintf("Warning :: _cisTEMPreExposure occurs more than once. I will take the last occurrence\n");
-            pre_exposure_column                    = current_column;
-            parameters_that_were_read.pre_exposure = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMTotalExposure ") == true ) {
-            if ( total_exposure_column != -1 )
-                wxPrintf("Warning :: _cisTEMTotalExposure occurs more than once. I will take the last occurrence\n");
-            total_exposure_column                    = current_column;
-            parameters_that_were_read.total_exposure = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMOriginalXPosition") == true ) {
-            if ( original_x_position_column != -1 )
-                wxPrintf("Warning :: _cisTEMOriginalXPosition occurs more than once. I will take the last occurrence\n");
-            original_x_position_column                    = current_column;
-            parameters_that_were_read.original_x_position = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMOriginalYPosition") == true ) {
-            if ( original_y_position_column != -1 )
-                wxPrintf("Warning :: _cisTEMOriginalYPosition occurs more than once. I will take the last occurrence\n");
-            original_y_position_column                    = current_column;
-            parameters_that_were_read.original_y_position = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMReference3DFilename ") == true ) {
-            if ( reference_3d_filename_column != -1 )
-                wxPrintf("Warning :: _cisTEMReference3DFilename occurs more than once. I will take the last occurrence\n");
-            reference_3d_filename_column                    = current_column;
-            parameters_that_were_read.reference_3d_filename = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMOriginalImageFilename ") == true ) {
-            if ( original_image_filename_column != -1 )
-                wxPrintf("Warning :: _cisTEMOriginalImageFilename occurs more than once. I will take the last occurrence\n");
-            original_image_filename_column                    = current_column;
-            parameters_that_were_read.original_image_filename = true;
-        }
-        else if ( current_line.StartsWith("_cisTEMStackFilename ") == true ) {
-            if ( stack_filename_column != -1 )
-                wxPrintf("Warning :: _cisTEMStackFilename occurs more than once. I will take the last occurrence\n");
-            stack_filename_column                    = current_column;
-            parameters_that_were_read.stack_filename = true;
-        }
-
-        current_column++;
+        SetColumnFromHeaderLabel(current_line);
     }
 
     // quick checks we have all the desired info.
@@ -1059,6 +1228,384 @@ bool cisTEMStarFileReader::ReadTextFile(wxString wanted_filename, wxString* erro
     return true;
 }
 
+bool cisTEMStarFileReader::ReadMappedTextFile(wxString wanted_filename, wxString* error_string, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer, bool exclude_negative_film_numbers) {
+    /*! \brief Read a text star file through a memory map, parsing the data lines on several threads.
+	 *
+	 * 	Detailed:
+	 *		The header is read line by line as in ReadTextFile. The data block is then split into chunks that start and end on line breaks,
+	 *		each chunk is parsed into its own array without going through wxString, and the chunks are appended in file order, so the
+	 *		result is the same as that of ReadTextFile.
+	 */
+
+    Close( );
+
+    filename = wanted_filename;
+
+    if ( alternate_cached_parameters_pointer == NULL ) {
+        cached_parameters    = new ArrayOfcisTEMParameterLines;
+        using_external_array = false;
+    }
+    else {
+        cached_parameters    = alternate_cached_parameters_pointer;
+        using_external_array = true;
+    }
+
+    int         file_descriptor = open(wanted_filename.ToStdString( ).c_str( ), O_RDONLY);
+    struct stat file_status;
+
+    if ( file_descriptor < 0 || fstat(file_descriptor, &file_status) != 0 ) {
+        MyPrintWithDetails("Error: Cannot open star file (%s) for read\n", wanted_filename);
+        DEBUG_ABORT;
+    }
+
+    long  file_size      = long(file_status.st_size);
+    char* mapped_address = static_cast<char*>(mmap(NULL, size_t(file_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0));
+    close(file_descriptor);
+
+    if ( mapped_address == MAP_FAILED ) {
+        MyPrintWithDetails("Error: Cannot map star file (%s) for read\n", wanted_filename);
+        DEBUG_ABORT;
+    }
+
+    madvise(mapped_address, size_t(file_size), MADV_SEQUENTIAL);
+
+    const char* end_of_file      = mapped_address + file_size;
+
+    // Only \n and \r\n line breaks are split here. wxTextFile also takes a lone \r (old Mac files) as a line break, so such files are
+    // read line by line instead.
+    if ( BufferHasLoneCarriageReturns(mapped_address, end_of_file) == true ) {
+        munmap(mapped_address, size_t(file_size));
+        return ReadTextFileLineByLine(wanted_filename, error_string, alternate_cached_parameters_pointer, exclude_negative_film_numbers);
+    }
+
+    const char* current_position = mapped_address;
+    const char* line_first;
+    const char* line_last;
+
+    // find a data block
+
+    bool found_valid_data_block = false;
+    while ( ReturnNextTrimmedLine(current_position, end_of_file, line_first, line_last) == true ) {
+        if ( statistics_were_read == false && statistics_from_file.SetFromStarFileComment(line_first, line_last) == true ) {
+            statistics_were_read = true;
+            continue;
+        }
+        if ( LineContains(line_first, line_last, "data_") == true ) {
+            found_valid_data_block = true;
+            break;
+        }
+    }
+
+    if ( found_valid_data_block == false ) {
+        munmap(mapped_address, size_t(file_size));
+        MyPrintWithDetails("Error: Couldn't find a valid data block in star file (%s)\n", wanted_filename);
+        if ( error_string != NULL )
+            *error_string = wxString::Format("Error: Couldn't find a valid data block in star file (%s)\n", wanted_filename);
+        return false;
+    }
+
+    // find a loop block
+
+    bool found_valid_loop_block = false;
+    while ( ReturnNextTrimmedLine(current_position, end_of_file, line_first, line_last) == true ) {
+        if ( LineContains(line_first, line_last, "loop_") == true ) {
+            found_valid_loop_block = true;
+            break;
+        }
+    }
+
+    if ( found_valid_loop_block == false ) {
+        munmap(mapped_address, size_t(file_size));
+        MyPrintWithDetails("Error: Couldn't find a valid loop block in star file (%s)\n", wanted_filename);
+        if ( error_string != NULL )
+            *error_string = wxString::Format("Error: Couldn't find a valid loop block in star file (%s)\n", wanted_filename);
+        return false;
+    }
+
+    // now we can get headers..
+
+    ResetColumnPositions( );
+
+    const char* first_data_line = end_of_file;
+    const char* start_of_line   = current_position;
+
+    while ( ReturnNextTrimmedLine(current_position, end_of_file, line_first, line_last) == true ) {
+        if ( line_first == line_last || *line_first == '#' || *line_first == ';' ) {
+            start_of_line = current_position;
+            continue;
+        }
+
+        if ( *line_first != '_' ) {
+            first_data_line = start_of_line;
+            break;
+        }
+
+        wxString current_line = TokenToString(line_first, line_last);
+        SetColumnFromHeaderLabel(current_line);
+        start_of_line = current_position;
+    }
+
+    // split the data block into chunks..
+
+    std::vector<StarFileChunk> chunks;
+    const char*                chunk_start = first_data_line;
+
+    while ( chunk_start < end_of_file ) {
+        const char* chunk_end = chunk_start + star_file_bytes_per_chunk;
+
+        if ( chunk_end >= end_of_file )
+            chunk_end = end_of_file;
+        else {
+            chunk_end = static_cast<const char*>(memchr(chunk_end, '\n', end_of_file - chunk_end));
+            chunk_end = (chunk_end == NULL) ? end_of_file : chunk_end + 1;
+        }
+
+        chunks.emplace_back( );
+        chunks.back( ).first_character     = chunk_start;
+        chunks.back( ).last_character      = chunk_end;
+        chunks.back( ).reached_end_of_data = false;
+        chunks.back( ).failed              = false;
+
+        chunk_start = chunk_end;
+    }
+
+    // ..parse them..
+
+    int number_of_chunks  = int(chunks.size( ));
+    int number_of_threads = ReturnAppropriateNumberOfThreads(std::max(number_of_chunks, 1));
+
+#pragma omp parallel for schedule(dynamic) num_threads(number_of_threads)
+    for ( int chunk_counter = 0; chunk_counter < number_of_chunks; chunk_counter++ ) {
+        StarFileChunk&                                   current_chunk = chunks[chunk_counter];
+        std::vector<std::pair<const char*, const char*>> tokens;
+        cisTEMParameterLine                              temp_parameters;
+        bool                                             line_is_wanted;
+        const char*                                      chunk_position = current_chunk.first_character;
+        const char*                                      chunk_line_first;
+        const char*                                      chunk_line_last;
+
+        while ( ReturnNextTrimmedLine(chunk_position, current_chunk.last_character, chunk_line_first, chunk_line_last) == true ) {
+            if ( chunk_line_first == chunk_line_last ) {
+                current_chunk.reached_end_of_data = true;
+                break;
+            }
+            if ( *chunk_line_first == '#' || *chunk_line_first == ';' )
+                continue;
+
+            SplitLineIntoTokens(chunk_line_first, chunk_line_last, tokens);
+
+            if ( ExtractParametersFromTokens(tokens, temp_parameters, line_is_wanted, current_chunk.error_message, exclude_negative_film_numbers) == false ) {
+                current_chunk.failed = true;
+                break;
+            }
+
+            if ( line_is_wanted == true )
+                current_chunk.parameter_lines.push_back(temp_parameters);
+        }
+    }
+
+    // ..and append them in order, up to the end of the data block
+
+    std::vector<long> first_line_of_chunk(number_of_chunks, 0);
+    long              first_new_line          = cached_parameters->GetCount( );
+    long              number_of_new_lines     = 0;
+    int               number_of_chunks_to_add = 0;
+
+    for ( int chunk_counter = 0; chunk_counter < number_of_chunks; chunk_counter++ ) {
+        if ( chunks[chunk_counter].failed == true ) {
+            munmap(mapped_address, size_t(file_size));
+            MyPrintWithDetails("%s", chunks[chunk_counter].error_message);
+            if ( error_string != NULL )
+                *error_string = chunks[chunk_counter].error_message;
+            return false;
+        }
+
+        first_line_of_chunk[chunk_counter] = first_new_line + number_of_new_lines;
+        number_of_new_lines += chunks[chunk_counter].parameter_lines.size( );
+        number_of_chunks_to_add++;
+
+        if ( chunks[chunk_counter].reached_end_of_data == true )
+            break;
+    }
+
+    if ( number_of_new_lines > 0 )
+        cached_parameters->Add(cisTEMParameterLine( ), number_of_new_lines);
+
+#pragma omp parallel for schedule(dynamic) num_threads(number_of_threads)
+    for ( int chunk_counter = 0; chunk_counter < number_of_chunks_to_add; chunk_counter++ ) {
+        std::vector<cisTEMParameterLine>& chunk_lines = chunks[chunk_counter].parameter_lines;
+        for ( long line_counter = 0; line_counter < long(chunk_lines.size( )); line_counter++ ) {
+            cached_parameters->Item(first_line_of_chunk[chunk_counter] + line_counter) = chunk_lines[line_counter];
+        }
+        std::vector<cisTEMParameterLine>( ).swap(chunk_lines);
+    }
+
+    munmap(mapped_address, size_t(file_size));
+    return true;
+}
+
+bool cisTEMStarFileReader::ExtractParametersFromTokens(const std::vector<std::pair<const char*, const char*>>& tokens, cisTEMParameterLine& temp_parameters, bool& line_is_wanted, wxString& error_message, bool exclude_negative_film_numbers) const {
+    // Column by column, the same conversions and defaults as ExtractParametersFromLine
+
+    int    number_of_tokens = int(tokens.size( ));
+    double temp_double;
+    long   temp_long;
+
+    auto column_is_missing = [&](int wanted_column) -> bool {
+        if ( wanted_column >= 0 && wanted_column < number_of_tokens )
+            return false;
+        error_message = wxString::Format("Error: Line has %i columns, column %i is needed\n", number_of_tokens, wanted_column + 1);
+        return true;
+    };
+
+    auto read_double = [&](int wanted_column, double& wanted_value) -> bool {
+        if ( column_is_missing(wanted_column) == true )
+            return false;
+        if ( TokenToDouble(tokens[wanted_column].first, tokens[wanted_column].second, wanted_value) == false ) {
+            error_message = wxString::Format("Error: Converting to a number (%s)\n", TokenToString(tokens[wanted_column].first, tokens[wanted_column].second));
+            return false;
+        }
+        return true;
+    };
+
+    auto read_long = [&](int wanted_column, long& wanted_value) -> bool {
+        if ( column_is_missing(wanted_column) == true )
+            return false;
+        if ( TokenToLong(tokens[wanted_column].first, tokens[wanted_column].second, wanted_value) == false ) {
+            error_message = wxString::Format("Error: Converting to a number (%s)\n", TokenToString(tokens[wanted_column].first, tokens[wanted_column].second));
+            return false;
+        }
+        return true;
+    };
+
+    auto read_float = [&](int wanted_column, float default_value, float& wanted_value) -> bool {
+        if ( wanted_column == -1 ) {
+            wanted_value = default_value;
+            return true;
+        }
+        if ( read_double(wanted_column, temp_double) == false )
+            return false;
+        wanted_value = float(temp_double);
+        return true;
+    };
+
+    auto read_integer = [&](int wanted_column, int& wanted_value) -> bool {
+        if ( wanted_column == -1 ) {
+            wanted_value = 0;
+            return true;
+        }
+        if ( read_long(wanted_column, temp_long) == false )
+            return false;
+        wanted_value = int(temp_long);
+        return true;
+    };
+
+    auto read_filename = [&](int wanted_column, const char* description, wxString& wanted_value) -> bool {
+        if ( wanted_column == -1 ) {
+            wanted_value = "";
+            return true;
+        }
+        if ( column_is_missing(wanted_column) == true )
+            return false;
+
+        const char* token_first = tokens[wanted_column].first;
+        const char* token_last  = tokens[wanted_column].second;
+
+        if ( *token_first == '\'' && *(token_last - 1) == '\'' ) {
+            if ( token_last - token_first < 3 )
+                wanted_value = "";
+            else
+                wanted_value = TokenToString(token_first + 1, token_last - 1);
+        }
+        else {
+#pragma omp critical(star_file_reader_messages)
+            MyPrintfRed("Error: %s read as %s is not enclosed in single quotes ('), replacing with blank string\n", description, TokenToString(token_first, token_last));
+            wanted_value = "";
+        }
+        return true;
+    };
+
+    line_is_wanted = false;
+
+    // start with image is active, because sometimes we can just stop..
+
+    if ( image_is_active_column == -1 )
+        temp_parameters.image_is_active = 1;
+    else {
+        if ( read_long(image_is_active_column, temp_long) == false )
+            return false;
+        temp_parameters.image_is_active = int(temp_long);
+    }
+
+    if ( temp_parameters.image_is_active < 0 && exclude_negative_film_numbers == true )
+        return true;
+
+    if ( position_in_stack_column == -1 )
+        temp_double = -1;
+    else if ( read_double(position_in_stack_column, temp_double) == false )
+        return false;
+
+    temp_parameters.position_in_stack = int(temp_double);
+
+    if ( read_float(phi_column, 0.0f, temp_parameters.phi) == false || read_float(theta_column, 0.0f, temp_parameters.theta) == false || read_float(psi_column, 0.0f, temp_parameters.psi) == false )
+        return false;
+    if ( read_float(x_shift_column, 0.0f, temp_parameters.x_shift) == false || read_float(y_shift_column, 0.0f, temp_parameters.y_shift) == false )
+        return false;
+
+    // the defocus columns have no default
+
+    if ( read_double(defocus_1_column, temp_double) == false )
+        return false;
+    temp_parameters.defocus_1 = float(temp_double);
+    if ( read_double(defocus_2_column, temp_double) == false )
+        return false;
+    temp_parameters.defocus_2 = float(temp_double);
+    if ( read_double(defocus_angle_column, temp_double) == false )
+        return false;
+    temp_parameters.defocus_angle = float(temp_double);
+
+    if ( phase_shift_column == -1 )
+        temp_parameters.phase_shift = 0.0;
+    else {
+        if ( read_double(phase_shift_column, temp_double) == false )
+            return false;
+        temp_parameters.phase_shift = deg_2_rad(float(temp_double));
+    }
+
+    if ( read_float(occupancy_column, 100.0f, temp_parameters.occupancy) == false || read_float(logp_column, 100.0f, temp_parameters.logp) == false || read_float(sigma_column, 10.0f, temp_parameters.sigma) == false )
+        return false;
+    if ( read_float(score_column, 0.0f, temp_parameters.score) == false || read_float(score_change_column, 0.0f, temp_parameters.score_change) == false )
+        return false;
+    if ( read_float(pixel_size_column, 0.0f, temp_parameters.pixel_size) == false || read_float(microscope_voltage_kv_column, 0.0f, temp_parameters.microscope_voltage_kv) == false )
+        return false;
+    if ( read_float(microscope_spherical_aberration_mm_column, 2.7f, temp_parameters.microscope_spherical_aberration_mm) == false || read_float(amplitude_contrast_column, 0.07f, temp_parameters.amplitude_contrast) == false )
+        return false;
+    if ( read_float(beam_tilt_x_column, 0.0f, temp_parameters.beam_tilt_x) == false || read_float(beam_tilt_y_column, 0.0f, temp_parameters.beam_tilt_y) == false )
+        return false;
+    if ( read_float(image_shift_x_column, 0.0f, temp_parameters.image_shift_x) == false || read_float(image_shift_y_column, 0.0f, temp_parameters.image_shift_y) == false )
+        return false;
+
+    if ( read_integer(best_2d_class_column, temp_parameters.best_2d_class) == false || read_integer(beam_tilt_group_column, temp_parameters.beam_tilt_group) == false )
+        return false;
+    if ( read_integer(particle_group_column, temp_parameters.particle_group) == false || read_integer(assigned_subset_column, temp_parameters.assigned_subset) == false )
+        return false;
+
+    if ( read_float(pre_exposure_column, 0.0f, temp_parameters.pre_exposure) == false || read_float(total_exposure_column, 0.0f, temp_parameters.total_exposure) == false )
+        return false;
+    if ( read_float(original_x_position_column, 0.0f, temp_parameters.original_x_position) == false || read_float(original_y_position_column, 0.0f, temp_parameters.original_y_position) == false )
+        return false;
+
+    if ( read_filename(stack_filename_column, "stack file name", temp_parameters.stack_filename) == false )
+        return false;
+    if ( read_filename(original_image_filename_column, "original image file name", temp_parameters.original_image_filename) == false )
+        return false;
+    if ( read_filename(reference_3d_filename_column, "reference 3d file name", temp_parameters.reference_3d_filename) == false )
+        return false;
+
+    line_is_wanted = true;
+    return true;
+}
+
 bool cisTEMStarFileReader::ReadBinaryFile(wxString wanted_filename, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer, bool exclude_negative_film_numbers) {
     Open(wanted_filename, alternate_cached_parameters_pointer, true);
     MyDebugAssertTrue(binary_file_size > 2, "Input binary file is too small")
@@ -1571,5 +2118,9 @@ bool cisTEMStarFileReader::ReadBinaryFile(wxString wanted_filename, ArrayOfcisTE
             cached_parameters->Add(temp_parameters);
     }
 
+    // statistics stored after the last line, see cisTEMParameters::WriteTocisTEMBinaryFile
+    if ( binary_buffer_position < binary_file_size )
+        statistics_were_read = statistics_from_file.SetFromBinaryTrailer(&binary_file_read_buffer[binary_buffer_position], binary_file_size - binary_buffer_position);
+
     return true;
 }
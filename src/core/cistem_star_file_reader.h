@@ -46,6 +46,11 @@ class cisTEMStarFileReader {
 
     long binary_buffer_position;
 
+    void SetColumnFromHeaderLabel(wxString& current_line);
+
+    // The same as ExtractParametersFromLine, for a line that has already been split into [first, last) tokens. Thread safe.
+    bool ExtractParametersFromTokens(const std::vector<std::pair<const char*, const char*>>& tokens, cisTEMParameterLine& temp_parameters, bool& line_is_wanted, wxString& error_message, bool exclude_negative_film_numbers) const;
+
     // The following "Safely" functions are to read data from the buffer with error checking to make sure there is no segfault
 
     inline bool SafelyReadFromBinaryBufferIntoInteger(int& integer_to_read_into) {
@@ -171,6 +176,9 @@ class cisTEMStarFileReader {
     ArrayOfcisTEMParameterLines* cached_parameters;
     cisTEMParameterMask          parameters_that_were_read;
 
+    bool                      statistics_were_read; // the file had stored statistics (see cisTEMParameterStatistics)
+    cisTEMParameterStatistics statistics_from_file;
+
     cisTEMStarFileReader( );
     ~cisTEMStarFileReader( );
 
@@ -179,6 +187,8 @@ class cisTEMStarFileReader {
     void Open(wxString wanted_filename, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer = NULL, bool read_as_binary = false);
     void Close( );
     bool ReadTextFile(wxString wanted_filename, wxString* error_string = NULL, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer = NULL, bool exclude_negative_film_numbers = false);
+    bool ReadMappedTextFile(wxString wanted_filename, wxString* error_string = NULL, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer = NULL, bool exclude_negative_film_numbers = false);
+    bool ReadTextFileLineByLine(wxString wanted_filename, wxString* error_string = NULL, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer = NULL, bool exclude_negative_film_numbers = false);
     bool ReadBinaryFile(wxString wanted_filename, ArrayOfcisTEMParameterLines* alternate_cached_parameters_pointer = NULL, bool exclude_negative_film_numbers = false);
 
     bool ExtractParametersFromLine(wxString& wanted_line, wxString* error_string = NULL, bool exclude_negative_film_numbers = false);
@@ -127,6 +127,9 @@ wxString Classification::WritecisTEMStarFile(wxString base_filename, RefinementP
         output_params.all_parameters[particle_counter].image_shift_y                      = classification_results[particle_counter].image_shift_y;
     }
 
+    // the refine2d jobs read the statistics of the whole dataset from the file rather than each calculating them
+    output_params.write_statistics_to_file = true;
+
     if ( write_as_cistem_binary_file == false )
         output_params.WriteTocisTEMStarFile(output_filename);
     else
@@ -44,6 +44,7 @@ typedef struct CurvePoint {
 #include <iterator>
 #include <utility>
 #include <vector>
+#include <deque>
 #include <unordered_map>
 #include <random>
 #include <functional>
@@ -122,8 +123,10 @@ class StackDump : public wxStackWalker // so we can give backtraces..
 
 #include "defines.h"
 #include "stopwatch.h"
+#include "profiler.h"
 #include "cistem_parameters.h"
 #include "cistem_star_file_reader.h"
+#include "cistem_columnar_parameters.h"
 #include "assets.h"
 #include "asset_group.h"
 #include "socket_communication_utils/socket_codes.h"
@@ -147,8 +150,12 @@ class StackDump : public wxStackWalker // so we can give backtraces..
 #include "angles_and_shifts.h"
 #include "empirical_distribution.h"
 #include "randomnumbergenerator.h"
+#include "fftw_plan_cache.h"
 #include "image.h"
+#include "ctf_frequency_grid.h"
 #include "spectrum_image.h"
+#include "unblur_deformation_model.h"
+#include "unblur_frame_stream.h"
 #include "socket_communication_utils/socket_communicator.h"
 #include "userinput.h"
 #include "symmetry_matrix.h"
@@ -176,6 +183,7 @@ class StackDump : public wxStackWalker // so we can give backtraces..
 #include "frealign_parameter_file.h"
 #include "basic_star_file_reader.h"
 #include "particle_finder.h"
+#include "worker_cache.h"
 #include "myapp.h"
 #include "rle3d.h"
 #include "local_resolution_estimator.h"
@@ -517,6 +517,146 @@ float CTF::ParticleShiftGivenAzimuth(float azimuth) {
     return particle_shift * cosf(azimuth - particle_shift_azimuth);
 }
 
+// PhaseShiftGivenSquaredSpatialFrequencyAndAzimuth( ) for a row of a CTFFrequencyGrid.
+// cos(2 * (azimuth - astigmatism_azimuth)) is expanded into the cos / sin of twice the azimuth, which the grid holds.
+void CTF::PhaseShiftGivenSquaredSpatialFrequencyAndAzimuthRow(const CTFFrequencyGrid& grid, int row, float* phase_shifts) {
+    MyDebugAssertTrue(row >= 0 && row < grid.number_of_rows, "Row out of range (%i)", row);
+
+    const long   first_pixel               = grid.ReturnFirstPixelOfRow(row);
+    const float* squared_spatial_frequency = grid.squared_spatial_frequency.data( ) + first_pixel;
+    const float* cos_2_azimuth             = grid.cos_2_azimuth.data( ) + first_pixel;
+    const float* sin_2_azimuth             = grid.sin_2_azimuth.data( ) + first_pixel;
+
+    const float average_defocus            = 0.5f * (defocus_1 + defocus_2);
+    const float half_defocus_difference    = 0.5f * (defocus_1 - defocus_2);
+    const float cos_2_astigmatism_azimuth  = cosf(2.0f * astigmatism_azimuth);
+    const float sin_2_astigmatism_azimuth  = sinf(2.0f * astigmatism_azimuth);
+    const float half_squared_wavelength_cs = 0.5f * squared_wavelength * spherical_aberration;
+    const float pi_wavelength              = PIf * wavelength;
+    const float constant_phase_shift       = additional_phase_shift + precomputed_amplitude_contrast_term;
+    const int   number_of_pixels           = grid.number_of_columns;
+
+#pragma omp simd
+    for ( int i = 0; i < number_of_pixels; i++ ) {
+        float defocus   = average_defocus + half_defocus_difference * (cos_2_azimuth[i] * cos_2_astigmatism_azimuth + sin_2_azimuth[i] * sin_2_astigmatism_azimuth);
+        phase_shifts[i] = pi_wavelength * squared_spatial_frequency[i] * (defocus - half_squared_wavelength_cs * squared_spatial_frequency[i]) + constant_phase_shift;
+    }
+}
+
+void CTF::EvaluateRow(const CTFFrequencyGrid& grid, int row, float* ctf_values) {
+    const int number_of_pixels = grid.number_of_columns;
+
+    if ( defocus_1 == 0.0f && defocus_2 == 0.0f ) {
+        std::fill(ctf_values, ctf_values + number_of_pixels, -0.7f); // for defocus sweep
+        return;
+    }
+
+    PhaseShiftGivenSquaredSpatialFrequencyAndAzimuthRow(grid, row, ctf_values);
+
+    if ( low_resolution_contrast == 0.0f ) {
+#pragma omp simd
+        for ( int i = 0; i < number_of_pixels; i++ ) {
+            ctf_values[i] = -sinf(ctf_values[i]);
+        }
+    }
+    else {
+        const float threshold = PIf / 2.0f;
+#pragma omp simd
+        for ( int i = 0; i < number_of_pixels; i++ ) {
+            float phase_shift = ctf_values[i];
+            if ( phase_shift < threshold )
+                phase_shift += low_resolution_contrast * (threshold - phase_shift) / threshold;
+            ctf_values[i] = -sinf(phase_shift);
+        }
+    }
+}
+
+void CTF::EvaluateRowWithEnvelope(const CTFFrequencyGrid& grid, int row, float* ctf_values) {
+    if ( squared_energy_half_width == -1 || squared_illumination_aperture == -1 ) {
+        wxPrintf("\nTo use EvaluateWithEnvelope, call SetEnvelope first\n");
+        exit(-1);
+    }
+
+    PhaseShiftGivenSquaredSpatialFrequencyAndAzimuthRow(grid, row, ctf_values);
+
+    const float* squared_spatial_frequency = grid.squared_spatial_frequency.data( ) + grid.ReturnFirstPixelOfRow(row);
+    const float  average_defocus           = 0.5f * (defocus_1 + defocus_2);
+    const int    number_of_pixels          = grid.number_of_columns;
+
+#pragma omp simd
+    for ( int i = 0; i < number_of_pixels; i++ ) {
+        float common_term   = -1.0f * PISQf * squared_spatial_frequency[i] / (2.0f * (1 + (2 * PISQf * squared_illumination_aperture * squared_spatial_frequency[i] * squared_energy_half_width)));
+        float defocus_term  = spherical_aberration * squared_wavelength * squared_spatial_frequency[i] - average_defocus;
+        float envelope_term = expf(common_term * (squared_wavelength * squared_energy_half_width * squared_spatial_frequency[i] + 2.0f * squared_illumination_aperture * defocus_term * defocus_term));
+        ctf_values[i]       = -sinf(ctf_values[i]) * envelope_term;
+    }
+}
+
+// The real phase shifts of a row, before they are turned into complex values. One buffer per thread, kept between calls,
+// so that evaluating a row does not allocate.
+static float* ReturnScratchRow(int number_of_pixels) {
+    thread_local std::vector<float> scratch_row;
+    if ( int(scratch_row.size( )) < number_of_pixels )
+        scratch_row.resize(number_of_pixels);
+    return scratch_row.data( );
+}
+
+void CTF::EvaluateComplexRow(const CTFFrequencyGrid& grid, int row, std::complex<float>* ctf_values) {
+    const int number_of_pixels = grid.number_of_columns;
+    float*    phase_shifts     = ReturnScratchRow(number_of_pixels);
+
+    PhaseShiftGivenSquaredSpatialFrequencyAndAzimuthRow(grid, row, phase_shifts);
+
+    for ( int i = 0; i < number_of_pixels; i++ ) {
+        ctf_values[i] = std::complex<float>(-sinf(phase_shifts[i]), -cosf(phase_shifts[i]));
+    }
+}
+
+// PhaseShiftGivenBeamTiltAndShift( ) for a row of a CTFFrequencyGrid, with the beam tilt and the particle shift projected on the azimuth of each pixel
+void CTF::PhaseShiftGivenBeamTiltAndShiftRow(const CTFFrequencyGrid& grid, int row, float* phase_shifts) {
+    MyDebugAssertTrue(row >= 0 && row < grid.number_of_rows, "Row out of range (%i)", row);
+
+    const long   first_pixel               = grid.ReturnFirstPixelOfRow(row);
+    const float* squared_spatial_frequency = grid.squared_spatial_frequency.data( ) + first_pixel;
+    const float* spatial_frequency         = grid.spatial_frequency.data( ) + first_pixel;
+    const float* cos_azimuth               = grid.cos_azimuth.data( ) + first_pixel;
+    const float* sin_azimuth               = grid.sin_azimuth.data( ) + first_pixel;
+
+    const float beam_tilt_x_term      = beam_tilt * cosf(beam_tilt_azimuth);
+    const float beam_tilt_y_term      = beam_tilt * sinf(beam_tilt_azimuth);
+    const float particle_shift_x_term = particle_shift * cosf(particle_shift_azimuth);
+    const float particle_shift_y_term = particle_shift * sinf(particle_shift_azimuth);
+    const float beam_tilt_factor      = 2.0f * PIf * spherical_aberration * squared_wavelength;
+    const int   number_of_pixels      = grid.number_of_columns;
+
+#pragma omp simd
+    for ( int i = 0; i < number_of_pixels; i++ ) {
+        float beam_tilt_given_azimuth      = cos_azimuth[i] * beam_tilt_x_term + sin_azimuth[i] * beam_tilt_y_term;
+        float particle_shift_given_azimuth = cos_azimuth[i] * particle_shift_x_term + sin_azimuth[i] * particle_shift_y_term;
+        float phase_shift                  = beam_tilt_factor * squared_spatial_frequency[i] * spatial_frequency[i] * beam_tilt_given_azimuth;
+        phase_shift -= 2.0f * PIf * spatial_frequency[i] * particle_shift_given_azimuth;
+        phase_shifts[i] = clamp_angular_range_negative_pi_to_pi(phase_shift);
+    }
+}
+
+void CTF::EvaluateBeamTiltPhaseShiftRow(const CTFFrequencyGrid& grid, int row, std::complex<float>* phase_shifts) {
+    const int number_of_pixels = grid.number_of_columns;
+
+    // Save some time if no beam tilt
+    if ( beam_tilt == 0.0f && particle_shift == 0.0f ) {
+        std::fill(phase_shifts, phase_shifts + number_of_pixels, std::complex<float>(1.0f, 0.0f));
+        return;
+    }
+
+    float* real_phase_shifts = ReturnScratchRow(number_of_pixels);
+    PhaseShiftGivenBeamTiltAndShiftRow(grid, row, real_phase_shifts);
+
+    // See EvaluateBeamTiltPhaseShift( ) for the sign of the sine term
+    for ( int i = 0; i < number_of_pixels; i++ ) {
+        phase_shifts[i] = std::complex<float>(cosf(real_phase_shifts[i]), sinf(real_phase_shifts[i]));
+    }
+}
+
 // Compare two CTF objects and return true if they are within a specified defocus tolerance
 bool CTF::IsAlmostEqualTo(CTF* wanted_ctf, float delta_defocus) {
     float delta;
@@ -1,4 +1,5 @@
 class Image;
+class CTFFrequencyGrid;
 
 class CTF {
 
@@ -123,6 +124,16 @@ class CTF {
     float               BeamTiltGivenAzimuth(float azimuth);
     float               ParticleShiftGivenAzimuth(float azimuth);
 
+    // The same values as Evaluate( ), EvaluateWithEnvelope( ), EvaluateComplex( ) and EvaluateBeamTiltPhaseShift( ) for one row
+    // (physical Y) of a CTFFrequencyGrid, vectorized over the pixels of the row. The astigmatism and the beam tilt are applied
+    // through the cosine and sine of the (twice) azimuth of the grid, not through the angle, so values can differ in the last bits.
+    void PhaseShiftGivenSquaredSpatialFrequencyAndAzimuthRow(const CTFFrequencyGrid& grid, int row, float* phase_shifts);
+    void EvaluateRow(const CTFFrequencyGrid& grid, int row, float* ctf_values);
+    void EvaluateRowWithEnvelope(const CTFFrequencyGrid& grid, int row, float* ctf_values);
+    void EvaluateComplexRow(const CTFFrequencyGrid& grid, int row, std::complex<float>* ctf_values);
+    void EvaluateBeamTiltPhaseShiftRow(const CTFFrequencyGrid& grid, int row, std::complex<float>* phase_shifts);
+    void PhaseShiftGivenBeamTiltAndShiftRow(const CTFFrequencyGrid& grid, int row, float* phase_shifts);
+
     // This is the sinc(xi) term derived in the supplemental of McMullan et al. (2015)
     inline float IntegratedDefocusModulation(float squared_spatial_frequency) {
         return sinc(PIf * wavelength * squared_spatial_frequency * sample_thickness);
@@ -0,0 +1,136 @@
+#include "core_headers.h"
+
+namespace {
+
+struct CTFFrequencyGridCache {
+    wxMutex                                                           mutex;
+    std::unordered_map<long, std::shared_ptr<const CTFFrequencyGrid>> grids;
+    std::deque<long>                                                  keys_in_order_of_creation;
+    long                                                              size_in_bytes;
+    long                                                              budget_in_bytes;
+
+    CTFFrequencyGridCache( ) {
+        size_in_bytes   = 0;
+        budget_in_bytes = 256L * 1024L * 1024L;
+
+        wxString budget_in_megabytes;
+        long     wanted_budget_in_megabytes;
+        if ( wxGetEnv("CISTEM_CTF_GRID_CACHE_MB", &budget_in_megabytes) && budget_in_megabytes.ToLong(&wanted_budget_in_megabytes) && wanted_budget_in_megabytes >= 0 ) {
+            budget_in_bytes = wanted_budget_in_megabytes * 1024L * 1024L;
+        }
+    }
+};
+
+CTFFrequencyGridCache& ReturnCache( ) {
+    static CTFFrequencyGridCache the_cache;
+    return the_cache;
+}
+
+// The most recent grid of this thread, so that consecutive requests for the same size are lock-free
+thread_local std::shared_ptr<const CTFFrequencyGrid> thread_local_grid;
+
+inline long GridKey(int logical_x_dimension, int logical_y_dimension) {
+    return (long(logical_x_dimension) << 32) | long(logical_y_dimension);
+}
+
+} // namespace
+
+CTFFrequencyGrid::CTFFrequencyGrid(Image& image_of_wanted_size) {
+    logical_x_dimension = image_of_wanted_size.logical_x_dimension;
+    logical_y_dimension = image_of_wanted_size.logical_y_dimension;
+    number_of_columns   = image_of_wanted_size.physical_upper_bound_complex_x + 1;
+    number_of_rows      = image_of_wanted_size.physical_upper_bound_complex_y + 1;
+
+    squared_spatial_frequency.resize(ReturnNumberOfPixels( ));
+    spatial_frequency.resize(ReturnNumberOfPixels( ));
+    cos_azimuth.resize(ReturnNumberOfPixels( ));
+    sin_azimuth.resize(ReturnNumberOfPixels( ));
+    cos_2_azimuth.resize(ReturnNumberOfPixels( ));
+    sin_2_azimuth.resize(ReturnNumberOfPixels( ));
+
+    // Coordinates are calculated as the Image CTF functions always did, so that the squared spatial frequencies are identical
+    for ( int j = 0; j < number_of_rows; j++ ) {
+        float y_coord    = image_of_wanted_size.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * image_of_wanted_size.fourier_voxel_size_y;
+        float y_coord_sq = powf(y_coord, 2);
+        long  pixel      = ReturnFirstPixelOfRow(j);
+
+        for ( int i = 0; i < number_of_columns; i++ ) {
+            float x_coord = i * image_of_wanted_size.fourier_voxel_size_x;
+
+            squared_spatial_frequency[pixel] = powf(x_coord, 2) + y_coord_sq;
+            spatial_frequency[pixel]         = sqrtf(squared_spatial_frequency[pixel]);
+
+            // The azimuth of the origin is 0
+            double radius = sqrt(double(x_coord) * double(x_coord) + double(y_coord) * double(y_coord));
+            double cosine = (radius > 0.0) ? double(x_coord) / radius : 1.0;
+            double sine   = (radius > 0.0) ? double(y_coord) / radius : 0.0;
+
+            cos_azimuth[pixel]   = float(cosine);
+            sin_azimuth[pixel]   = float(sine);
+            cos_2_azimuth[pixel] = float(cosine * cosine - sine * sine);
+            sin_2_azimuth[pixel] = float(2.0 * sine * cosine);
+
+            pixel++;
+        }
+    }
+}
+
+std::shared_ptr<const CTFFrequencyGrid> CTFFrequencyGrid::ReturnGrid(Image& image_of_wanted_size) {
+    if ( thread_local_grid && thread_local_grid->logical_x_dimension == image_of_wanted_size.logical_x_dimension && thread_local_grid->logical_y_dimension == image_of_wanted_size.logical_y_dimension ) {
+        return thread_local_grid;
+    }
+
+    CTFFrequencyGridCache& cache = ReturnCache( );
+    long                   key   = GridKey(image_of_wanted_size.logical_x_dimension, image_of_wanted_size.logical_y_dimension);
+
+    {
+        wxMutexLocker lock(cache.mutex);
+        MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+        auto cached_grid = cache.grids.find(key);
+        if ( cached_grid != cache.grids.end( ) ) {
+            thread_local_grid = cached_grid->second;
+            return thread_local_grid;
+        }
+    }
+
+    // A grid that could not be kept would be calculated (and allocated) again on every call, which costs more than it saves
+    long number_of_pixels = long(image_of_wanted_size.physical_upper_bound_complex_x + 1) * long(image_of_wanted_size.physical_upper_bound_complex_y + 1);
+    if ( 6 * number_of_pixels * long(sizeof(float)) > cache.budget_in_bytes ) {
+        return std::shared_ptr<const CTFFrequencyGrid>( );
+    }
+
+    // Calculate outside of the lock, so that other threads are not held up by a new size
+    std::shared_ptr<const CTFFrequencyGrid> new_grid = std::make_shared<const CTFFrequencyGrid>(image_of_wanted_size);
+
+    wxMutexLocker lock(cache.mutex);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+    // Another thread may have made the same grid in the meantime
+    auto cached_grid = cache.grids.find(key);
+    if ( cached_grid != cache.grids.end( ) ) {
+        thread_local_grid = cached_grid->second;
+        return thread_local_grid;
+    }
+
+    while ( cache.size_in_bytes + new_grid->ReturnSizeInBytes( ) > cache.budget_in_bytes && cache.keys_in_order_of_creation.empty( ) == false ) {
+        auto oldest_grid = cache.grids.find(cache.keys_in_order_of_creation.front( ));
+        cache.size_in_bytes -= oldest_grid->second->ReturnSizeInBytes( );
+        cache.grids.erase(oldest_grid);
+        cache.keys_in_order_of_creation.pop_front( );
+    }
+
+    cache.grids[key] = new_grid;
+    cache.keys_in_order_of_creation.push_back(key);
+    cache.size_in_bytes += new_grid->ReturnSizeInBytes( );
+
+    thread_local_grid = new_grid;
+    return new_grid;
+}
+
+long CTFFrequencyGrid::ReturnNumberOfCachedGrids( ) {
+    CTFFrequencyGridCache& cache = ReturnCache( );
+    wxMutexLocker          lock(cache.mutex);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+    return long(cache.grids.size( ));
+}
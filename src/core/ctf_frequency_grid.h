@@ -0,0 +1,55 @@
+#ifndef _SRC_CORE_CTF_FREQUENCY_GRID_H_
+#define _SRC_CORE_CTF_FREQUENCY_GRID_H_
+
+/*  \brief  CTFFrequencyGrid class - the squared spatial frequency and the azimuth terms of every pixel of a 2D Fourier transform.
+
+	The values are laid out as Image::complex_values (physical X fastest, one row per physical Y), so that a CTF can be evaluated
+	one row at a time by CTF::EvaluateRow( ) and friends, without an atan2f, a cosf of the azimuth and the special case of the origin
+	in the inner loop. The azimuth is only kept as the cosine and sine of the azimuth and of twice the azimuth, which is all the
+	astigmatism, beam tilt and particle shift terms need.
+
+	A grid only depends on the logical X and Y dimensions. ReturnGrid( ) hands out grids from a process-wide cache, so that the CTF
+	of every particle of a stack re-uses the same grid. The most recent grid of each thread is also kept by that thread, so repeated
+	requests for the same size do not take the lock of the cache. Once the cache holds more than its memory budget, the oldest
+	grids are dropped from it; a grid that is still in use stays valid until its last user releases it.
+
+	Environment variables (read on first use of the cache):
+	  CISTEM_CTF_GRID_CACHE_MB   memory budget of the cache in MB (default 256). No grid is made for sizes whose grid would
+	                             be larger than the budget; ReturnGrid( ) returns an empty pointer and the callers evaluate
+	                             the CTF pixel by pixel instead.
+*/
+
+#include <memory>
+#include <vector>
+
+class CTFFrequencyGrid {
+
+  public:
+    int logical_x_dimension;
+    int logical_y_dimension;
+    int number_of_columns; // physical_upper_bound_complex_x + 1
+    int number_of_rows; // physical_upper_bound_complex_y + 1
+
+    std::vector<float> squared_spatial_frequency;
+    std::vector<float> spatial_frequency;
+    std::vector<float> cos_azimuth;
+    std::vector<float> sin_azimuth;
+    std::vector<float> cos_2_azimuth;
+    std::vector<float> sin_2_azimuth;
+
+    // Calculate the grid for the logical X and Y dimensions of the image
+    CTFFrequencyGrid(Image& image_of_wanted_size);
+
+    inline long ReturnFirstPixelOfRow(int row) const { return long(row) * number_of_columns; }
+
+    inline long ReturnNumberOfPixels( ) const { return long(number_of_rows) * number_of_columns; }
+
+    inline long ReturnSizeInBytes( ) const { return 6 * ReturnNumberOfPixels( ) * long(sizeof(float)); }
+
+    // The (shared) grid for the logical X and Y dimensions of the image, or an empty pointer if it would be larger than the cache
+    static std::shared_ptr<const CTFFrequencyGrid> ReturnGrid(Image& image_of_wanted_size);
+
+    static long ReturnNumberOfCachedGrids( );
+};
+
+#endif
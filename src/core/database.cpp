@@ -1,9 +1,90 @@
 #include "core_headers.h"
 #include "database_schema.h"
 
+#ifdef __APPLE__
+#include <sys/param.h>
+#include <sys/mount.h>
+#else
+#include <sys/vfs.h>
+#endif
+
 // #define PRINT_FOR_SLOW_DEBUG
 // #define SKIP_TM_TABLE_CHECK
 
+namespace {
+
+// Page cache used while in BeginBulkLoad( ) / EndBulkLoad( )
+constexpr long bulk_load_cache_size_in_kb = 262144;
+
+// Network and cluster filesystems, on which the database file is not memory mapped
+bool DatabaseIsOnLocalFilesystem(const wxFileName& database_filename) {
+    struct statfs filesystem_info;
+
+    if ( statfs(database_filename.GetPath( ).ToUTF8( ).data( ), &filesystem_info) != 0 )
+        return false;
+
+#ifdef __APPLE__
+    return (filesystem_info.f_flags & MNT_LOCAL) != 0;
+#else
+    switch ( static_cast<unsigned long>(filesystem_info.f_type) ) {
+        case 0x6969: // NFS
+        case 0x517B: // SMB
+        case 0xFF534D42: // CIFS
+        case 0xFE534D42: // SMB2
+        case 0x0BD00BD0: // Lustre
+        case 0x47504653: // GPFS
+        case 0x00C36400: // Ceph
+        case 0x19830326: // BeeGFS
+        case 0x5346414F: // AFS
+        case 0x65735546: // FUSE (sshfs and friends)
+            return false;
+        default:
+            return true;
+    }
+#endif
+}
+
+} // namespace
+
+DatabasePerformanceProfile DatabasePerformanceProfile::ReturnDefaultProfile( ) {
+    DatabasePerformanceProfile default_profile;
+
+    default_profile.use_exclusive_locking = false;
+    default_profile.use_wal_journal       = false;
+    default_profile.use_memory_temp_store = true;
+    default_profile.synchronous_level     = 2;
+    default_profile.cache_size_in_kb      = 65536;
+    default_profile.mmap_size_in_bytes    = 0;
+
+    return default_profile;
+}
+
+DatabasePerformanceProfile DatabasePerformanceProfile::ReturnFastProfile( ) {
+    DatabasePerformanceProfile fast_profile;
+
+    fast_profile.use_exclusive_locking = true;
+    fast_profile.use_wal_journal       = true;
+    fast_profile.use_memory_temp_store = true;
+    fast_profile.synchronous_level     = 1;
+    fast_profile.cache_size_in_kb      = 262144;
+    fast_profile.mmap_size_in_bytes    = 1073741824;
+
+    return fast_profile;
+}
+
+DatabasePerformanceProfile DatabasePerformanceProfile::ReturnProfileFromEnvironment( ) {
+    wxString profile_name;
+
+    if ( wxGetEnv("CISTEM_DATABASE_PROFILE", &profile_name) ) {
+        if ( profile_name.IsSameAs("fast", false) )
+            return ReturnFastProfile( );
+        else if ( profile_name.IsSameAs("default", false) == false )
+            wxPrintf("Warning: unknown CISTEM_DATABASE_PROFILE (%s), using the default profile\n", profile_name);
+    }
+
+    return ReturnDefaultProfile( );
+}
+
 Database::Database( ) {
     last_return_code = -1;
     is_open          = false;
@@ -11,8 +92,13 @@ Database::Database( ) {
 
     in_batch_insert = false;
     in_batch_select = false;
+    in_bulk_load    = false;
     batch_statement = NULL;
 
+    performance_profile         = DatabasePerformanceProfile::ReturnProfileFromEnvironment( );
+    journal_is_wal              = false;
+    cache_size_before_bulk_load = 0;
+
     should_do_local_commit = false;
 
     number_of_active_transactions = 0;
@@ -528,18 +614,13 @@ bool Database::CreateNewDatabase(wxFileName wanted_database_file) {
         return false;
     }
 
-    //ExecuteSQL("PRAGMA main.locking_mode=EXCLUSIVE;");
-    //ExecuteSQL("PRAGMA main.temp_store=MEMORY;");
-    //ExecuteSQL("PRAGMA main.synchronous=NORMAL;");
-    //ExecuteSQL("PRAGMA main.page_size=4096;");
-    //ExecuteSQL("PRAGMA main.cache_size=10000;");
-    //ExecuteSQL("PRAGMA main.journal_mode=WAL;");
-
     // if we get here, we should have the database open, with an exclusive lock
 
     database_file = wanted_database_file;
     is_open       = true;
 
+    ApplyPerformanceProfile( );
+
     return true;
 }
 
@@ -570,18 +651,15 @@ bool Database::Open(wxFileName file_to_open, bool disable_locking) {
         return false;
     }
 
-    //	ExecuteSQL("PRAGMA main.locking_mode=EXCLUSIVE;");
-    //	ExecuteSQL("PRAGMA main.temp_store=MEMORY;");
-    //	ExecuteSQL("PRAGMA main.synchronous=NORMAL;");
-    //	ExecuteSQL("PRAGMA main.page_size=4096;");
-    //	ExecuteSQL("PRAGMA main.cache_size=10000;");
-    //	ExecuteSQL("PRAGMA main.journal_mode=WAL;");
-
     // if we get here, we should have the database open, with an exclusive lock
 
     database_file = file_to_open;
     is_open       = true;
 
+    // without locking the database is only opened to roll back a hot journal, so it is left as it is
+    if ( disable_locking == false )
+        ApplyPerformanceProfile( );
+
     // We used to check here whether all tables exists, this has been moved now
     // to the GUI upon project opening
     // CreateAllTables();
@@ -589,6 +667,35 @@ bool Database::Open(wxFileName file_to_open, bool disable_locking) {
     return true;
 }
 
+void Database::ApplyPerformanceProfile( ) {
+    MyDebugAssertTrue(is_open == true, "database not open!");
+
+    journal_is_wal = false;
+
+    if ( performance_profile.use_memory_temp_store == true )
+        ExecuteSQL("PRAGMA temp_store=MEMORY;");
+    if ( performance_profile.cache_size_in_kb > 0 )
+        ExecuteSQL(wxString::Format("PRAGMA main.cache_size=-%li;", performance_profile.cache_size_in_kb));
+    if ( performance_profile.mmap_size_in_bytes > 0 && DatabaseIsOnLocalFilesystem(database_file) == true )
+        ExecuteSQL(wxString::Format("PRAGMA main.mmap_size=%li;", performance_profile.mmap_size_in_bytes));
+
+    if ( performance_profile.use_exclusive_locking == true ) {
+        ExecuteSQL("PRAGMA main.locking_mode=EXCLUSIVE;");
+
+        if ( performance_profile.use_wal_journal == true ) {
+            journal_is_wal = ReturnSingleStringFromSelectCommand("PRAGMA main.journal_mode=WAL;").IsSameAs("wal", false);
+            if ( journal_is_wal == false )
+                MyDebugPrint("WAL journal not available for %s, keeping the rollback journal\n", database_file.GetFullPath( ));
+        }
+    }
+
+    // a lower sync level is only safe against power loss with the WAL journal
+    if ( journal_is_wal == true )
+        ExecuteSQL(wxString::Format("PRAGMA main.synchronous=%i;", performance_profile.synchronous_level));
+    else
+        ExecuteSQL(wxString::Format("PRAGMA main.synchronous=%i;", std::max(performance_profile.synchronous_level, 2)));
+}
+
 /**
  * @brief Make backup copy of existing database file. Currently only in use when
  * database schema changes are detected and a schema update is necessary.
@@ -1001,6 +1108,12 @@ void Database::Close(bool remove_lock) {
         if ( number_of_active_transactions != 0 )
             MyPrintWithDetails("Warning: Transaction number (%i) is not 0 upon close!\n", number_of_active_transactions);
 
+        // leave the database in rollback journal mode, so that it can still be opened without an exclusive lock
+        if ( journal_is_wal == true && number_of_active_transactions == 0 ) {
+            ReturnSingleStringFromSelectCommand("PRAGMA main.journal_mode=DELETE;");
+            journal_is_wal = false;
+        }
+
         int return_code = sqlite3_close(sqlite_database);
         MyDebugAssertTrue(return_code == SQLITE_OK, "SQL close error, return code : %i\n", return_code);
     }
@@ -1115,6 +1228,53 @@ void Database::EndBatchInsert( ) {
     in_batch_insert = false;
 }
 
+void Database::BeginBulkLoad(const wxArrayString& tables_to_load) {
+    MyDebugAssertTrue(is_open == true, "database not open!");
+    MyDebugAssertTrue(in_bulk_load == false, "Starting bulk load but already in bulk load mode");
+
+    sqlite3_stmt* index_statement;
+    wxArrayString index_names;
+
+    in_bulk_load = true;
+    deferred_index_commands.Clear( );
+
+    Begin( );
+
+    for ( size_t table_counter = 0; table_counter < tables_to_load.GetCount( ); table_counter++ ) {
+        // automatic indexes (primary keys, unique constraints) have no sql, and can't be dropped
+        Prepare(wxString::Format("SELECT name, sql FROM sqlite_master WHERE type='index' AND tbl_name='%s' AND sql IS NOT NULL;", tables_to_load[table_counter]), &index_statement);
+
+        while ( Step(index_statement) == SQLITE_ROW ) {
+            index_names.Add(wxString(sqlite3_column_text(index_statement, 0)));
+            deferred_index_commands.Add(wxString(sqlite3_column_text(index_statement, 1)));
+        }
+
+        Finalize(index_statement);
+    }
+
+    for ( size_t index_counter = 0; index_counter < index_names.GetCount( ); index_counter++ ) {
+        ExecuteSQL(wxString::Format("DROP INDEX \"%s\";", index_names[index_counter]));
+    }
+
+    cache_size_before_bulk_load = ReturnSingleLongFromSelectCommand("PRAGMA main.cache_size;");
+    ExecuteSQL(wxString::Format("PRAGMA main.cache_size=-%li;", bulk_load_cache_size_in_kb));
+}
+
+void Database::EndBulkLoad( ) {
+    MyDebugAssertTrue(in_bulk_load == true, "Ending bulk load but not in bulk load mode");
+
+    for ( size_t index_counter = 0; index_counter < deferred_index_commands.GetCount( ); index_counter++ ) {
+        ExecuteSQL(deferred_index_commands[index_counter]);
+    }
+
+    deferred_index_commands.Clear( );
+
+    Commit( );
+
+    ExecuteSQL(wxString::Format("PRAGMA main.cache_size=%li;", cache_size_before_bulk_load));
+    in_bulk_load = false;
+}
+
 void Database::BeginMovieAssetInsert( ) {
     BeginBatchInsert("MOVIE_ASSETS", 21, "MOVIE_ASSET_ID", "NAME", "FILENAME", "POSITION_IN_STACK", "X_SIZE", "Y_SIZE", "NUMBER_OF_FRAMES", "VOLTAGE", "PIXEL_SIZE", "DOSE_PER_FRAME", "SPHERICAL_ABERRATION", "GAIN_FILENAME", "DARK_FILENAME", "OUTPUT_BINNING_FACTOR", "CORRECT_MAG_DISTORTION", "MAG_DISTORTION_ANGLE", "MAG_DISTORTION_MAJOR_SCALE", "MAG_DISTORTION_MINOR_SCALE", "PROTEIN_IS_WHITE", "EER_SUPER_RES_FACTOR", "EER_FRAMES_PER_IMAGE");
 }
@@ -2068,6 +2228,13 @@ void Database::AddRefinement(Refinement* refinement_to_add) {
         InsertOrReplace(wxString::Format("REFINEMENT_DETAILS_%li", refinement_to_add->refinement_id), "ilrrrrrrirrrrirrrrirrrrlliiilrrir", "CLASS_NUMBER", "REFERENCE_VOLUME_ASSET_ID", "LOW_RESOLUTION_LIMIT", "HIGH_RESOLUTION_LIMIT", "MASK_RADIUS", "SIGNED_CC_RESOLUTION_LIMIT", "GLOBAL_RESOLUTION_LIMIT", "GLOBAL_MASK_RADIUS", "NUMBER_RESULTS_TO_REFINE", "ANGULAR_SEARCH_STEP", "SEARCH_RANGE_X", "SEARCH_RANGE_Y", "CLASSIFICATION_RESOLUTION_LIMIT", "SHOULD_FOCUS_CLASSIFY", "SPHERE_X_COORD", "SPHERE_Y_COORD", "SPHERE_Z_COORD", "SPHERE_RADIUS", "SHOULD_REFINE_CTF", "DEFOCUS_SEARCH_RANGE", "DEFOCUS_SEARCH_STEP", "AVERAGE_OCCUPANCY", "ESTIMATED_RESOLUTION", "RECONSTRUCTED_VOLUME_ASSET_ID", "RECONSTRUCTION_ID", "SHOULD_AUTOMASK", "SHOULD_REFINE_INPUT_PARAMS", "SHOULD_USE_SUPPLIED_MASK", "MASK_ASSET_ID", "MASK_EDGE_WIDTH", "OUTSIDE_MASK_WEIGHT", "SHOULD_LOWPASS_OUTSIDE_MASK", "MASK_FILTER_RESOLUTION", class_counter + 1, refinement_to_add->reference_volume_ids[class_counter], refinement_to_add->class_refinement_results[class_counter].low_resolution_limit, refinement_to_add->class_refinement_results[class_counter].high_resolution_limit, refinement_to_add->class_refinement_results[class_counter].mask_radius, refinement_to_add->class_refinement_results[class_counter].signed_cc_resolution_limit, refinement_to_add->class_refinement_results[class_counter].global_resolution_limit, refinement_to_add->class_refinement_results[class_counter].global_mask_radius, refinement_to_add->class_refinement_results[class_counter].number_results_to_refine, refinement_to_add->class_refinement_results[class_counter].angular_search_step, refinement_to_add->class_refinement_results[class_counter].search_range_x, refinement_to_add->class_refinement_results[class_counter].search_range_y, refinement_to_add->class_refinement_results[class_counter].classification_resolution_limit, refinement_to_add->class_refinement_results[class_counter].should_focus_classify, refinement_to_add->class_refinement_results[class_counter].sphere_x_coord, refinement_to_add->class_refinement_results[class_counter].sphere_y_coord, refinement_to_add->class_refinement_results[class_counter].sphere_z_coord, refinement_to_add->class_refinement_results[class_counter].sphere_radius, refinement_to_add->class_refinement_results[class_counter].should_refine_ctf, refinement_to_add->class_refinement_results[class_counter].defocus_search_range, refinement_to_add->class_refinement_results[class_counter].defocus_search_step, refinement_to_add->class_refinement_results[class_counter].average_occupancy, estimated_resolution, refinement_to_add->class_refinement_results[class_counter].reconstructed_volume_asset_id, refinement_to_add->class_refinement_results[class_counter].reconstruction_id, refinement_to_add->class_refinement_results[class_counter].should_auto_mask, refinement_to_add->class_refinement_results[class_counter].should_refine_input_params, refinement_to_add->class_refinement_results[class_counter].should_use_supplied_mask, refinement_to_add->class_refinement_results[class_counter].mask_asset_id, refinement_to_add->class_refinement_results[class_counter].mask_edge_width, refinement_to_add->class_refinement_results[class_counter].outside_mask_weight, refinement_to_add->class_refinement_results[class_counter].should_low_pass_filter_mask, refinement_to_add->class_refinement_results[class_counter].filter_resolution);
     }
 
+    wxArrayString result_tables;
+    for ( class_counter = 1; class_counter <= refinement_to_add->number_of_classes; class_counter++ ) {
+        result_tables.Add(wxString::Format("REFINEMENT_RESULT_%li_%i", refinement_to_add->refinement_id, class_counter));
+    }
+
+    BeginBulkLoad(result_tables);
+
     for ( class_counter = 1; class_counter <= refinement_to_add->number_of_classes; class_counter++ ) {
         BeginBatchInsert(wxString::Format("REFINEMENT_RESULT_%li_%i", refinement_to_add->refinement_id, class_counter), 24, "POSITION_IN_STACK", "PSI", "THETA", "PHI", "XSHIFT", "YSHIFT", "DEFOCUS1", "DEFOCUS2", "DEFOCUS_ANGLE", "PHASE_SHIFT", "OCCUPANCY", "LOGP", "SIGMA", "SCORE", "IMAGE_IS_ACTIVE", "PIXEL_SIZE", "MICROSCOPE_VOLTAGE", "MICROSCOPE_CS", "AMPLITUDE_CONTRAST", "BEAM_TILT_X", "BEAM_TILT_Y", "IMAGE_SHIFT_X", "IMAGE_SHIFT_Y", "ASSIGNED_SUBSET");
 
@@ -2078,6 +2245,8 @@ void Database::AddRefinement(Refinement* refinement_to_add) {
         EndBatchInsert( );
     }
 
+    EndBulkLoad( );
+
     for ( class_counter = 1; class_counter <= refinement_to_add->number_of_classes; class_counter++ ) {
 
         BeginBatchInsert(wxString::Format("REFINEMENT_RESOLUTION_STATISTICS_%li_%i", refinement_to_add->refinement_id, class_counter), 6, "SHELL", "RESOLUTION", "FSC", "PART_FSC", "PART_SSNR", "REC_SSNR");
@@ -2118,10 +2287,10 @@ Refinement* Database::GetRefinementByID(long wanted_refinement_id, bool include_
     int              return_code;
     sqlite3_stmt*    list_statement  = NULL;
     Refinement*      temp_refinement = new Refinement;
-    RefinementResult temp_result;
     int              class_counter;
     long             current_reference_volume;
     long             number_of_active_images;
+    long             result_counter;
 
     float temp_resolution;
     float temp_fsc;
@@ -2205,47 +2374,65 @@ Refinement* Database::GetRefinementByID(long wanted_refinement_id, bool include_
 
     if ( include_particle_info == true ) {
         for ( class_counter = 0; class_counter < temp_refinement->number_of_classes; class_counter++ ) {
-            temp_refinement->class_refinement_results[class_counter].particle_refinement_results.Alloc(temp_refinement->number_of_particles);
-            sql_select_command = wxString::Format("SELECT * FROM REFINEMENT_RESULT_%li_%i", temp_refinement->refinement_id, class_counter + 1);
+            ArrayofRefinementResults& current_results = temp_refinement->class_refinement_results[class_counter].particle_refinement_results;
+
+            // The results are filled in place, rather than built in a temporary and copied in one at a time. The columns are named so the
+            // statement does not depend on the table layout, and are read through the typed batch select so no format string is parsed per row.
+
+            current_results.Alloc(temp_refinement->number_of_particles);
+            current_results.Add(junk_result, temp_refinement->number_of_particles);
+
+            sql_select_command = wxString::Format("SELECT POSITION_IN_STACK, PSI, THETA, PHI, XSHIFT, YSHIFT, DEFOCUS1, DEFOCUS2, DEFOCUS_ANGLE, PHASE_SHIFT, OCCUPANCY, LOGP, SIGMA, SCORE, IMAGE_IS_ACTIVE, PIXEL_SIZE, MICROSCOPE_VOLTAGE, MICROSCOPE_CS, AMPLITUDE_CONTRAST, BEAM_TILT_X, BEAM_TILT_Y, IMAGE_SHIFT_X, IMAGE_SHIFT_Y, ASSIGNED_SUBSET FROM REFINEMENT_RESULT_%li_%i", temp_refinement->refinement_id, class_counter + 1);
 
             more_data = BeginBatchSelect(sql_select_command);
 
             temp_refinement->class_refinement_results[class_counter].average_occupancy = 0.0f;
             number_of_active_images                                                    = 0;
+            result_counter                                                             = 0;
 
             while ( more_data == true ) {
-                more_data = GetFromBatchSelect("lsssssssssssssissssssssi", &temp_result.position_in_stack,
-                                               &temp_result.psi,
-                                               &temp_result.theta,
-                                               &temp_result.phi,
-                                               &temp_result.xshift,
-                                               &temp_result.yshift,
-                                               &temp_result.defocus1,
-                                               &temp_result.defocus2,
-                                               &temp_result.defocus_angle,
-                                               &temp_result.phase_shift,
-                                               &temp_result.occupancy,
-                                               &temp_result.logp,
-                                               &temp_result.sigma,
-                                               &temp_result.score,
-                                               &temp_result.image_is_active,
-                                               &temp_result.pixel_size,
-                                               &temp_result.microscope_voltage_kv,
-                                               &temp_result.microscope_spherical_aberration_mm,
-                                               &temp_result.amplitude_contrast,
-                                               &temp_result.beam_tilt_x,
-                                               &temp_result.beam_tilt_y,
-                                               &temp_result.image_shift_x,
-                                               &temp_result.image_shift_y,
-                                               &temp_result.assigned_subset);
-
-                temp_refinement->class_refinement_results[class_counter].particle_refinement_results.Add(temp_result);
-
-                if ( temp_result.image_is_active >= 0.0 ) {
-                    temp_refinement->class_refinement_results[class_counter].average_occupancy += temp_result.occupancy;
+                if ( result_counter == long(current_results.GetCount( )) )
+                    current_results.Add(junk_result);
+
+                RefinementResult& current_result = current_results.Item(result_counter);
+
+                more_data = GetFromBatchSelect_NoChar(&current_result.position_in_stack,
+                                                      &current_result.psi,
+                                                      &current_result.theta,
+                                                      &current_result.phi,
+                                                      &current_result.xshift,
+                                                      &current_result.yshift,
+                                                      &current_result.defocus1,
+                                                      &current_result.defocus2,
+                                                      &current_result.defocus_angle,
+                                                      &current_result.phase_shift,
+                                                      &current_result.occupancy,
+                                                      &current_result.logp,
+                                                      &current_result.sigma,
+                                                      &current_result.score,
+                                                      &current_result.image_is_active,
+                                                      &current_result.pixel_size,
+                                                      &current_result.microscope_voltage_kv,
+                                                      &current_result.microscope_spherical_aberration_mm,
+                                                      &current_result.amplitude_contrast,
+                                                      &current_result.beam_tilt_x,
+                                                      &current_result.beam_tilt_y,
+                                                      &current_result.image_shift_x,
+                                                      &current_result.image_shift_y,
+                                                      &current_result.assigned_subset);
+
+                if ( current_result.image_is_active >= 0.0 ) {
+                    temp_refinement->class_refinement_results[class_counter].average_occupancy += current_result.occupancy;
                     number_of_active_images++;
                 }
+
+                result_counter++;
             }
+
+            // in case the table holds fewer rows than the refinement says it has particles
+            if ( result_counter < long(current_results.GetCount( )) )
+                current_results.RemoveAt(result_counter, current_results.GetCount( ) - result_counter);
+
             if ( number_of_active_images > 0 )
                 temp_refinement->class_refinement_results[class_counter].average_occupancy /= float(number_of_active_images);
             EndBatchSelect( );
@@ -2284,6 +2471,10 @@ void Database::AddClassification(Classification* classification_to_add) {
     InsertOrReplace("CLASSIFICATION_LIST", "Plttilllirrrrrrriir", "CLASSIFICATION_ID", "REFINEMENT_PACKAGE_ASSET_ID", "NAME", "CLASS_AVERAGE_FILE", "REFINEMENT_WAS_IMPORTED_OR_GENERATED", "DATETIME_OF_RUN", "STARTING_CLASSIFICATION_ID", "NUMBER_OF_PARTICLES", "NUMBER_OF_CLASSES", "LOW_RESOLUTION_LIMIT", "HIGH_RESOLUTION_LIMIT", "MASK_RADIUS", "ANGULAR_SEARCH_STEP", "SEARCH_RANGE_X", "SEARCH_RANGE_Y", "SMOOTHING_FACTOR", "EXCLUDE_BLANK_EDGES", "AUTO_PERCENT_USED", "PERCENT_USED", classification_to_add->classification_id, classification_to_add->refinement_package_asset_id, classification_to_add->name.ToUTF8( ).data( ), classification_to_add->class_average_file.ToUTF8( ).data( ), classification_to_add->classification_was_imported_or_generated, classification_to_add->datetime_of_run.GetAsDOS( ), classification_to_add->starting_classification_id, classification_to_add->number_of_particles, classification_to_add->number_of_classes, classification_to_add->low_resolution_limit, classification_to_add->high_resolution_limit, classification_to_add->mask_radius, classification_to_add->angular_search_step, classification_to_add->search_range_x, classification_to_add->search_range_y, classification_to_add->smoothing_factor, classification_to_add->exclude_blank_edges, classification_to_add->auto_percent_used, classification_to_add->percent_used);
     CreateClassificationResultTable(classification_to_add->classification_id);
 
+    wxArrayString result_tables;
+    result_tables.Add(wxString::Format("CLASSIFICATION_RESULT_%li", classification_to_add->classification_id));
+
+    BeginBulkLoad(result_tables);
     BeginBatchInsert(wxString::Format("CLASSIFICATION_RESULT_%li", classification_to_add->classification_id), 19, "POSITION_IN_STACK", "PSI", "XSHIFT", "YSHIFT", "BEST_CLASS", "SIGMA", "LOGP", "PIXEL_SIZE", "VOLTAGE", "CS", "AMPLITUDE_CONTRAST", "DEFOCUS_1", "DEFOCUS_2", "DEFOCUS_ANGLE", "PHASE_SHIFT", "BEAM_TILT_X", "BEAM_TILT_Y", "IMAGE_SHIFT_X", "IMAGE_SHIFT_Y");
 
     for ( counter = 0; counter < classification_to_add->classification_results.GetCount( ); counter++ ) {
@@ -2309,6 +2500,7 @@ void Database::AddClassification(Classification* classification_to_add) {
     }
 
     EndBatchInsert( );
+    EndBulkLoad( );
 }
 
 Classification* Database::GetClassificationByID(long wanted_classification_id) {
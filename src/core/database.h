@@ -1,10 +1,45 @@
 #include "../constants/constants.h"
 #include "../gui/UpdateProgressTracker.h"
 
+/*  \brief  DatabasePerformanceProfile - the sqlite settings applied to a project database when it is opened or created.
+
+	The default profile keeps the journal, locking and syncing behaviour cisTEM has always had, and only keeps temporary
+	tables in memory with a larger page cache. The fast profile holds the lock for the whole session instead of taking it for every
+	transaction, which removes a lock file round trip per transaction on network filesystems. With dot-file locking an
+	exclusive lock is also what allows a WAL journal, as the WAL index is then kept in heap memory rather than in shared memory.
+	If sqlite refuses the WAL journal the rollback journal is kept, and the sync level is only lowered when the WAL journal is in use.
+	The file is only memory mapped on local filesystems.
+
+	The profile is taken from the environment variable CISTEM_DATABASE_PROFILE ("default" or "fast") when a Database is
+	constructed, and can be changed with Database::SetPerformanceProfile( ) before the database is opened.
+*/
+
+struct DatabasePerformanceProfile {
+    bool use_exclusive_locking;
+    bool use_wal_journal; // only used together with use_exclusive_locking
+    bool use_memory_temp_store;
+    int  synchronous_level; // 0 = OFF, 1 = NORMAL, 2 = FULL. Below FULL only used with the WAL journal
+    long cache_size_in_kb; // 0 = the sqlite default
+    long mmap_size_in_bytes; // 0 = no memory mapped I/O
+
+    static DatabasePerformanceProfile ReturnDefaultProfile( );
+    static DatabasePerformanceProfile ReturnFastProfile( );
+    static DatabasePerformanceProfile ReturnProfileFromEnvironment( );
+};
+
 class Database {
 
     bool in_batch_insert;
     bool in_batch_select;
+    bool in_bulk_load;
+
+    DatabasePerformanceProfile performance_profile;
+    bool                       journal_is_wal;
+
+    wxArrayString deferred_index_commands; // indexes dropped by BeginBulkLoad( ), created again by EndBulkLoad( )
+    long          cache_size_before_bulk_load;
+
+    void ApplyPerformanceProfile( );
 
     int number_of_active_transactions;
 
@@ -29,6 +64,13 @@ class Database {
     bool Open(wxFileName file_to_open, bool disable_locking = false);
     bool CopyDatabaseFile(wxFileName backup_db);
 
+    // only has an effect on databases opened after the call
+    inline void SetPerformanceProfile(const DatabasePerformanceProfile& wanted_profile) { performance_profile = wanted_profile; }
+
+    inline DatabasePerformanceProfile ReturnPerformanceProfile( ) const { return performance_profile; }
+
+    inline bool JournalIsWAL( ) const { return journal_is_wal; }
+
     inline void Begin( ) {
         if ( number_of_active_transactions == 0 )
             ExecuteSQL("BEGIN IMMEDIATE;"); // we can start, otherwise, we are already in begin commit
@@ -131,6 +173,11 @@ class Database {
     void AddToBatchInsert(const char* column_format, ...);
     void EndBatchInsert( );
 
+    // For loading many rows into the given tables within one transaction. Indexes on the tables are dropped, and created again
+    // in one pass by EndBulkLoad( ), and the page cache is enlarged so that the transaction does not spill to the journal.
+    void BeginBulkLoad(const wxArrayString& tables_to_load);
+    void EndBulkLoad( );
+
     bool BeginBatchSelect(const char* select_command);
     bool GetFromBatchSelect(const char* column_format, ...);
     void EndBatchSelect( );
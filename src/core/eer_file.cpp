@@ -1,5 +1,7 @@
 #include "core_headers.h"
 
+#include <unistd.h>
+
 EerFile::EerFile( ) {
     fh                             = NULL;
     tif                            = NULL;
@@ -9,9 +11,9 @@ EerFile::EerFile( ) {
     number_of_eer_frames           = 0;
     number_of_eer_frames_per_image = 0;
     super_res_factor               = 0;
-    buf                            = NULL;
     frame_starts                   = NULL;
     frame_sizes                    = NULL;
+    number_of_threads              = 1;
 }
 
 EerFile::EerFile(std::string wanted_filename, bool overwrite) {
@@ -22,7 +24,6 @@ EerFile::~EerFile( ) {
     CloseFile( );
     delete[] frame_starts;
     delete[] frame_sizes;
-    delete[] buf;
 }
 
 //
@@ -135,34 +136,75 @@ bool EerFile::ReadLogicalDimensionsFromDisk(bool check_only_the_first_image) {
     return return_value;
 }
 
-void EerFile::ReadWholeFileIntoBuffer( ) {
+/*
+ * Record where the raw strips of every EER frame live in the file. Only this index is kept in memory, the frame data themselves
+ * are read from disk when they are needed (see ReadFrameFromDisk), so that memory use does not grow with the length of the movie.
+ * libtiff directory access is not thread-safe, which is why this is all done up front.
+ */
+void EerFile::ReadFrameIndex( ) {
     MyDebugAssertTrue(tif != NULL, "File must be open");
     MyDebugAssertTrue(logical_dimension_x > 0, "You must call ReadLogicalDimensionsFromDisk first");
-    MyDebugAssertTrue(buf == NULL, "Buffer was already allocated");
     MyDebugAssertTrue(frame_starts == NULL, "frame_starts was already allocated");
     MyDebugAssertTrue(frame_sizes == NULL, "frame_sizes was already allocated");
 
     frame_starts = new unsigned long long[number_of_eer_frames];
     frame_sizes  = new unsigned long long[number_of_eer_frames];
-    buf          = new unsigned char[file_size_bytes];
-    long               output_counter;
+    frame_strip_offsets.resize(number_of_eer_frames);
+    frame_strip_sizes.resize(number_of_eer_frames);
+
     unsigned long long pos = 0;
 
-    // Read everything into the buffer
     for ( int frame = 0; frame < number_of_eer_frames; frame++ ) {
         TIFFSetDirectory(tif, frame);
         const int nstrips   = TIFFNumberOfStrips(tif);
         frame_starts[frame] = pos;
         frame_sizes[frame]  = 0;
 
+        uint64* strip_offsets    = NULL;
+        uint64* strip_byte_count = NULL;
+        TIFFGetField(tif, TIFFTAG_STRIPOFFSETS, &strip_offsets);
+        TIFFGetField(tif, TIFFTAG_STRIPBYTECOUNTS, &strip_byte_count);
+
+        frame_strip_offsets[frame].resize(nstrips);
+        frame_strip_sizes[frame].resize(nstrips);
+
         for ( int strip = 0; strip < nstrips; strip++ ) {
-            unsigned long long strip_size = TIFFRawStripSize(tif, strip);
+            frame_strip_offsets[frame][strip] = strip_offsets[strip];
+            frame_strip_sizes[frame][strip]   = strip_byte_count[strip];
+            pos += strip_byte_count[strip];
+            frame_sizes[frame] += strip_byte_count[strip];
+        }
+    } // end of loop over frames
+}
+
+/*
+ * Read the raw (compressed) bytes of one EER frame into frame_buffer. Uses pread, so may be called from several threads at once.
+ * The buffer is padded with zeroes so that the bit reader can always load a full 64-bit word.
+ */
+void EerFile::ReadFrameFromDisk(int eer_frame, std::vector<unsigned char>& frame_buffer) {
+    const int bit_reader_padding_bytes = 8;
+
+    frame_buffer.resize(frame_sizes[eer_frame] + bit_reader_padding_bytes);
 
-            TIFFReadRawStrip(tif, strip, buf + pos, strip_size);
-            pos += strip_size;
-            frame_sizes[frame] += strip_size;
+    int                file_descriptor = fileno(fh);
+    unsigned long long pos             = 0;
+
+    for ( size_t strip = 0; strip < frame_strip_offsets[eer_frame].size( ); strip++ ) {
+        unsigned long long bytes_read_so_far = 0;
+        unsigned long long bytes_to_read     = frame_strip_sizes[eer_frame][strip];
+
+        while ( bytes_read_so_far < bytes_to_read ) {
+            ssize_t bytes_read = pread(file_descriptor, frame_buffer.data( ) + pos + bytes_read_so_far, bytes_to_read - bytes_read_so_far, off_t(frame_strip_offsets[eer_frame][strip] + bytes_read_so_far));
+            if ( bytes_read <= 0 ) {
+                MyPrintWithDetails("Error: could not read EER frame %i from %s\n", eer_frame, filename.GetFullPath( ));
+                DEBUG_ABORT;
+            }
+            bytes_read_so_far += bytes_read;
         }
-    } // end of loop over slices
+        pos += bytes_to_read;
+    }
+
+    memset(frame_buffer.data( ) + pos, 0, bit_reader_padding_bytes);
 }
 
 void EerFile::ReadSliceFromDisk(int slice_number, float* output_array) {
@@ -181,9 +223,9 @@ void EerFile::ReadSlicesFromDisk(int start_slice, int end_slice, float* output_a
     MyDebugAssertTrue(super_res_factor > 0, "Super res factor was not set");
     MyDebugAssertTrue(logical_dimension_y > 0, "Logical dimensions were not set");
 
-    // Read the contents of the file into the buffer
-    if ( buf == NULL )
-        ReadWholeFileIntoBuffer( );
+    // Work out where the frames are in the file
+    if ( frame_starts == NULL )
+        ReadFrameIndex( );
 
     long start_pos_in_output_array = 0;
 
@@ -201,123 +243,118 @@ void EerFile::ReadSlicesFromDisk(int start_slice, int end_slice, float* output_a
     }
 }
 
+/*
+ * Decode one frame into a list of event addresses in the (possibly super-resolved) output image.
+ *
+ * The bit reader loads an unaligned 64-bit little-endian word at the current byte and shifts off the sub-byte offset, which always
+ * leaves at least 57 valid bits - enough for one RLE code plus its 4-bit sub-pixel symbol - so each event costs a single load.
+ * Events come out in raster order of the physical pixel.
+ */
+void EerFile::DecodeFrameToEventAddresses(const unsigned char* frame_data, unsigned long long frame_size_bytes, std::vector<unsigned int>& event_addresses) {
+    const unsigned int       rle_mask             = (bits_per_rle == 7) ? 127 : 255;
+    const unsigned int       bits_per_event       = bits_per_rle + 4;
+    const unsigned long long maximum_bit_position = frame_size_bytes * 8;
+    const int                output_row_length    = logical_dimension_y * super_res_factor;
+
+    unsigned long long bit_pos = 0;
+    unsigned int       npixels = 0;
+    uint64             word;
+    unsigned int       rle;
+    unsigned int       subpixel;
+    int                x, y;
+
+    event_addresses.clear( );
+
+    while ( bit_pos < maximum_bit_position ) {
+        memcpy(&word, frame_data + (bit_pos >> 3), sizeof(uint64));
+        word >>= (bit_pos & 7);
+
+        rle = (unsigned int)(word & rle_mask);
+        npixels += rle;
+        if ( npixels >= frame_size_bits )
+            break;
+        if ( rle == rle_mask ) {
+            bit_pos += bits_per_rle;
+            continue; // this should be rare.
+        }
+
+        subpixel = (unsigned int)((word >> bits_per_rle) & 15) ^ 0x0A; // 15 = 00001111; 0x0A = 00001010
+        bit_pos += bits_per_event;
+
+        // Work out 0-indexed x,y location of the event
+        switch ( super_res_factor ) {
+            case 1:
+                x = npixels & 4095; // 4095 = 111111111111b
+                y = npixels >> 12; //  4096 = 2^12
+                break;
+            case 2:
+                x = ((npixels & 4095) << 1) | ((subpixel & 2) >> 1); //render8K; 4095 = 111111111111b, 2 = 00000010b
+                y = ((npixels >> 12) << 1) | ((subpixel & 8) >> 3); //render8K;  4096 = 2^12, 8 = 00001000b
+                break;
+            default:
+                x = ((npixels & 4095) << 2) | (subpixel & 3); //render16K; 4095 = 111111111111b, 3 = 00000011b
+                y = ((npixels >> 12) << 2) | ((subpixel & 12) >> 2); //render16K;  4096 = 2^12, 12 = 00001100b
+                break;
+        }
+
+        event_addresses.push_back((unsigned int)(y * output_row_length + x));
+        npixels++;
+    }
+}
+
 /*
  * Start and finish EER frames should be 0-indexed
  * A single image data array will be returned, summing all the events founds between the start and finish eer_frames
+ *
+ * Frames are read and decoded in parallel (number_of_threads), each thread keeping its own read buffer and event list. Counts are then
+ * accumulated in parallel as well: every thread owns a band of output rows and adds the events of all frames that fall in its band. As the
+ * events of each frame are in raster order, a thread finds its part of each event list with a binary search, and no two threads ever write
+ * to the same pixel, so no per-thread copies of the output image (and no reduction of them) are needed.
  */
 void EerFile::DecodeToFloatArray(int start_eer_frame, int finish_eer_frame, float* output_array) {
-    MyDebugAssertTrue(buf != NULL, "Data from the file has not been read into the buffer yet");
-    long current_address;
+    MyDebugAssertTrue(frame_starts != NULL, "The frame index has not been read yet");
 
-    // Zeroe the array
-    for ( current_address = 0; current_address < logical_dimension_x * logical_dimension_y * super_res_factor * super_res_factor; current_address++ ) {
-        output_array[current_address] = 0.0f;
-    }
+    const long number_of_output_pixels = long(logical_dimension_x) * long(logical_dimension_y) * long(super_res_factor * super_res_factor);
+    const int  number_of_frames        = std::max(finish_eer_frame - start_eer_frame, 0); // finish_eer_frame itself is not decoded
+    const int  output_row_length       = logical_dimension_y * super_res_factor;
+    const int  number_of_output_rows   = int(number_of_output_pixels / output_row_length);
+    const int  rows_per_band           = 16 * super_res_factor;
 
-    /*
-	 * Max number of electrons in a frame
-	 */
-    unsigned long long max_electrons = 0;
-    for ( int iframe = start_eer_frame; iframe <= finish_eer_frame; iframe++ ) {
-        max_electrons = std::max(max_electrons, frame_sizes[iframe] * 2); // at 4 bits per electron (very permissive bound!)
-    }
+    std::vector<std::vector<unsigned int>> events_of_each_frame(number_of_frames);
 
-    /*
-	 * Decode into a list of events
-	 */
-    // wxPrintf("max electrons = %llu\n", max_electrons);
-    unsigned int*  positions = new unsigned int[max_electrons]( );
-    unsigned char* symbols   = new unsigned char[max_electrons]( );
-    for ( int iframe = start_eer_frame; iframe < finish_eer_frame; iframe++ ) {
-        long long     pos     = frame_starts[iframe];
-        unsigned int  npixels = 0, nelectrons = 0;
-        unsigned int  bit_pos = 0; // 4 K * 4 K * 11 bit << 2 ** 32
-        unsigned char rle, subpixel;
-        long long     first_byte;
-        unsigned int  bit_offset_in_first_byte;
-        unsigned int  chunk;
-        if ( bits_per_rle == 7 ) {
-            while ( true ) {
-                first_byte               = pos + (bit_pos >> 3);
-                bit_offset_in_first_byte = bit_pos & 7; // 7 = 00000111 (same as % 8)
-                chunk                    = *(unsigned int*)(buf + first_byte);
-                rle                      = (unsigned char)((chunk >> bit_offset_in_first_byte) & 127); // 127 = 01111111
-                bit_pos += 7;
-                npixels += rle;
-                if ( npixels == frame_size_bits )
-                    break;
-                if ( rle == 127 )
-                    continue; // this should be rare.
-                if ( nelectrons > max_electrons )
-                    break;
-
-                first_byte               = pos + (bit_pos >> 3);
-                bit_offset_in_first_byte = bit_pos & 7;
-                chunk                    = *(unsigned int*)(buf + first_byte);
-                subpixel                 = (unsigned char)((chunk >> bit_offset_in_first_byte) & 15) ^ 0x0A; // 15 = 00001111; 0x0A = 00001010
-                bit_pos += 4;
-                //          wxPrintf("nelectrons = %u / %llu\n", nelectrons, max_electrons);
-                positions[nelectrons] = npixels;
-                symbols[nelectrons]   = subpixel;
-                nelectrons++;
-                npixels++;
-            }
-        }
-        else {
-            while ( true ) {
-                first_byte               = pos + (bit_pos >> 3);
-                bit_offset_in_first_byte = bit_pos & 7; // 7 = 00000111 (same as % 8)
-                chunk                    = *(unsigned int*)(buf + first_byte);
-                rle                      = (unsigned char)((chunk >> bit_offset_in_first_byte) & 255); // 255 = 11111111
-                bit_pos += 8;
-                npixels += rle;
-                if ( npixels == frame_size_bits )
-                    break;
-                if ( rle == 255 )
-                    continue; // this should be rare.
-                if ( nelectrons > max_electrons )
-                    break;
-
-                first_byte               = pos + (bit_pos >> 3);
-                bit_offset_in_first_byte = bit_pos & 7;
-                chunk                    = *(unsigned int*)(buf + first_byte);
-                subpixel                 = (unsigned char)((chunk >> bit_offset_in_first_byte) & 15) ^ 0x0A; // 15 = 00001111; 0x0A = 00001010
-
-                bit_pos += 4;
-                positions[nelectrons] = npixels;
-                symbols[nelectrons]   = subpixel;
-                nelectrons++;
-                npixels++;
-            }
+#pragma omp parallel num_threads(number_of_threads) default(shared)
+    {
+        std::vector<unsigned char> frame_buffer;
+
+#pragma omp for schedule(dynamic, 1)
+        for ( int frame_counter = 0; frame_counter < number_of_frames; frame_counter++ ) {
+            ReadFrameFromDisk(start_eer_frame + frame_counter, frame_buffer);
+            DecodeFrameToEventAddresses(frame_buffer.data( ), frame_sizes[start_eer_frame + frame_counter], events_of_each_frame[frame_counter]);
         }
 
-        /*
-		 * Insert the events into a pixel array
-		 */
-        for ( int i = 0; i < nelectrons; i++ ) {
-            // Work out 0-indexed x,y location of the event
-            int x, y;
-            if ( super_res_factor == 1 ) {
-                x = positions[i] & 4095; // 4095 = 111111111111b
-                y = positions[i] >> 12; //  4096 = 2^12
-            }
-            else if ( super_res_factor == 2 ) {
-                x = ((positions[i] & 4095) << 1) | ((symbols[i] & 2) >> 1); //render8K; 4095 = 111111111111b, 2 = 00000010b
-                y = ((positions[i] >> 12) << 1) | ((symbols[i] & 8) >> 3); //render8K;  4096 = 2^12, 8 = 00001000b
-            }
-            else if ( super_res_factor == 4 ) {
-                x = ((positions[i] & 4095) << 2) | (symbols[i] & 3); //render16K; 4095 = 111111111111b, 3 = 00000011b
-                y = ((positions[i] >> 12) << 2) | ((symbols[i] & 12) >> 2); //render16K;  4096 = 2^12, 12 = 00001100b
-            }
+        // Bands are whole multiples of super_res_factor output rows, i.e. whole physical rows. Physical rows are non-decreasing
+        // along each event list, so the events of a band are one contiguous run of each list.
+        auto physical_row_of_address = [output_row_length, this](unsigned int address) { return int(address / output_row_length) / super_res_factor; };
 
-            current_address = y * logical_dimension_y * super_res_factor + x;
+#pragma omp for schedule(static)
+        for ( int band_start_row = 0; band_start_row < number_of_output_rows; band_start_row += rows_per_band ) {
+            const int band_finish_row    = std::min(band_start_row + rows_per_band, number_of_output_rows);
+            const int first_physical_row = band_start_row / super_res_factor;
+            const int last_physical_row  = band_finish_row / super_res_factor; // not included
 
-            output_array[current_address] += 1.0f;
+            std::fill(output_array + long(band_start_row) * output_row_length, output_array + long(band_finish_row) * output_row_length, 0.0f);
+
+            for ( int frame_counter = 0; frame_counter < number_of_frames; frame_counter++ ) {
+                const std::vector<unsigned int>& events = events_of_each_frame[frame_counter];
+
+                auto event = std::lower_bound(events.begin( ), events.end( ), first_physical_row, [&physical_row_of_address](unsigned int address, int physical_row) { return physical_row_of_address(address) < physical_row; });
+
+                for ( ; event != events.end( ) && physical_row_of_address(*event) < last_physical_row; ++event ) {
+                    output_array[*event] += 1.0f;
+                }
+            }
         }
     }
-
-    delete[] positions;
-    delete[] symbols;
 }
 
 void EerFile::WriteSliceToDisk(int slice_number, float* input_array) {
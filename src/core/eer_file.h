@@ -11,14 +11,20 @@ class EerFile : public AbstractImageFile {
     int                 super_res_factor;
     unsigned long long* frame_starts;
     unsigned long long* frame_sizes;
-    unsigned char*      buf;
+
+    std::vector<std::vector<unsigned long long>> frame_strip_offsets; // position in the file of each strip of each frame
+    std::vector<std::vector<unsigned long long>> frame_strip_sizes;
+
+    int number_of_threads; // used to read and decode the frames of one image in parallel
     //unsigned int * ion_of_each_frame;
     unsigned long long file_size_bytes;
     unsigned long long frame_size_bits;
 
     float pixel_size;
 
-    void ReadWholeFileIntoBuffer( );
+    void ReadFrameIndex( );
+    void ReadFrameFromDisk(int eer_frame, std::vector<unsigned char>& frame_buffer);
+    void DecodeFrameToEventAddresses(const unsigned char* frame_data, unsigned long long frame_size_bytes, std::vector<unsigned int>& event_addresses);
     void DecodeToFloatArray(int start_eer_frame, int finish_eer_frame, float* output_array);
     bool ReadLogicalDimensionsFromDisk(bool check_only_the_first_image = false);
 
@@ -37,6 +43,8 @@ class EerFile : public AbstractImageFile {
 
     inline float ReturnPixelSize( ) { return pixel_size; };
 
+    inline void SetNumberOfThreads(int wanted_number_of_threads) { number_of_threads = std::max(wanted_number_of_threads, 1); };
+
     inline bool IsOpen( ) {
         if ( tif ) {
             return true;
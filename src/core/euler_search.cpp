@@ -1,5 +1,48 @@
 #include "core_headers.h"
 
+EulerSearchWorkspace::EulerSearchWorkspace( ) {
+    rotation_cache      = NULL;
+    rotation_cache_size = 0;
+    temp_k              = NULL;
+    temp_k_size         = 0;
+}
+
+EulerSearchWorkspace::~EulerSearchWorkspace( ) {
+    if ( rotation_cache != NULL )
+        delete[] rotation_cache;
+    if ( temp_k != NULL )
+        delete[] temp_k;
+}
+
+void EulerSearchWorkspace::Prepare(int wanted_logical_x_dimension, int wanted_logical_y_dimension, int padding_factor_2d, int number_of_rotations) {
+    int i;
+
+    // Allocate( ) returns straight away if an image already has the wanted dimensions
+    flipped_image.Allocate(wanted_logical_x_dimension, wanted_logical_y_dimension, false);
+    padded_image.Allocate(padding_factor_2d * wanted_logical_x_dimension, padding_factor_2d * wanted_logical_y_dimension, true);
+    padded_image.object_is_centred_in_box = true;
+    projection_image.Allocate(wanted_logical_x_dimension, wanted_logical_y_dimension, false);
+    correlation_map.Allocate(wanted_logical_x_dimension, wanted_logical_y_dimension, false);
+    correlation_map.object_is_centred_in_box = false;
+
+    if ( number_of_rotations > rotation_cache_size ) {
+        if ( rotation_cache != NULL )
+            delete[] rotation_cache;
+        rotation_cache      = new Image[number_of_rotations];
+        rotation_cache_size = number_of_rotations;
+    }
+    for ( i = 0; i < number_of_rotations; i++ ) {
+        rotation_cache[i].Allocate(wanted_logical_x_dimension, wanted_logical_y_dimension, false);
+    }
+
+    if ( flipped_image.real_memory_allocated > temp_k_size ) {
+        if ( temp_k != NULL )
+            delete[] temp_k;
+        temp_k      = new float[flipped_image.real_memory_allocated];
+        temp_k_size = flipped_image.real_memory_allocated;
+    }
+}
+
 EulerSearch::EulerSearch( ) {
     // Nothing to do until Init is called
     refine_top_N                = 0;
@@ -407,7 +450,7 @@ void EulerSearch::SetSymmetryLimits( ) {
 }
 
 // Run the search
-void EulerSearch::Run(Particle& particle, Image& input_3d, Image* projections) {
+void EulerSearch::Run(Particle& particle, Image& input_3d, Image* projections, EulerSearchWorkspace* workspace) {
     MyDebugAssertTrue(number_of_search_positions > 0, "EulerSearch not initialized");
     MyDebugAssertTrue(particle.particle_image->is_in_memory, "Particle image not allocated");
     MyDebugAssertTrue(input_3d.is_in_memory, "3D reference map not allocated");
@@ -432,20 +475,34 @@ void EulerSearch::Run(Particle& particle, Image& input_3d, Image* projections) {
     bool            mirrored_match;
     Peak            found_peak;
     AnglesAndShifts angles;
-    Image*          flipped_image    = new Image;
-    Image*          padded_image     = new Image;
-    Image*          projection_image = new Image;
-    Image*          rotated_image    = new Image;
-    Image*          correlation_map  = new Image;
-    Image*          rotation_cache   = NULL;
-    flipped_image->Allocate(particle.particle_image->logical_x_dimension, particle.particle_image->logical_y_dimension, false);
-    padded_image->Allocate(padding_factor_2d * flipped_image->logical_x_dimension, padding_factor_2d * flipped_image->logical_y_dimension, true);
-    projection_image->Allocate(particle.particle_image->logical_x_dimension, particle.particle_image->logical_y_dimension, false);
-    rotated_image->Allocate(particle.particle_image->logical_x_dimension, particle.particle_image->logical_y_dimension, false);
-    correlation_map->Allocate(particle.particle_image->logical_x_dimension, particle.particle_image->logical_y_dimension, false);
-    correlation_map->object_is_centred_in_box = false;
+
+    if ( parameter_map.psi ) {
+        number_of_psi_positions = myroundint(psi_max / psi_step);
+        if ( number_of_psi_positions < 1 )
+            number_of_psi_positions = 1;
+    }
+    else {
+        number_of_psi_positions = 1;
+    }
+    psi_i = number_of_psi_positions;
+    if ( test_mirror )
+        psi_i *= 2;
+
+    // Without a workspace from the caller, the scratch images only live for this call
+    EulerSearchWorkspace* local_workspace = NULL;
+    if ( workspace == NULL ) {
+        local_workspace = new EulerSearchWorkspace;
+        workspace       = local_workspace;
+    }
+    workspace->Prepare(particle.particle_image->logical_x_dimension, particle.particle_image->logical_y_dimension, padding_factor_2d, psi_i);
+
+    Image* flipped_image    = &workspace->flipped_image;
+    Image* padded_image     = &workspace->padded_image;
+    Image* projection_image = &workspace->projection_image;
+    Image* correlation_map  = &workspace->correlation_map;
+    Image* rotation_cache   = workspace->rotation_cache;
 #ifndef MKL
-    float* temp_k1 = new float[flipped_image->real_memory_allocated];
+    float* temp_k1 = workspace->temp_k;
     float* temp_k2;
     temp_k2 = temp_k1 + 1;
     float* real_a;
@@ -474,22 +531,6 @@ void EulerSearch::Run(Particle& particle, Image& input_3d, Image* projections) {
         list_of_best_parameters[i][5] = -std::numeric_limits<float>::max( );
     }
 
-    if ( parameter_map.psi ) {
-        number_of_psi_positions = myroundint(psi_max / psi_step);
-        if ( number_of_psi_positions < 1 )
-            number_of_psi_positions = 1;
-    }
-    else {
-        number_of_psi_positions = 1;
-    }
-    psi_i = number_of_psi_positions;
-    if ( test_mirror )
-        psi_i *= 2;
-    rotation_cache = new Image[psi_i];
-    for ( i = 0; i < psi_i; i++ ) {
-        rotation_cache[i].Allocate(particle.particle_image->logical_x_dimension, particle.particle_image->logical_y_dimension, false);
-    }
-
     flipped_image->CopyFrom(particle.particle_image);
     //	flipped_image->MultiplyPixelWiseReal(*particle.ctf_image, particle.is_phase_flipped);
     flipped_image->MultiplyPixelWiseReal(*particle.ctf_image, true);
@@ -676,19 +717,6 @@ void EulerSearch::Run(Particle& particle, Image& input_3d, Image* projections) {
 	projection_image->SwapRealSpaceQuadrants();
 	projection_image->QuickAndDirtyWriteSlice("proj.mrc", particle.origin_micrograph); */
 
-    delete flipped_image;
-    delete padded_image;
-    delete projection_image;
-    delete rotated_image;
-    delete correlation_map;
-    psi_i = number_of_psi_positions;
-    if ( test_mirror )
-        psi_i *= 2;
-    for ( i = 0; i < psi_i; ++i ) {
-        rotation_cache[i].Deallocate( );
-    }
-    delete[] rotation_cache;
-#ifndef MKL
-    delete[] temp_k1;
-#endif
+    if ( local_workspace != NULL )
+        delete local_workspace;
 }
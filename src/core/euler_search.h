@@ -1,3 +1,25 @@
+// Scratch images for EulerSearch::Run. A workspace kept by each thread across particles means that, once it has been sized for the
+// first particle, Run( ) neither allocates memory nor plans FFTs.
+class EulerSearchWorkspace {
+  public:
+    Image  flipped_image;
+    Image  padded_image;
+    Image  projection_image;
+    Image  correlation_map;
+    Image* rotation_cache;
+    int    rotation_cache_size;
+    float* temp_k;
+    long   temp_k_size;
+
+    EulerSearchWorkspace( );
+    ~EulerSearchWorkspace( );
+
+    EulerSearchWorkspace(const EulerSearchWorkspace&)            = delete;
+    EulerSearchWorkspace& operator=(const EulerSearchWorkspace&) = delete;
+
+    void Prepare(int wanted_logical_x_dimension, int wanted_logical_y_dimension, int padding_factor_2d, int number_of_rotations);
+};
+
 class EulerSearch {
     // Brute-force search to find matching projections
 
@@ -39,7 +61,7 @@ class EulerSearch {
     void Init(float wanted_resolution_limit, ParameterMap& wanted_parameter_map, int wanted_parameters_to_keep);
     void InitGrid(wxString wanted_symmetry_symbol, float angular_step_size, float wanted_phi_start, float wanted_theta_start, float wanted_psi_max, float wanted_psi_step, float wanted_psi_start, float wanted_resolution_limit, ParameterMap& parameter_map, int wanted_parameters_to_keep);
     void InitRandom(wxString wanted_symmetry_symbol, float wanted_psi_step, int wanted_number_of_search_positions, float wanted_resolution_limit, ParameterMap& wanted_parameter_map, int wanted_parameters_to_keep);
-    void Run(Particle& particle, Image& input_3d, Image* projections);
+    void Run(Particle& particle, Image& input_3d, Image* projections, EulerSearchWorkspace* workspace = NULL);
     void CalculateGridSearchPositions(bool random_start_angle = true);
     void CalculateRandomSearchPositions( );
     void SetSymmetryLimits( );
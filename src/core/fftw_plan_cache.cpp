@@ -0,0 +1,188 @@
+#include "core_headers.h"
+
+namespace {
+
+struct ThreadLocalPlanEntry {
+    FFTWPlanCache::PlanPair plans;
+    int                     number_of_requests;
+    bool                    promotion_was_requested;
+};
+
+// Each thread keeps its own view of the cache, so that repeated requests for a size this thread has already seen are lock-free.
+// Plans referenced here are owned by the process-wide cache and are never destroyed while the process is running.
+thread_local std::unordered_map<FFTWPlanCache::PlanKey, ThreadLocalPlanEntry, FFTWPlanCache::PlanKeyHash> thread_local_plans;
+
+} // namespace
+
+FFTWPlanCache& FFTWPlanCache::GetInstance( ) {
+    static FFTWPlanCache the_cache;
+    return the_cache;
+}
+
+FFTWPlanCache::FFTWPlanCache( ) {
+    hot_planner_flags           = FFTW_ESTIMATE;
+    hot_size_number_of_requests = 64;
+
+    wxString hot_planner;
+    if ( wxGetEnv("CISTEM_FFTW_HOT_PLANNER", &hot_planner) ) {
+        if ( hot_planner.IsSameAs("measure", false) )
+            hot_planner_flags = FFTW_MEASURE;
+        else if ( hot_planner.IsSameAs("patient", false) )
+            hot_planner_flags = FFTW_PATIENT;
+    }
+
+    if ( wxGetEnv("CISTEM_FFTW_WISDOM", &environment_wisdom_filename) && wxFileExists(environment_wisdom_filename) ) {
+        ImportWisdomFromFile(environment_wisdom_filename);
+    }
+}
+
+FFTWPlanCache::~FFTWPlanCache( ) {
+    for ( auto& cached_entry : cached_plans ) {
+        fftwf_destroy_plan(cached_entry.second.plan_fwd);
+        fftwf_destroy_plan(cached_entry.second.plan_bwd);
+    }
+
+    for ( auto& retired_plan : retired_plans ) {
+        fftwf_destroy_plan(retired_plan);
+    }
+}
+
+void FFTWPlanCache::SetPlanningRigorForHotSizes(unsigned wanted_planner_flags, int wanted_number_of_requests) {
+    MyDebugAssertTrue(wanted_number_of_requests > 0, "Number of requests must be positive (%i)", wanted_number_of_requests);
+    hot_planner_flags           = wanted_planner_flags;
+    hot_size_number_of_requests = wanted_number_of_requests;
+}
+
+bool FFTWPlanCache::ImportWisdomFromFile(wxString wisdom_filename) {
+    wxMutexLocker lock(Image::s_mutexProtectingFFTW);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+    return fftwf_import_wisdom_from_filename(wisdom_filename.ToStdString( ).c_str( )) != 0;
+}
+
+// Many processes on one node may share the same wisdom file, so write to a private file first and rename it into place.
+bool FFTWPlanCache::ExportWisdomToFile(wxString wisdom_filename) {
+    wxMutexLocker lock(Image::s_mutexProtectingFFTW);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+    wxString temporary_filename = wxString::Format("%s.%li.tmp", wisdom_filename, wxGetProcessId( ));
+
+    if ( fftwf_export_wisdom_to_filename(temporary_filename.ToStdString( ).c_str( )) == 0 ) {
+        return false;
+    }
+
+    return wxRenameFile(temporary_filename, wisdom_filename, true);
+}
+
+bool FFTWPlanCache::ExportWisdomIfRequested( ) {
+    if ( environment_wisdom_filename.IsEmpty( ) )
+        return false;
+    return ExportWisdomToFile(environment_wisdom_filename);
+}
+
+long FFTWPlanCache::ReturnNumberOfCachedPlans( ) {
+    wxMutexLocker lock(Image::s_mutexProtectingFFTW);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+    return long(cached_plans.size( ));
+}
+
+bool FFTWPlanCache::ReturnPlans(int nx, int ny, int nz, float* real_values, std::complex<float>* complex_values, fftwf_plan& plan_fwd, fftwf_plan& plan_bwd) {
+    MyDebugAssertTrue(nx > 0 && ny > 0 && nz > 0, "Bad dimensions: %i %i %i", nx, ny, nz);
+
+    PlanKey key;
+    key.nx                = nx;
+    key.ny                = ny;
+    key.nz                = nz;
+    key.in_place          = (static_cast<void*>(real_values) == static_cast<void*>(complex_values));
+    key.real_alignment    = fftwf_alignment_of(real_values);
+    key.complex_alignment = fftwf_alignment_of(reinterpret_cast<float*>(complex_values));
+
+    auto local_entry = thread_local_plans.find(key);
+
+    if ( local_entry == thread_local_plans.end( ) ) {
+        ThreadLocalPlanEntry new_entry;
+        if ( ! ReturnPlansFromGlobalTable(key, false, new_entry.plans) )
+            return false;
+        new_entry.number_of_requests      = 0;
+        new_entry.promotion_was_requested = false;
+        local_entry                       = thread_local_plans.emplace(key, new_entry).first;
+    }
+
+    ThreadLocalPlanEntry& entry = local_entry->second;
+    entry.number_of_requests++;
+
+    if ( ! entry.promotion_was_requested && hot_planner_flags != FFTW_ESTIMATE && entry.number_of_requests >= hot_size_number_of_requests ) {
+        // This size is hot for this thread - ask for (and pick up) a more rigorously planned version
+        entry.promotion_was_requested = true;
+        ReturnPlansFromGlobalTable(key, true, entry.plans);
+    }
+
+    plan_fwd = entry.plans.plan_fwd;
+    plan_bwd = entry.plans.plan_bwd;
+    return true;
+}
+
+bool FFTWPlanCache::ReturnPlansFromGlobalTable(const PlanKey& key, bool promote_to_hot, PlanPair& wanted_plans) {
+    wxMutexLocker lock(Image::s_mutexProtectingFFTW); // the mutex will be unlocked when this object is destroyed (when it goes out of scope)
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+    auto cached_entry = cached_plans.find(key);
+
+    if ( cached_entry == cached_plans.end( ) ) {
+        PlanPair new_plans;
+        if ( ! MakePlans(key, promote_to_hot ? hot_planner_flags.load( ) : FFTW_ESTIMATE, new_plans) )
+            return false;
+        cached_entry = cached_plans.emplace(key, new_plans).first;
+    }
+    else if ( promote_to_hot && cached_entry->second.planner_flags != hot_planner_flags ) {
+        PlanPair new_plans;
+        if ( MakePlans(key, hot_planner_flags, new_plans) ) {
+            // Images allocated earlier may still hold the old plans, so they are kept alive until the cache is destroyed
+            retired_plans.push_back(cached_entry->second.plan_fwd);
+            retired_plans.push_back(cached_entry->second.plan_bwd);
+            cached_entry->second = new_plans;
+        }
+    }
+
+    wanted_plans = cached_entry->second;
+    return true;
+}
+
+// Must be called with Image::s_mutexProtectingFFTW held.
+// Planning is done on scratch arrays with the same alignment as the requested arrays, so that the rigorous planner flags
+// (which overwrite the arrays during planning) never touch the caller's data and the plans stay valid for the new-array execute interface.
+bool FFTWPlanCache::MakePlans(const PlanKey& key, unsigned planner_flags, PlanPair& new_plans) {
+    long number_of_complex_values = long(key.nx / 2 + 1) * long(key.ny) * long(key.nz);
+    long number_of_real_values    = (key.in_place) ? 2 * number_of_complex_values : long(key.nx) * long(key.ny) * long(key.nz);
+    int  maximum_alignment_bytes  = 64;
+
+    char*  real_scratch    = (char*)fftwf_malloc(sizeof(float) * number_of_real_values + maximum_alignment_bytes);
+    char*  complex_scratch = (key.in_place) ? real_scratch : (char*)fftwf_malloc(sizeof(fftwf_complex) * number_of_complex_values + maximum_alignment_bytes);
+    float* real_array      = reinterpret_cast<float*>(real_scratch + key.real_alignment);
+
+    fftwf_complex* complex_array = (key.in_place) ? reinterpret_cast<fftwf_complex*>(real_array) : reinterpret_cast<fftwf_complex*>(complex_scratch + key.complex_alignment);
+
+    if ( key.nz > 1 ) {
+        new_plans.plan_fwd = fftwf_plan_dft_r2c_3d(key.nz, key.ny, key.nx, real_array, complex_array, planner_flags);
+        new_plans.plan_bwd = fftwf_plan_dft_c2r_3d(key.nz, key.ny, key.nx, complex_array, real_array, planner_flags);
+    }
+    else {
+        new_plans.plan_fwd = fftwf_plan_dft_r2c_2d(key.ny, key.nx, real_array, complex_array, planner_flags);
+        new_plans.plan_bwd = fftwf_plan_dft_c2r_2d(key.ny, key.nx, complex_array, real_array, planner_flags);
+    }
+    new_plans.planner_flags = planner_flags;
+
+    fftwf_free(real_scratch);
+    if ( ! key.in_place )
+        fftwf_free(complex_scratch);
+
+    if ( new_plans.plan_fwd == NULL || new_plans.plan_bwd == NULL ) {
+        MyPrintWithDetails("Error in FFT Planning for %i x %i x %i\n", key.nx, key.ny, key.nz);
+        if ( new_plans.plan_fwd != NULL )
+            fftwf_destroy_plan(new_plans.plan_fwd);
+        if ( new_plans.plan_bwd != NULL )
+            fftwf_destroy_plan(new_plans.plan_bwd);
+        return false;
+    }
+
+    return true;
+}
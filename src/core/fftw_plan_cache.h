@@ -0,0 +1,91 @@
+#ifndef _SRC_CORE_FFTW_PLAN_CACHE_H_
+#define _SRC_CORE_FFTW_PLAN_CACHE_H_
+
+/*  \brief  FFTWPlanCache class - a process-wide store of FFTW plans shared by all Image objects.
+
+	Plans are keyed on the logical dimensions, whether the transform is in-place and the SIMD alignment of the data pointer,
+	which are exactly the conditions under which FFTW allows a plan to be re-used through the new-array execute interface
+	(fftwf_execute_dft_r2c / fftwf_execute_dft_c2r). Plans handed out by the cache are owned by the cache and must never be
+	destroyed by the caller.
+
+	Lookups go through a per-thread table first, so once a thread has seen a given size it neither plans nor takes
+	Image::s_mutexProtectingFFTW again. Sizes that are requested often ("hot" sizes) can optionally be re-planned with a more
+	rigorous planner flag (FFTW_MEASURE / FFTW_PATIENT), and FFTW wisdom can be loaded from and saved to disk.
+
+	Environment variables (read on first use of the cache):
+	  CISTEM_FFTW_WISDOM        filename - wisdom is imported from it on first use, and written back to it by ExportWisdomIfRequested( )
+	  CISTEM_FFTW_HOT_PLANNER   "measure" or "patient" - planner flag used to re-plan hot sizes
+*/
+
+#include <atomic>
+
+class FFTWPlanCache {
+
+  public:
+    struct PlanKey {
+        int  nx;
+        int  ny;
+        int  nz;
+        bool in_place;
+        int  real_alignment;
+        int  complex_alignment;
+
+        bool operator==(const PlanKey& other) const {
+            return nx == other.nx && ny == other.ny && nz == other.nz && in_place == other.in_place && real_alignment == other.real_alignment && complex_alignment == other.complex_alignment;
+        }
+    };
+
+    struct PlanKeyHash {
+        std::size_t operator( )(const PlanKey& key) const {
+            std::size_t seed = std::hash<int>( )(key.nx);
+            seed ^= std::hash<int>( )(key.ny) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<int>( )(key.nz) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<int>( )(key.real_alignment) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<int>( )(key.complex_alignment) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<bool>( )(key.in_place) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    struct PlanPair {
+        fftwf_plan plan_fwd;
+        fftwf_plan plan_bwd;
+        unsigned   planner_flags;
+    };
+
+    static FFTWPlanCache& GetInstance( );
+
+    // Fill plan_fwd and plan_bwd with (shared) plans suitable for transforming real_values <-> complex_values.
+    // Returns false if FFTW could not create a plan.
+    bool ReturnPlans(int nx, int ny, int nz, float* real_values, std::complex<float>* complex_values, fftwf_plan& plan_fwd, fftwf_plan& plan_bwd);
+
+    // Sizes that have been requested at least wanted_number_of_requests times by one thread are re-planned using wanted_planner_flags
+    // (e.g. FFTW_MEASURE or FFTW_PATIENT). A value of FFTW_ESTIMATE (the default) disables the promotion.
+    void SetPlanningRigorForHotSizes(unsigned wanted_planner_flags, int wanted_number_of_requests = 64);
+
+    bool ImportWisdomFromFile(wxString wisdom_filename);
+    bool ExportWisdomToFile(wxString wisdom_filename);
+    bool ExportWisdomIfRequested( );
+
+    long ReturnNumberOfCachedPlans( );
+
+  private:
+    FFTWPlanCache( );
+    ~FFTWPlanCache( );
+
+    FFTWPlanCache(const FFTWPlanCache&)            = delete;
+    FFTWPlanCache& operator=(const FFTWPlanCache&) = delete;
+
+    bool MakePlans(const PlanKey& key, unsigned planner_flags, PlanPair& new_plans);
+    bool ReturnPlansFromGlobalTable(const PlanKey& key, bool promote_to_hot, PlanPair& wanted_plans);
+
+    std::unordered_map<PlanKey, PlanPair, PlanKeyHash> cached_plans;
+    std::vector<fftwf_plan>                            retired_plans; // superseded by hot re-planning, but possibly still referenced by live Images
+
+    wxString environment_wisdom_filename;
+
+    std::atomic<unsigned> hot_planner_flags;
+    std::atomic<int>      hot_size_number_of_requests;
+};
+
+#endif
@@ -8,6 +8,8 @@
 #include <string.h>
 #include <arpa/inet.h>
 
+#include <set>
+
 /**
 @brief 	Swaps bytes.
 @param	*v 			a pointer to the bytes.
@@ -481,6 +483,90 @@ bool FilenameExtensionMatches(std::string filename, std::string extension) {
     return input_filename_ext.IsSameAs(extension, false);
 }
 
+// A batch of micrographs is given as a text file with one filename per line, a star file, or a wildcard pattern
+bool InputIsABatchOfMicrographs(const std::string& input_filename) {
+    return input_filename.find_first_of("*?") != std::string::npos || FilenameExtensionMatches(input_filename, "txt") || FilenameExtensionMatches(input_filename, "star");
+}
+
+bool ReadBatchOfMicrographs(const std::string& input_filename, wxArrayString& micrograph_filenames) {
+    micrograph_filenames.Clear( );
+
+    if ( input_filename.find_first_of("*?") != std::string::npos ) {
+        // Wildcards are only expanded in the filename, not in the directory
+        wxFileName pattern(input_filename);
+        wxString   directory = pattern.GetPath( );
+        if ( directory.IsEmpty( ) )
+            directory = ".";
+        if ( wxDir::Exists(directory) )
+            wxDir::GetAllFiles(directory, &micrograph_filenames, pattern.GetFullName( ), wxDIR_FILES);
+        micrograph_filenames.Sort( );
+        return micrograph_filenames.GetCount( ) > 0;
+    }
+
+    wxTextFile list_file;
+    if ( ! wxFileName::FileExists(input_filename) || ! list_file.Open(input_filename) )
+        return false;
+
+    wxString current_line;
+    if ( FilenameExtensionMatches(input_filename, "star") ) {
+        // Take the micrograph names from the first loop that has a _rlnMicrographName column
+        int  micrograph_name_column = -1;
+        int  number_of_columns      = 0;
+        bool reading_header         = false;
+        for ( current_line = list_file.GetFirstLine( ); ! list_file.Eof( ); current_line = list_file.GetNextLine( ) ) {
+            current_line.Trim(true).Trim(false);
+            if ( current_line.StartsWith("loop_") ) {
+                if ( micrograph_name_column >= 0 )
+                    break;
+                reading_header    = true;
+                number_of_columns = 0;
+                continue;
+            }
+            if ( reading_header && current_line.StartsWith("_") ) {
+                if ( current_line.BeforeFirst(' ').BeforeFirst('\t') == "_rlnMicrographName" )
+                    micrograph_name_column = number_of_columns;
+                number_of_columns++;
+                continue;
+            }
+            reading_header = false;
+            if ( micrograph_name_column < 0 || current_line.IsEmpty( ) || current_line.StartsWith("#") )
+                continue;
+            if ( current_line.StartsWith("data_") )
+                break;
+
+            wxArrayString columns = wxStringTokenize(current_line);
+            if ( int(columns.GetCount( )) > micrograph_name_column )
+                micrograph_filenames.Add(columns[micrograph_name_column]);
+        }
+    }
+    else {
+        for ( current_line = list_file.GetFirstLine( ); ! list_file.Eof( ); current_line = list_file.GetNextLine( ) ) {
+            current_line.Trim(true).Trim(false);
+            if ( ! current_line.IsEmpty( ) && ! current_line.StartsWith("#") )
+                micrograph_filenames.Add(current_line);
+        }
+    }
+
+    list_file.Close( );
+    return micrograph_filenames.GetCount( ) > 0;
+}
+
+bool ReturnBatchOutputFilenames(const std::string& output_filename, const wxArrayString& micrograph_filenames, std::vector<std::string>& output_filenames, std::string& duplicate_output_filename) {
+    std::set<std::string> unique_output_filenames;
+
+    output_filenames.resize(micrograph_filenames.GetCount( ));
+    duplicate_output_filename.clear( );
+    for ( size_t micrograph_counter = 0; micrograph_counter < micrograph_filenames.GetCount( ); micrograph_counter++ ) {
+        output_filenames[micrograph_counter] = FilenameAddSuffix(output_filename, "_" + wxFileName(micrograph_filenames[micrograph_counter]).GetName( ).ToStdString( ));
+        if ( ! unique_output_filenames.insert(output_filenames[micrograph_counter]).second ) {
+            duplicate_output_filename = output_filenames[micrograph_counter];
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /*
  *
  * String manipulations
@@ -1039,6 +1125,15 @@ wxString StringFromSocketCode(unsigned char* socket_input_buffer) {
     if ( memcmp(socket_input_buffer, socket_result_with_image_to_write, SOCKET_CODE_SIZE) == 0 ) {
         return "socket_result_with_image_to_write";
     }
+    if ( memcmp(socket_input_buffer, socket_ready_to_send_job_window, SOCKET_CODE_SIZE) == 0 ) {
+        return "socket_ready_to_send_job_window";
+    }
+    if ( memcmp(socket_input_buffer, socket_job_finished_send_more, SOCKET_CODE_SIZE) == 0 ) {
+        return "socket_job_finished_send_more";
+    }
+    if ( memcmp(socket_input_buffer, socket_send_profile_summary, SOCKET_CODE_SIZE) == 0 ) {
+        return "socket_send_profile_summary";
+    }
     return "socket code not recognized";
 }
 
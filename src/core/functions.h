@@ -392,6 +392,14 @@ void ReturnBestFourierBinnedSize(float& output_binning_factor, int& dx, int& dy,
 
 bool FilenameExtensionMatches(std::string filename, std::string extension);
 
+// A batch of micrographs is given as a text file with one filename per line, a star file (the _rlnMicrographName column
+// of the first loop that has one), or a wildcard pattern in the filename. Returns false if no micrographs were found.
+bool InputIsABatchOfMicrographs(const std::string& input_filename);
+bool ReadBatchOfMicrographs(const std::string& input_filename, wxArrayString& micrograph_filenames);
+// Every micrograph of a batch gets its own output, named after output_filename with "_" and the name of the micrograph added.
+// Returns false, with the name in duplicate_output_filename, when two micrographs would be written to the same output.
+bool ReturnBatchOutputFilenames(const std::string& output_filename, const wxArrayString& micrograph_filenames, std::vector<std::string>& output_filenames, std::string& duplicate_output_filename);
+
 /*
  *
  * String manipulations
@@ -60,7 +60,8 @@ void Image::SetupInitialValues( ) {
     plan_fwd = NULL;
     plan_bwd = NULL;
 
-    planned = false;
+    planned          = false;
+    plans_are_shared = false;
 
     padding_jump_value                     = 0;
     image_memory_should_not_be_deallocated = false;
@@ -2401,6 +2402,7 @@ void Image::RotateFourier2D(Image& rotated_image, AnglesAndShifts& rotation_angl
  * @param apply_resolution_limit 
  */
 void Image::ExtractSlice(Image& image_to_extract, AnglesAndShifts& angles_and_shifts_of_image, float resolution_limit, bool apply_resolution_limit) {
+    cistem_timer::ProfileScope profile_scope("ExtractSlice");
     //	MyDebugAssertTrue(image_to_extract.logical_x_dimension == logical_x_dimension && image_to_extract.logical_y_dimension == logical_y_dimension, "Error: Images different sizes");
     MyDebugAssertTrue(image_to_extract.logical_z_dimension == 1, "Error: attempting to extract 3D image from 3D reconstruction");
     MyDebugAssertTrue(image_to_extract.is_in_memory, "Memory not allocated for receiving image");
@@ -3014,56 +3016,66 @@ void Image::CalculateCTFImage(CTF& ctf_of_image, bool calculate_complex_ctf, boo
     }
     //	MyDebugAssertTrue(is_in_real_space == false, "CTF image not in Fourier space");
 
-    int i;
-    int j;
+    std::shared_ptr<const CTFFrequencyGrid> frequency_grid = CTFFrequencyGrid::ReturnGrid(*this);
 
-    long pixel_counter      = 0;
-    long pixel_counter_fp16 = 0;
-
-    float x_coordinate_2d;
-    float y_coordinate_2d;
+    int  j;
+    int  i;
+    long pixel_counter;
 
-    float y_coord_sq;
+    if ( ! frequency_grid ) {
+        // The box is too large for a cached grid, so the CTF is evaluated pixel by pixel
+        float x_coordinate_2d;
+        float y_coordinate_2d;
+        float frequency_squared;
+        float azimuth;
 
-    float frequency_squared;
-    float azimuth;
+        pixel_counter = 0;
+        for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
+            y_coordinate_2d = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * fourier_voxel_size_y;
+            for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
+                x_coordinate_2d   = i * fourier_voxel_size_x;
+                azimuth           = (i == 0 && j == 0) ? 0.0f : atan2f(y_coordinate_2d, x_coordinate_2d);
+                frequency_squared = powf(x_coordinate_2d, 2) + powf(y_coordinate_2d, 2);
 
-    for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
-        y_coordinate_2d = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * fourier_voxel_size_y;
-        y_coord_sq      = powf(y_coordinate_2d, 2);
+                if ( calculate_complex_ctf )
+                    complex_values[pixel_counter] = ctf_of_image.EvaluateComplex(frequency_squared, azimuth);
+                else if ( apply_coherence_envelope )
+                    complex_values[pixel_counter] = ctf_of_image.EvaluateWithEnvelope(frequency_squared, azimuth) + I * 0.0f;
+                else
+                    complex_values[pixel_counter] = ctf_of_image.Evaluate(frequency_squared, azimuth) + I * 0.0f;
 
-        for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
-            x_coordinate_2d = i * fourier_voxel_size_x;
-            // Compute the azimuth
-            if ( i == 0 && j == 0 ) {
-                azimuth = 0.0;
-            }
-            else {
-                azimuth = atan2f(y_coordinate_2d, x_coordinate_2d);
+                pixel_counter++;
             }
-            // Compute the square of the frequency
-            frequency_squared = powf(x_coordinate_2d, 2) + y_coord_sq;
+        }
+    }
+    else {
+        std::vector<float> ctf_row(frequency_grid->number_of_columns);
+
+        for ( j = 0; j < frequency_grid->number_of_rows; j++ ) {
+            pixel_counter = frequency_grid->ReturnFirstPixelOfRow(j);
 
             if ( calculate_complex_ctf ) {
-                complex_values[pixel_counter] = ctf_of_image.EvaluateComplex(frequency_squared, azimuth);
+                ctf_of_image.EvaluateComplexRow(*frequency_grid, j, &complex_values[pixel_counter]);
             }
             else {
                 if ( apply_coherence_envelope )
-                    complex_values[pixel_counter] = ctf_of_image.EvaluateWithEnvelope(frequency_squared, azimuth) + I * 0.0f;
+                    ctf_of_image.EvaluateRowWithEnvelope(*frequency_grid, j, ctf_row.data( ));
                 else
-                    complex_values[pixel_counter] = ctf_of_image.Evaluate(frequency_squared, azimuth) + I * 0.0f;
-            }
+                    ctf_of_image.EvaluateRow(*frequency_grid, j, ctf_row.data( ));
 
-            if ( use_half_precision ) {
-                // On the cpu half library, we don't have vector types, to manually interleave the real and imag parts
-                // real_values_16f[pixel_counter_fp16]     = half_float::half_cast<half>(real(ctf_value));
-                // real_values_16f[pixel_counter_fp16 + 1] = half_float::half_cast<half>(imag(ctf_value));
-                real_values_16f[pixel_counter_fp16]     = half_float::half(real(complex_values[pixel_counter]));
-                real_values_16f[pixel_counter_fp16 + 1] = half_float::half(imag(complex_values[pixel_counter]));
-                pixel_counter_fp16 += 2;
+                for ( i = 0; i < frequency_grid->number_of_columns; i++ ) {
+                    complex_values[pixel_counter + i] = ctf_row[i] + I * 0.0f;
+                }
             }
+        }
+    }
 
-            pixel_counter++;
+    if ( use_half_precision ) {
+        // On the cpu half library, we don't have vector types, to manually interleave the real and imag parts
+        const long number_of_pixels = long(physical_upper_bound_complex_x + 1) * long(physical_upper_bound_complex_y + 1);
+        for ( pixel_counter = 0; pixel_counter < number_of_pixels; pixel_counter++ ) {
+            real_values_16f[2 * pixel_counter]     = half_float::half(real(complex_values[pixel_counter]));
+            real_values_16f[2 * pixel_counter + 1] = half_float::half(imag(complex_values[pixel_counter]));
         }
     }
 
@@ -3074,45 +3086,50 @@ void Image::CalculateBeamTiltImage(CTF& ctf_of_image, bool output_phase_shifts)
     MyDebugAssertTrue(is_in_memory, "Memory not allocated for beam tilt image");
     //	MyDebugAssertTrue(is_in_real_space == false, "beam tilt image not in Fourier space");
 
-    int i;
-    int j;
-
-    long pixel_counter = 0;
+    std::shared_ptr<const CTFFrequencyGrid> frequency_grid = CTFFrequencyGrid::ReturnGrid(*this);
 
-    float x_coordinate_2d;
-    float y_coordinate_2d;
+    int  j;
+    int  i;
+    long pixel_counter;
 
-    float y_coord_sq;
+    if ( ! frequency_grid ) {
+        // The box is too large for a cached grid, so the phase shifts are evaluated pixel by pixel
+        float x_coordinate_2d;
+        float y_coordinate_2d;
+        float frequency_squared;
+        float azimuth;
 
-    float frequency_squared;
-    float azimuth;
-    float phase_shift;
+        pixel_counter = 0;
+        for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
+            y_coordinate_2d = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * fourier_voxel_size_y;
+            for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
+                x_coordinate_2d   = i * fourier_voxel_size_x;
+                azimuth           = (i == 0 && j == 0) ? 0.0f : atan2f(y_coordinate_2d, x_coordinate_2d);
+                frequency_squared = powf(x_coordinate_2d, 2) + powf(y_coordinate_2d, 2);
 
-    for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
-        y_coordinate_2d = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * fourier_voxel_size_y;
-        y_coord_sq      = powf(y_coordinate_2d, 2);
+                if ( output_phase_shifts )
+                    complex_values[pixel_counter] = ctf_of_image.PhaseShiftGivenBeamTiltAndShift(frequency_squared, ctf_of_image.BeamTiltGivenAzimuth(azimuth), ctf_of_image.ParticleShiftGivenAzimuth(azimuth)) + I * 0.0f;
+                else
+                    complex_values[pixel_counter] = ctf_of_image.EvaluateBeamTiltPhaseShift(frequency_squared, azimuth);
 
-        for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
-            x_coordinate_2d = i * fourier_voxel_size_x;
-            // Compute the azimuth
-            if ( i == 0 && j == 0 )
-                azimuth = 0.0;
-            else
-                azimuth = atan2f(y_coordinate_2d, x_coordinate_2d);
-            // Compute the square of the frequency
-            frequency_squared = powf(x_coordinate_2d, 2) + y_coord_sq;
+                pixel_counter++;
+            }
+        }
+    }
+    else {
+        std::vector<float> phase_shift_row(frequency_grid->number_of_columns);
 
-            //			phase_shift = 2.0f * PI * (x_coordinate_2d * image_shift_x + y_coordinate_2d * image_shift_y);
+        for ( j = 0; j < frequency_grid->number_of_rows; j++ ) {
+            pixel_counter = frequency_grid->ReturnFirstPixelOfRow(j);
 
             if ( output_phase_shifts ) {
-                phase_shift                   = ctf_of_image.PhaseShiftGivenBeamTiltAndShift(frequency_squared, ctf_of_image.BeamTiltGivenAzimuth(azimuth), ctf_of_image.ParticleShiftGivenAzimuth(azimuth));
-                complex_values[pixel_counter] = phase_shift + I * 0.0f;
+                ctf_of_image.PhaseShiftGivenBeamTiltAndShiftRow(*frequency_grid, j, phase_shift_row.data( ));
+                for ( i = 0; i < frequency_grid->number_of_columns; i++ ) {
+                    complex_values[pixel_counter + i] = phase_shift_row[i] + I * 0.0f;
+                }
             }
             else
-                complex_values[pixel_counter] = ctf_of_image.EvaluateBeamTiltPhaseShift(frequency_squared, azimuth);
-            //			else complex_values[pixel_counter] = ctf_of_image.EvaluateBeamTiltPhaseShift(frequency_squared, azimuth) * (cosf( phase_shift ) + I * sinf( phase_shift ));
-
-            pixel_counter++;
+                ctf_of_image.EvaluateBeamTiltPhaseShiftRow(*frequency_grid, j, &complex_values[pixel_counter]);
         }
     }
 
@@ -4480,11 +4497,17 @@ void Image::Deallocate( ) {
     }
 
     if ( planned == true ) {
-        wxMutexLocker lock(s_mutexProtectingFFTW); // the mutex will be unlocked when this object is destroyed (when it goes out of scope)
-        MyDebugAssertTrue(lock.IsOk( ), "Mute locking failed");
-        fftwf_destroy_plan(plan_fwd);
-        fftwf_destroy_plan(plan_bwd);
-        planned = false;
+        if ( plans_are_shared == false ) {
+            wxMutexLocker lock(s_mutexProtectingFFTW); // the mutex will be unlocked when this object is destroyed (when it goes out of scope)
+            MyDebugAssertTrue(lock.IsOk( ), "Mute locking failed");
+            fftwf_destroy_plan(plan_fwd);
+            fftwf_destroy_plan(plan_bwd);
+        }
+        // plans from the FFTWPlanCache are owned by the cache, we just forget about them
+        plan_fwd         = NULL;
+        plan_bwd         = NULL;
+        planned          = false;
+        plans_are_shared = false;
     }
 
 #ifdef ENABLEGPU
@@ -4550,25 +4573,18 @@ void Image::Allocate(int wanted_x_size, int wanted_y_size, int wanted_z_size, bo
 
     // Prepare the plans for FFTW
 
+    // Plans are shared between all images of the same size through the FFTWPlanCache, so only the first
+    // allocation of a given size (per thread) pays for planning and for the FFTW mutex.
+
     if ( planned == false && do_fft_planning == true ) // skip fft planning at your peril!
     {
-        wxMutexLocker lock(s_mutexProtectingFFTW); // the mutex will be unlocked when this object is destroyed (when it goes out of scope)
-        MyDebugAssertTrue(lock.IsOk( ), "Mute locking failed");
-        if ( logical_z_dimension > 1 ) {
-            plan_fwd = fftwf_plan_dft_r2c_3d(logical_z_dimension, logical_y_dimension, logical_x_dimension, real_values, reinterpret_cast<fftwf_complex*>(complex_values), FFTW_ESTIMATE);
-            plan_bwd = fftwf_plan_dft_c2r_3d(logical_z_dimension, logical_y_dimension, logical_x_dimension, reinterpret_cast<fftwf_complex*>(complex_values), real_values, FFTW_ESTIMATE);
-        }
-        else {
-            plan_fwd = fftwf_plan_dft_r2c_2d(logical_y_dimension, logical_x_dimension, real_values, reinterpret_cast<fftwf_complex*>(complex_values), FFTW_ESTIMATE);
-            plan_bwd = fftwf_plan_dft_c2r_2d(logical_y_dimension, logical_x_dimension, reinterpret_cast<fftwf_complex*>(complex_values), real_values, FFTW_ESTIMATE);
-        }
-
-        if ( plan_fwd == NULL || plan_bwd == NULL ) {
+        if ( FFTWPlanCache::GetInstance( ).ReturnPlans(logical_x_dimension, logical_y_dimension, logical_z_dimension, real_values, complex_values, plan_fwd, plan_bwd) == false ) {
             MyPrintWithDetails("Error in FFT Planning...");
             DEBUG_ABORT;
         }
 
-        planned = true;
+        planned          = true;
+        plans_are_shared = true;
     }
 
     // set the loop junk value..
@@ -4645,19 +4661,14 @@ void Image::AllocateAsPointingToSliceIn3D(Image* wanted3d, long wanted_slice) {
     // Prepare the plans for FFTW
 
     if ( planned == false ) {
-        wxMutexLocker lock(s_mutexProtectingFFTW); // the mutex will be unlocked when this object is destroyed (when it goes out of scope)
-        MyDebugAssertTrue(lock.IsOk( ), "Mute locking failed");
-
-        if ( logical_z_dimension > 1 ) {
-            plan_fwd = fftwf_plan_dft_r2c_3d(logical_z_dimension, logical_y_dimension, logical_x_dimension, real_values, reinterpret_cast<fftwf_complex*>(complex_values), FFTW_ESTIMATE);
-            plan_bwd = fftwf_plan_dft_c2r_3d(logical_z_dimension, logical_y_dimension, logical_x_dimension, reinterpret_cast<fftwf_complex*>(complex_values), real_values, FFTW_ESTIMATE);
-        }
-        else {
-            plan_fwd = fftwf_plan_dft_r2c_2d(logical_y_dimension, logical_x_dimension, real_values, reinterpret_cast<fftwf_complex*>(complex_values), FFTW_ESTIMATE);
-            plan_bwd = fftwf_plan_dft_c2r_2d(logical_y_dimension, logical_x_dimension, reinterpret_cast<fftwf_complex*>(complex_values), real_values, FFTW_ESTIMATE);
+        // the slice may not share the alignment of a freshly allocated image, the cache keys on that
+        if ( FFTWPlanCache::GetInstance( ).ReturnPlans(logical_x_dimension, logical_y_dimension, logical_z_dimension, real_values, complex_values, plan_fwd, plan_bwd) == false ) {
+            MyPrintWithDetails("Error in FFT Planning...");
+            DEBUG_ABORT;
         }
 
-        planned = true;
+        planned          = true;
+        plans_are_shared = true;
     }
 
     // set the loop jump value..
@@ -5080,9 +5091,79 @@ void Image::ReadSlices(MRCFile* input_file, long start_slice, long end_slice) {
     is_in_real_space         = true;
     object_is_centred_in_box = true;
 
-    input_file->ReadSlicesFromDisk(start_slice, end_slice, real_values);
+    if ( CopyFromMemoryMappedFile(input_file, start_slice, end_slice) == false ) {
+        input_file->ReadSlicesFromDisk(start_slice, end_slice, real_values);
 
-    // we need to respace this to take into account the FFTW padding..
+        // we need to respace this to take into account the FFTW padding..
+
+        AddFFTWPadding( );
+    }
+}
+
+//!> \brief If the file is memory mapped float32, copy the rows straight from the page cache into their padded positions (no AddFFTWPadding pass needed)
+
+bool Image::CopyFromMemoryMappedFile(MRCFile* input_file, long start_slice, long end_slice) {
+    const float* mapped_values = input_file->ReturnPointerToSlicesInMemoryMap(start_slice, end_slice);
+
+    if ( mapped_values == NULL )
+        return false;
+
+    long output_address = 0;
+    long input_address  = 0;
+
+    for ( int k = 0; k < logical_z_dimension; k++ ) {
+        for ( int j = 0; j < logical_y_dimension; j++ ) {
+            memcpy(&real_values[output_address], &mapped_values[input_address], sizeof(float) * logical_x_dimension);
+            output_address += logical_x_dimension + padding_jump_value;
+            input_address += logical_x_dimension;
+        }
+    }
+
+    return true;
+}
+
+//!> \brief Read a set of slices from disk without touching any state shared with other readers of input_file, so that many threads can read from one file at once
+
+void Image::ReadSlicesThreadSafe(MRCFile* input_file, long start_slice, long end_slice) {
+
+    MyDebugAssertTrue(start_slice <= end_slice, "Start slice larger than end slice!");
+    MyDebugAssertTrue(start_slice > 0, "Start slice is less than 0, the first slice is 1!");
+    MyDebugAssertTrue(end_slice <= input_file->ReturnNumberOfSlices( ), "End slice is greater than number of slices in the file!");
+
+    int number_of_slices = (end_slice - start_slice) + 1;
+
+    if ( logical_x_dimension != input_file->ReturnXSize( ) || logical_y_dimension != input_file->ReturnYSize( ) || logical_z_dimension != number_of_slices || is_in_memory == false ) {
+        Deallocate( );
+        Allocate(input_file->ReturnXSize( ), input_file->ReturnYSize( ), number_of_slices);
+    }
+
+    is_in_real_space         = true;
+    object_is_centred_in_box = true;
+
+    if ( CopyFromMemoryMappedFile(input_file, start_slice, end_slice) == false ) {
+        input_file->ReadSlicesFromDiskThreadSafe(start_slice, end_slice, real_values);
+        AddFFTWPadding( );
+    }
+}
+
+void Image::ReadSlicesThreadSafe(ImageFile* input_file, long start_slice, long end_slice) {
+
+    MyDebugAssertTrue(start_slice <= end_slice, "Start slice larger than end slice!");
+    MyDebugAssertTrue(start_slice > 0, "Start slice is less than 0, the first slice is 1!");
+    MyDebugAssertTrue(end_slice <= input_file->ReturnNumberOfSlices( ), "End slice is greater than number of slices in the file!");
+    MyDebugAssertTrue(input_file->IsOpen( ), "Image file is not open!");
+
+    int number_of_slices = (end_slice - start_slice) + 1;
+
+    if ( logical_x_dimension != input_file->ReturnXSize( ) || logical_y_dimension != input_file->ReturnYSize( ) || logical_z_dimension != number_of_slices || is_in_memory == false ) {
+        Deallocate( );
+        Allocate(input_file->ReturnXSize( ), input_file->ReturnYSize( ), number_of_slices);
+    }
+
+    is_in_real_space         = true;
+    object_is_centred_in_box = true;
+
+    input_file->ReadSlicesFromDiskThreadSafe(start_slice, end_slice, real_values);
 
     AddFFTWPadding( );
 }
@@ -8465,17 +8546,19 @@ void Image::Consume(Image* other_image) // copy the parameters then directly ste
     complex_values = other_image->complex_values;
     is_in_memory   = other_image->is_in_memory;
 
-    plan_fwd = other_image->plan_fwd;
-    plan_bwd = other_image->plan_bwd;
-    planned  = other_image->planned;
+    plan_fwd         = other_image->plan_fwd;
+    plan_bwd         = other_image->plan_bwd;
+    planned          = other_image->planned;
+    plans_are_shared = other_image->plans_are_shared;
 
     other_image->real_values    = NULL;
     other_image->complex_values = NULL;
     other_image->is_in_memory   = false;
 
-    other_image->plan_fwd = NULL;
-    other_image->plan_bwd = NULL;
-    other_image->planned  = false;
+    other_image->plan_fwd         = NULL;
+    other_image->plan_bwd         = NULL;
+    other_image->planned          = false;
+    other_image->plans_are_shared = false;
 
     number_of_real_space_pixels = other_image->number_of_real_space_pixels;
     ft_normalization_factor     = other_image->ft_normalization_factor;
@@ -8633,6 +8716,8 @@ void Image::Abs( ) {
     }
 }
 
+// The phase shift is separable, so it is applied as the product of one table of complex exponentials per dimension (indexed by physical address)
+// instead of calling sincos for every voxel
 void Image::PhaseShift(float wanted_x_shift, float wanted_y_shift, float wanted_z_shift) {
     MyDebugAssertTrue(is_in_memory, "Memory not allocated");
 
@@ -8641,41 +8726,41 @@ void Image::PhaseShift(float wanted_x_shift, float wanted_y_shift, float wanted_
     long pixel_counter = 0;
 
     int k;
-    int k_logical;
-
     int j;
-    int j_logical;
-
     int i;
 
-    float phase_z;
-    float phase_y;
-    float phase_x;
+    std::complex<float>  phase_shift_yz;
+    std::complex<float>* complex_row;
 
-    std::complex<float> total_phase_shift;
+    std::vector<std::complex<float>> phase_shifts_x(physical_upper_bound_complex_x + 1);
+    std::vector<std::complex<float>> phase_shifts_y(physical_upper_bound_complex_y + 1);
+    std::vector<std::complex<float>> phase_shifts_z(physical_upper_bound_complex_z + 1);
 
     if ( is_in_real_space == true ) {
         ForwardFFT( );
         need_to_fft = true;
     }
 
+    for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
+        phase_shifts_x[i] = Return3DPhaseFromIndividualDimensions(ReturnPhaseFromShift(wanted_x_shift, i, logical_x_dimension), 0.0f, 0.0f);
+    }
+    for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
+        phase_shifts_y[j] = Return3DPhaseFromIndividualDimensions(0.0f, ReturnPhaseFromShift(wanted_y_shift, ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j), logical_y_dimension), 0.0f);
+    }
     for ( k = 0; k <= physical_upper_bound_complex_z; k++ ) {
-        k_logical = ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k);
-        phase_z   = ReturnPhaseFromShift(wanted_z_shift, k_logical, logical_z_dimension);
+        phase_shifts_z[k] = Return3DPhaseFromIndividualDimensions(0.0f, 0.0f, ReturnPhaseFromShift(wanted_z_shift, ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k), logical_z_dimension));
+    }
 
+    for ( k = 0; k <= physical_upper_bound_complex_z; k++ ) {
         for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
-            j_logical = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
-            phase_y   = ReturnPhaseFromShift(wanted_y_shift, j_logical, logical_y_dimension);
+            phase_shift_yz = phase_shifts_y[j] * phase_shifts_z[k];
+            complex_row    = &complex_values[pixel_counter];
 
             for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
-
-                phase_x = ReturnPhaseFromShift(wanted_x_shift, i, logical_x_dimension);
-
-                total_phase_shift = Return3DPhaseFromIndividualDimensions(phase_x, phase_y, phase_z);
-                complex_values[pixel_counter] *= total_phase_shift;
-
-                pixel_counter++;
+                complex_row[i] *= phase_shifts_x[i] * phase_shift_yz;
             }
+
+            pixel_counter += physical_upper_bound_complex_x + 1;
         }
     }
 
@@ -8683,6 +8768,60 @@ void Image::PhaseShift(float wanted_x_shift, float wanted_y_shift, float wanted_
         BackwardFFT( );
 }
 
+void Image::PhaseShiftStack(Image* image_stack, int number_of_images, const float* x_shifts, const float* y_shifts, int wanted_number_of_threads) {
+    MyDebugAssertTrue(number_of_images > 0, "Nothing to shift");
+    MyDebugAssertTrue(wanted_number_of_threads > 0, "Number of threads must be positive (%i)", wanted_number_of_threads);
+    MyDebugAssertTrue(image_stack[0].is_in_memory, "Memory not allocated");
+    MyDebugAssertTrue(image_stack[0].logical_z_dimension == 1, "Only 2D images are supported");
+
+    const int number_of_columns   = image_stack[0].physical_upper_bound_complex_x + 1;
+    const int number_of_rows      = image_stack[0].physical_upper_bound_complex_y + 1;
+    const int logical_x_dimension = image_stack[0].logical_x_dimension;
+    const int logical_y_dimension = image_stack[0].logical_y_dimension;
+
+    // The Fourier coordinates of the rows are the same for every image of the stack
+    std::vector<int> logical_y_coordinates(number_of_rows);
+    for ( int j = 0; j < number_of_rows; j++ ) {
+        logical_y_coordinates[j] = image_stack[0].ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
+    }
+
+#pragma omp parallel num_threads(wanted_number_of_threads)
+    {
+        // Each thread fills its phase tables again for every image, rather than allocating them
+        std::vector<std::complex<float>> phase_shifts_x(number_of_columns);
+        std::vector<std::complex<float>> phase_shifts_y(number_of_rows);
+
+#pragma omp for schedule(static)
+        for ( int image_counter = 0; image_counter < number_of_images; image_counter++ ) {
+            Image& current_image = image_stack[image_counter];
+            MyDebugAssertTrue(current_image.is_in_memory, "Memory not allocated");
+            MyDebugAssertTrue(current_image.logical_x_dimension == logical_x_dimension && current_image.logical_y_dimension == logical_y_dimension && current_image.logical_z_dimension == 1, "Images of the stack must all have the same 2D dimensions");
+
+            bool need_to_fft = current_image.is_in_real_space;
+            if ( need_to_fft == true )
+                current_image.ForwardFFT( );
+
+            for ( int i = 0; i < number_of_columns; i++ ) {
+                phase_shifts_x[i] = Return3DPhaseFromIndividualDimensions(ReturnPhaseFromShift(x_shifts[image_counter], i, logical_x_dimension), 0.0f, 0.0f);
+            }
+            for ( int j = 0; j < number_of_rows; j++ ) {
+                phase_shifts_y[j] = Return3DPhaseFromIndividualDimensions(0.0f, ReturnPhaseFromShift(y_shifts[image_counter], logical_y_coordinates[j], logical_y_dimension), 0.0f);
+            }
+
+            std::complex<float>* complex_row = current_image.complex_values;
+            for ( int j = 0; j < number_of_rows; j++ ) {
+                for ( int i = 0; i < number_of_columns; i++ ) {
+                    complex_row[i] *= phase_shifts_x[i] * phase_shifts_y[j];
+                }
+                complex_row += number_of_columns;
+            }
+
+            if ( need_to_fft == true )
+                current_image.BackwardFFT( );
+        }
+    }
+}
+
 //END_FOR_STAND_ALONE_CTFFIND
 
 void Image::ApplyCTFPhaseFlip(CTF ctf_to_apply) {
@@ -8690,45 +8829,41 @@ void Image::ApplyCTFPhaseFlip(CTF ctf_to_apply) {
     MyDebugAssertTrue(is_in_real_space == false, "image not in Fourier space");
     MyDebugAssertTrue(logical_z_dimension == 1, "Volumes not supported");
 
-    int j;
-    int i;
+    std::shared_ptr<const CTFFrequencyGrid> frequency_grid = CTFFrequencyGrid::ReturnGrid(*this);
 
-    long pixel_counter = 0;
+    int                  j;
+    int                  i;
+    std::complex<float>* complex_row;
 
-    float y_coord_sq;
-    float x_coord_sq;
-
-    float y_coord;
-    float x_coord;
-
-    float frequency_squared;
-    float azimuth;
-    float ctf_value;
-
-    for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
-        y_coord    = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * fourier_voxel_size_y;
-        y_coord_sq = powf(y_coord, 2.0);
-
-        for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
-            x_coord    = i * fourier_voxel_size_x;
-            x_coord_sq = powf(x_coord, 2);
+    if ( ! frequency_grid ) {
+        // The box is too large for a cached grid, so the CTF is evaluated pixel by pixel
+        long  pixel_counter = 0;
+        float x_coord;
+        float y_coord;
+        float azimuth;
 
-            // Compute the azimuth
-            if ( i == 0 && j == 0 ) {
-                azimuth = 0.0;
-            }
-            else {
-                azimuth = atan2f(y_coord, x_coord);
+        for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
+            y_coord = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * fourier_voxel_size_y;
+            for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
+                x_coord = i * fourier_voxel_size_x;
+                azimuth = (i == 0 && j == 0) ? 0.0f : atan2f(y_coord, x_coord);
+                if ( ctf_to_apply.Evaluate(powf(x_coord, 2) + powf(y_coord, 2), azimuth) < 0.0f )
+                    complex_values[pixel_counter] = -1.0f * complex_values[pixel_counter];
+                pixel_counter++;
             }
+        }
+        return;
+    }
 
-            // Compute the square of the frequency
-            frequency_squared = x_coord_sq + y_coord_sq;
+    std::vector<float> ctf_row(frequency_grid->number_of_columns);
 
-            ctf_value = ctf_to_apply.Evaluate(frequency_squared, azimuth);
+    for ( j = 0; j < frequency_grid->number_of_rows; j++ ) {
+        ctf_to_apply.EvaluateRow(*frequency_grid, j, ctf_row.data( ));
+        complex_row = &complex_values[frequency_grid->ReturnFirstPixelOfRow(j)];
 
-            if ( ctf_value < 0.0 )
-                complex_values[pixel_counter] = -1.0f * complex_values[pixel_counter];
-            pixel_counter++;
+        for ( i = 0; i < frequency_grid->number_of_columns; i++ ) {
+            if ( ctf_row[i] < 0.0f )
+                complex_row[i] = -1.0f * complex_row[i];
         }
     }
 }
@@ -8738,63 +8873,76 @@ void Image::ApplyCTF(CTF ctf_to_apply, bool absolute, bool apply_beam_tilt, bool
     MyDebugAssertTrue(is_in_real_space == false, "image not in Fourier space");
     MyDebugAssertTrue(logical_z_dimension == 1, "Volumes not supported");
 
-    int j;
-    int i;
+    std::shared_ptr<const CTFFrequencyGrid> frequency_grid = CTFFrequencyGrid::ReturnGrid(*this);
 
-    long pixel_counter = 0;
+    int                  j;
+    int                  i;
+    std::complex<float>* complex_row;
 
-    float y_coord_sq;
-    float x_coord_sq;
+    apply_beam_tilt = apply_beam_tilt && (ctf_to_apply.GetBeamTiltX( ) != 0.0f || ctf_to_apply.GetBeamTiltY( ) != 0.0f);
 
-    float y_coord;
-    float x_coord;
+    if ( ! frequency_grid ) {
+        // The box is too large for a cached grid, so the CTF is evaluated pixel by pixel
+        long  pixel_counter = 0;
+        float x_coord;
+        float y_coord;
+        float frequency_squared;
+        float azimuth;
+        float ctf_value;
 
-    float frequency_squared;
-    float azimuth;
-    float ctf_value;
+        for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
+            y_coord = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * fourier_voxel_size_y;
+            for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
+                x_coord           = i * fourier_voxel_size_x;
+                azimuth           = (i == 0 && j == 0) ? 0.0f : atan2f(y_coord, x_coord);
+                frequency_squared = powf(x_coord, 2) + powf(y_coord, 2);
 
-    for ( j = 0; j <= physical_upper_bound_complex_y; j++ ) {
-        y_coord    = ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * fourier_voxel_size_y;
-        y_coord_sq = powf(y_coord, 2.0);
+                ctf_value = (apply_envelope) ? ctf_to_apply.EvaluateWithEnvelope(frequency_squared, azimuth) : ctf_to_apply.Evaluate(frequency_squared, azimuth);
+                if ( absolute )
+                    ctf_value = fabsf(ctf_value);
 
-        for ( i = 0; i <= physical_upper_bound_complex_x; i++ ) {
-            x_coord    = i * fourier_voxel_size_x;
-            x_coord_sq = powf(x_coord, 2);
+                complex_values[pixel_counter] *= ctf_value;
+                if ( apply_beam_tilt )
+                    complex_values[pixel_counter] *= ctf_to_apply.EvaluateBeamTiltPhaseShift(frequency_squared, azimuth);
 
-            // Compute the azimuth
-            if ( i == 0 && j == 0 ) {
-                azimuth = 0.0;
-            }
-            else {
-                azimuth = atan2f(y_coord, x_coord);
+                pixel_counter++;
             }
+        }
+        return;
+    }
 
-            // Compute the square of the frequency
-            frequency_squared = x_coord_sq + y_coord_sq;
+    std::vector<float>               ctf_row(frequency_grid->number_of_columns);
+    std::vector<std::complex<float>> beam_tilt_row;
+    if ( apply_beam_tilt )
+        beam_tilt_row.resize(frequency_grid->number_of_columns);
 
-            if ( apply_envelope ) {
-                ctf_value = ctf_to_apply.EvaluateWithEnvelope(frequency_squared, azimuth);
-            }
-            else {
-                ctf_value = ctf_to_apply.Evaluate(frequency_squared, azimuth);
-            }
+    for ( j = 0; j < frequency_grid->number_of_rows; j++ ) {
+        if ( apply_envelope ) {
+            ctf_to_apply.EvaluateRowWithEnvelope(*frequency_grid, j, ctf_row.data( ));
+        }
+        else {
+            ctf_to_apply.EvaluateRow(*frequency_grid, j, ctf_row.data( ));
+        }
 
-            if ( absolute )
-                ctf_value = fabsf(ctf_value);
+        if ( absolute ) {
+            for ( i = 0; i < frequency_grid->number_of_columns; i++ ) {
+                ctf_row[i] = fabsf(ctf_row[i]);
+            }
+        }
 
-            complex_values[pixel_counter] *= ctf_value;
+        complex_row = &complex_values[frequency_grid->ReturnFirstPixelOfRow(j)];
 
-            if ( apply_beam_tilt && (ctf_to_apply.GetBeamTiltX( ) != 0.0f || ctf_to_apply.GetBeamTiltY( ) != 0.0f) )
-                complex_values[pixel_counter] *= ctf_to_apply.EvaluateBeamTiltPhaseShift(frequency_squared, azimuth);
+        for ( i = 0; i < frequency_grid->number_of_columns; i++ ) {
+            complex_row[i] *= ctf_row[i];
+        }
 
-            pixel_counter++;
+        if ( apply_beam_tilt ) {
+            ctf_to_apply.EvaluateBeamTiltPhaseShiftRow(*frequency_grid, j, beam_tilt_row.data( ));
+            for ( i = 0; i < frequency_grid->number_of_columns; i++ ) {
+                complex_row[i] *= beam_tilt_row[i];
+            }
         }
     }
-    //	Image temp_image;
-    //	temp_image.Allocate(logical_x_dimension, logical_y_dimension, false);
-    //	ComputeAmplitudeSpectrumFull2D(&temp_image, true);
-    //	temp_image.QuickAndDirtyWriteSlice("junk.mrc", 1);
-    //	exit(0);
 }
 
 // This function assumes the image is in real space and multiplies it with the
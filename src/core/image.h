@@ -121,6 +121,7 @@ class Image {
     fftwf_plan plan_fwd; // !< FFTW plan for the image (fwd)
     fftwf_plan plan_bwd; // !< FFTW plan for the image (bwd)
     bool       planned; // !< Whether the plan has been setup by/for FFTW
+    bool       plans_are_shared; // !< Whether plan_fwd/plan_bwd belong to the FFTWPlanCache (and so must not be destroyed by this image)
     bool       image_memory_should_not_be_deallocated; // !< Don't deallocate the memory, generally should only be used when doing something funky with the pointers
 
     static wxMutex s_mutexProtectingFFTW;
@@ -451,6 +452,23 @@ class Image {
     void ReadSlices(EerFile* input_file, long start_slice, long end_slice);
     void ReadSlices(ImageFile* input_file, long start_slice, long end_slice);
 
+    // Thread-safe versions of the above, for use by many threads reading from the same (shared) file object, e.g. in OpenMP particle loops.
+    inline void ReadSliceThreadSafe(MRCFile* input_file, long slice_to_read) {
+        MyDebugAssertTrue(slice_to_read > 0, "Start slice is 0, the first slice is 1!");
+        MyDebugAssertTrue(slice_to_read <= input_file->ReturnNumberOfSlices( ), "End slice (%li) is greater than number of slices in the file! (%i)", slice_to_read, input_file->ReturnNumberOfSlices( ));
+        ReadSlicesThreadSafe(input_file, slice_to_read, slice_to_read);
+    };
+
+    inline void ReadSliceThreadSafe(ImageFile* input_file, long slice_to_read) {
+        MyDebugAssertTrue(slice_to_read > 0, "Start slice is 0, the first slice is 1!");
+        MyDebugAssertTrue(slice_to_read <= input_file->ReturnNumberOfSlices( ), "End slice (%li) is greater than number of slices in the file! (%i)", slice_to_read, input_file->ReturnNumberOfSlices( ));
+        ReadSlicesThreadSafe(input_file, slice_to_read, slice_to_read);
+    };
+
+    void ReadSlicesThreadSafe(MRCFile* input_file, long start_slice, long end_slice);
+    bool CopyFromMemoryMappedFile(MRCFile* input_file, long start_slice, long end_slice);
+    void ReadSlicesThreadSafe(ImageFile* input_file, long start_slice, long end_slice);
+
     inline void WriteSlice(MRCFile* input_file, long slice_to_write) {
         MyDebugAssertTrue(slice_to_write > 0, "Start slice is 0, the first slice is 1!");
         WriteSlices(input_file, slice_to_write, slice_to_write);
@@ -499,6 +517,10 @@ class Image {
     void  ErodeBinarizedMask(float erosion_radius);
 
     void PhaseShift(float wanted_x_shift, float wanted_y_shift, float wanted_z_shift = 0.0);
+    // Phase shift each image of a stack of 2D images of the same size by its own shift, spreading the images over the threads.
+    // The row coordinates are worked out once for the stack and each thread reuses its phase tables, but images in real space
+    // still make their own FFT round trip (with the plans shared through the plan cache).
+    static void PhaseShiftStack(Image* image_stack, int number_of_images, const float* x_shifts, const float* y_shifts, int wanted_number_of_threads = 1);
 
     // This has no check on real or complex status and I'm not going to take the time to see everywhere it is used
     // as I'm sure it is likely intentional. Adding Abs() to actually return the absolute value of the underlying array.
@@ -101,6 +101,13 @@ void ImageFile::ReadSlicesFromDisk(int start_slice, int end_slice, float* output
     }
 }
 
+void ImageFile::ReadSlicesFromDiskThreadSafe(int start_slice, int end_slice, float* output_array) {
+    switch ( file_type ) {
+        case MRC_FILE: mrc_file.ReadSlicesFromDiskThreadSafe(start_slice, end_slice, output_array); break;
+        default: AbstractImageFile::ReadSlicesFromDiskThreadSafe(start_slice, end_slice, output_array); break;
+    }
+}
+
 void ImageFile::WriteSliceToDisk(int slice_number, float* input_array) {
     WriteSlicesToDisk(slice_number, slice_number, input_array);
 }
@@ -41,9 +41,13 @@ class ImageFile : public AbstractImageFile {
 
     void ReadSliceFromDisk(int slice_number, float* output_array);
     void ReadSlicesFromDisk(int start_slice, int end_slice, float* output_array);
+    void ReadSlicesFromDiskThreadSafe(int start_slice, int end_slice, float* output_array);
 
     void WriteSliceToDisk(int slice_number, float* input_array);
     void WriteSlicesToDisk(int start_slice, int end_slice, float* input_array);
 
     void PrintInfo( );
+
+    // Only EER files make use of this at the moment, to decode frames in parallel
+    inline void SetNumberOfThreads(int wanted_number_of_threads) { eer_file.SetNumberOfThreads(wanted_number_of_threads); };
 };
@@ -2,10 +2,19 @@
 
 #include "../../include/ieee-754-half/half.hpp"
 
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 MRCFile::MRCFile( ) {
     rewrite_header_on_close                         = false;
     max_number_of_seconds_to_wait_for_file_to_exist = 30;
     my_file                                         = new std::fstream;
+    thread_safe_read_descriptor                     = -1;
+    memory_map_address                              = NULL;
+    memory_map_size_in_bytes                        = 0;
     do_nothing                                      = false;
 }
 
@@ -13,6 +22,9 @@ MRCFile::MRCFile(std::string filename, bool overwrite) {
     rewrite_header_on_close                         = false;
     max_number_of_seconds_to_wait_for_file_to_exist = 30;
     my_file                                         = new std::fstream;
+    thread_safe_read_descriptor                     = -1;
+    memory_map_address                              = NULL;
+    memory_map_size_in_bytes                        = 0;
     OpenFile(filename, overwrite);
 }
 
@@ -20,6 +32,9 @@ MRCFile::MRCFile(std::string filename, bool overwrite, bool wait_for_file_to_exi
     rewrite_header_on_close                         = false;
     max_number_of_seconds_to_wait_for_file_to_exist = 30;
     my_file                                         = new std::fstream;
+    thread_safe_read_descriptor                     = -1;
+    memory_map_address                              = NULL;
+    memory_map_size_in_bytes                        = 0;
     OpenFile(filename, overwrite, wait_for_file_to_exist);
 }
 
@@ -42,6 +57,13 @@ void MRCFile::CloseFile( ) {
             WriteHeader( );
         my_file->close( );
     }
+
+    UnmapFile( );
+
+    if ( thread_safe_read_descriptor >= 0 ) {
+        close(thread_safe_read_descriptor);
+        thread_safe_read_descriptor = -1;
+    }
     do_nothing = false;
 }
 
@@ -97,6 +119,9 @@ bool MRCFile::OpenFile(std::string wanted_filename, bool overwrite, bool wait_fo
 
             if ( file_already_exists == true )
                 my_header.ReadHeader(my_file);
+
+            // a second, read-only, descriptor for positional reads that don't disturb the stream (see ReadSlicesFromDiskThreadSafe)
+            thread_safe_read_descriptor = open(wanted_filename.c_str( ), O_RDONLY);
         }
         else {
             my_file->open(wanted_filename.c_str( ), std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
@@ -134,9 +159,54 @@ void MRCFile::SetPixelSize(float wanted_pixel_size) {
     my_header.SetPixelSize(wanted_pixel_size);
 }
 
-void MRCFile::ReadSlicesFromDisk(int start_slice, int end_slice, float* output_array) {
+// Work out where on disk slices start_slice to end_slice live, how many bytes they take up and how many values need to be converted.
+void MRCFile::ReturnByteRangeOfSlices(int start_slice, int end_slice, long& seek_position, long& bytes_to_read, long& records_to_read) {
+    long bytes_per_slice;
+    long image_offset;
 
-    using half = half_float::half;
+    if ( my_header.Mode( ) == 101 ) {
+        records_to_read = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * (long(end_slice - start_slice) + 1);
+
+        if ( IsOdd(my_header.ReturnDimensionX( )) == true ) {
+            bytes_per_slice = ((long(my_header.ReturnDimensionX( )) - 1) / 2) + 1;
+            bytes_per_slice *= long(my_header.ReturnDimensionY( ));
+        }
+        else {
+            bytes_per_slice = long(my_header.ReturnDimensionX( )) / 2;
+            bytes_per_slice *= long(my_header.ReturnDimensionY( ));
+        }
+
+        image_offset  = (start_slice - 1) * bytes_per_slice;
+        bytes_to_read = ((end_slice - start_slice) + 1) * bytes_per_slice;
+    }
+    else {
+        // check for mastronarde 4-bit hack.
+
+        if ( my_header.ReturnIfThisIsInMastronarde4BitHackFormat( ) == true ) {
+            records_to_read = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * (long(end_slice - start_slice) + 1);
+            records_to_read /= 2;
+
+            bytes_per_slice = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * long(my_header.BytesPerPixel( ));
+            image_offset    = long(start_slice - 1) * bytes_per_slice;
+            bytes_to_read   = records_to_read;
+        }
+        else {
+            records_to_read = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * (long(end_slice - start_slice) + 1);
+            bytes_per_slice = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * long(my_header.BytesPerPixel( ));
+            image_offset    = long(start_slice - 1) * bytes_per_slice;
+
+            switch ( my_header.Mode( ) ) {
+                case 0: bytes_to_read = records_to_read; break;
+                case 2: bytes_to_read = records_to_read * 4; break;
+                default: bytes_to_read = records_to_read * 2; break; // modes 1, 6 and 12
+            }
+        }
+    }
+
+    seek_position = 1024 + image_offset + my_header.SymmetryDataBytes( );
+}
+
+void MRCFile::ReadSlicesFromDisk(int start_slice, int end_slice, float* output_array) {
 
     if ( ! do_nothing ) {
         MyDebugAssertTrue(my_file->is_open( ), "File not open!");
@@ -148,243 +218,350 @@ void MRCFile::ReadSlicesFromDisk(int start_slice, int end_slice, float* output_a
 
         // calculate and seek to the start byte..
 
+        if ( memory_map_address != NULL ) {
+            ReadSlicesFromMemoryMap(start_slice, end_slice, output_array);
+            return;
+        }
+
         long records_to_read;
-        long bytes_per_slice;
-        long image_offset;
-        long current_position;
+        long bytes_to_read;
         long seek_position;
 
-        if ( my_header.Mode( ) == 101 ) {
-            records_to_read = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * (long(end_slice - start_slice) + 1);
+        ReturnByteRangeOfSlices(start_slice, end_slice, seek_position, bytes_to_read, records_to_read);
 
-            if ( IsOdd(my_header.ReturnDimensionX( )) == true ) {
-                bytes_per_slice = ((long(my_header.ReturnDimensionX( )) - 1) / 2) + 1;
-                bytes_per_slice *= long(my_header.ReturnDimensionY( ));
-            }
-            else {
-                bytes_per_slice = long(my_header.ReturnDimensionX( )) / 2;
-                bytes_per_slice *= long(my_header.ReturnDimensionY( ));
-            }
+        long current_position = my_file->tellg( );
 
-            image_offset     = (start_slice - 1) * bytes_per_slice;
-            current_position = my_file->tellg( );
-            seek_position    = 1024 + image_offset + my_header.SymmetryDataBytes( );
+        if ( current_position != seek_position )
+            my_file->seekg(seek_position);
+
+        //	wxPrintf("seek_position = %li\n", (seek_position - 1024) / 1679616 + 1);
+        if ( my_header.Mode( ) == 2 ) {
+            // 4-byte real, read straight into the output
+            my_file->read((char*)output_array, bytes_to_read);
         }
         else {
-            // check for mastronarde 4-bit hack.
+            // we need a temp array for non float formats..
+            std::vector<char> temp_char_array(bytes_to_read);
+            my_file->read(temp_char_array.data( ), bytes_to_read);
+            ConvertRawDataToFloat(temp_char_array.data( ), records_to_read, bytes_to_read, output_array);
+        }
 
-            if ( my_header.ReturnIfThisIsInMastronarde4BitHackFormat( ) == true ) {
-                records_to_read = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * (long(end_slice - start_slice) + 1);
-                records_to_read /= 2;
+        ReorderVoxelsToColumnRowSection(output_array);
+    }
+}
 
-                bytes_per_slice = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * long(my_header.BytesPerPixel( ));
-                image_offset    = long(start_slice - 1) * bytes_per_slice;
-            }
-            else {
-                records_to_read = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * (long(end_slice - start_slice) + 1);
-                bytes_per_slice = long(my_header.ReturnDimensionX( )) * long(my_header.ReturnDimensionY( )) * long(my_header.BytesPerPixel( ));
-                image_offset    = long(start_slice - 1) * bytes_per_slice;
-            }
+/*
+ * Same as ReadSlicesFromDisk, but the data are fetched with pread(2) on a separate read-only descriptor, so no state shared between callers
+ * (stream position, stream buffer) is touched. Any number of threads may call this concurrently on the same MRCFile, e.g. inside an OpenMP
+ * particle loop, without an omp critical section.
+ * 
+ * Data written through this object but not yet flushed to disk will not be seen. If there is no read descriptor (e.g. the file was created
+ * by this object), we fall back to a serialized call to ReadSlicesFromDisk.
+ */
+void MRCFile::ReadSlicesFromDiskThreadSafe(int start_slice, int end_slice, float* output_array) {
+
+    if ( do_nothing )
+        return;
+
+    if ( memory_map_address != NULL ) {
+        // the mapping is read-only and shared, so this is inherently thread-safe
+        ReadSlicesFromMemoryMap(start_slice, end_slice, output_array);
+        return;
+    }
 
-            current_position = my_file->tellg( );
-            seek_position    = 1024 + image_offset + my_header.SymmetryDataBytes( );
-        }
+    if ( thread_safe_read_descriptor < 0 ) {
+        AbstractImageFile::ReadSlicesFromDiskThreadSafe(start_slice, end_slice, output_array);
+        return;
+    }
 
-        if ( current_position != seek_position )
-            my_file->seekg(seek_position);
+    MyDebugAssertTrue(start_slice <= ReturnNumberOfSlices( ), "Start slice number larger than total slices!");
+    MyDebugAssertTrue(end_slice <= ReturnNumberOfSlices( ), "end slice number larger than total slices!");
+    MyDebugAssertTrue(start_slice <= end_slice, "Start slice larger than end slice!");
 
-        // we need a temp array for non float formats..
+    long records_to_read;
+    long bytes_to_read;
+    long seek_position;
 
-        //	wxPrintf("seek_position = %li\n", (seek_position - 1024) / 1679616 + 1);
-        switch ( my_header.Mode( ) ) {
-            // 1-byte integer
-            case 0: {
-                long  output_counter = 0;
-                uint8 low_4bits;
-                uint8 hi_4bits;
+    ReturnByteRangeOfSlices(start_slice, end_slice, seek_position, bytes_to_read, records_to_read);
 
-                char* temp_char_array = new char[records_to_read];
-                my_file->read(temp_char_array, records_to_read);
-                signed char*   temp_signed_char_array   = reinterpret_cast<signed char*>(temp_char_array);
-                unsigned char* temp_unsigned_char_array = reinterpret_cast<unsigned char*>(temp_char_array);
+    if ( my_header.Mode( ) == 2 ) {
+        ReadBytesAtPosition(seek_position, bytes_to_read, (char*)output_array);
+    }
+    else {
+        std::vector<char> temp_char_array(bytes_to_read);
+        ReadBytesAtPosition(seek_position, bytes_to_read, temp_char_array.data( ));
+        ConvertRawDataToFloat(temp_char_array.data( ), records_to_read, bytes_to_read, output_array);
+    }
 
-                // Convert to float array
-                if ( my_header.ReturnIfThisIsInMastronarde4BitHackFormat( ) ) {
-                    for ( long counter = 0; counter < records_to_read; counter++ ) {
+    ReorderVoxelsToColumnRowSection(output_array);
+}
 
-                        low_4bits = temp_char_array[counter] & 0x0F;
-                        hi_4bits  = (temp_char_array[counter] >> 4) & 0x0F;
+bool MRCFile::MapFileIntoMemory( ) {
+    if ( memory_map_address != NULL )
+        return true;
+    if ( do_nothing || thread_safe_read_descriptor < 0 )
+        return false;
 
-                        output_array[output_counter] = float(low_4bits);
-                        output_counter++;
-                        output_array[output_counter] = float(hi_4bits);
-                        output_counter++;
-                    }
-                }
-                else {
-                    if ( my_header.PixelDataAreSigned( ) ) {
-                        for ( long counter = 0; counter < records_to_read; counter++ ) {
-                            output_array[counter] = float(temp_signed_char_array[counter] + 128);
-                        }
-                    }
-                    else {
-                        for ( long counter = 0; counter < records_to_read; counter++ ) {
-                            output_array[counter] = float(temp_unsigned_char_array[counter]);
-                        }
-                    }
-                }
+    struct stat file_status;
+    if ( fstat(thread_safe_read_descriptor, &file_status) != 0 || file_status.st_size == 0 )
+        return false;
 
-                delete[] temp_char_array;
-            } break;
+    void* mapped_address = mmap(NULL, size_t(file_status.st_size), PROT_READ, MAP_SHARED, thread_safe_read_descriptor, 0);
+    if ( mapped_address == MAP_FAILED ) {
+        wxPrintf("Warning: could not memory map %s, reading through the file instead\n", filename);
+        return false;
+    }
 
-            // 2-byte integer
-            case 1: {
-                short* temp_short_array = new short[records_to_read];
-                my_file->read((char*)temp_short_array, records_to_read * 2);
+    memory_map_address       = static_cast<char*>(mapped_address);
+    memory_map_size_in_bytes = long(file_status.st_size);
+    return true;
+}
 
-                for ( long counter = 0; counter < records_to_read; counter++ ) {
-                    output_array[counter] = float(temp_short_array[counter]);
-                }
+void MRCFile::UnmapFile( ) {
+    if ( memory_map_address != NULL ) {
+        munmap(memory_map_address, size_t(memory_map_size_in_bytes));
+        memory_map_address       = NULL;
+        memory_map_size_in_bytes = 0;
+    }
+}
 
-                delete[] temp_short_array;
-            } break;
+const float* MRCFile::ReturnPointerToSlicesInMemoryMap(int start_slice, int end_slice) {
+    if ( memory_map_address == NULL || my_header.Mode( ) != 2 )
+        return NULL;
+    if ( my_header.ReturnMapC( ) != 1 || my_header.ReturnMapR( ) != 2 || my_header.ReturnMapS( ) != 3 )
+        return NULL;
 
-            // 4-byte real
-            case 2:
-                my_file->read((char*)output_array, records_to_read * 4);
-                break;
+    long records_to_read;
+    long bytes_to_read;
+    long seek_position;
 
-            // 2-byte real
-            case 12: {
-                std::vector<half> temp_half_array(records_to_read);
-                my_file->read((char*)temp_half_array.data( ), records_to_read * 2);
-                for ( long counter = 0; counter < records_to_read; counter++ ) {
-                    // float() operator overloaded in half_float namespace
-                    output_array[counter] = float(temp_half_array[counter]);
-                }
-            } break;
+    ReturnByteRangeOfSlices(start_slice, end_slice, seek_position, bytes_to_read, records_to_read);
 
-            // unsigned 2-byte integers
-            case 6: {
-                unsigned short int* temp_int_array = new unsigned short int[records_to_read];
-                my_file->read((char*)temp_int_array, records_to_read * 2);
-                for ( long counter = 0; counter < records_to_read; counter++ ) {
-                    output_array[counter] = float(temp_int_array[counter]);
-                }
-                delete[] temp_int_array;
-            } break;
+    // floats must be aligned to be used in place, which depends on the size of the extended header
+    if ( seek_position % sizeof(float) != 0 || seek_position + bytes_to_read > memory_map_size_in_bytes )
+        return NULL;
+
+    return reinterpret_cast<const float*>(memory_map_address + seek_position);
+}
+
+void MRCFile::ReadSlicesFromMemoryMap(int start_slice, int end_slice, float* output_array) {
+    MyDebugAssertTrue(start_slice <= end_slice, "Start slice larger than end slice!");
+
+    long records_to_read;
+    long bytes_to_read;
+    long seek_position;
+
+    ReturnByteRangeOfSlices(start_slice, end_slice, seek_position, bytes_to_read, records_to_read);
+
+    if ( seek_position + bytes_to_read > memory_map_size_in_bytes ) {
+        MyPrintWithDetails("Error: slices %i to %i lie beyond the end of %s\n", start_slice, end_slice, filename);
+        DEBUG_ABORT;
+    }
+
+    if ( my_header.Mode( ) == 2 ) {
+        memcpy(output_array, memory_map_address + seek_position, bytes_to_read);
+    }
+    else {
+        // converting straight from the mapped page, no intermediate copy
+        ConvertRawDataToFloat(memory_map_address + seek_position, records_to_read, bytes_to_read, output_array);
+    }
 
-                // 101.. 4-bit integer..
+    ReorderVoxelsToColumnRowSection(output_array);
+}
 
-            case 101: {
-                // horrible format.. each byte is two pixels, if x is odd then the last one is padded.
-                // so recalculate the number of bytes to read
+void MRCFile::ReadBytesAtPosition(long seek_position, long bytes_to_read, char* output_bytes) {
+    long bytes_read_so_far = 0;
 
-                long input_array_position  = 0;
-                long output_array_position = 0;
-                int  x_pos                 = 0;
+    while ( bytes_read_so_far < bytes_to_read ) {
+        ssize_t bytes_read = pread(thread_safe_read_descriptor, output_bytes + bytes_read_so_far, bytes_to_read - bytes_read_so_far, off_t(seek_position + bytes_read_so_far));
 
-                long actual_bytes_to_read = ((end_slice - start_slice) + 1) * bytes_per_slice;
+        if ( bytes_read < 0 && errno == EINTR )
+            continue;
 
-                uint8 hi_4bits;
-                uint8 low_4bits;
+        if ( bytes_read <= 0 ) {
+            MyPrintWithDetails("Error: could only read %li of %li bytes at position %li from %s\n", bytes_read_so_far, bytes_to_read, seek_position, filename);
+            DEBUG_ABORT;
+        }
 
-                char* temp_char_array = new char[actual_bytes_to_read];
-                my_file->read(temp_char_array, actual_bytes_to_read);
+        bytes_read_so_far += bytes_read;
+    }
+}
 
-                // now we have to convert..
+// Convert the raw bytes of a non-float MRC file to floats. Does not touch the file, so is safe to call from several threads.
+void MRCFile::ConvertRawDataToFloat(char* temp_char_array, long records_to_read, long bytes_to_read, float* output_array) {
 
-                for ( long counter = 0; counter < actual_bytes_to_read; counter++ ) {
+    using half = half_float::half;
 
-                    low_4bits = temp_char_array[input_array_position] & 0x0F;
-                    hi_4bits  = (temp_char_array[input_array_position] >> 4) & 0x0F;
+    switch ( my_header.Mode( ) ) {
+        // 1-byte integer
+        case 0: {
+            long  output_counter = 0;
+            uint8 low_4bits;
+            uint8 hi_4bits;
 
-                    //wxPrintf("\n\ninput = %i, low = %i, high = %i\n\n", int(temp_char_array[input_array_position]), int(low_4bits), int(hi_4bits));
+            signed char*   temp_signed_char_array   = reinterpret_cast<signed char*>(temp_char_array);
+            unsigned char* temp_unsigned_char_array = reinterpret_cast<unsigned char*>(temp_char_array);
 
-                    input_array_position++;
+            // Convert to float array
+            if ( my_header.ReturnIfThisIsInMastronarde4BitHackFormat( ) ) {
+                for ( long counter = 0; counter < records_to_read; counter++ ) {
 
-                    x_pos++;
+                    low_4bits = temp_char_array[counter] & 0x0F;
+                    hi_4bits  = (temp_char_array[counter] >> 4) & 0x0F;
 
-                    if ( x_pos == my_header.ReturnDimensionX( ) && IsOdd(my_header.ReturnDimensionX( )) == true ) {
-                        x_pos                               = 0;
-                        output_array[output_array_position] = float(low_4bits);
-                        output_array_position++;
+                    output_array[output_counter] = float(low_4bits);
+                    output_counter++;
+                    output_array[output_counter] = float(hi_4bits);
+                    output_counter++;
+                }
+            }
+            else {
+                if ( my_header.PixelDataAreSigned( ) ) {
+                    for ( long counter = 0; counter < records_to_read; counter++ ) {
+                        output_array[counter] = float(temp_signed_char_array[counter] + 128);
                     }
-                    else {
-                        output_array[output_array_position] = float(low_4bits);
-                        output_array_position++;
-                        output_array[output_array_position] = float(hi_4bits);
-                        output_array_position++;
+                }
+                else {
+                    for ( long counter = 0; counter < records_to_read; counter++ ) {
+                        output_array[counter] = float(temp_unsigned_char_array[counter]);
                     }
                 }
+            }
+        } break;
 
-                delete[] temp_char_array;
-
-            } break;
+        // 2-byte integer
+        case 1: {
+            short* temp_short_array = reinterpret_cast<short*>(temp_char_array);
 
-            default: {
-                MyPrintfRed("Error: mode %i MRC files not currently supported\n", my_header.Mode( ));
-                DEBUG_ABORT;
-            } break;
-        }
+            for ( long counter = 0; counter < records_to_read; counter++ ) {
+                output_array[counter] = float(temp_short_array[counter]);
+            }
+        } break;
+
+        // 4-byte real
+        case 2:
+            memcpy(output_array, temp_char_array, records_to_read * 4);
+            break;
+
+        // 2-byte real
+        case 12: {
+            half* temp_half_array = reinterpret_cast<half*>(temp_char_array);
+            for ( long counter = 0; counter < records_to_read; counter++ ) {
+                // float() operator overloaded in half_float namespace
+                output_array[counter] = float(temp_half_array[counter]);
+            }
+        } break;
 
-        {
-            /*
-			* Deal with the cases where the data are not indexed like this:
-			* - fastest = column (map_c = 1)
-			* - medium = row (map_r = 2)
-			* - slow = section (map_s = 3)
-			*/
-
-            long counter;
-            long counter_in_file;
-            long number_of_voxels = my_header.ReturnDimensionX( ) * my_header.ReturnDimensionY( ) * my_header.ReturnDimensionZ( );
-
-            //
-            int col_index;
-            int row_index;
-            int sec_index;
-
-            if ( my_header.ReturnMapC( ) == 1 && my_header.ReturnMapR( ) == 2 && my_header.ReturnMapS( ) == 3 ) {
-                // Nothing to do, this is how cisTEM expects the data to be laid out
+        // unsigned 2-byte integers
+        case 6: {
+            unsigned short int* temp_int_array = reinterpret_cast<unsigned short int*>(temp_char_array);
+            for ( long counter = 0; counter < records_to_read; counter++ ) {
+                output_array[counter] = float(temp_int_array[counter]);
             }
-            else if ( my_header.ReturnMapS( ) == 1 && my_header.ReturnMapC( ) == 3 ) {
+        } break;
+
+            // 101.. 4-bit integer..
+
+        case 101: {
+            // horrible format.. each byte is two pixels, if x is odd then the last one is padded.
+
+            long input_array_position  = 0;
+            long output_array_position = 0;
+            int  x_pos                 = 0;
+
+            uint8 hi_4bits;
+            uint8 low_4bits;
+
+            // now we have to convert..
 
-                // Allocate a temp array and copy data over
-                float* temp_array;
-                temp_array = new float[number_of_voxels];
-                for ( counter = 0; counter < number_of_voxels; counter++ ) {
-                    temp_array[counter] = output_array[counter];
+            for ( long counter = 0; counter < bytes_to_read; counter++ ) {
+
+                low_4bits = temp_char_array[input_array_position] & 0x0F;
+                hi_4bits  = (temp_char_array[input_array_position] >> 4) & 0x0F;
+
+                //wxPrintf("\n\ninput = %i, low = %i, high = %i\n\n", int(temp_char_array[input_array_position]), int(low_4bits), int(hi_4bits));
+
+                input_array_position++;
+
+                x_pos++;
+
+                if ( x_pos == my_header.ReturnDimensionX( ) && IsOdd(my_header.ReturnDimensionX( )) == true ) {
+                    x_pos                               = 0;
+                    output_array[output_array_position] = float(low_4bits);
+                    output_array_position++;
                 }
+                else {
+                    output_array[output_array_position] = float(low_4bits);
+                    output_array_position++;
+                    output_array[output_array_position] = float(hi_4bits);
+                    output_array_position++;
+                }
+            }
 
-                // Loop over output array and copy voxel values over one by one
-                counter = 0;
-                for ( sec_index = 0; sec_index < my_header.ReturnDimensionZ( ); sec_index++ ) //z
+        } break;
+
+        default: {
+            MyPrintfRed("Error: mode %i MRC files not currently supported\n", my_header.Mode( ));
+            DEBUG_ABORT;
+        } break;
+    }
+}
+
+void MRCFile::ReorderVoxelsToColumnRowSection(float* output_array) {
+    /*
+	* Deal with the cases where the data are not indexed like this:
+	* - fastest = column (map_c = 1)
+	* - medium = row (map_r = 2)
+	* - slow = section (map_s = 3)
+	*/
+
+    long counter;
+    long counter_in_file;
+    long number_of_voxels = my_header.ReturnDimensionX( ) * my_header.ReturnDimensionY( ) * my_header.ReturnDimensionZ( );
+
+    //
+    int col_index;
+    int row_index;
+    int sec_index;
+
+    if ( my_header.ReturnMapC( ) == 1 && my_header.ReturnMapR( ) == 2 && my_header.ReturnMapS( ) == 3 ) {
+        // Nothing to do, this is how cisTEM expects the data to be laid out
+    }
+    else if ( my_header.ReturnMapS( ) == 1 && my_header.ReturnMapC( ) == 3 ) {
+
+        // Allocate a temp array and copy data over
+        float* temp_array;
+        temp_array = new float[number_of_voxels];
+        for ( counter = 0; counter < number_of_voxels; counter++ ) {
+            temp_array[counter] = output_array[counter];
+        }
+
+        // Loop over output array and copy voxel values over one by one
+        counter = 0;
+        for ( sec_index = 0; sec_index < my_header.ReturnDimensionZ( ); sec_index++ ) //z
+        {
+            for ( row_index = 0; row_index < my_header.ReturnDimensionY( ); row_index++ ) //y
+            {
+                for ( col_index = 0; col_index < my_header.ReturnDimensionX( ); col_index++ ) //x
                 {
-                    for ( row_index = 0; row_index < my_header.ReturnDimensionY( ); row_index++ ) //y
-                    {
-                        for ( col_index = 0; col_index < my_header.ReturnDimensionX( ); col_index++ ) //x
-                        {
-                            // compute address of voxel in the file
-                            counter_in_file = sec_index + my_header.ReturnDimensionZ( ) * row_index + my_header.ReturnDimensionZ( ) * my_header.ReturnDimensionY( ) * col_index;
-
-                            MyDebugAssertTrue(counter_in_file >= 0 && counter_in_file < number_of_voxels, "Oops bad counter_in_file = %li\n", counter_in_file);
-                            MyDebugAssertTrue(counter >= 0 && counter < number_of_voxels, "Oops bad counter = %li\n", counter);
-
-                            output_array[counter] = temp_array[counter_in_file];
-                            counter++;
-                        }
-                    }
-                }
+                    // compute address of voxel in the file
+                    counter_in_file = sec_index + my_header.ReturnDimensionZ( ) * row_index + my_header.ReturnDimensionZ( ) * my_header.ReturnDimensionY( ) * col_index;
 
-                // Deallocate temp array
-                delete[] temp_array;
-            }
-            else {
-                wxPrintf("Ooops, strange ordering of data in MRC file not yet supported");
-                DEBUG_ABORT;
+                    MyDebugAssertTrue(counter_in_file >= 0 && counter_in_file < number_of_voxels, "Oops bad counter_in_file = %li\n", counter_in_file);
+                    MyDebugAssertTrue(counter >= 0 && counter < number_of_voxels, "Oops bad counter = %li\n", counter);
+
+                    output_array[counter] = temp_array[counter_in_file];
+                    counter++;
+                }
             }
         }
+
+        // Deallocate temp array
+        delete[] temp_array;
+    }
+    else {
+        wxPrintf("Ooops, strange ordering of data in MRC file not yet supported");
+        DEBUG_ABORT;
     }
 }
 
@@ -475,6 +652,15 @@ MRCFile& MRCFile::operator=(const MRCFile* other_file) {
         max_number_of_seconds_to_wait_for_file_to_exist = other_file->max_number_of_seconds_to_wait_for_file_to_exist;
 
         do_nothing = other_file->do_nothing;
+
+        if ( thread_safe_read_descriptor >= 0 )
+            close(thread_safe_read_descriptor);
+        thread_safe_read_descriptor = (other_file->thread_safe_read_descriptor >= 0) ? dup(other_file->thread_safe_read_descriptor) : -1;
+
+        // the mapping belongs to other_file, so map again rather than share it
+        UnmapFile( );
+        if ( other_file->memory_map_address != NULL )
+            MapFileIntoMemory( );
     }
 
     return *this;
@@ -5,6 +5,18 @@
 
 class MRCFile : public AbstractImageFile {
 
+  private:
+    int thread_safe_read_descriptor; // read-only POSIX descriptor used for pread(), -1 if not available
+
+    char* memory_map_address; // start of the read-only mapping of the whole file, NULL if not mapped
+    long  memory_map_size_in_bytes;
+
+    void ReturnByteRangeOfSlices(int start_slice, int end_slice, long& seek_position, long& bytes_to_read, long& records_to_read);
+    void ReadBytesAtPosition(long seek_position, long bytes_to_read, char* output_bytes);
+    void ConvertRawDataToFloat(char* temp_char_array, long records_to_read, long bytes_to_read, float* output_array);
+    void ReorderVoxelsToColumnRowSection(float* output_array);
+    void ReadSlicesFromMemoryMap(int start_slice, int end_slice, float* output_array);
+
   public:
     std::fstream* my_file;
     MRCHeader     my_header;
@@ -53,6 +65,19 @@ class MRCFile : public AbstractImageFile {
     inline void ReadSliceFromDisk(int slice_number, float* output_array) { ReadSlicesFromDisk(slice_number, slice_number, output_array); }
 
     void ReadSlicesFromDisk(int start_slice, int end_slice, float* output_array);
+    void ReadSlicesFromDiskThreadSafe(int start_slice, int end_slice, float* output_array);
+
+    inline bool SupportsConcurrentReads( ) { return thread_safe_read_descriptor >= 0 || memory_map_address != NULL; }
+
+    // Read-only memory-mapped mode, intended for large particle stacks. Once mapped, all reads come from the page cache, which is shared
+    // between all processes on the node that map the same file. Returns false (and leaves the file in normal mode) if mapping is not possible.
+    bool MapFileIntoMemory( );
+    void UnmapFile( );
+
+    inline bool IsMemoryMapped( ) { return memory_map_address != NULL; }
+
+    // Zero-copy access to float32 data with the standard axis order, NULL if the file is not mapped or the data can't be used directly.
+    const float* ReturnPointerToSlicesInMemoryMap(int start_slice, int end_slice);
 
     inline void WriteSliceToDisk(int slice_number, float* input_array) { WriteSlicesToDisk(slice_number, slice_number, input_array); }
 
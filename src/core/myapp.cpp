@@ -13,6 +13,10 @@ wxDEFINE_EVENT(wxEVT_COMMAND_MYTHREAD_SEND_PROGRAM_DEFINED_RESULT, ReturnProgram
 #define THREAD_DIE 1
 #define THREAD_SLEEP 2
 
+// With adaptive job windows, each worker is sent enough jobs to keep about this much work queued, up to a maximum number of jobs
+#define JOB_WINDOW_TARGET_QUEUED_MILLISECONDS 500.0
+#define JOB_WINDOW_MAXIMUM_SIZE 32
+
 bool MyApp::OnInit( ) {
     long counter;
     thread_next_action = THREAD_SLEEP;
@@ -22,6 +26,17 @@ bool MyApp::OnInit( ) {
     number_of_timing_results_received = 0;
 
     max_number_of_connected_workers = 0;
+    number_of_lost_workers          = 0;
+
+    fixed_job_window_size          = 0;
+    average_milliseconds_per_job   = 0.0;
+    number_of_job_timings_received = 0;
+
+    wxString job_window_size_string;
+    long     job_window_size;
+    if ( wxGetEnv("CISTEM_JOB_WINDOW", &job_window_size_string) && job_window_size_string.ToLong(&job_window_size) && job_window_size > 0 ) {
+        fixed_job_window_size = std::min(int(job_window_size), JOB_WINDOW_MAXIMUM_SIZE);
+    }
 
     zombie_timer           = NULL;
     queue_timer            = NULL;
@@ -40,7 +55,7 @@ bool MyApp::OnInit( ) {
 
     total_milliseconds_spent_on_threads = 0;
 
-    socket_to_worker_job_pointer_hash.clear( );
+    socket_to_worker_job_numbers_hash.clear( );
 
     inter_thread_message_queue.Post(0);
 
@@ -52,6 +67,7 @@ bool MyApp::OnInit( ) {
 
 int MyApp::OnExit( ) {
     ProgramSpecificCleanUp( );
+    FFTWPlanCache::GetInstance( ).ExportWisdomIfRequested( );
     return 0;
 }
 
@@ -71,7 +87,7 @@ void MyApp::OnEventLoopEnter(wxEventLoopBase* loop) {
         wxArrayString possible_controller_addresses;
         wxIPV4address junk_address;
 
-        socket_to_worker_job_pointer_hash.clear( );
+        socket_to_worker_job_numbers_hash.clear( );
 
         // Bind the thread events
 
@@ -112,7 +128,15 @@ void MyApp::OnEventLoopEnter(wxEventLoopBase* loop) {
             is_running_locally = true;
             DoInteractiveUserInput( );
             stopwatch.Start( );
-            DoCalculation( );
+            cistem_timer::Profiler::StartJob(wxFileName(argv[0]).GetName( ), -1);
+            {
+                cistem_timer::ProfileScope profile_scope("DoCalculation");
+                DoCalculation( );
+            }
+            if ( cistem_timer::Profiler::IsEnabled( ) ) {
+                cistem_timer::Profiler::FinishJob( );
+                wxPrintf("\n%s\n", cistem_timer::Profiler::ReturnSummary( ).ReturnFormattedTable( ));
+            }
             total_milliseconds_spent_on_threads += stopwatch.Time( );
             MyInteractiveProgramCleanup( );
             fftwf_cleanup( ); // this is needed to stop valgrind reporting memory leaks..
@@ -228,24 +252,77 @@ void MyApp::AddCommandLineOptions( ) {
 }
 
 void MyApp::SendNextJobTo(wxSocketBase* socket) {
-    // if we haven't dispatched all jobs yet, then send it, otherwise tell the worker to die..
+    // top up the jobs queued on this worker, jobs of lost workers go first. If there is nothing left to send and the worker has nothing left to do, tell it to die..
+
+    std::deque<int>& jobs_on_worker = socket_to_worker_job_numbers_hash[socket];
+    std::vector<int> jobs_to_send;
+    int              number_of_jobs_wanted = ReturnJobWindowSize( ) - int(jobs_on_worker.size( ));
 
-    if ( number_of_dispatched_jobs < current_job_package.number_of_jobs ) {
+    while ( int(jobs_to_send.size( )) < number_of_jobs_wanted ) {
+        if ( jobs_to_requeue.empty( ) == false ) {
+            jobs_to_send.push_back(jobs_to_requeue.front( ));
+            jobs_to_requeue.pop_front( );
+        }
+        else if ( number_of_dispatched_jobs < current_job_package.number_of_jobs ) {
+            jobs_to_send.push_back(number_of_dispatched_jobs);
+            number_of_dispatched_jobs++;
+        }
+        else
+            break;
+    }
+
+    if ( jobs_to_send.size( ) == 1 ) {
         // See RunJob::SendJob() Doxygen for encoding order specification
-        current_job_package.jobs[number_of_dispatched_jobs].SendJob(socket);
-        socket_to_worker_job_pointer_hash[socket] = &current_job_package.jobs[number_of_dispatched_jobs];
-        number_of_dispatched_jobs++;
+        current_job_package.jobs[jobs_to_send[0]].SendJob(socket);
     }
-    else {
+    else if ( jobs_to_send.size( ) > 1 ) {
+        // See JobPackage::SendJobWindow() Doxygen for encoding order specification
+        current_job_package.SendJobWindow(socket, jobs_to_send.data( ), int(jobs_to_send.size( )));
+    }
+
+    jobs_on_worker.insert(jobs_on_worker.end( ), jobs_to_send.begin( ), jobs_to_send.end( ));
+
+    if ( jobs_on_worker.empty( ) == true ) {
         WriteToSocket(socket, socket_time_to_die, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING);
         // stop monitoring the socket..
         //StopMonitoringSocket(socket); stopped doing this for timings
 
         // Remember that this socket doesn't have a job anymore
-        socket_to_worker_job_pointer_hash.erase(socket);
+        socket_to_worker_job_numbers_hash.erase(socket);
     }
 }
 
+// The number of jobs a worker may have been sent but not finished, including the one it is running.
+// Short jobs are dominated by the round trip to the master, so enough of them are queued to cover JOB_WINDOW_TARGET_QUEUED_MILLISECONDS.
+// Until the first jobs have finished, there is nothing to go on and jobs are sent one at a time.
+
+int MyApp::ReturnJobWindowSize( ) {
+    if ( fixed_job_window_size > 0 )
+        return fixed_job_window_size;
+    if ( number_of_job_timings_received == 0 )
+        return 1;
+
+    int window_size = 1 + int(ceil(JOB_WINDOW_TARGET_QUEUED_MILLISECONDS / std::max(average_milliseconds_per_job, 1.0)));
+
+    // never queue more than a fair share of the jobs that are left, so that the last jobs do not end up waiting behind each other on one worker
+
+    int number_of_live_workers = std::max(1, ReturnNumberOfExpectedWorkers( ) - int(number_of_lost_workers));
+    int number_of_jobs_left    = current_job_package.number_of_jobs - int(number_of_dispatched_jobs) + int(jobs_to_requeue.size( ));
+    int fair_share             = (number_of_jobs_left + number_of_live_workers - 1) / number_of_live_workers;
+
+    return std::max(1, std::min(std::min(window_size, fair_share), JOB_WINDOW_MAXIMUM_SIZE));
+}
+
+int MyApp::ReturnNumberOfExpectedWorkers( ) {
+    int number_of_commands_to_run;
+    if ( current_job_package.number_of_jobs + 1 < current_job_package.my_profile.ReturnTotalJobs( ) )
+        number_of_commands_to_run = current_job_package.number_of_jobs + 1;
+    else
+        number_of_commands_to_run = current_job_package.my_profile.ReturnTotalJobs( );
+
+    return number_of_commands_to_run - 1;
+}
+
 void MyApp::SendJobFinished(int job_number) {
     //MyDebugAssertTrue(i_am_the_master == true, "SendJobFinished called by a worker!");
 
@@ -288,6 +365,12 @@ void MyApp::SendAllJobsFinished( ) {
     if ( master_job_queue.GetCount( ) != 0 )
         MasterSendIntenalQueue( );
 
+    if ( profile_summary_of_workers.IsEmpty( ) == false ) {
+        wxFileName summary_filename(cistem_timer::Profiler::ReturnOutputDirectory( ), wxString::Format("cistem_profile_%s_%s_%lu_summary.txt", wxFileName(argv[0]).GetName( ), wxGetHostName( ), wxGetProcessId( )));
+        profile_summary_of_workers.WriteToFile(summary_filename.GetFullPath( ));
+        SocketSendInfo(wxString::Format("Profile of the job package (full summary in %s):\n\n", summary_filename.GetFullPath( )) + profile_summary_of_workers.ReturnFormattedTable(20));
+    }
+
     WriteToSocket(controller_socket, socket_all_jobs_finished, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING);
     WriteToSocket(controller_socket, &total_milliseconds_spent_on_threads, sizeof(long), true, "SendTotalMillisecondsSpentOnThreads", FUNCTION_DETAILS_AS_WXSTRING);
 }
@@ -369,12 +452,23 @@ void MyApp::OnThreadComplete(wxThreadEvent& my_event) {
     //work_thread = NULL;
     SendAllResultsFromResultQueue( );
 
-    // get the next job..
-    WriteToSocket(master_socket, socket_send_next_job, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING);
+    // keep a copy of the result, and if the master has sent jobs ahead start the next one before reporting back, so the thread is not idle during the round trip
 
-    // if there is a result - send it to the gui..
-    my_result.job_number = my_current_job.job_number;
-    my_result.SendToSocket(master_socket);
+    JobResult finished_result(my_result);
+    finished_result.job_number     = my_current_job.job_number;
+    long milliseconds_spent_on_job = job_stopwatch.Time( );
+    currently_running_a_job        = false;
+
+    if ( queued_jobs.empty( ) == false ) {
+        RunJob* next_job = queued_jobs.front( );
+        queued_jobs.pop_front( );
+        StartJob(next_job);
+    }
+
+    // say the job is finished (and ask for more), with the result and how long it took..
+    WriteToSocket(master_socket, socket_job_finished_send_more, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING);
+    finished_result.SendToSocket(master_socket);
+    WriteToSocket(master_socket, &milliseconds_spent_on_job, sizeof(long), true, "SendMillisecondsSpentOnJob", FUNCTION_DETAILS_AS_WXSTRING);
 }
 
 void MyApp::OnThreadEnding(wxThreadEvent& my_event) {
@@ -624,7 +718,16 @@ wxThread::ExitCode CalculateThread::Entry( ) {
         delete lock;
 
         if ( thread_action_copy == THREAD_START_NEXT_JOB ) {
-            bool           success         = main_thread_pointer->DoCalculation( ); // This should be overrided per app..
+            bool success;
+
+            cistem_timer::Profiler::StartJob(wxFileName(main_thread_pointer->argv[0]).GetName( ), main_thread_pointer->my_current_job.job_number);
+            {
+                cistem_timer::ProfileScope profile_scope("DoCalculation");
+                success = main_thread_pointer->DoCalculation( ); // This should be overrided per app..
+            }
+            if ( cistem_timer::Profiler::IsEnabled( ) )
+                cistem_timer::Profiler::FinishJob( );
+
             wxThreadEvent* my_thread_event = new wxThreadEvent(wxEVT_COMMAND_MYTHREAD_COMPLETED);
 
             if ( success == true )
@@ -883,6 +986,13 @@ void MyApp::HandleSocketTimeToDie(wxSocketBase* connected_socket) // This can be
     }
     else //Worker
     {
+        // The profile of this process goes first, so that the master has it once it has the timing
+        if ( cistem_timer::Profiler::IsEnabled( ) ) {
+            wxString profile_summary = cistem_timer::Profiler::ReturnSummary( ).ReturnAsString( );
+            WriteToSocket(master_socket, socket_send_profile_summary, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING);
+            SendwxStringToSocket(&profile_summary, master_socket);
+        }
+
         // Timing stuff here
         long milliseconds_spent_by_thread = stopwatch.Time( );
 
@@ -927,11 +1037,18 @@ void MyApp::HandleSocketTimeToDie(wxSocketBase* connected_socket) // This can be
 ///////////////////////////////////////////////////////////////////////////////////
 
 void MyApp::HandleSocketSendNextJob(wxSocketBase* connected_socket, JobResult* received_result) {
+    if ( received_result->job_number != -1 ) {
+        std::deque<int>&          jobs_on_worker = socket_to_worker_job_numbers_hash[connected_socket];
+        std::deque<int>::iterator finished_job   = std::find(jobs_on_worker.begin( ), jobs_on_worker.end( ), received_result->job_number);
+        if ( finished_job != jobs_on_worker.end( ) )
+            jobs_on_worker.erase(finished_job);
+    }
+
     SendNextJobTo(connected_socket);
 
-    // Send info that the job has finished, and if necessary the result..
+    // Send info that the job has finished, and if necessary the result.. (unless it was already reported by a worker that was thought to be lost)
 
-    if ( received_result->job_number != -1 ) {
+    if ( received_result->job_number != -1 && current_job_package.jobs[received_result->job_number].has_been_run == false ) {
         if ( received_result->result_size > 0 ) {
             SendJobResult(received_result);
         }
@@ -970,6 +1087,17 @@ void MyApp::HandleSocketSendNextJob(wxSocketBase* connected_socket, JobResult* r
     delete received_result;
 }
 
+void MyApp::HandleSocketJobFinishedSendMore(wxSocketBase* connected_socket, JobResult* received_result, long milliseconds_spent_on_job) {
+    // a running average that follows changes in the job length, used to size the job windows
+    if ( number_of_job_timings_received == 0 )
+        average_milliseconds_per_job = milliseconds_spent_on_job;
+    else
+        average_milliseconds_per_job = 0.8 * average_milliseconds_per_job + 0.2 * milliseconds_spent_on_job;
+    number_of_job_timings_received++;
+
+    HandleSocketSendNextJob(connected_socket, received_result);
+}
+
 void MyApp::HandleSocketIHaveAnError(wxSocketBase* connected_socket, wxString error_message) {
     SocketSendError(error_message);
 }
@@ -1039,6 +1167,15 @@ void MyApp::HandleSocketProgramDefinedResult(wxSocketBase* connected_socket, flo
     delete[] data_array;
 }
 
+void MyApp::HandleSocketSendProfileSummary(wxSocketBase* connected_socket, wxString profile_summary) {
+    cistem_timer::ProfileSummary worker_summary;
+
+    if ( worker_summary.SetFromString(profile_summary) == true )
+        profile_summary_of_workers.Add(worker_summary);
+    else
+        SocketSendInfo("A worker sent a profile summary that could not be read, it is left out of the profile.");
+}
+
 void MyApp::HandleSocketSendThreadTiming(wxSocketBase* connected_socket, long received_timing_in_milliseconds) {
     total_milliseconds_spent_on_threads += received_timing_in_milliseconds;
     StopMonitoringAndDestroySocket(connected_socket);
@@ -1091,13 +1228,7 @@ void MyApp::HandleNewSocketConnection(wxSocketBase* new_connection, unsigned cha
         // tell it is is connected..
         WriteToSocket(new_connection, socket_you_are_connected, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING);
 
-        int number_of_commands_to_run;
-        if ( current_job_package.number_of_jobs + 1 < current_job_package.my_profile.ReturnTotalJobs( ) )
-            number_of_commands_to_run = current_job_package.number_of_jobs + 1;
-        else
-            number_of_commands_to_run = current_job_package.my_profile.ReturnTotalJobs( );
-
-        if ( worker_socket_pointers.GetCount( ) == number_of_commands_to_run - 1 ) {
+        if ( worker_socket_pointers.GetCount( ) == ReturnNumberOfExpectedWorkers( ) ) {
             SocketSendInfo("All workers have re-connected to the master.");
         }
     }
@@ -1132,9 +1263,22 @@ void MyApp::HandleSocketYouAreConnected(wxSocketBase* connected_socket) {
 }
 
 void MyApp::HandleSocketReadyToSendSingleJob(wxSocketBase* connected_socket, RunJob* received_job) {
-    MyDebugAssertTrue(currently_running_a_job == false, "Received a new job, when already running a job!");
-    my_current_job = *received_job;
-    delete received_job;
+    // jobs that arrive while one is running were sent ahead in a window, they are started from OnThreadComplete
+    if ( currently_running_a_job == true ) {
+        queued_jobs.push_back(received_job);
+        return;
+    }
+
+    StartJob(received_job);
+}
+
+void MyApp::StartJob(RunJob* job_to_start) {
+    MyDebugAssertTrue(currently_running_a_job == false, "Starting a new job, when already running a job!");
+    my_current_job = *job_to_start;
+    delete job_to_start;
+
+    currently_running_a_job = true;
+    job_stopwatch.Start( );
 
     wxMutexLocker* lock = new wxMutexLocker(job_lock);
 
@@ -1177,9 +1321,26 @@ void MyApp::HandleSocketDisconnect(wxSocketBase* connected_socket) {
     }
     else if ( i_am_the_master == true && connected_socket != master_socket ) // a worker died..
     {
-        if ( number_of_dispatched_jobs < current_job_package.number_of_jobs ) {
-            SocketSendError("Error: A worker has disconnected before all jobs are finished.");
-            SocketSendInfo("The disconnected worker was running a job with the following arguments:\n" + socket_to_worker_job_pointer_hash[connected_socket]->PrintAllArgumentsTowxString( ));
+        SocketJobNumbersHash::iterator lost_worker = socket_to_worker_job_numbers_hash.find(connected_socket);
+
+        if ( lost_worker != socket_to_worker_job_numbers_hash.end( ) ) {
+            // it will never send its timing, so don't wait for it, and give its unfinished jobs to the workers that are left
+
+            max_number_of_connected_workers--;
+            number_of_lost_workers++;
+
+            int number_of_requeued_jobs = current_job_package.AddUnfinishedJobsToQueue(lost_worker->second, jobs_to_requeue);
+
+            socket_to_worker_job_numbers_hash.erase(lost_worker);
+
+            if ( number_of_requeued_jobs > 0 ) {
+                if ( socket_to_worker_job_numbers_hash.empty( ) == true ) {
+                    SocketSendError("Error: A worker has disconnected before all jobs are finished.");
+                    SocketSendInfo("The disconnected worker was running a job with the following arguments:\n" + current_job_package.jobs[jobs_to_requeue.front( )].PrintAllArgumentsTowxString( ));
+                }
+                else
+                    SocketSendInfo(wxString::Format("A worker has disconnected, its %i unfinished job(s) will be run by the remaining workers.", number_of_requeued_jobs));
+            }
         }
 
         StopMonitoringAndDestroySocket(connected_socket);
@@ -1,5 +1,5 @@
 WX_DEFINE_ARRAY_PTR(wxSocketBase*, ArrayOfSocketBasePointers);
-WX_DECLARE_HASH_MAP(wxSocketBase*, RunJob*, wxPointerHash, wxPointerEqual, SocketJobPointerHash);
+WX_DECLARE_HASH_MAP(wxSocketBase*, std::deque<int>, wxPointerHash, wxPointerEqual, SocketJobNumbersHash);
 
 class ReturnProgramDefinedResultEvent;
 wxDECLARE_EVENT(RETURN_PROGRAM_DEFINED_RESULT_EVT, ReturnProgramDefinedResultEvent);
@@ -131,8 +131,10 @@ class
     void HandleSocketResultWithImageToWrite(wxSocketBase* connected_socket, wxString filename_to_write_to, int position_in_stack);
     void HandleSocketProgramDefinedResult(wxSocketBase* connected_socket, float* data_array, int size_of_data_array, int result_number, int number_of_expected_results);
     void HandleSocketSendThreadTiming(wxSocketBase* connected_socket, long received_timing_in_milliseconds);
+    void HandleSocketSendProfileSummary(wxSocketBase* connected_socket, wxString profile_summary);
     void HandleSocketYouAreConnected(wxSocketBase* connected_socket);
     void HandleSocketReadyToSendSingleJob(wxSocketBase* connected_socket, RunJob* received_job);
+    void HandleSocketJobFinishedSendMore(wxSocketBase* connected_socket, JobResult* received_result, long milliseconds_spent_on_job);
     void HandleSocketDisconnect(wxSocketBase* connected_socket);
 
     void IfSocketIsAKeySocketSetItToNull(wxSocketBase* socket_to_check);
@@ -177,6 +179,10 @@ class
     RunJob my_current_job;
     RunJob global_job_parameters;
 
+    // Jobs the master has sent ahead, to be started as soon as the current job has finished (worker)
+    std::deque<RunJob*> queued_jobs;
+    wxStopWatch         job_stopwatch;
+
     wxString  master_ip_address;
     wxString  master_port_string;
     short int master_port;
@@ -188,8 +194,20 @@ class
     //wxSocketBase **worker_sockets;  // POINTER TO POINTER..
     ArrayOfSocketBasePointers worker_socket_pointers;
 
-    // HashMap to keep track of which socket is currently working on which job
-    SocketJobPointerHash socket_to_worker_job_pointer_hash;
+    // HashMap to keep track of which jobs have been sent to each socket and have not been reported as finished yet, oldest first
+    SocketJobNumbersHash socket_to_worker_job_numbers_hash;
+
+    // Jobs of workers that disconnected before finishing them, these are sent out again before any new jobs
+    std::deque<int> jobs_to_requeue;
+    long            number_of_lost_workers;
+
+    // The combined runtime profiles of the workers (for the master), see cistem_timer::Profiler
+    cistem_timer::ProfileSummary profile_summary_of_workers;
+
+    // Number of jobs each worker may have queued, either fixed (CISTEM_JOB_WINDOW) or adapted to the time the jobs take
+    int    fixed_job_window_size;
+    double average_milliseconds_per_job;
+    long   number_of_job_timings_received;
 
     wxCmdLineParser command_line_parser;
 
@@ -233,6 +251,9 @@ class
     void SocketSendInfo(wxString info_message);
 
     void SendNextJobTo(wxSocketBase* socket);
+    int  ReturnJobWindowSize( );
+    int  ReturnNumberOfExpectedWorkers( );
+    void StartJob(RunJob* job_to_start);
 
     void OnThreadComplete(wxThreadEvent& my_event);
     void OnThreadEnding(wxThreadEvent& my_event);
@@ -43,6 +43,10 @@ Particle::~Particle( ) {
     if ( bin_index != NULL ) {
         delete[] bin_index;
     }
+
+    if ( snr_image != NULL ) {
+        delete snr_image;
+    }
 }
 
 void Particle::CopyAllButImages(const Particle* other_particle) {
@@ -115,7 +119,12 @@ void Particle::CopyAllButImages(const Particle* other_particle) {
         }
         if ( bin_index != NULL ) {
             delete[] bin_index;
-            bin_index = NULL;
+            bin_index      = NULL;
+            bin_index_size = 0;
+        }
+        if ( snr_image != NULL ) {
+            delete snr_image;
+            snr_image = NULL;
         }
     }
 }
@@ -161,6 +170,8 @@ void Particle::Init( ) {
     insert_even                       = false;
     number_of_search_dimensions       = 0;
     bin_index                         = NULL;
+    bin_index_size                    = 0;
+    snr_image                         = NULL;
     mask_center_2d_x                  = 0.0;
     mask_center_2d_y                  = 0.0;
     mask_center_2d_z                  = 0.0;
@@ -207,6 +218,10 @@ void Particle::Deallocate( ) {
         delete beamtilt_image;
         beamtilt_image = NULL;
     }
+    if ( snr_image != NULL ) {
+        delete snr_image;
+        snr_image = NULL;
+    }
 }
 
 void Particle::ResetImageFlags( ) {
@@ -335,6 +350,7 @@ void Particle::SetLowResolutionContrast(float low_resolution_contrast) {
 }
 
 void Particle::InitCTFImage(float voltage_kV, float spherical_aberration_mm, float amplitude_contrast, float defocus_1, float defocus_2, float astigmatism_angle, float phase_shift, float beam_tilt_x, float beam_tilt_y, float particle_shift_x, float particle_shift_y, bool calculate_complex_ctf) {
+    cistem_timer::ProfileScope profile_scope("InitCTFImage");
     MyDebugAssertTrue(ctf_image->is_in_memory, "ctf_image memory not allocated");
     MyDebugAssertTrue(beamtilt_image->is_in_memory, "beamtilt_image memory not allocated");
     MyDebugAssertTrue(! ctf_image->is_in_real_space, "ctf_image not in Fourier space");
@@ -407,9 +423,12 @@ void Particle::SetIndexForWeightedCorrelation(bool limit_resolution) {
     if ( filter_radius_low != 0.0 )
         low_limit2 = powf(pixel_size / filter_radius_low, 2);
 
-    if ( bin_index != NULL )
-        delete[] bin_index;
-    bin_index = new int[particle_image->real_memory_allocated / 2];
+    if ( bin_index_size != particle_image->real_memory_allocated / 2 ) {
+        if ( bin_index != NULL )
+            delete[] bin_index;
+        bin_index      = new int[particle_image->real_memory_allocated / 2];
+        bin_index_size = particle_image->real_memory_allocated / 2;
+    }
 
     for ( k = 0; k <= particle_image->physical_upper_bound_complex_z; k++ ) {
         z = powf(particle_image->ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k) * particle_image->fourier_voxel_size_z, 2);
@@ -455,7 +474,8 @@ void Particle::WeightBySSNR(Curve& SSNR, int include_reference_weighting, bool n
     if ( particle_image->is_in_real_space )
         particle_image->ForwardFFT( );
 
-    Image* snr_image = new Image;
+    if ( snr_image == NULL )
+        snr_image = new Image;
     snr_image->Allocate(ctf_image->logical_x_dimension, ctf_image->logical_y_dimension, false);
     particle_image->Whiten( );
 
@@ -480,8 +500,6 @@ void Particle::WeightBySSNR(Curve& SSNR, int include_reference_weighting, bool n
 
     // Apply cosine filter to reduce ringing when resolution limit higher than 7 A
     //	if (filter_radius_high > 0.0) particle_image->CosineMask(std::max(pixel_size / filter_radius_high, pixel_size / 7.0f + pixel_size / mask_falloff) - pixel_size / (2.0 * mask_falloff), pixel_size / mask_falloff);
-
-    delete snr_image;
 }
 
 void Particle::WeightBySSNR(Curve& SSNR, Image& projection_image, bool weight_particle_image, bool weight_projection_image) {
@@ -730,6 +748,7 @@ int Particle::UnmapParameters(float* mapped_parameters) {
 
 float Particle::ReturnLogLikelihood(Image& input_image, CTF& input_ctf, ReconstructedVolume& input_3d, ResolutionStatistics& statistics,
                                     float classification_resolution_limit, float* frealign_score) {
+    cistem_timer::ProfileScope profile_scope("ReturnLogLikelihood");
     //!!!	MyDebugAssertTrue(is_ssnr_filtered, "particle_image not filtered");
 
     float number_of_independent_pixels;
@@ -1058,6 +1077,7 @@ float Particle::MLBlur(Image* input_classes_cache, float ssq_X, Image& cropped_i
                        int current_class, int number_of_rotations, float psi_step, float psi_start, float smoothing_factor, float& max_logp_particle,
                        int best_class, float best_psi, Image& best_correlation_map, bool calculate_correlation_map_only, bool uncrop, bool apply_ctf_to_classes,
                        Image* image_to_blur, Image* diff_image_to_blur, float max_shift_in_angstroms) {
+    cistem_timer::ProfileScope profile_scope("MLBlur");
     MyDebugAssertTrue(cropped_input_image.is_in_memory, "cropped_input_image: memory not allocated");
     MyDebugAssertTrue(rotation_cache[0].is_in_memory, "rotation_cache: memory not allocated");
     MyDebugAssertTrue(blurred_image.is_in_memory, "blurred_image: memory not allocated");
@@ -98,6 +98,8 @@ class Particle {
     ParameterMap         constraints_used;
     int                  number_of_search_dimensions;
     int*                 bin_index;
+    long                 bin_index_size;
+    Image*               snr_image; // scratch for WeightBySSNR, kept between particles
     float                mask_center_2d_x;
     float                mask_center_2d_y;
     float                mask_center_2d_z;
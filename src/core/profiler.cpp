@@ -0,0 +1,521 @@
+#include "core_headers.h"
+
+namespace cistem_timer {
+
+namespace {
+
+struct OpenScope {
+    int      node;
+    uint64_t start_nanoseconds;
+};
+
+struct TraceEvent {
+    int      node;
+    uint64_t start_nanoseconds;
+    uint64_t duration_nanoseconds;
+};
+
+// Everything a thread records. Only the owning thread writes to it; the profiler reads it once the threads of a job are idle.
+struct ThreadBuffer {
+    int thread_index;
+
+    // A node is a scope path, i.e. a name below a parent node (-1 for the outermost scopes)
+    std::vector<std::string>                   node_names;
+    std::vector<int>                           node_parents;
+    std::vector<ProfileStatistics>             node_statistics;
+    std::map<std::pair<int, std::string>, int> child_nodes;
+
+    // Scope names are usually literals, so their nodes are also found by the pointer, which saves making a string
+    std::map<std::pair<int, const char*>, int> child_nodes_of_literal_names;
+    std::vector<OpenScope>                     open_scopes;
+    std::vector<TraceEvent>                    events;
+
+    long event_generation;
+    long statistics_generation;
+
+    ThreadBuffer(int wanted_thread_index) {
+        thread_index          = wanted_thread_index;
+        event_generation      = 0;
+        statistics_generation = 0;
+    }
+};
+
+struct ProfilerState {
+    wxMutex                                    mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers;
+    std::chrono::steady_clock::time_point      epoch;
+
+    std::atomic<long> event_generation;
+    std::atomic<long> statistics_generation;
+
+    long     maximum_number_of_events_per_thread;
+    wxString output_directory;
+    wxString program_name;
+    int      job_number;
+
+    ProfilerState( ) {
+        epoch                               = std::chrono::steady_clock::now( );
+        event_generation                    = 0;
+        statistics_generation               = 0;
+        maximum_number_of_events_per_thread = 1000000;
+        output_directory                    = wxFileName::GetTempDir( );
+        program_name                        = "cistem";
+        job_number                          = -1;
+
+        wxString environment_value;
+        long     wanted_maximum_number_of_events;
+        if ( wxGetEnv("CISTEM_PROFILE_MAX_EVENTS", &environment_value) && environment_value.ToLong(&wanted_maximum_number_of_events) && wanted_maximum_number_of_events >= 0 ) {
+            maximum_number_of_events_per_thread = wanted_maximum_number_of_events;
+        }
+        if ( wxGetEnv("CISTEM_PROFILE_DIR", &environment_value) && environment_value.IsEmpty( ) == false ) {
+            output_directory = environment_value;
+        }
+    }
+};
+
+ProfilerState& ReturnState( ) {
+    static ProfilerState the_state;
+    return the_state;
+}
+
+bool ReturnEnabledFromEnvironment( ) {
+    const char* environment_value = std::getenv("CISTEM_PROFILE");
+    return environment_value != NULL && environment_value[0] != '\0' && strcmp(environment_value, "0") != 0;
+}
+
+thread_local ThreadBuffer* thread_local_buffer = NULL;
+
+inline uint64_t NanosecondsSinceEpoch(const ProfilerState& state) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now( ) - state.epoch).count( );
+}
+
+// The buffer of this thread, with the events and statistics of earlier jobs and resets dropped
+ThreadBuffer& ReturnThreadBuffer(ProfilerState& state) {
+    if ( thread_local_buffer == NULL ) {
+        wxMutexLocker lock(state.mutex);
+        MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+        state.thread_buffers.emplace_back(new ThreadBuffer(int(state.thread_buffers.size( ))));
+        thread_local_buffer                        = state.thread_buffers.back( ).get( );
+        thread_local_buffer->event_generation      = state.event_generation;
+        thread_local_buffer->statistics_generation = state.statistics_generation;
+    }
+
+    ThreadBuffer& buffer = *thread_local_buffer;
+
+    if ( buffer.statistics_generation != state.statistics_generation.load(std::memory_order_relaxed) ) {
+        buffer.node_names.clear( );
+        buffer.node_parents.clear( );
+        buffer.node_statistics.clear( );
+        buffer.child_nodes.clear( );
+        buffer.child_nodes_of_literal_names.clear( );
+        buffer.open_scopes.clear( );
+        buffer.events.clear( );
+        buffer.statistics_generation = state.statistics_generation;
+        buffer.event_generation      = state.event_generation;
+    }
+    if ( buffer.event_generation != state.event_generation.load(std::memory_order_relaxed) ) {
+        buffer.events.clear( );
+        buffer.event_generation = state.event_generation;
+    }
+
+    return buffer;
+}
+
+int ReturnNode(ThreadBuffer& buffer, int parent_node, const std::string& name) {
+    auto found_node = buffer.child_nodes.find(std::make_pair(parent_node, name));
+    if ( found_node != buffer.child_nodes.end( ) )
+        return found_node->second;
+
+    int new_node = int(buffer.node_names.size( ));
+    buffer.node_names.push_back(name);
+    buffer.node_parents.push_back(parent_node);
+    buffer.node_statistics.emplace_back( );
+    buffer.child_nodes[std::make_pair(parent_node, name)] = new_node;
+    return new_node;
+}
+
+inline int ReturnCurrentNode(const ThreadBuffer& buffer) {
+    return buffer.open_scopes.empty( ) ? -1 : buffer.open_scopes.back( ).node;
+}
+
+void RecordEvent(ProfilerState& state, ThreadBuffer& buffer, int node, uint64_t start_nanoseconds, uint64_t duration_nanoseconds) {
+    buffer.node_statistics[node].AddDuration(duration_nanoseconds);
+    if ( long(buffer.events.size( )) < state.maximum_number_of_events_per_thread ) {
+        buffer.events.push_back({node, start_nanoseconds, duration_nanoseconds});
+    }
+}
+
+std::string ReturnPathOfNode(const ThreadBuffer& buffer, int node) {
+    std::string path = buffer.node_names[node];
+    for ( int parent = buffer.node_parents[node]; parent >= 0; parent = buffer.node_parents[parent] ) {
+        path = buffer.node_names[parent] + "/" + path;
+    }
+    return path;
+}
+
+// Names are used as paths, lines of the summary and JSON strings
+std::string ReturnCleanName(const std::string& name) {
+    std::string clean_name = name;
+    for ( char& character : clean_name ) {
+        if ( character == '/' || character == '\t' || character == '\n' || character == '\r' || character == '"' || character == '\\' )
+            character = '_';
+    }
+    return clean_name;
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////////
+//                               ProfileStatistics                               //
+///////////////////////////////////////////////////////////////////////////////////
+
+ProfileStatistics::ProfileStatistics( ) {
+    number_of_calls     = 0;
+    total_nanoseconds   = 0;
+    minimum_nanoseconds = std::numeric_limits<uint64_t>::max( );
+    maximum_nanoseconds = 0;
+    histogram.resize(number_of_histogram_bins, 0);
+}
+
+int ProfileStatistics::ReturnHistogramBin(uint64_t nanoseconds) {
+    if ( nanoseconds < 4 )
+        return 0;
+
+    // 4 linear bins per octave
+    int octave = 63 - __builtin_clzll(nanoseconds);
+    int bin    = 4 * octave + int((nanoseconds >> (octave - 2)) & 3);
+    return std::min(bin, number_of_histogram_bins - 1);
+}
+
+void ProfileStatistics::Add(const ProfileStatistics& other_statistics) {
+    number_of_calls += other_statistics.number_of_calls;
+    total_nanoseconds += other_statistics.total_nanoseconds;
+    minimum_nanoseconds = std::min(minimum_nanoseconds, other_statistics.minimum_nanoseconds);
+    maximum_nanoseconds = std::max(maximum_nanoseconds, other_statistics.maximum_nanoseconds);
+    for ( int bin = 0; bin < number_of_histogram_bins; bin++ ) {
+        histogram[bin] += other_statistics.histogram[bin];
+    }
+}
+
+double ProfileStatistics::ReturnPercentileInNanoseconds(double wanted_percentile) const {
+    if ( number_of_calls == 0 )
+        return 0.0;
+
+    uint64_t wanted_rank           = std::max(uint64_t(1), uint64_t(ceil(wanted_percentile / 100.0 * double(number_of_calls))));
+    uint64_t number_of_calls_below = 0;
+
+    if ( wanted_rank >= number_of_calls )
+        return double(maximum_nanoseconds);
+
+    for ( int bin = 0; bin < number_of_histogram_bins; bin++ ) {
+        number_of_calls_below += histogram[bin];
+        if ( number_of_calls_below >= wanted_rank ) {
+            // The middle of the bin, which cannot be outside of the range that was seen
+            double lower_bound = (bin < 4) ? 0.0 : ldexp(1.0 + 0.25 * (bin % 4), bin / 4);
+            double upper_bound = (bin < 4) ? 4.0 : ldexp(1.0 + 0.25 * (bin % 4 + 1), bin / 4);
+            return std::min(std::max(0.5 * (lower_bound + upper_bound), double(minimum_nanoseconds)), double(maximum_nanoseconds));
+        }
+    }
+
+    return double(maximum_nanoseconds);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+//                                 ProfileSummary                                //
+///////////////////////////////////////////////////////////////////////////////////
+
+ProfileSummary::ProfileSummary( ) {
+    number_of_processes = 0;
+}
+
+void ProfileSummary::Add(const ProfileSummary& other_summary) {
+    for ( const auto& path_and_statistics : other_summary.statistics_per_path ) {
+        statistics_per_path[path_and_statistics.first].Add(path_and_statistics.second);
+    }
+    number_of_processes += other_summary.number_of_processes;
+}
+
+wxString ProfileSummary::ReturnAsString( ) const {
+    wxString summary_string = wxString::Format("processes\t%i\n", number_of_processes);
+
+    for ( const auto& path_and_statistics : statistics_per_path ) {
+        const ProfileStatistics& statistics = path_and_statistics.second;
+
+        summary_string += wxString::Format("%s\t%llu\t%llu\t%llu\t%llu\t", path_and_statistics.first.c_str( ), (unsigned long long)statistics.number_of_calls, (unsigned long long)statistics.total_nanoseconds, (unsigned long long)statistics.minimum_nanoseconds, (unsigned long long)statistics.maximum_nanoseconds);
+
+        bool is_first_bin = true;
+        for ( int bin = 0; bin < ProfileStatistics::number_of_histogram_bins; bin++ ) {
+            if ( statistics.histogram[bin] > 0 ) {
+                summary_string += wxString::Format("%s%i:%llu", is_first_bin ? "" : ",", bin, (unsigned long long)statistics.histogram[bin]);
+                is_first_bin = false;
+            }
+        }
+        summary_string += "\n";
+    }
+
+    return summary_string;
+}
+
+bool ProfileSummary::SetFromString(const wxString& summary_string) {
+    statistics_per_path.clear( );
+    number_of_processes = 0;
+
+    wxStringTokenizer lines(summary_string, "\n");
+    while ( lines.HasMoreTokens( ) ) {
+        wxString line = lines.GetNextToken( );
+        if ( line.IsEmpty( ) )
+            continue;
+
+        wxArrayString fields = wxStringTokenize(line, "\t", wxTOKEN_RET_EMPTY_ALL);
+
+        if ( fields.GetCount( ) == 2 && fields[0] == "processes" ) {
+            long wanted_number_of_processes;
+            if ( fields[1].ToLong(&wanted_number_of_processes) == false )
+                return false;
+            number_of_processes = int(wanted_number_of_processes);
+            continue;
+        }
+
+        if ( fields.GetCount( ) != 6 )
+            return false;
+
+        ProfileStatistics  statistics;
+        unsigned long long number_of_calls, total_nanoseconds, minimum_nanoseconds, maximum_nanoseconds;
+        if ( fields[1].ToULongLong(&number_of_calls) == false || fields[2].ToULongLong(&total_nanoseconds) == false || fields[3].ToULongLong(&minimum_nanoseconds) == false || fields[4].ToULongLong(&maximum_nanoseconds) == false ) {
+            return false;
+        }
+        statistics.number_of_calls     = number_of_calls;
+        statistics.total_nanoseconds   = total_nanoseconds;
+        statistics.minimum_nanoseconds = minimum_nanoseconds;
+        statistics.maximum_nanoseconds = maximum_nanoseconds;
+
+        wxStringTokenizer bins(fields[5], ",");
+        while ( bins.HasMoreTokens( ) ) {
+            wxString           bin_and_count = bins.GetNextToken( );
+            long               bin;
+            unsigned long long count;
+            if ( bin_and_count.BeforeFirst(':').ToLong(&bin) == false || bin_and_count.AfterFirst(':').ToULongLong(&count) == false || bin < 0 || bin >= ProfileStatistics::number_of_histogram_bins ) {
+                return false;
+            }
+            statistics.histogram[bin] = count;
+        }
+
+        statistics_per_path[fields[0].ToStdString( )].Add(statistics);
+    }
+
+    return true;
+}
+
+wxString ProfileSummary::ReturnFormattedTable(int maximum_number_of_rows) const {
+    std::vector<std::pair<std::string, const ProfileStatistics*>> sorted_paths;
+    double                                                        total_of_outermost_scopes = 0.0;
+
+    for ( const auto& path_and_statistics : statistics_per_path ) {
+        sorted_paths.emplace_back(path_and_statistics.first, &path_and_statistics.second);
+        if ( path_and_statistics.first.find('/') == std::string::npos )
+            total_of_outermost_scopes += double(path_and_statistics.second.total_nanoseconds);
+    }
+
+    std::sort(sorted_paths.begin( ), sorted_paths.end( ), [](const std::pair<std::string, const ProfileStatistics*>& first, const std::pair<std::string, const ProfileStatistics*>& second) {
+        return first.second->total_nanoseconds > second.second->total_nanoseconds;
+    });
+
+    if ( maximum_number_of_rows > 0 && int(sorted_paths.size( )) > maximum_number_of_rows )
+        sorted_paths.resize(maximum_number_of_rows);
+
+    wxString table = wxString::Format("Profile of %i process(es), times in ms unless noted\n\n", number_of_processes);
+    table += wxString::Format("%-60s %10s %12s %7s %10s %10s %10s %10s %10s\n", "Path", "Calls", "Total (s)", "%", "Mean", "p50", "p90", "p99", "Max");
+
+    for ( const auto& path_and_statistics : sorted_paths ) {
+        const ProfileStatistics& statistics = *path_and_statistics.second;
+        table += wxString::Format("%-60s %10llu %12.3f %7.2f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                                  path_and_statistics.first.c_str( ),
+                                  (unsigned long long)statistics.number_of_calls,
+                                  double(statistics.total_nanoseconds) * 1.0e-9,
+                                  (total_of_outermost_scopes > 0.0) ? 100.0 * double(statistics.total_nanoseconds) / total_of_outermost_scopes : 0.0,
+                                  statistics.ReturnMeanInNanoseconds( ) * 1.0e-6,
+                                  statistics.ReturnPercentileInNanoseconds(50.0) * 1.0e-6,
+                                  statistics.ReturnPercentileInNanoseconds(90.0) * 1.0e-6,
+                                  statistics.ReturnPercentileInNanoseconds(99.0) * 1.0e-6,
+                                  double(statistics.maximum_nanoseconds) * 1.0e-6);
+    }
+
+    return table;
+}
+
+bool ProfileSummary::WriteToFile(const wxString& filename) const {
+    FILE* output_file = fopen(filename.mb_str( ), "w");
+    if ( output_file == NULL ) {
+        MyPrintWithDetails("Warning: cannot write the profile summary to %s\n", filename);
+        return false;
+    }
+
+    fprintf(output_file, "%s", ReturnFormattedTable( ).ToStdString( ).c_str( ));
+    fclose(output_file);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+//                                    Profiler                                   //
+///////////////////////////////////////////////////////////////////////////////////
+
+std::atomic<bool> Profiler::is_enabled(ReturnEnabledFromEnvironment( ));
+
+void Profiler::Enable(bool wanted_enabled) {
+    is_enabled = wanted_enabled;
+}
+
+void Profiler::BeginScope(const char* name) {
+    ProfilerState& state       = ReturnState( );
+    ThreadBuffer&  buffer      = ReturnThreadBuffer(state);
+    int            parent_node = ReturnCurrentNode(buffer);
+    int            node;
+
+    auto found_node = buffer.child_nodes_of_literal_names.find(std::make_pair(parent_node, name));
+    if ( found_node != buffer.child_nodes_of_literal_names.end( ) ) {
+        node = found_node->second;
+    }
+    else {
+        node                                                                   = ReturnNode(buffer, parent_node, ReturnCleanName(name));
+        buffer.child_nodes_of_literal_names[std::make_pair(parent_node, name)] = node;
+    }
+
+    buffer.open_scopes.push_back({node, NanosecondsSinceEpoch(state)});
+}
+
+void Profiler::EndScope( ) {
+    ProfilerState& state  = ReturnState( );
+    ThreadBuffer&  buffer = ReturnThreadBuffer(state);
+
+    // The scope may have been dropped by Reset( )
+    if ( buffer.open_scopes.empty( ) )
+        return;
+
+    OpenScope scope = buffer.open_scopes.back( );
+    buffer.open_scopes.pop_back( );
+
+    uint64_t end_nanoseconds = NanosecondsSinceEpoch(state);
+    RecordEvent(state, buffer, scope.node, scope.start_nanoseconds, end_nanoseconds - std::min(end_nanoseconds, scope.start_nanoseconds));
+}
+
+void Profiler::RecordCompletedEvent(const std::string& name, uint64_t duration_in_nanoseconds) {
+    ProfilerState& state           = ReturnState( );
+    ThreadBuffer&  buffer          = ReturnThreadBuffer(state);
+    int            node            = ReturnNode(buffer, ReturnCurrentNode(buffer), ReturnCleanName(name));
+    uint64_t       end_nanoseconds = NanosecondsSinceEpoch(state);
+
+    RecordEvent(state, buffer, node, end_nanoseconds - std::min(end_nanoseconds, duration_in_nanoseconds), duration_in_nanoseconds);
+}
+
+void Profiler::StartJob(const wxString& program_name, int job_number) {
+    ProfilerState& state = ReturnState( );
+    wxMutexLocker  lock(state.mutex);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+    state.program_name = program_name;
+    state.job_number   = job_number;
+    state.event_generation++;
+}
+
+void Profiler::FinishJob(bool write_trace) {
+    ProfilerState& state = ReturnState( );
+
+    if ( write_trace ) {
+        wxString job_string;
+        {
+            wxMutexLocker lock(state.mutex);
+            MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+            job_string = (state.job_number >= 0) ? wxString::Format("job_%i", state.job_number) : wxString("local");
+        }
+
+        wxFileName trace_filename(ReturnOutputDirectory( ), wxString::Format("cistem_profile_%s_%s_%lu_%s.json", ReturnProgramName( ), wxGetHostName( ), wxGetProcessId( ), job_string));
+        WriteChromeTrace(trace_filename.GetFullPath( ));
+    }
+
+    state.event_generation++;
+}
+
+bool Profiler::WriteChromeTrace(const wxString& filename) {
+    ProfilerState& state = ReturnState( );
+    wxMutexLocker  lock(state.mutex);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+    long wanted_event_generation      = state.event_generation;
+    long wanted_statistics_generation = state.statistics_generation;
+    bool has_events                   = false;
+
+    for ( const auto& buffer : state.thread_buffers ) {
+        if ( buffer->event_generation == wanted_event_generation && buffer->statistics_generation == wanted_statistics_generation && buffer->events.empty( ) == false )
+            has_events = true;
+    }
+    if ( has_events == false )
+        return true;
+
+    FILE* output_file = fopen(filename.mb_str( ), "w");
+    if ( output_file == NULL ) {
+        MyPrintWithDetails("Warning: cannot write the profile trace to %s\n", filename);
+        return false;
+    }
+
+    unsigned long process_id = wxGetProcessId( );
+    std::string   process    = ReturnCleanName(wxString::Format("%s (%s)", state.program_name, wxGetHostName( )).ToStdString( ));
+
+    fprintf(output_file, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"program\":\"%s\",\"job_number\":%i},\"traceEvents\":[\n", ReturnCleanName(state.program_name.ToStdString( )).c_str( ), state.job_number);
+    fprintf(output_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":0,\"args\":{\"name\":\"%s\"}}", process_id, process.c_str( ));
+
+    for ( const auto& buffer : state.thread_buffers ) {
+        if ( buffer->event_generation != wanted_event_generation || buffer->statistics_generation != wanted_statistics_generation || buffer->events.empty( ) )
+            continue;
+
+        fprintf(output_file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%i,\"args\":{\"name\":\"thread %i\"}}", process_id, buffer->thread_index, buffer->thread_index);
+
+        for ( const TraceEvent& event : buffer->events ) {
+            fprintf(output_file, ",\n{\"name\":\"%s\",\"cat\":\"cistem\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%i}",
+                    buffer->node_names[event.node].c_str( ), double(event.start_nanoseconds) * 1.0e-3, double(event.duration_nanoseconds) * 1.0e-3, process_id, buffer->thread_index);
+        }
+    }
+
+    fprintf(output_file, "\n]}\n");
+    fclose(output_file);
+    return true;
+}
+
+ProfileSummary Profiler::ReturnSummary( ) {
+    ProfilerState& state = ReturnState( );
+    wxMutexLocker  lock(state.mutex);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+    ProfileSummary summary;
+    summary.number_of_processes = 1;
+
+    for ( const auto& buffer : state.thread_buffers ) {
+        if ( buffer->statistics_generation != state.statistics_generation )
+            continue;
+
+        for ( int node = 0; node < int(buffer->node_statistics.size( )); node++ ) {
+            if ( buffer->node_statistics[node].number_of_calls > 0 )
+                summary.statistics_per_path[ReturnPathOfNode(*buffer, node)].Add(buffer->node_statistics[node]);
+        }
+    }
+
+    return summary;
+}
+
+void Profiler::Reset( ) {
+    ProfilerState& state = ReturnState( );
+    state.statistics_generation++;
+    state.event_generation++;
+}
+
+wxString Profiler::ReturnOutputDirectory( ) {
+    return ReturnState( ).output_directory;
+}
+
+wxString Profiler::ReturnProgramName( ) {
+    ProfilerState& state = ReturnState( );
+    wxMutexLocker  lock(state.mutex);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+    return state.program_name;
+}
+
+} // namespace cistem_timer
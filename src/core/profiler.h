@@ -0,0 +1,149 @@
+#ifndef __SRC_CORE_PROFILER_H__
+#define __SRC_CORE_PROFILER_H__
+
+/*  \brief  Profiler - a runtime-enabled, thread-aware profiler that complements StopWatch.
+
+	Scopes are opened with a ProfileScope object (or BeginScope( ) / EndScope( )) and may be nested, so that every recorded
+	time belongs to a path such as "DoCalculation/Refine/ExtractSlice". The events of cistem_timer::StopWatch are recorded
+	as well, under the scope that is open when they finish, so the timing that programs already collect with a StopWatch
+	shows up without any changes to them.
+
+	Each thread records into its own buffer, so that the hot path does not take a lock. The statistics of every path
+	(calls, total, minimum, maximum and a logarithmic histogram of the durations, from which the percentiles are estimated)
+	are kept for the whole process, while the individual events are kept until the end of the current job and are then
+	written as a Chrome trace-event JSON file (open in chrome://tracing or ui.perfetto.dev).
+
+	When a program runs through the job system, every worker sends the statistics of its process to the master, which
+	combines them and writes a summary for the whole job package (see MyApp).
+
+	Environment variables (read on first use):
+	  CISTEM_PROFILE              1 to enable the profiler (default off, in which case a scope costs a single test)
+	  CISTEM_PROFILE_DIR          directory for the traces and summaries (default: the temporary directory)
+	  CISTEM_PROFILE_MAX_EVENTS   maximum number of trace events per thread and job (default 1000000). Later events
+	                              are still counted in the statistics.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cistem_timer {
+
+// The statistics of one scope path. The histogram has 4 bins per octave of nanoseconds, so percentiles are estimated to ~10%
+class ProfileStatistics {
+
+  public:
+    static constexpr int number_of_histogram_bins = 4 * 48;
+
+    uint64_t              number_of_calls;
+    uint64_t              total_nanoseconds;
+    uint64_t              minimum_nanoseconds;
+    uint64_t              maximum_nanoseconds;
+    std::vector<uint64_t> histogram;
+
+    ProfileStatistics( );
+
+    inline void AddDuration(uint64_t nanoseconds) {
+        number_of_calls++;
+        total_nanoseconds += nanoseconds;
+        if ( nanoseconds < minimum_nanoseconds )
+            minimum_nanoseconds = nanoseconds;
+        if ( nanoseconds > maximum_nanoseconds )
+            maximum_nanoseconds = nanoseconds;
+        histogram[ReturnHistogramBin(nanoseconds)]++;
+    }
+
+    void   Add(const ProfileStatistics& other_statistics);
+    double ReturnPercentileInNanoseconds(double wanted_percentile) const;
+
+    inline double ReturnMeanInNanoseconds( ) const { return (number_of_calls > 0) ? double(total_nanoseconds) / double(number_of_calls) : 0.0; }
+
+    static int ReturnHistogramBin(uint64_t nanoseconds);
+};
+
+// The statistics of all scope paths of one or more processes, as sent from the workers to the master
+class ProfileSummary {
+
+  public:
+    std::map<std::string, ProfileStatistics> statistics_per_path;
+    int                                      number_of_processes;
+
+    ProfileSummary( );
+
+    void Add(const ProfileSummary& other_summary);
+
+    inline bool IsEmpty( ) const { return statistics_per_path.empty( ); }
+
+    // One line per path, with only the occupied histogram bins, for sending through a socket
+    wxString ReturnAsString( ) const;
+    bool     SetFromString(const wxString& summary_string);
+
+    // A table of the paths sorted by their total time, limited to the wanted number of rows (all if <= 0)
+    wxString ReturnFormattedTable(int maximum_number_of_rows = 0) const;
+    bool     WriteToFile(const wxString& filename) const;
+};
+
+class Profiler {
+
+  public:
+    typedef std::chrono::steady_clock::time_point time_pt;
+
+    static inline bool IsEnabled( ) { return is_enabled.load(std::memory_order_relaxed); }
+
+    // Overrides CISTEM_PROFILE, e.g. for tests
+    static void Enable(bool wanted_enabled);
+
+    // The name must stay valid until the scope ends, which string literals do
+    static void BeginScope(const char* name);
+    static void EndScope( );
+
+    // An event that has already been timed elsewhere, e.g. by StopWatch::lap( ), ending now
+    static void RecordCompletedEvent(const std::string& name, uint64_t duration_in_nanoseconds);
+
+    // Events are collected per job; FinishJob( ) writes the trace of the job (if wanted) and drops its events
+    static void StartJob(const wxString& program_name, int job_number);
+    static void FinishJob(bool write_trace = true);
+
+    static bool WriteChromeTrace(const wxString& filename);
+
+    static ProfileSummary ReturnSummary( );
+
+    // Drop all events and statistics
+    static void Reset( );
+
+    static wxString ReturnOutputDirectory( );
+    static wxString ReturnProgramName( );
+
+  private:
+    static std::atomic<bool> is_enabled;
+};
+
+// Times the enclosing block as a nested scope when the profiler is enabled
+class ProfileScope {
+
+  public:
+    inline ProfileScope(const char* name) {
+        is_active = Profiler::IsEnabled( );
+        if ( is_active )
+            Profiler::BeginScope(name);
+    }
+
+    inline ~ProfileScope( ) {
+        if ( is_active )
+            Profiler::EndScope( );
+    }
+
+    ProfileScope(const ProfileScope&)            = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+  private:
+    bool is_active;
+};
+
+} // namespace cistem_timer
+
+#endif /* __SRC_CORE_PROFILER_H__ */
@@ -1,5 +1,66 @@
 #include "core_headers.h"
 
+#include <zlib.h>
+
+// Dump files written by DumpArrays start with this, followed by a version number, the original (version 1) header, and the chunked arrays.
+// Files without it are version 1 dumps: the header followed by the complete arrays.
+static const char reconstruct3d_dump_magic[4]         = {'R', '3', 'D', 'D'};
+static const int  reconstruct3d_dump_version          = 2;
+static const int  reconstruct3d_dump_header_bytes     = 9 * sizeof(int) + 5 * sizeof(float) + 4;
+static const long reconstruct3d_dump_chunk_bytes      = 16 * 1024 * 1024;
+static const int  reconstruct3d_dump_chunk_raw        = 0;
+static const int  reconstruct3d_dump_chunk_deflated   = 1; // byte-shuffled floats, deflated with zlib
+static const long reconstruct3d_dump_floats_per_block = 4 * 1024 * 1024; // for streaming version 1 dumps
+
+// Returns the version of the dump file and leaves b_stream at the start of the (version 1) header
+static int ReturnDumpFileVersion(std::ifstream& b_stream) {
+    char magic[4];
+    int  version = 1;
+
+    b_stream.read(magic, 4);
+    if ( b_stream.gcount( ) == 4 && memcmp(magic, reconstruct3d_dump_magic, 4) == 0 ) {
+        b_stream.read((char*)&version, sizeof(int));
+    }
+    else {
+        b_stream.clear( );
+        b_stream.seekg(0, std::ios::beg);
+    }
+
+    return version;
+}
+
+// Number of voxels at the start of the row with logical coordinates (y, z) that are within wanted_radius of the origin
+static int ReturnNumberOfVoxelsInRowWithinRadius(int logical_y, int logical_z, int wanted_radius, int voxels_in_row) {
+    long remaining_squared = long(wanted_radius) * long(wanted_radius) - long(logical_y) * long(logical_y) - long(logical_z) * long(logical_z);
+    if ( remaining_squared < 0 )
+        return 0;
+
+    long x_max = long(sqrt(double(remaining_squared)));
+    while ( (x_max + 1) * (x_max + 1) <= remaining_squared )
+        x_max++;
+    while ( x_max * x_max > remaining_squared )
+        x_max--;
+
+    return int(std::min(x_max + 1, long(voxels_in_row)));
+}
+
+// Gather the bytes of each float into separate planes, which makes the slowly varying exponents compress much better
+static void ShuffleFloatBytes(const char* input, char* output, long number_of_floats) {
+    for ( long float_counter = 0; float_counter < number_of_floats; float_counter++ ) {
+        for ( int byte_counter = 0; byte_counter < sizeof(float); byte_counter++ ) {
+            output[byte_counter * number_of_floats + float_counter] = input[float_counter * sizeof(float) + byte_counter];
+        }
+    }
+}
+
+static void UnshuffleFloatBytes(const char* input, char* output, long number_of_floats) {
+    for ( long float_counter = 0; float_counter < number_of_floats; float_counter++ ) {
+        for ( int byte_counter = 0; byte_counter < sizeof(float); byte_counter++ ) {
+            output[float_counter * sizeof(float) + byte_counter] = input[byte_counter * number_of_floats + float_counter];
+        }
+    }
+}
+
 Reconstruct3D::Reconstruct3D(float wanted_pixel_size, float wanted_average_occupancy, float wanted_average_score, float wanted_score_weights_conversion, int wanted_correct_ewald_sphere) {
     logical_x_dimension  = 0;
     logical_y_dimension  = 0;
@@ -17,7 +78,8 @@ Reconstruct3D::Reconstruct3D(float wanted_pixel_size, float wanted_average_occup
     score_weights_conversion = wanted_score_weights_conversion;
     correct_ewald_sphere     = wanted_correct_ewald_sphere;
 
-    ctf_reconstruction = NULL;
+    ctf_reconstruction        = NULL;
+    is_shared_between_threads = false;
 
     symmetry_matrices.Init("C1");
     edge_terms_were_added = false;
@@ -41,7 +103,8 @@ Reconstruct3D::Reconstruct3D(float wanted_pixel_size, float wanted_average_occup
     score_weights_conversion = wanted_score_weights_conversion;
     correct_ewald_sphere     = wanted_correct_ewald_sphere;
 
-    ctf_reconstruction = NULL;
+    ctf_reconstruction        = NULL;
+    is_shared_between_threads = false;
 
     symmetry_matrices.Init(wanted_symmetry);
     edge_terms_were_added = false;
@@ -49,7 +112,8 @@ Reconstruct3D::Reconstruct3D(float wanted_pixel_size, float wanted_average_occup
 }
 
 Reconstruct3D::Reconstruct3D(int wanted_logical_x_dimension, int wanted_logical_y_dimension, int wanted_logical_z_dimension, float wanted_pixel_size, float wanted_average_occupancy, float wanted_average_score, float wanted_score_weights_conversion, wxString wanted_symmetry, int wanted_correct_ewald_sphere) {
-    ctf_reconstruction = NULL;
+    ctf_reconstruction        = NULL;
+    is_shared_between_threads = false;
     Init(wanted_logical_x_dimension, wanted_logical_y_dimension, wanted_logical_z_dimension, wanted_pixel_size, wanted_average_occupancy, wanted_average_score, wanted_score_weights_conversion, wanted_correct_ewald_sphere);
 
     symmetry_matrices.Init(wanted_symmetry);
@@ -107,6 +171,7 @@ void Reconstruct3D::Init(int wanted_logical_x_dimension, int wanted_logical_y_di
 }
 
 void Reconstruct3D::InsertSliceWithCTF(Particle& particle_to_insert, float symmetry_weight) {
+    cistem_timer::ProfileScope profile_scope("InsertSlice");
     MyDebugAssertTrue(particle_to_insert.particle_image->logical_x_dimension == logical_x_dimension && particle_to_insert.particle_image->logical_y_dimension == logical_y_dimension, "Error: Images different sizes");
     MyDebugAssertTrue(particle_to_insert.particle_image->logical_z_dimension == 1, "Error: attempting to insert 3D image into 3D reconstruction");
     MyDebugAssertTrue(image_reconstruction.is_in_memory, "Memory not allocated for image_reconstruction");
@@ -125,7 +190,12 @@ void Reconstruct3D::InsertSliceWithCTF(Particle& particle_to_insert, float symme
     particle_weight = particle_to_insert.particle_occupancy / particle_to_insert.parameter_average.occupancy / powf(particle_to_insert.sigma_noise / particle_to_insert.parameter_average.sigma, 2);
     //	particle_weight = particle_to_insert.particle_occupancy / 100.0 / powf(particle_to_insert.sigma_noise,2);
 
-    images_processed++;
+    if ( is_shared_between_threads ) {
+#pragma omp atomic
+        images_processed++;
+    }
+    else
+        images_processed++;
 
     if ( particle_weight > 0.0 ) {
         int i;
@@ -323,6 +393,7 @@ void Reconstruct3D::InsertSliceWithCTF(Particle& particle_to_insert, float symme
 }
 
 void Reconstruct3D::InsertSliceNoCTF(Particle& particle_to_insert, float symmetry_weight) {
+    cistem_timer::ProfileScope profile_scope("InsertSlice");
     MyDebugAssertTrue(particle_to_insert.particle_image->logical_x_dimension == logical_x_dimension && particle_to_insert.particle_image->logical_y_dimension == logical_y_dimension, "Error: Images different sizes");
     MyDebugAssertTrue(particle_to_insert.particle_image->logical_z_dimension == 1, "Error: attempting to insert 3D image into 3D reconstruction");
     MyDebugAssertTrue(image_reconstruction.is_in_memory, "Memory not allocated for image_reconstruction");
@@ -339,7 +410,12 @@ void Reconstruct3D::InsertSliceNoCTF(Particle& particle_to_insert, float symmetr
     particle_weight = particle_to_insert.particle_occupancy / particle_to_insert.parameter_average.occupancy / powf(particle_to_insert.sigma_noise / particle_to_insert.parameter_average.sigma, 2);
     //	particle_weight = particle_to_insert.particle_occupancy / 100.0 / powf(particle_to_insert.sigma_noise,2);
 
-    images_processed++;
+    if ( is_shared_between_threads ) {
+#pragma omp atomic
+        images_processed++;
+    }
+    else
+        images_processed++;
 
     if ( particle_weight > 0.0 ) {
         int i;
@@ -508,10 +584,9 @@ void Reconstruct3D::AddByLinearInterpolation(float& wanted_logical_x_coordinate,
                         else {
                             physical_z_address = image_reconstruction.logical_z_dimension + k;
                         }
-                        weight                                              = (1.0 - fabsf(wanted_logical_z_coordinate - k)) * weight_xy;
-                        physical_coord                                      = (upper_xy * physical_z_address) + physical_coord_xy;
-                        image_reconstruction.complex_values[physical_coord] = image_reconstruction.complex_values[physical_coord] + value_to_insert * weight;
-                        ctf_reconstruction[physical_coord]                  = ctf_reconstruction[physical_coord] + ctf_squared * weight;
+                        weight         = (1.0 - fabsf(wanted_logical_z_coordinate - k)) * weight_xy;
+                        physical_coord = (upper_xy * physical_z_address) + physical_coord_xy;
+                        AddToVoxel(physical_coord, value_to_insert * weight, ctf_squared * weight);
                     }
                 }
             }
@@ -532,11 +607,10 @@ void Reconstruct3D::AddByLinearInterpolation(float& wanted_logical_x_coordinate,
                         else {
                             physical_z_address = -k;
                         }
-                        weight                                              = (1.0 - fabsf(wanted_logical_z_coordinate - k)) * weight_xy;
-                        physical_coord                                      = (upper_xy * physical_z_address) + physical_coord_xy;
-                        conjugate                                           = conj(value_to_insert);
-                        image_reconstruction.complex_values[physical_coord] = image_reconstruction.complex_values[physical_coord] + conjugate * weight;
-                        ctf_reconstruction[physical_coord]                  = ctf_reconstruction[physical_coord] + ctf_squared * weight;
+                        weight         = (1.0 - fabsf(wanted_logical_z_coordinate - k)) * weight_xy;
+                        physical_coord = (upper_xy * physical_z_address) + physical_coord_xy;
+                        conjugate      = conj(value_to_insert);
+                        AddToVoxel(physical_coord, conjugate * weight, ctf_squared * weight);
                     }
                 }
             }
@@ -613,7 +687,8 @@ float Reconstruct3D::Correct3DCTF(Image& buffer3d) {
     return correction_factor;
 }
 
-void Reconstruct3D::DumpArrays(wxString filename, bool insert_even) {
+void Reconstruct3D::DumpArrays(wxString filename, bool insert_even, bool compress_arrays) {
+    cistem_timer::ProfileScope profile_scope("DumpArrays");
     int   i;
     int   count = 0;
     int   oddeven;
@@ -623,6 +698,9 @@ void Reconstruct3D::DumpArrays(wxString filename, bool insert_even) {
 
     std::ofstream b_stream(filename.c_str( ), std::fstream::out | std::fstream::binary);
 
+    b_stream.write(reconstruct3d_dump_magic, 4);
+    b_stream.write((char*)&reconstruct3d_dump_version, sizeof(int));
+
     char_pointer = (char*)&logical_x_dimension;
     for ( i = 0; i < sizeof(int); i++ ) {
         temp_char[count] = char_pointer[i];
@@ -708,11 +786,104 @@ void Reconstruct3D::DumpArrays(wxString filename, bool insert_even) {
     };
     b_stream.write(temp_char, count);
 
-    char_pointer = (char*)image_reconstruction.real_values;
-    b_stream.write(char_pointer, sizeof(float) * image_reconstruction.real_memory_allocated);
+    // Only the voxels within the radius of the furthest non-zero voxel are written. Everything beyond the resolution limit
+    // that was used for the insertion is zero, so this usually leaves out the corners of the Fourier volume.
+    int  j;
+    int  k;
+    int  voxels_in_row = image_reconstruction.physical_upper_bound_complex_x + 1;
+    long pixel_counter = 0;
+    long radius_squared;
+    long maximum_radius_squared = 0;
+    int  logical_y;
+    int  logical_z;
+
+    for ( k = 0; k <= image_reconstruction.physical_upper_bound_complex_z; k++ ) {
+        logical_z = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k);
+        for ( j = 0; j <= image_reconstruction.physical_upper_bound_complex_y; j++ ) {
+            logical_y = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
+            for ( i = 0; i < voxels_in_row; i++ ) {
+                if ( ctf_reconstruction[pixel_counter] != 0.0f || image_reconstruction.complex_values[pixel_counter] != 0.0f ) {
+                    radius_squared         = long(i) * long(i) + long(logical_y) * long(logical_y) + long(logical_z) * long(logical_z);
+                    maximum_radius_squared = std::max(maximum_radius_squared, radius_squared);
+                }
+                pixel_counter++;
+            }
+        }
+    }
 
-    char_pointer = (char*)ctf_reconstruction;
-    b_stream.write(char_pointer, sizeof(float) * image_reconstruction.real_memory_allocated / 2);
+    int radius_limit = int(sqrt(double(maximum_radius_squared)));
+    while ( long(radius_limit) * long(radius_limit) < maximum_radius_squared )
+        radius_limit++;
+
+    int  number_of_z_planes  = image_reconstruction.physical_upper_bound_complex_z + 1;
+    long bytes_per_z_plane   = long(voxels_in_row) * long(image_reconstruction.physical_upper_bound_complex_y + 1) * 3 * sizeof(float);
+    int  z_planes_per_chunk  = std::max(1, int(reconstruct3d_dump_chunk_bytes / bytes_per_z_plane));
+    int  number_of_chunks    = (number_of_z_planes + z_planes_per_chunk - 1) / z_planes_per_chunk;
+    long floats_per_chunk    = long(z_planes_per_chunk) * bytes_per_z_plane / sizeof(float);
+    uLong compressed_maximum = compressBound(floats_per_chunk * sizeof(float));
+
+    b_stream.write((char*)&radius_limit, sizeof(int));
+    b_stream.write((char*)&number_of_chunks, sizeof(int));
+
+    std::vector<float> chunk_values(floats_per_chunk);
+    std::vector<char>  shuffled_bytes;
+    std::vector<char>  compressed_bytes;
+    if ( compress_arrays ) {
+        shuffled_bytes.resize(floats_per_chunk * sizeof(float));
+        compressed_bytes.resize(compressed_maximum);
+    }
+
+    for ( int first_z = 0; first_z < number_of_z_planes; first_z += z_planes_per_chunk ) {
+        int  z_planes_in_chunk = std::min(z_planes_per_chunk, number_of_z_planes - first_z);
+        long number_of_floats  = 0;
+        int  voxels_to_write;
+        long first_voxel_index;
+
+        // All complex values of the chunk first, then the matching CTF values
+        for ( k = first_z; k < first_z + z_planes_in_chunk; k++ ) {
+            logical_z = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k);
+            for ( j = 0; j <= image_reconstruction.physical_upper_bound_complex_y; j++ ) {
+                logical_y         = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
+                voxels_to_write   = ReturnNumberOfVoxelsInRowWithinRadius(logical_y, logical_z, radius_limit, voxels_in_row);
+                first_voxel_index = (long(k) * long(image_reconstruction.physical_upper_bound_complex_y + 1) + long(j)) * long(voxels_in_row);
+                memcpy(&chunk_values[number_of_floats], &image_reconstruction.complex_values[first_voxel_index], sizeof(std::complex<float>) * voxels_to_write);
+                number_of_floats += 2 * voxels_to_write;
+            }
+        }
+        for ( k = first_z; k < first_z + z_planes_in_chunk; k++ ) {
+            logical_z = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k);
+            for ( j = 0; j <= image_reconstruction.physical_upper_bound_complex_y; j++ ) {
+                logical_y         = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
+                voxels_to_write   = ReturnNumberOfVoxelsInRowWithinRadius(logical_y, logical_z, radius_limit, voxels_in_row);
+                first_voxel_index = (long(k) * long(image_reconstruction.physical_upper_bound_complex_y + 1) + long(j)) * long(voxels_in_row);
+                memcpy(&chunk_values[number_of_floats], &ctf_reconstruction[first_voxel_index], sizeof(float) * voxels_to_write);
+                number_of_floats += voxels_to_write;
+            }
+        }
+
+        int       chunk_encoding     = reconstruct3d_dump_chunk_raw;
+        long long uncompressed_bytes = number_of_floats * sizeof(float);
+        long long stored_bytes       = uncompressed_bytes;
+        char*     bytes_to_write     = (char*)chunk_values.data( );
+
+        if ( compress_arrays && number_of_floats > 0 ) {
+            ShuffleFloatBytes((char*)chunk_values.data( ), shuffled_bytes.data( ), number_of_floats);
+            uLongf compressed_size = compressed_bytes.size( );
+            // Keep the chunk raw if deflating fails or does not help
+            if ( compress2((Bytef*)compressed_bytes.data( ), &compressed_size, (Bytef*)shuffled_bytes.data( ), uncompressed_bytes, Z_BEST_SPEED) == Z_OK && compressed_size < uncompressed_bytes ) {
+                chunk_encoding = reconstruct3d_dump_chunk_deflated;
+                stored_bytes   = compressed_size;
+                bytes_to_write = compressed_bytes.data( );
+            }
+        }
+
+        b_stream.write((char*)&first_z, sizeof(int));
+        b_stream.write((char*)&z_planes_in_chunk, sizeof(int));
+        b_stream.write((char*)&chunk_encoding, sizeof(int));
+        b_stream.write((char*)&uncompressed_bytes, sizeof(long long));
+        b_stream.write((char*)&stored_bytes, sizeof(long long));
+        b_stream.write(bytes_to_write, stored_bytes);
+    }
 
     b_stream.close( );
 }
@@ -720,16 +891,36 @@ void Reconstruct3D::DumpArrays(wxString filename, bool insert_even) {
 void Reconstruct3D::ReadArrayHeader(wxString filename, int& logical_x_dimension, int& logical_y_dimension, int& logical_z_dimension,
                                     int& original_x_dimension, int& original_y_dimension, int& original_z_dimension, int& images_processed, float& pixel_size, float& original_pixel_size,
                                     float& average_occupancy, float& average_score, float& score_weights_conversion, wxString& symmetry_symbol, bool& insert_even, bool& center_mass) {
+    std::ifstream b_stream(filename.c_str( ), std::fstream::in | std::fstream::binary);
+
+    if ( ReturnDumpFileVersion(b_stream) > reconstruct3d_dump_version ) {
+        MyPrintWithDetails("Error: Dump file %s was written by a newer version\n", filename);
+        DEBUG_ABORT;
+    }
+
+    if ( ! ReadArrayHeader(b_stream, logical_x_dimension, logical_y_dimension, logical_z_dimension, original_x_dimension, original_y_dimension, original_z_dimension,
+                           images_processed, pixel_size, original_pixel_size, average_occupancy, average_score, score_weights_conversion, symmetry_symbol, insert_even, center_mass) ) {
+        MyPrintWithDetails("Error: Dump file %s is truncated or corrupt\n", filename);
+        DEBUG_ABORT;
+    }
+
+    b_stream.close( );
+}
+
+bool Reconstruct3D::ReadArrayHeader(std::ifstream& b_stream, int& logical_x_dimension, int& logical_y_dimension, int& logical_z_dimension,
+                                    int& original_x_dimension, int& original_y_dimension, int& original_z_dimension, int& images_processed, float& pixel_size, float& original_pixel_size,
+                                    float& average_occupancy, float& average_score, float& score_weights_conversion, wxString& symmetry_symbol, bool& insert_even, bool& center_mass) {
     int   i;
-    int   count = 9 * sizeof(int) + 5 * sizeof(float) + 4;
+    int   count = reconstruct3d_dump_header_bytes;
     int   oddeven;
     int   center;
-    char  temp_char[count];
+    char  temp_char[reconstruct3d_dump_header_bytes];
     char* char_pointer;
 
-    std::ifstream b_stream(filename.c_str( ), std::fstream::in | std::fstream::binary);
-
     b_stream.read(temp_char, count);
+    if ( ! b_stream.good( ) || b_stream.gcount( ) != count )
+        return false;
+
     count        = 0;
     char_pointer = (char*)&logical_x_dimension;
     for ( i = 0; i < sizeof(int); i++ ) {
@@ -816,120 +1007,220 @@ void Reconstruct3D::ReadArrayHeader(wxString filename, int& logical_x_dimension,
 
     symmetry_matrices.Init(symmetry_symbol);
 
-    b_stream.close( );
+    return true;
 }
 
 void Reconstruct3D::ReadArrays(wxString filename) {
-    int   i;
-    int   count = 9 * sizeof(int) + 5 * sizeof(float) + 4;
-    int   oddeven;
-    int   center;
-    char  temp_char[count];
-    char* char_pointer;
-    float input_pixel_size;
-    float input_original_pixel_size;
-    float input_average_occupancy;
-    float input_average_score;
-    float input_score_weights_conversion;
-    int   input_logical_x_dimension;
-    int   input_logical_y_dimension;
-    int   input_logical_z_dimension;
-    int   input_original_x_dimension;
-    int   input_original_y_dimension;
-    int   input_original_z_dimension;
-    //	int input_images_processed;
+    image_reconstruction.SetToConstant(0.0f);
+    ZeroFloatArray(ctf_reconstruction, image_reconstruction.real_memory_allocated / 2);
+    images_processed = 0;
+
+    AddArraysFromFile(filename);
+}
+
+// Add the arrays stored in a dump file to this reconstruction, one chunk at a time, so that dump files can be merged without
+// holding a second copy of the arrays in memory.
+void Reconstruct3D::AddArraysFromFile(wxString filename) {
+    if ( ! TryToAddArraysFromFile(filename) )
+        DEBUG_ABORT;
+}
+
+bool Reconstruct3D::TryToAddArraysFromFile(wxString filename) {
+    cistem_timer::ProfileScope profile_scope("AddArraysFromFile");
+    int      i;
+    int      j;
+    int      k;
+    float    input_pixel_size;
+    float    input_original_pixel_size;
+    float    input_average_occupancy;
+    float    input_average_score;
+    float    input_score_weights_conversion;
+    int      input_logical_x_dimension;
+    int      input_logical_y_dimension;
+    int      input_logical_z_dimension;
+    int      input_original_x_dimension;
+    int      input_original_y_dimension;
+    int      input_original_z_dimension;
+    int      input_images_processed;
     wxString input_symmetry_symbol;
+    bool     input_insert_even;
+    bool     input_center_mass;
 
     std::ifstream b_stream(filename.c_str( ), std::fstream::in | std::fstream::binary);
 
-    b_stream.read(temp_char, count);
-    count        = 0;
-    char_pointer = (char*)&input_logical_x_dimension;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_logical_y_dimension;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_logical_z_dimension;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_original_x_dimension;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_original_y_dimension;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_original_z_dimension;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&images_processed;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_pixel_size;
-    for ( i = 0; i < sizeof(float); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_original_pixel_size;
-    for ( i = 0; i < sizeof(float); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_average_occupancy;
-    for ( i = 0; i < sizeof(float); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_average_score;
-    for ( i = 0; i < sizeof(float); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&input_score_weights_conversion;
-    for ( i = 0; i < sizeof(float); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    input_symmetry_symbol = "";
-    for ( i = 0; i < 4; i++ )
-        input_symmetry_symbol += temp_char[count + i];
-    count += 4;
-    char_pointer = (char*)&oddeven;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
-    char_pointer = (char*)&center;
-    for ( i = 0; i < sizeof(int); i++ ) {
-        char_pointer[i] = temp_char[count];
-        count++;
-    };
+    int version = ReturnDumpFileVersion(b_stream);
+    if ( version > reconstruct3d_dump_version ) {
+        MyPrintWithDetails("Error: Dump file %s was written by a newer version\n", filename);
+        return false;
+    }
+
+    if ( ! ReadArrayHeader(b_stream, input_logical_x_dimension, input_logical_y_dimension, input_logical_z_dimension,
+                           input_original_x_dimension, input_original_y_dimension, input_original_z_dimension, input_images_processed,
+                           input_pixel_size, input_original_pixel_size, input_average_occupancy, input_average_score, input_score_weights_conversion,
+                           input_symmetry_symbol, input_insert_even, input_center_mass) ) {
+        MyPrintWithDetails("Error: Dump file %s is truncated or corrupt\n", filename);
+        return false;
+    }
 
     if ( input_logical_x_dimension != logical_x_dimension || input_logical_y_dimension != logical_y_dimension || input_logical_z_dimension != logical_z_dimension || input_pixel_size != pixel_size ) {
         MyPrintWithDetails("Error: Dump file incompatible with 3D reconstruction\n");
-        DEBUG_ABORT;
+        return false;
+    }
+
+    if ( version == 1 ) {
+        // The complete arrays follow the header
+        long               floats_in_complex_array = image_reconstruction.real_memory_allocated;
+        long               floats_in_ctf_array     = image_reconstruction.real_memory_allocated / 2;
+        long               floats_to_read;
+        std::vector<float> block(std::min(reconstruct3d_dump_floats_per_block, floats_in_complex_array));
+
+        for ( long first_float = 0; first_float < floats_in_complex_array; first_float += floats_to_read ) {
+            floats_to_read = std::min(long(block.size( )), floats_in_complex_array - first_float);
+            b_stream.read((char*)block.data( ), sizeof(float) * floats_to_read);
+            if ( ! b_stream.good( ) ) {
+                MyPrintWithDetails("Error: Dump file %s is truncated or corrupt\n", filename);
+                return false;
+            }
+            for ( long float_counter = 0; float_counter < floats_to_read; float_counter++ ) {
+                image_reconstruction.real_values[first_float + float_counter] += block[float_counter];
+            }
+        }
+
+        for ( long first_float = 0; first_float < floats_in_ctf_array; first_float += floats_to_read ) {
+            floats_to_read = std::min(long(block.size( )), floats_in_ctf_array - first_float);
+            b_stream.read((char*)block.data( ), sizeof(float) * floats_to_read);
+            if ( ! b_stream.good( ) ) {
+                MyPrintWithDetails("Error: Dump file %s is truncated or corrupt\n", filename);
+                return false;
+            }
+            for ( long float_counter = 0; float_counter < floats_to_read; float_counter++ ) {
+                ctf_reconstruction[first_float + float_counter] += block[float_counter];
+            }
+        }
     }
-    char_pointer = (char*)image_reconstruction.real_values;
-    b_stream.read(char_pointer, sizeof(float) * image_reconstruction.real_memory_allocated);
+    else {
+        int radius_limit;
+        int number_of_chunks;
+        int voxels_in_row = image_reconstruction.physical_upper_bound_complex_x + 1;
+        int logical_y;
+        int logical_z;
+        int voxels_to_add;
+
+        b_stream.read((char*)&radius_limit, sizeof(int));
+        b_stream.read((char*)&number_of_chunks, sizeof(int));
+
+        if ( ! b_stream.good( ) || radius_limit < 0 || number_of_chunks < 0 || number_of_chunks > image_reconstruction.physical_upper_bound_complex_z + 1 ) {
+            MyPrintWithDetails("Error: Dump file %s is truncated or corrupt\n", filename);
+            return false;
+        }
+
+        std::vector<float> chunk_values;
+        std::vector<char>  stored_bytes_buffer;
+        std::vector<char>  shuffled_bytes;
+
+        for ( int chunk_counter = 0; chunk_counter < number_of_chunks; chunk_counter++ ) {
+            int       first_z;
+            int       z_planes_in_chunk;
+            int       chunk_encoding;
+            long long uncompressed_bytes;
+            long long stored_bytes;
+
+            b_stream.read((char*)&first_z, sizeof(int));
+            b_stream.read((char*)&z_planes_in_chunk, sizeof(int));
+            b_stream.read((char*)&chunk_encoding, sizeof(int));
+            b_stream.read((char*)&uncompressed_bytes, sizeof(long long));
+            b_stream.read((char*)&stored_bytes, sizeof(long long));
+
+            if ( ! b_stream.good( ) || first_z < 0 || z_planes_in_chunk < 0 || first_z + z_planes_in_chunk > image_reconstruction.physical_upper_bound_complex_z + 1 ) {
+                MyPrintWithDetails("Error: Dump file %s is truncated or corrupt\n", filename);
+                return false;
+            }
+
+            // The geometry of the chunk determines how many values it must hold, so that the sizes in the file need not be trusted
+            long number_of_floats = 0;
+            for ( k = first_z; k < first_z + z_planes_in_chunk; k++ ) {
+                logical_z = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k);
+                for ( j = 0; j <= image_reconstruction.physical_upper_bound_complex_y; j++ ) {
+                    logical_y = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
+                    number_of_floats += 3 * ReturnNumberOfVoxelsInRowWithinRadius(logical_y, logical_z, radius_limit, voxels_in_row);
+                }
+            }
+
+            bool chunk_sizes_are_valid = uncompressed_bytes == (long long)(number_of_floats * sizeof(float));
+            if ( chunk_encoding == reconstruct3d_dump_chunk_raw )
+                chunk_sizes_are_valid = chunk_sizes_are_valid && stored_bytes == uncompressed_bytes;
+            else if ( chunk_encoding == reconstruct3d_dump_chunk_deflated )
+                chunk_sizes_are_valid = chunk_sizes_are_valid && stored_bytes > 0 && stored_bytes <= (long long)compressBound(uncompressed_bytes);
+            else
+                chunk_sizes_are_valid = false;
+
+            if ( ! chunk_sizes_are_valid ) {
+                MyPrintWithDetails("Error: Chunk %i of dump file %s is corrupt\n", chunk_counter, filename);
+                return false;
+            }
+
+            chunk_values.resize(number_of_floats);
+
+            if ( chunk_encoding == reconstruct3d_dump_chunk_deflated ) {
+                stored_bytes_buffer.resize(stored_bytes);
+                shuffled_bytes.resize(uncompressed_bytes);
+                b_stream.read(stored_bytes_buffer.data( ), stored_bytes);
+                if ( ! b_stream.good( ) ) {
+                    MyPrintWithDetails("Error: Dump file %s is truncated or corrupt\n", filename);
+                    return false;
+                }
+                uLongf decompressed_size = uncompressed_bytes;
+                if ( uncompress((Bytef*)shuffled_bytes.data( ), &decompressed_size, (Bytef*)stored_bytes_buffer.data( ), stored_bytes) != Z_OK || decompressed_size != uncompressed_bytes ) {
+                    MyPrintWithDetails("Error: Could not decompress chunk %i of dump file %s\n", chunk_counter, filename);
+                    return false;
+                }
+                UnshuffleFloatBytes(shuffled_bytes.data( ), (char*)chunk_values.data( ), number_of_floats);
+            }
+            else {
+                b_stream.read((char*)chunk_values.data( ), stored_bytes);
+                if ( ! b_stream.good( ) ) {
+                    MyPrintWithDetails("Error: Dump file %s is truncated or corrupt\n", filename);
+                    return false;
+                }
+            }
+
+            // Same order as in DumpArrays: the complex values of every row in the chunk, then the CTF values
+            long float_counter = 0;
+            long first_voxel_index;
+            for ( k = first_z; k < first_z + z_planes_in_chunk; k++ ) {
+                logical_z = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k);
+                for ( j = 0; j <= image_reconstruction.physical_upper_bound_complex_y; j++ ) {
+                    logical_y         = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
+                    voxels_to_add     = ReturnNumberOfVoxelsInRowWithinRadius(logical_y, logical_z, radius_limit, voxels_in_row);
+                    first_voxel_index = (long(k) * long(image_reconstruction.physical_upper_bound_complex_y + 1) + long(j)) * long(voxels_in_row);
+                    for ( i = 0; i < 2 * voxels_to_add; i++ ) {
+                        image_reconstruction.real_values[2 * first_voxel_index + i] += chunk_values[float_counter];
+                        float_counter++;
+                    }
+                }
+            }
+            for ( k = first_z; k < first_z + z_planes_in_chunk; k++ ) {
+                logical_z = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k);
+                for ( j = 0; j <= image_reconstruction.physical_upper_bound_complex_y; j++ ) {
+                    logical_y         = image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
+                    voxels_to_add     = ReturnNumberOfVoxelsInRowWithinRadius(logical_y, logical_z, radius_limit, voxels_in_row);
+                    first_voxel_index = (long(k) * long(image_reconstruction.physical_upper_bound_complex_y + 1) + long(j)) * long(voxels_in_row);
+                    for ( i = 0; i < voxels_to_add; i++ ) {
+                        ctf_reconstruction[first_voxel_index + i] += chunk_values[float_counter];
+                        float_counter++;
+                    }
+                }
+            }
 
-    char_pointer = (char*)ctf_reconstruction;
-    b_stream.read(char_pointer, sizeof(float) * image_reconstruction.real_memory_allocated / 2);
+            MyDebugAssertTrue(float_counter == number_of_floats, "Chunk %i holds %li values, but %li were expected", chunk_counter, number_of_floats, float_counter);
+        }
+    }
 
     b_stream.close( );
+
+    images_processed += input_images_processed;
+
+    return true;
 }
 
 Reconstruct3D& Reconstruct3D::operator=(const Reconstruct3D& other) {
@@ -1000,3 +1291,62 @@ Reconstruct3D& Reconstruct3D::operator+=(const Reconstruct3D* other) {
 
     return *this;
 }
+
+void Reconstruct3D::AddZSlab(const Reconstruct3D& other, int first_z, int last_z) {
+    MyDebugAssertTrue(other.logical_x_dimension == image_reconstruction.logical_x_dimension && other.logical_y_dimension == image_reconstruction.logical_y_dimension && other.logical_z_dimension == image_reconstruction.logical_z_dimension, "Reconstruct3D objects have different dimensions");
+    MyDebugAssertTrue(first_z >= 0 && last_z <= image_reconstruction.physical_upper_bound_complex_z && first_z <= last_z, "Bad slab: %i to %i", first_z, last_z);
+
+    long voxels_per_z_plane = long(image_reconstruction.physical_upper_bound_complex_x + 1) * long(image_reconstruction.physical_upper_bound_complex_y + 1);
+    long first_voxel        = long(first_z) * voxels_per_z_plane;
+    long last_voxel         = long(last_z + 1) * voxels_per_z_plane;
+
+    for ( long pixel_counter = first_voxel; pixel_counter < last_voxel; pixel_counter++ ) {
+        image_reconstruction.complex_values[pixel_counter] += other.image_reconstruction.complex_values[pixel_counter];
+        ctf_reconstruction[pixel_counter] += other.ctf_reconstruction[pixel_counter];
+    }
+}
+
+void Reconstruct3D::AddInZSlabs(std::vector<Reconstruct3D*>& targets, std::vector<Reconstruct3D*>& sources, int max_threads) {
+    MyDebugAssertTrue(targets.size( ) == sources.size( ), "Number of targets (%li) and sources (%li) differ", long(targets.size( )), long(sources.size( )));
+
+    if ( targets.empty( ) )
+        return;
+
+    int number_of_pairs      = int(targets.size( ));
+    int number_of_z_planes   = targets[0]->image_reconstruction.physical_upper_bound_complex_z + 1;
+    int z_planes_per_slab    = std::max(1, number_of_z_planes / (4 * max_threads));
+    int number_of_slabs      = (number_of_z_planes + z_planes_per_slab - 1) / z_planes_per_slab;
+    int number_of_work_items = number_of_pairs * number_of_slabs;
+
+#pragma omp parallel for num_threads(max_threads) schedule(dynamic, 1)
+    for ( int work_item = 0; work_item < number_of_work_items; work_item++ ) {
+        int pair    = work_item / number_of_slabs;
+        int first_z = (work_item % number_of_slabs) * z_planes_per_slab;
+        int last_z  = std::min(first_z + z_planes_per_slab, number_of_z_planes) - 1;
+        targets[pair]->AddZSlab(*sources[pair], first_z, last_z);
+    }
+
+    for ( int pair = 0; pair < number_of_pairs; pair++ ) {
+        targets[pair]->images_processed += sources[pair]->images_processed;
+    }
+}
+
+void Reconstruct3D::AddPartialSumsInTree(std::vector<Reconstruct3D*>& partial_sums, int max_threads) {
+    int number_of_partial_sums = int(partial_sums.size( ));
+
+    for ( int stride = 1; stride < number_of_partial_sums; stride *= 2 ) {
+        std::vector<Reconstruct3D*> targets;
+        std::vector<Reconstruct3D*> sources;
+        for ( int target = 0; target + stride < number_of_partial_sums; target += 2 * stride ) {
+            targets.push_back(partial_sums[target]);
+            sources.push_back(partial_sums[target + stride]);
+        }
+
+        AddInZSlabs(targets, sources, max_threads);
+
+        for ( int target = 0; target + stride < number_of_partial_sums; target += 2 * stride ) {
+            delete partial_sums[target + stride];
+            partial_sums[target + stride] = NULL;
+        }
+    }
+}
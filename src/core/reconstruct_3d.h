@@ -27,6 +27,10 @@ class Reconstruct3D {
 
     int images_processed;
 
+    // When true, several threads may insert into this reconstruction at the same time; every voxel update is then done as an atomic add.
+    // This keeps one copy of the arrays instead of one per thread, at the cost of slower updates.
+    bool is_shared_between_threads;
+
     Reconstruct3D(float wanted_pixel_size = 0.0, float wanted_average_occupancy = 0.0, float wanted_average_score = 0.0, float wanted_score_weights_conversion = 0.0, int wanted_correct_ewald_sphere = 0);
     Reconstruct3D(float wanted_pixel_size, float wanted_average_occupancy, float wanted_average_score, float wanted_score_weights_conversion, wxString wanted_symmetry, int wanted_correct_ewald_sphere = 0);
     Reconstruct3D(int wanted_logical_x_dimension, int wanted_logical_y_dimension, int wanted_logical_z_dimension, float wanted_pixel_size, float wanted_average_occupancy, float wanted_average_score, float wanted_score_weights_conversion, wxString wanted_symmetry, int wanted_correct_ewald_sphere = 0); // constructor with size
@@ -39,14 +43,50 @@ class Reconstruct3D {
     void           AddByLinearInterpolation(float& wanted_x_coordinate, float& wanted_y_coordinate, float& wanted_z_coordinate, std::complex<float>& wanted_value, std::complex<float>& ctf_value, float wanted_weight, bool complex_ctf = false);
     void           CompleteEdges( );
     float          Correct3DCTF(Image& buffer3d);
-    void           DumpArrays(wxString filename, bool insert_even);
+    void           DumpArrays(wxString filename, bool insert_even, bool compress_arrays = true);
     void           ReadArrayHeader(wxString filename, int& logical_x_dimension, int& logical_y_dimension, int& logical_z_dimension,
                                    int& original_x_dimension, int& original_y_dimension, int& original_z_dimension, int& images_processed, float& pixel_size, float& original_pixel_size,
                                    float& average_occupancy, float& average_score, float& score_weights_conversion, wxString& symmetry_symbol, bool& insert_even, bool& center_mass);
+    // Same, from a dump file that is already open and positioned after the version; returns false if the header is truncated
+    bool           ReadArrayHeader(std::ifstream& b_stream, int& logical_x_dimension, int& logical_y_dimension, int& logical_z_dimension,
+                                   int& original_x_dimension, int& original_y_dimension, int& original_z_dimension, int& images_processed, float& pixel_size, float& original_pixel_size,
+                                   float& average_occupancy, float& average_score, float& score_weights_conversion, wxString& symmetry_symbol, bool& insert_even, bool& center_mass);
     void           ReadArrays(wxString filename);
+    void           AddArraysFromFile(wxString filename);
+    // Same, but prints the error and returns false for a dump file that is truncated, corrupt, newer or incompatible, rather than
+    // aborting. The arrays may then hold part of the file.
+    bool           TryToAddArraysFromFile(wxString filename);
     Reconstruct3D  operator+(const Reconstruct3D& other);
     Reconstruct3D& operator=(const Reconstruct3D& other);
     Reconstruct3D& operator=(const Reconstruct3D* other);
     Reconstruct3D& operator+=(const Reconstruct3D& other);
     Reconstruct3D& operator+=(const Reconstruct3D* other);
+
+    // Add the physical z planes first_z to last_z (inclusive) of other to this reconstruction. images_processed is left alone,
+    // so that disjoint slabs of the same pair of reconstructions may be added by different threads.
+    void AddZSlab(const Reconstruct3D& other, int first_z, int last_z);
+
+    // Add each source to the target of the same index. Every pair is cut into slabs of z planes, so that all threads are kept busy
+    // even when there are fewer pairs than threads.
+    static void AddInZSlabs(std::vector<Reconstruct3D*>& targets, std::vector<Reconstruct3D*>& sources, int max_threads);
+
+    // Add partial sums 1 to n-1 to partial_sums[0], pairwise in a tree. Partial sums 1 to n-1 must have been allocated with new;
+    // each is deleted as soon as it has been added, and its pointer set to NULL.
+    static void AddPartialSumsInTree(std::vector<Reconstruct3D*>& partial_sums, int max_threads);
+
+    inline void AddToVoxel(long physical_coord, std::complex<float> value_to_add, float ctf_value_to_add) {
+        if ( is_shared_between_threads ) {
+            float* voxel = reinterpret_cast<float*>(&image_reconstruction.complex_values[physical_coord]);
+#pragma omp atomic
+            voxel[0] += real(value_to_add);
+#pragma omp atomic
+            voxel[1] += imag(value_to_add);
+#pragma omp atomic
+            ctf_reconstruction[physical_coord] += ctf_value_to_add;
+        }
+        else {
+            image_reconstruction.complex_values[physical_coord] += value_to_add;
+            ctf_reconstruction[physical_coord] += ctf_value_to_add;
+        }
+    }
 };
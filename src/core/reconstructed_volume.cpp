@@ -185,6 +185,7 @@ void ReconstructedVolume::InitWithDimensions(int wanted_logical_x_dimension, int
 
 //void ReconstructedVolume::PrepareForProjections(float resolution_limit, bool approximate_binning, bool apply_binning)
 void ReconstructedVolume::PrepareForProjections(float low_resolution_limit, float high_resolution_limit, bool approximate_binning, bool apply_binning) {
+    cistem_timer::ProfileScope profile_scope("PrepareForProjections");
     int   fourier_size_x;
     int   fourier_size_y;
     int   fourier_size_z;
@@ -254,6 +255,7 @@ void ReconstructedVolume::PrepareForProjections(float low_resolution_limit, floa
 
 void ReconstructedVolume::CalculateProjection(Image& projection, Image& CTF, AnglesAndShifts& angles_and_shifts_of_projection,
                                               float mask_radius, float mask_falloff, float resolution_limit, bool swap_quadrants, bool apply_shifts, bool whiten, bool apply_ctf, bool abolute_ctf, bool calculate_projection) {
+    cistem_timer::ProfileScope profile_scope("CalculateProjection");
     //	MyDebugAssertTrue(projection.logical_x_dimension == density_map->logical_x_dimension && projection.logical_y_dimension == density_map->logical_y_dimension, "Error: Images have different sizes");
     MyDebugAssertTrue(CTF.logical_x_dimension == projection.logical_x_dimension && CTF.logical_y_dimension == projection.logical_y_dimension, "Error: CTF image has different size");
     MyDebugAssertTrue(projection.logical_z_dimension == 1, "Error: attempting to extract 3D image from 3D reconstruction");
@@ -599,6 +601,7 @@ void ReconstructedVolume::OptimalFilter(ResolutionStatistics& statistics) {
 
 void ReconstructedVolume::FinalizeSimple(Reconstruct3D& reconstruction, int& original_box_size, float& original_pixel_size, float& pixel_size,
                                          float& inner_mask_radius, float& outer_mask_radius, float& mask_falloff, wxString& output_volume) {
+    cistem_timer::ProfileScope profile_scope("FinalizeSimple");
     int     intermediate_box_size = myroundint(original_box_size / pixel_size * original_pixel_size);
     int     box_size              = reconstruction.logical_x_dimension;
     MRCFile output_file;
@@ -629,6 +632,7 @@ void ReconstructedVolume::FinalizeSimple(Reconstruct3D& reconstruction, int& ori
 void ReconstructedVolume::FinalizeOptimal(Reconstruct3D& reconstruction, Image* density_map_1, Image* density_map_2,
                                           float& original_pixel_size, float& pixel_size, float& inner_mask_radius, float& outer_mask_radius, float& mask_falloff,
                                           bool center_mass, wxString& output_volume, NumericTextFile& output_statistics, ResolutionStatistics* copy_of_statistics, float weiner_filter_nominator) {
+    cistem_timer::ProfileScope profile_scope("FinalizeOptimal");
     int                  original_box_size     = density_map_1->logical_x_dimension;
     int                  intermediate_box_size = myroundint(original_box_size / pixel_size * original_pixel_size);
     int                  box_size              = reconstruction.logical_x_dimension;
@@ -738,6 +742,7 @@ void ReconstructedVolume::FinalizeOptimal(Reconstruct3D& reconstruction, Image*
 void ReconstructedVolume::FinalizeML(Reconstruct3D& reconstruction, Image* density_map_1, Image* density_map_2,
                                      float& original_pixel_size, float& pixel_size, float& inner_mask_radius, float& outer_mask_radius, float& mask_falloff,
                                      wxString& output_volume, NumericTextFile& output_statistics, ResolutionStatistics* copy_of_statistics) {
+    cistem_timer::ProfileScope profile_scope("FinalizeML");
     int                  original_box_size     = density_map_1->logical_x_dimension;
     int                  intermediate_box_size = myroundint(original_box_size / pixel_size * original_pixel_size);
     int                  box_size              = reconstruction.logical_x_dimension;
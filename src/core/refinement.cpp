@@ -113,6 +113,62 @@ ShortRefinementInfo& ShortRefinementInfo::operator=(const Refinement* other_refi
     return *this;
 }
 
+RefinementResultIndex::RefinementResultIndex( ) {
+    is_dense = true;
+    is_built = false;
+}
+
+void RefinementResultIndex::Clear( ) {
+    dense_index.clear( );
+    sparse_index.clear( );
+    is_dense = true;
+    is_built = false;
+}
+
+void RefinementResultIndex::Build(const ArrayofRefinementResults& wanted_results) {
+    long number_of_results = wanted_results.GetCount( );
+    long lowest_position   = std::numeric_limits<long>::max( );
+    long highest_position  = -1;
+
+    Clear( );
+
+    for ( long result_counter = 0; result_counter < number_of_results; result_counter++ ) {
+        lowest_position  = std::min(lowest_position, wanted_results[result_counter].position_in_stack);
+        highest_position = std::max(highest_position, wanted_results[result_counter].position_in_stack);
+    }
+
+    // a table is used as long as it wouldn't be much larger than the results themselves
+    is_dense = (number_of_results == 0) || (lowest_position >= 0 && highest_position < 2 * number_of_results + 1024);
+
+    // where a position occurs more than once, the first occurrence wins
+    if ( is_dense == true ) {
+        dense_index.assign(highest_position + 1, -1);
+        for ( long result_counter = 0; result_counter < number_of_results; result_counter++ ) {
+            if ( dense_index[wanted_results[result_counter].position_in_stack] == -1 )
+                dense_index[wanted_results[result_counter].position_in_stack] = result_counter;
+        }
+    }
+    else {
+        sparse_index.reserve(number_of_results);
+        for ( long result_counter = 0; result_counter < number_of_results; result_counter++ ) {
+            sparse_index.emplace(wanted_results[result_counter].position_in_stack, result_counter);
+        }
+    }
+
+    is_built = true;
+}
+
+long RefinementResultIndex::ReturnIndex(long wanted_position_in_stack) const {
+    if ( is_dense == true ) {
+        if ( wanted_position_in_stack < 0 || wanted_position_in_stack >= long(dense_index.size( )) )
+            return -1;
+        return dense_index[wanted_position_in_stack];
+    }
+
+    auto found_position = sparse_index.find(wanted_position_in_stack);
+    return (found_position == sparse_index.end( )) ? -1 : found_position->second;
+}
+
 Refinement::Refinement( ) {
     refinement_id                       = -1;
     refinement_package_asset_id         = -1;
@@ -216,18 +272,38 @@ RefinementResult Refinement::ReturnRefinementResultByClassAndPositionInStack(int
     MyDebugAssertTrue(wanted_class >= 0 && wanted_class < number_of_classes, "wanted class (%i) out of range!", wanted_class);
     MyDebugAssertTrue(wanted_position_in_stack > 0 && wanted_class <= number_of_particles, "wanted position in stack out of range!");
 
-    for ( long counter = wanted_position_in_stack - 1; counter < number_of_particles; counter++ ) {
-        if ( class_refinement_results[wanted_class].particle_refinement_results[counter].position_in_stack == wanted_position_in_stack )
-            return class_refinement_results[wanted_class].particle_refinement_results[counter];
+    long result_index = ReturnResultIndexByClassAndPositionInStack(wanted_class, wanted_position_in_stack);
+
+    if ( result_index < 0 ) {
+        MyDebugPrintWithDetails("Shouldn't get here, means i didn't find the particle - Class #%i, Pos = %li", wanted_class, wanted_position_in_stack);
+        DEBUG_ABORT;
     }
 
-    for ( long counter = 0; counter < wanted_position_in_stack; counter++ ) {
-        if ( class_refinement_results[wanted_class].particle_refinement_results[counter].position_in_stack == wanted_position_in_stack )
-            return class_refinement_results[wanted_class].particle_refinement_results[counter];
+    return class_refinement_results[wanted_class].particle_refinement_results[result_index];
+}
+
+long Refinement::ReturnResultIndexByClassAndPositionInStack(int wanted_class, long wanted_position_in_stack) {
+    MyDebugAssertTrue(wanted_class >= 0 && wanted_class < class_refinement_results.GetCount( ), "wanted class (%i) out of range!", wanted_class);
+
+    ArrayofRefinementResults& wanted_results = class_refinement_results[wanted_class].particle_refinement_results;
+
+    if ( position_in_stack_indices.size( ) != class_refinement_results.GetCount( ) ) {
+        position_in_stack_indices.clear( );
+        position_in_stack_indices.resize(class_refinement_results.GetCount( ));
     }
 
-    MyDebugPrintWithDetails("Shouldn't get here, means i didn't find the particle - Class #%i, Pos = %li", wanted_class, wanted_position_in_stack);
-    DEBUG_ABORT;
+    // The results can be changed by anyone at any time, so an entry is only trusted if it still points at the wanted particle. Otherwise the index is rebuilt.
+
+    RefinementResultIndex& current_index = position_in_stack_indices[wanted_class];
+
+    if ( current_index.IsBuilt( ) == true ) {
+        long result_index = current_index.ReturnIndex(wanted_position_in_stack);
+        if ( result_index >= 0 && result_index < long(wanted_results.GetCount( )) && wanted_results[result_index].position_in_stack == wanted_position_in_stack )
+            return result_index;
+    }
+
+    current_index.Build(wanted_results);
+    return current_index.ReturnIndex(wanted_position_in_stack);
 }
 
 int Refinement::ReturnClassWithHighestOccupanyForGivenParticle(long wanted_particle) // starts at 0
@@ -381,6 +457,9 @@ void Refinement::WriteSingleClasscisTEMStarFile(wxString filename, int wanted_cl
         output_params.all_parameters[particle_counter].total_exposure  = class_refinement_results[wanted_class].particle_refinement_results[particle_counter].total_exposure;
     }
 
+    // the refine3d jobs read the statistics of the whole dataset from the file rather than each calculating them
+    output_params.write_statistics_to_file = true;
+
     if ( write_binary_file == false )
         output_params.WriteTocisTEMStarFile(filename);
     else
@@ -455,6 +534,7 @@ void Refinement::SizeAndFillWithEmpty(long wanted_number_of_particles, int wante
 
     //class_refinement_results.Alloc(number_of_classes);
     class_refinement_results.Add(junk_class_results, number_of_classes);
+    position_in_stack_indices.clear( );
 
     for ( int class_counter = 0; class_counter < number_of_classes; class_counter++ ) {
         //class_refinement_results[class_counter].particle_refinement_results.Alloc(number_of_particles);
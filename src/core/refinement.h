@@ -82,8 +82,31 @@ class ClassRefinementResults {
 
 WX_DECLARE_OBJARRAY(ClassRefinementResults, ArrayofClassRefinementResults);
 
+// Maps position_in_stack to an index into the particle_refinement_results of one class. When the positions are close to
+// contiguous (the usual case) a direct-address table is used, otherwise a hash map.
+class RefinementResultIndex {
+    std::vector<long>              dense_index; // -1 where there is no particle
+    std::unordered_map<long, long> sparse_index;
+    bool                           is_dense;
+    bool                           is_built;
+
+  public:
+    RefinementResultIndex( );
+
+    void Build(const ArrayofRefinementResults& wanted_results);
+    void Clear( );
+
+    inline bool IsBuilt( ) const { return is_built; }
+
+    // -1 if the position is not in the index
+    long ReturnIndex(long wanted_position_in_stack) const;
+};
+
 class Refinement {
 
+    // One per class, built on first lookup - see ReturnResultIndexByClassAndPositionInStack
+    std::vector<RefinementResultIndex> position_in_stack_indices;
+
   public:
     Refinement( );
     ~Refinement( );
@@ -113,6 +136,7 @@ class Refinement {
     float ReturnChangeInAverageOccupancy(Refinement& other_refinement);
 
     RefinementResult ReturnRefinementResultByClassAndPositionInStack(int wanted_class, long wanted_position_in_stack);
+    long             ReturnResultIndexByClassAndPositionInStack(int wanted_class, long wanted_position_in_stack);
 
     void WriteSingleClassFrealignParameterFile(wxString filename, int wanted_class, float percent_used_overide = 1.0f, float sigma_override = 0.0f);
     void WriteSingleClasscisTEMStarFile(wxString filename, int wanted_class, float percent_used_overide = 1.0f, float sigma_override = 0.0f, bool write_binary_file = false);
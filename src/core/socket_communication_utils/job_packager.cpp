@@ -873,6 +873,41 @@ void JobPackage::AddJob(const char* format, ...) {
     number_of_added_jobs++;
 }
 
+/**
+ * @brief Sends several jobs of the package to one worker in a single message
+ *
+ * The worker queues the jobs and starts the next one as soon as the previous one has finished, so that it does not sit
+ * idle for a round trip between jobs.
+ *
+ * @param socket wxSocketBase connection to the worker
+ * @param job_numbers indices of the jobs to send, in the order they should be run
+ * @param number_of_jobs_in_window number of entries in job_numbers
+ * @return true on successful transmission, false on socket write failure
+ *
+ * @note Encoding order:
+ * 1. Socket signal: socket_ready_to_send_job_window (SOCKET_CODE_SIZE bytes)
+ * 2. number_of_jobs_in_window (int → 4 bytes)
+ * 3. For each job in the window: the encoding of RunJob::SendJob() without its socket signal
+ *
+ * @see SocketClientMonitorThread::Entry() for decoder counterpart
+ */
+bool JobPackage::SendJobWindow(wxSocketBase* socket, const int* job_numbers, int number_of_jobs_in_window) {
+    MyDebugAssertTrue(number_of_jobs_in_window > 0, "Nothing to send (%i)", number_of_jobs_in_window);
+
+    if ( WriteToSocket(socket, socket_ready_to_send_job_window, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING) == false )
+        return false;
+    if ( WriteToSocket(socket, &number_of_jobs_in_window, sizeof(int), true, "SendNumberOfJobsInWindow", FUNCTION_DETAILS_AS_WXSTRING) == false )
+        return false;
+
+    for ( int counter = 0; counter < number_of_jobs_in_window; counter++ ) {
+        MyDebugAssertTrue(job_numbers[counter] >= 0 && job_numbers[counter] < number_of_jobs, "Job number out of range (%i)", job_numbers[counter]);
+        if ( jobs[job_numbers[counter]].SendJob(socket, false) == false )
+            return false;
+    }
+
+    return true;
+}
+
 int JobPackage::ReturnNumberOfJobsRemaining( ) {
     int number_remaining = 0;
 
@@ -884,6 +919,24 @@ int JobPackage::ReturnNumberOfJobsRemaining( ) {
     return number_remaining;
 }
 
+// Appends the jobs in job_numbers that have not been run yet to job_queue, skipping any that are already queued, so that
+// the jobs of a worker that was lost are run again exactly once. Returns the number of jobs added.
+
+int JobPackage::AddUnfinishedJobsToQueue(const std::deque<int>& job_numbers, std::deque<int>& job_queue) {
+    int number_added = 0;
+
+    for ( std::deque<int>::const_iterator job_number = job_numbers.begin( ); job_number != job_numbers.end( ); ++job_number ) {
+        MyDebugAssertTrue(*job_number >= 0 && *job_number < number_of_jobs, "Job number out of range (%i)", *job_number);
+        if ( jobs[*job_number].has_been_run == true || std::find(job_queue.begin( ), job_queue.end( ), *job_number) != job_queue.end( ) )
+            continue;
+
+        job_queue.push_back(*job_number);
+        number_added++;
+    }
+
+    return number_added;
+}
+
 JobPackage& JobPackage::operator=(const JobPackage* other_package) {
     // Check for self assignment
     if ( this != other_package ) {
@@ -934,6 +987,7 @@ RunJob::~RunJob( ) {
  * @brief Encodes and sends a single job with typed arguments over a socket
  *
  * @param socket wxSocketBase connection to transmit the encoded job
+ * @param send_socket_code if false, the leading socket_ready_to_send_single_job signal is left out (used by JobPackage::SendJobWindow)
  * @return true on successful transmission, false on socket write failure
  *
  * @warning No protocol version checking - mixed-version clusters corrupt data silently (C-2)
@@ -943,7 +997,7 @@ RunJob::~RunJob( ) {
  * @see src/core/socket_communication_utils/FUTURE_REFACTOR_IDEAS.md for detailed security analysis
  *
  * @note Encoding order:
- * 1. Socket signal: socket_ready_to_send_single_job (SOCKET_CODE_SIZE bytes)
+ * 1. Socket signal: socket_ready_to_send_single_job (SOCKET_CODE_SIZE bytes, only if send_socket_code)
  * 2. transfer_size (long → 8 bytes on 64-bit)
  * 3. job_number (int → 4 bytes)
  * 4. number_of_arguments (int → 4 bytes)
@@ -959,7 +1013,7 @@ RunJob::~RunJob( ) {
  * @see RecieveJob() for decoder counterpart
  * @see ReturnEncodedByteTransferSize() for buffer size calculation
  */
-bool RunJob::SendJob(wxSocketBase* socket) {
+bool RunJob::SendJob(wxSocketBase* socket, bool send_socket_code) {
     using c_ft = cistem::fundamental_type::Enum;
     static_assert(sizeof(c_ft) == sizeof(uint8_t), "fundamental_type::Enum must match uint8_t size for safe casting in wire protocol");
 
@@ -1097,7 +1151,7 @@ bool RunJob::SendJob(wxSocketBase* socket) {
     //	 socket->SetNotify(wxSOCKET_LOST_FLAG);
 
     // inform what we want to do..
-    if ( WriteToSocket(socket, socket_ready_to_send_single_job, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING) == false ) {
+    if ( send_socket_code == true && WriteToSocket(socket, socket_ready_to_send_single_job, SOCKET_CODE_SIZE, true, "SendSocketJobType", FUNCTION_DETAILS_AS_WXSTRING) == false ) {
         delete[] transfer_buffer;
         return false;
     }
@@ -79,7 +79,7 @@ class RunJob {
     void     SetArguments(const char* format, va_list args);
     void     ManualSetArguments(const char* format, ...);
     long     ReturnEncodedByteTransferSize( );
-    bool     SendJob(wxSocketBase* socket);
+    bool     SendJob(wxSocketBase* socket, bool send_socket_code = true);
     bool     RecieveJob(wxSocketBase* socket);
     void     PrintAllArguments( );
     wxString PrintAllArgumentsTowxString( );
@@ -105,9 +105,11 @@ class JobPackage {
     void AddJob(const char* format, ...);
     bool SendJobPackage(wxSocketBase* socket);
     bool ReceiveJobPackage(wxSocketBase* socket);
+    bool SendJobWindow(wxSocketBase* socket, const int* job_numbers, int number_of_jobs_in_window);
 
     long ReturnEncodedByteTransferSize( );
     int  ReturnNumberOfJobsRemaining( );
+    int  AddUnfinishedJobsToQueue(const std::deque<int>& job_numbers, std::deque<int>& job_queue);
 
     JobPackage& operator=(const JobPackage& other_package);
     JobPackage& operator=(const JobPackage* other_package);
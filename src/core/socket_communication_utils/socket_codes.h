@@ -25,5 +25,8 @@ const unsigned char socket_result_with_image_to_write[]  = "=z4-Y8Ge?vEjh`H^";
 const unsigned char socket_program_defined_result[]      = "e}w<S9hm<3L6Dr+V";
 const unsigned char socket_send_thread_timing[]          = "Kq04etrq1fO2QV4d";
 const unsigned char socket_template_match_result_ready[] = "EP927e$*cQ^egWq'";
+const unsigned char socket_ready_to_send_job_window[]    = "v9Hs#T2k@pXq!e7R";
+const unsigned char socket_job_finished_send_more[]      = "Wm3)Ld8]fZ+u6N;c";
+const unsigned char socket_send_profile_summary[]        = "p7Gx!2Rk%Tz^dQ0w";
 
 #endif
@@ -654,6 +654,43 @@ wxThread::ExitCode SocketClientMonitorThread::Entry( ) {
                                         socket_counter--;
                                     }
                                 }
+                                else if ( memcmp(socket_input_buffer, socket_ready_to_send_job_window, SOCKET_CODE_SIZE) == 0 ) {
+                                    // a window of jobs is passed on one job at a time, in order, exactly as if they had been sent separately
+                                    int  number_of_jobs_in_window;
+                                    bool no_error = ReadFromSocket(monitored_sockets[socket_counter], &number_of_jobs_in_window, sizeof(int), true, "SendNumberOfJobsInWindow", FUNCTION_DETAILS_AS_WXSTRING);
+
+                                    for ( int job_counter = 0; no_error == true && job_counter < number_of_jobs_in_window; job_counter++ ) {
+                                        RunJob* received_job = new RunJob;
+                                        if ( received_job->RecieveJob(monitored_sockets[socket_counter]) == true ) {
+                                            parent_pointer->brother_event_handler->CallAfter(std::bind(&SocketCommunicator::HandleSocketReadyToSendSingleJob, parent_pointer, monitored_sockets[socket_counter], received_job));
+                                        }
+                                        else {
+                                            delete received_job;
+                                            no_error = false;
+                                        }
+                                    }
+
+                                    if ( no_error == false ) {
+                                        // socket is not ok.. pass on a message to the handler and remove it..
+                                        parent_pointer->brother_event_handler->CallAfter(std::bind(&SocketCommunicator::HandleSocketDisconnect, parent_pointer, monitored_sockets[socket_counter]));
+                                        monitored_sockets.RemoveAt(socket_counter);
+                                        socket_counter--;
+                                    }
+                                }
+                                else if ( memcmp(socket_input_buffer, socket_job_finished_send_more, SOCKET_CODE_SIZE) == 0 ) {
+                                    JobResult* temp_job = new JobResult;
+                                    long       milliseconds_spent_on_job;
+                                    if ( temp_job->ReceiveFromSocket(monitored_sockets[socket_counter]) == true && ReadFromSocket(monitored_sockets[socket_counter], &milliseconds_spent_on_job, sizeof(long), true, "SendMillisecondsSpentOnJob", FUNCTION_DETAILS_AS_WXSTRING) == true ) {
+                                        parent_pointer->brother_event_handler->CallAfter(std::bind(&SocketCommunicator::HandleSocketJobFinishedSendMore, parent_pointer, monitored_sockets[socket_counter], temp_job, milliseconds_spent_on_job));
+                                    }
+                                    else {
+                                        delete temp_job;
+                                        // socket is not ok.. pass on a message to the handler and remove it..
+                                        parent_pointer->brother_event_handler->CallAfter(std::bind(&SocketCommunicator::HandleSocketDisconnect, parent_pointer, monitored_sockets[socket_counter]));
+                                        monitored_sockets.RemoveAt(socket_counter);
+                                        socket_counter--;
+                                    }
+                                }
                                 else if ( memcmp(socket_input_buffer, socket_i_have_an_error, SOCKET_CODE_SIZE) == 0 ) {
                                     // get the error..
 
@@ -864,6 +901,21 @@ wxThread::ExitCode SocketClientMonitorThread::Entry( ) {
                                         socket_counter--;
                                     }
                                 }
+                                else if ( memcmp(socket_input_buffer, socket_send_profile_summary, SOCKET_CODE_SIZE) == 0 ) {
+                                    wxString profile_summary;
+                                    bool     no_error;
+
+                                    profile_summary = ReceivewxStringFromSocket(monitored_sockets[socket_counter], no_error);
+
+                                    if ( no_error == true )
+                                        parent_pointer->brother_event_handler->CallAfter(std::bind(&SocketCommunicator::HandleSocketSendProfileSummary, parent_pointer, monitored_sockets[socket_counter], profile_summary));
+                                    else {
+                                        // socket is not ok.. pass on a message to the handler and remove it..
+                                        parent_pointer->brother_event_handler->CallAfter(std::bind(&SocketCommunicator::HandleSocketDisconnect, parent_pointer, monitored_sockets[socket_counter]));
+                                        monitored_sockets.RemoveAt(socket_counter);
+                                        socket_counter--;
+                                    }
+                                }
                                 else if ( memcmp(socket_input_buffer, socket_template_match_result_ready, SOCKET_CODE_SIZE) == 0 ) {
                                     int                                image_number;
                                     float                              threshold_used;
@@ -70,6 +70,8 @@ class SocketCommunicator {
 
     virtual void HandleSocketReadyToSendSingleJob(wxSocketBase* connected_socket, RunJob* received_job) { wxPrintf("Warning:: Unhandled Socket Message(HandleSocketReadyToSendSingleJob)\n"); }
 
+    virtual void HandleSocketJobFinishedSendMore(wxSocketBase* connected_socket, JobResult* received_result, long milliseconds_spent_on_job) { wxPrintf("Warning:: Unhandled Socket Message(HandleSocketJobFinishedSendMore)\n"); }
+
     virtual void HandleSocketIHaveAnError(wxSocketBase* connected_socket, wxString error_message) { wxPrintf("Warning:: Unhandled Socket Message(HandleSocketIHaveAnError)\n"); }
 
     virtual void HandleSocketIHaveInfo(wxSocketBase* connected_socket, wxString info_message) { wxPrintf("Warning:: Unhandled Socket Message(HandleSocketIHaveInfo)\n"); }
@@ -91,6 +93,8 @@ class SocketCommunicator {
 
     virtual void HandleSocketSendThreadTiming(wxSocketBase* connected_socket, long received_timing_in_milliseconds) { wxPrintf("Warning:: Unhandled Socket Message(HandleSocketSendThreadTiming\n"); }
 
+    virtual void HandleSocketSendProfileSummary(wxSocketBase* connected_socket, wxString profile_summary) { wxPrintf("Warning:: Unhandled Socket Message(HandleSocketSendProfileSummary)\n"); }
+
     virtual void HandleSocketDisconnect(wxSocketBase* connected_socket) { wxPrintf("Warning:: Unhandled Socket Disconnect(HandleSocketDisconnect)\n"); }
 
     virtual void HandleSocketTemplateMatchResultReady(wxSocketBase* connected_socket, int& image_number, float& threshold_used, ArrayOfTemplateMatchFoundPeakInfos& peak_infos, ArrayOfTemplateMatchFoundPeakInfos& peak_changes) { wxPrintf("Warning:: Unhandled Socket Message (HandleSocketTemplateMatchResultReady)\n"); }
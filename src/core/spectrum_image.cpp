@@ -558,6 +558,99 @@ float SpectrumImage::DilatePowerspectrumToNewPixelSize(bool resample_if_pixel_to
     return pixel_size_for_fitting;
 }
 
+/*
+ * Welch-style estimate of the amplitude spectrum of a real-space image: the power spectra of overlapping square tiles of tile_size pixels
+ * are averaged, and the square root taken. The tiles are processed in parallel. When the image was padded, e.g. a rectangular micrograph
+ * centred in a square with ClipIntoLargerRealSpace2D( ), wanted_extent_x and wanted_extent_y give the dimensions of the original
+ * image, and the tiles are restricted to it (0 means the whole image). Tiles that are still constant are skipped. The result is
+ * scaled as the amplitude spectrum of the whole image (unscaled FFT) would be, and is left in real space with its origin in the
+ * centre of the box, like ComputeAmplitudeSpectrumFull2D( ).
+ * Returns the number of tiles used.
+ */
+int SpectrumImage::ComputeTiledAmplitudeSpectrum(Image* input_image, int tile_size, int number_of_threads, int wanted_extent_x, int wanted_extent_y) {
+    MyDebugAssertTrue(input_image->is_in_memory, "Input image not allocated");
+    MyDebugAssertTrue(input_image->is_in_real_space, "Input image is not in real space");
+    MyDebugAssertTrue(input_image->logical_z_dimension == 1, "Input image is not 2D");
+    MyDebugAssertTrue(wanted_extent_x >= 0 && wanted_extent_x <= input_image->logical_x_dimension && wanted_extent_y >= 0 && wanted_extent_y <= input_image->logical_y_dimension, "Bad extent: %i x %i", wanted_extent_x, wanted_extent_y);
+
+    const int extent_x = (wanted_extent_x > 0) ? wanted_extent_x : input_image->logical_x_dimension;
+    const int extent_y = (wanted_extent_y > 0) ? wanted_extent_y : input_image->logical_y_dimension;
+
+    MyDebugAssertTrue(tile_size <= extent_x && tile_size <= extent_y, "Tiles are larger than the input image");
+
+    // neighbouring tiles overlap by half, and the grid of tiles is centred on the image, as is the original image within any padding
+    const int tile_step             = std::max(tile_size / 2, 1);
+    const int number_of_tiles_x     = (extent_x - tile_size) / tile_step + 1;
+    const int number_of_tiles_y     = (extent_y - tile_size) / tile_step + 1;
+    const int first_tile_centre_x   = -((number_of_tiles_x - 1) * tile_step) / 2;
+    const int first_tile_centre_y   = -((number_of_tiles_y - 1) * tile_step) / 2;
+    const int total_number_of_tiles = number_of_tiles_x * number_of_tiles_y;
+    int       number_of_tiles_used  = 0;
+    long      pixel_counter;
+
+    Allocate(tile_size, tile_size, 1, true);
+    SetToConstant(0.0f);
+
+#pragma omp parallel default(shared) num_threads(number_of_threads) private(pixel_counter)
+    {
+        Image tile;
+        Image tile_spectrum;
+        Image sum_of_powers;
+        int   thread_number_of_tiles_used = 0;
+
+        tile.Allocate(tile_size, tile_size, 1, true);
+        tile_spectrum.Allocate(tile_size, tile_size, 1, true);
+        sum_of_powers.Allocate(tile_size, tile_size, 1, true);
+        sum_of_powers.SetToConstant(0.0f);
+
+#pragma omp for schedule(dynamic)
+        for ( int tile_counter = 0; tile_counter < total_number_of_tiles; tile_counter++ ) {
+            tile.is_in_real_space = true;
+            input_image->ClipInto(&tile, 0.0f, false, 1.0f, first_tile_centre_x + (tile_counter % number_of_tiles_x) * tile_step, first_tile_centre_y + (tile_counter / number_of_tiles_x) * tile_step, 0);
+
+            if ( tile.IsConstant( ) )
+                continue;
+
+            tile.AddConstant(-tile.ReturnAverageOfRealValues( ));
+            tile.ForwardFFT(false);
+            tile.ComputeAmplitudeSpectrumFull2D(&tile_spectrum);
+
+            pixel_counter = 0;
+            for ( int j = 0; j < tile_size; j++ ) {
+                for ( int i = 0; i < tile_size; i++ ) {
+                    sum_of_powers.real_values[pixel_counter] += powf(tile_spectrum.real_values[pixel_counter], 2);
+                    pixel_counter++;
+                }
+                pixel_counter += sum_of_powers.padding_jump_value;
+            }
+
+            thread_number_of_tiles_used++;
+        }
+
+#pragma omp critical
+        {
+            AddImage(&sum_of_powers);
+            number_of_tiles_used += thread_number_of_tiles_used;
+        }
+    }
+
+    if ( number_of_tiles_used > 0 ) {
+        // the power of a tile grows with its number of pixels, so the average is brought to the scale of the whole image
+        const float scale_factor = float(input_image->number_of_real_space_pixels) / float(number_of_real_space_pixels) / float(number_of_tiles_used);
+
+        pixel_counter = 0;
+        for ( int j = 0; j < logical_y_dimension; j++ ) {
+            for ( int i = 0; i < logical_x_dimension; i++ ) {
+                real_values[pixel_counter] = sqrtf(real_values[pixel_counter] * scale_factor);
+                pixel_counter++;
+            }
+            pixel_counter += padding_jump_value;
+        }
+    }
+
+    return number_of_tiles_used;
+}
+
 /*
  * Compute average value in power spectrum as a function of wave function aberration. This allows for averaging even when
  * there is significant astigmatism.
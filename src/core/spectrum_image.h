@@ -16,4 +16,5 @@ class SpectrumImage : public Image {
     void  RescaleSpectrumAndRotationalAverage(Image* number_of_extrema, Image* ctf_values, int number_of_bins, double spatial_frequency[], double average[], double average_fit[], float number_of_extrema_profile[], float ctf_values_profile[], int last_bin_without_aliasing, int last_bin_with_good_fit);
     float DilatePowerspectrumToNewPixelSize(bool resample_if_pixel_too_small, float pixel_size_of_input_image, float target_pixel_size_after_resampling,
                                             int box_size, Image* resampled_power_spectrum, bool do_resampling = true, float stretch_factor = 1.0f);
+    int   ComputeTiledAmplitudeSpectrum(Image* input_image, int tile_size, int number_of_threads = 1, int wanted_extent_x = 0, int wanted_extent_y = 0);
 };
\ No newline at end of file
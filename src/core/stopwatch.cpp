@@ -58,6 +58,10 @@ void StopWatch::record_start(std::string name) {
 
 void StopWatch::record_end( ) {
 
+    // Also record the event with the runtime profiler, under whichever scope is currently open
+    if ( Profiler::IsEnabled( ) )
+        Profiler::RecordCompletedEvent(event_names[current_index], stop(NANOSECONDS, current_index));
+
     elapsed_times[current_index] += stop(time_fmt, current_index);
     // We've removed an event if the idx is not special
     if ( current_index != (SpecialIDX)total_elapsed && current_index != (SpecialIDX)total_measured ) {
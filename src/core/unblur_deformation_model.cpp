@@ -0,0 +1,241 @@
+#include "core_headers.h"
+
+#include <set>
+
+UnblurDeformationModel::UnblurDeformationModel( ) {
+    is_fitted        = false;
+    number_of_frames = 0;
+    rms_deviation    = 0.0f;
+
+    for ( int spatial_term = 0; spatial_term < number_of_spatial_terms; spatial_term++ ) {
+        for ( int temporal_order = 0; temporal_order < maximum_temporal_order; temporal_order++ ) {
+            x_coefficients[spatial_term][temporal_order] = 0.0;
+            y_coefficients[spatial_term][temporal_order] = 0.0;
+        }
+    }
+}
+
+bool UnblurDeformationModel::FitToPatchShifts(const std::vector<float>& patch_x_coordinates, const std::vector<float>& patch_y_coordinates, const std::vector<std::vector<float>>& patch_x_shifts, const std::vector<std::vector<float>>& patch_y_shifts) {
+    MyDebugAssertTrue(patch_x_coordinates.size( ) == patch_y_coordinates.size( ) && patch_x_coordinates.size( ) == patch_x_shifts.size( ) && patch_x_shifts.size( ) == patch_y_shifts.size( ), "Numbers of patches do not match");
+
+    is_fitted = false;
+
+    int number_of_patches = int(patch_x_coordinates.size( ));
+    if ( number_of_patches == 0 )
+        return false;
+
+    number_of_frames = int(patch_x_shifts[0].size( ));
+
+    // a quadratic term needs at least 3 columns (or rows) of patches, a linear term 2
+
+    int number_of_columns = int(std::set<float>(patch_x_coordinates.begin( ), patch_x_coordinates.end( )).size( ));
+    int number_of_rows    = int(std::set<float>(patch_y_coordinates.begin( ), patch_y_coordinates.end( )).size( ));
+
+    bool spatial_term_is_used[number_of_spatial_terms] = {true, number_of_columns > 1, number_of_rows > 1, number_of_columns > 2, number_of_columns > 1 && number_of_rows > 1, number_of_rows > 2};
+    int  number_of_temporal_orders                     = std::min(maximum_temporal_order, number_of_frames - 1);
+
+    std::vector<int> term_spatial_term;
+    std::vector<int> term_temporal_order;
+
+    for ( int spatial_term = 0; spatial_term < number_of_spatial_terms; spatial_term++ ) {
+        for ( int temporal_order = 0; temporal_order < number_of_temporal_orders; temporal_order++ ) {
+            if ( spatial_term_is_used[spatial_term] == true ) {
+                term_spatial_term.push_back(spatial_term);
+                term_temporal_order.push_back(temporal_order);
+            }
+        }
+    }
+
+    int number_of_terms = int(term_spatial_term.size( ));
+    if ( number_of_terms == 0 || number_of_patches * number_of_frames < number_of_terms )
+        return false;
+
+    // the normal equations, for both axes at once
+
+    std::vector<double> normal_matrix(number_of_terms * number_of_terms, 0.0);
+    std::vector<double> x_right_hand_side(number_of_terms, 0.0);
+    std::vector<double> y_right_hand_side(number_of_terms, 0.0);
+    std::vector<double> basis(number_of_terms);
+
+    for ( int patch_counter = 0; patch_counter < number_of_patches; patch_counter++ ) {
+        double x = patch_x_coordinates[patch_counter];
+        double y = patch_y_coordinates[patch_counter];
+
+        double spatial_basis[number_of_spatial_terms] = {1.0, x, y, x * x, x * y, y * y};
+
+        for ( int frame_counter = 0; frame_counter < number_of_frames; frame_counter++ ) {
+            double time = ReturnTime(frame_counter);
+
+            for ( int term = 0; term < number_of_terms; term++ ) {
+                basis[term] = spatial_basis[term_spatial_term[term]] * pow(time, term_temporal_order[term] + 1);
+            }
+
+            for ( int row = 0; row < number_of_terms; row++ ) {
+                x_right_hand_side[row] += basis[row] * patch_x_shifts[patch_counter][frame_counter];
+                y_right_hand_side[row] += basis[row] * patch_y_shifts[patch_counter][frame_counter];
+
+                for ( int column = 0; column < number_of_terms; column++ ) {
+                    normal_matrix[row * number_of_terms + column] += basis[row] * basis[column];
+                }
+            }
+        }
+    }
+
+    // Gaussian elimination with partial pivoting
+
+    double largest_diagonal_value = 0.0;
+    for ( int row = 0; row < number_of_terms; row++ ) {
+        largest_diagonal_value = std::max(largest_diagonal_value, normal_matrix[row * number_of_terms + row]);
+    }
+
+    for ( int pivot = 0; pivot < number_of_terms; pivot++ ) {
+        int pivot_row = pivot;
+        for ( int row = pivot + 1; row < number_of_terms; row++ ) {
+            if ( fabs(normal_matrix[row * number_of_terms + pivot]) > fabs(normal_matrix[pivot_row * number_of_terms + pivot]) )
+                pivot_row = row;
+        }
+
+        if ( fabs(normal_matrix[pivot_row * number_of_terms + pivot]) <= 1e-12 * largest_diagonal_value )
+            return false;
+
+        if ( pivot_row != pivot ) {
+            for ( int column = 0; column < number_of_terms; column++ ) {
+                std::swap(normal_matrix[pivot * number_of_terms + column], normal_matrix[pivot_row * number_of_terms + column]);
+            }
+            std::swap(x_right_hand_side[pivot], x_right_hand_side[pivot_row]);
+            std::swap(y_right_hand_side[pivot], y_right_hand_side[pivot_row]);
+        }
+
+        for ( int row = pivot + 1; row < number_of_terms; row++ ) {
+            double factor = normal_matrix[row * number_of_terms + pivot] / normal_matrix[pivot * number_of_terms + pivot];
+
+            for ( int column = pivot; column < number_of_terms; column++ ) {
+                normal_matrix[row * number_of_terms + column] -= factor * normal_matrix[pivot * number_of_terms + column];
+            }
+            x_right_hand_side[row] -= factor * x_right_hand_side[pivot];
+            y_right_hand_side[row] -= factor * y_right_hand_side[pivot];
+        }
+    }
+
+    for ( int row = number_of_terms - 1; row >= 0; row-- ) {
+        for ( int column = row + 1; column < number_of_terms; column++ ) {
+            x_right_hand_side[row] -= normal_matrix[row * number_of_terms + column] * x_right_hand_side[column];
+            y_right_hand_side[row] -= normal_matrix[row * number_of_terms + column] * y_right_hand_side[column];
+        }
+        x_right_hand_side[row] /= normal_matrix[row * number_of_terms + row];
+        y_right_hand_side[row] /= normal_matrix[row * number_of_terms + row];
+    }
+
+    for ( int spatial_term = 0; spatial_term < number_of_spatial_terms; spatial_term++ ) {
+        for ( int temporal_order = 0; temporal_order < maximum_temporal_order; temporal_order++ ) {
+            x_coefficients[spatial_term][temporal_order] = 0.0;
+            y_coefficients[spatial_term][temporal_order] = 0.0;
+        }
+    }
+
+    for ( int term = 0; term < number_of_terms; term++ ) {
+        x_coefficients[term_spatial_term[term]][term_temporal_order[term]] = x_right_hand_side[term];
+        y_coefficients[term_spatial_term[term]][term_temporal_order[term]] = y_right_hand_side[term];
+    }
+
+    is_fitted = true;
+
+    // how well does it fit?
+
+    double sum_of_squares = 0.0;
+    float  frame_x_coefficients[number_of_spatial_terms];
+    float  frame_y_coefficients[number_of_spatial_terms];
+
+    for ( int frame_counter = 0; frame_counter < number_of_frames; frame_counter++ ) {
+        ReturnSpatialCoefficients(frame_counter, frame_x_coefficients, frame_y_coefficients);
+
+        for ( int patch_counter = 0; patch_counter < number_of_patches; patch_counter++ ) {
+            sum_of_squares += pow(patch_x_shifts[patch_counter][frame_counter] - EvaluateSpatialPolynomial(frame_x_coefficients, patch_x_coordinates[patch_counter], patch_y_coordinates[patch_counter]), 2);
+            sum_of_squares += pow(patch_y_shifts[patch_counter][frame_counter] - EvaluateSpatialPolynomial(frame_y_coefficients, patch_x_coordinates[patch_counter], patch_y_coordinates[patch_counter]), 2);
+        }
+    }
+
+    rms_deviation = float(sqrt(sum_of_squares / double(number_of_patches * number_of_frames)));
+
+    return true;
+}
+
+void UnblurDeformationModel::ReturnSpatialCoefficients(int frame_index, float* wanted_x_coefficients, float* wanted_y_coefficients) const {
+    double time = ReturnTime(frame_index);
+
+    for ( int spatial_term = 0; spatial_term < number_of_spatial_terms; spatial_term++ ) {
+        double time_power = 1.0;
+
+        wanted_x_coefficients[spatial_term] = 0.0f;
+        wanted_y_coefficients[spatial_term] = 0.0f;
+
+        for ( int temporal_order = 0; temporal_order < maximum_temporal_order; temporal_order++ ) {
+            time_power *= time;
+            wanted_x_coefficients[spatial_term] += float(x_coefficients[spatial_term][temporal_order] * time_power);
+            wanted_y_coefficients[spatial_term] += float(y_coefficients[spatial_term][temporal_order] * time_power);
+        }
+    }
+}
+
+// The frame is transformed back to real space, resampled there with Catmull-Rom (cubic) interpolation, and transformed forward again
+void UnblurDeformationModel::ResampleFrame(Image& frame, int frame_index) const {
+    MyDebugAssertFalse(frame.is_in_real_space, "Frame is not in Fourier space");
+
+    float frame_x_coefficients[number_of_spatial_terms];
+    float frame_y_coefficients[number_of_spatial_terms];
+
+    ReturnSpatialCoefficients(frame_index, frame_x_coefficients, frame_y_coefficients);
+
+    // Catmull-Rom weights of the 4 pixels around a position, given the fraction of a pixel past the second one
+    auto return_cubic_weights = [](float fraction, float* weights) {
+        weights[0] = ((-0.5f * fraction + 1.0f) * fraction - 0.5f) * fraction;
+        weights[1] = (1.5f * fraction - 2.5f) * fraction * fraction + 1.0f;
+        weights[2] = ((-1.5f * fraction + 2.0f) * fraction + 0.5f) * fraction;
+        weights[3] = (0.5f * fraction - 0.5f) * fraction * fraction;
+    };
+
+    Image shifted_frame;
+    shifted_frame.Allocate(frame.logical_x_dimension, frame.logical_y_dimension, true);
+    frame.BackwardFFT( );
+
+    long  row_length    = frame.logical_x_dimension + frame.padding_jump_value;
+    long  pixel_counter = 0;
+    float x_weights[4];
+    float y_weights[4];
+    int   columns[4];
+
+    for ( int j = 0; j < frame.logical_y_dimension; j++ ) {
+        float y = float(j - frame.physical_address_of_box_center_y) / float(frame.logical_y_dimension);
+
+        for ( int i = 0; i < frame.logical_x_dimension; i++ ) {
+            float x = float(i - frame.physical_address_of_box_center_x) / float(frame.logical_x_dimension);
+
+            // a shift moves the frame content by the shift, so each pixel takes its value from where the content was
+            float source_x = float(i) - EvaluateSpatialPolynomial(frame_x_coefficients, x, y);
+            float source_y = float(j) - EvaluateSpatialPolynomial(frame_y_coefficients, x, y);
+            int   first_x  = int(floorf(source_x)) - 1;
+            int   first_y  = int(floorf(source_y)) - 1;
+
+            return_cubic_weights(source_x - floorf(source_x), x_weights);
+            return_cubic_weights(source_y - floorf(source_y), y_weights);
+
+            for ( int counter = 0; counter < 4; counter++ ) {
+                columns[counter] = std::max(0, std::min(first_x + counter, frame.logical_x_dimension - 1));
+            }
+
+            float interpolated_value = 0.0f;
+
+            for ( int row_counter = 0; row_counter < 4; row_counter++ ) {
+                const float* row = &frame.real_values[std::max(0, std::min(first_y + row_counter, frame.logical_y_dimension - 1)) * row_length];
+                interpolated_value += y_weights[row_counter] * (x_weights[0] * row[columns[0]] + x_weights[1] * row[columns[1]] + x_weights[2] * row[columns[2]] + x_weights[3] * row[columns[3]]);
+            }
+
+            shifted_frame.real_values[pixel_counter] = interpolated_value;
+            pixel_counter++;
+        }
+        pixel_counter += shifted_frame.padding_jump_value;
+    }
+
+    shifted_frame.ForwardFFT(true);
+    frame.Consume(&shifted_frame);
+}
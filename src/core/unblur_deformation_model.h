@@ -0,0 +1,50 @@
+#ifndef _SRC_CORE_UNBLUR_DEFORMATION_MODEL_H_
+#define _SRC_CORE_UNBLUR_DEFORMATION_MODEL_H_
+
+/*  \brief  UnblurDeformationModel class - the local motion of a movie left after the global alignment.
+
+	The motion is a smooth function of the position in the frame and of time. The shifts are polynomials of second order in x
+	and y, whose coefficients are polynomials of third order in time without a constant term, so that the middle frame, which the
+	alignment is centred on, is not deformed. Unblur fits the model to the shifts of a grid of patches and resamples the frames
+	with it before they are summed.
+*/
+
+class UnblurDeformationModel {
+
+  public:
+    static constexpr int number_of_spatial_terms = 6; // 1, x, y, x^2, xy, y^2
+    static constexpr int maximum_temporal_order  = 3;
+
+    UnblurDeformationModel( );
+
+    // Least squares fit to the shifts of the patches in every frame. The coordinates are fractions of the frame, from -0.5 to 0.5 around the
+    // centre. Only the terms that the patches can determine are used, and false is returned if there are not enough patches or frames.
+    bool FitToPatchShifts(const std::vector<float>& patch_x_coordinates, const std::vector<float>& patch_y_coordinates, const std::vector<std::vector<float>>& patch_x_shifts, const std::vector<std::vector<float>>& patch_y_shifts);
+
+    // The coefficients of 1, x, y, x^2, xy and y^2 for the shifts of one frame
+    void ReturnSpatialCoefficients(int frame_index, float* wanted_x_coefficients, float* wanted_y_coefficients) const;
+
+    // Resample a frame, given in Fourier space, at the positions given by the model for this frame. The frame is returned in Fourier space.
+    void ResampleFrame(Image& frame, int frame_index) const;
+
+    static inline float EvaluateSpatialPolynomial(const float* coefficients, float x, float y) {
+        return coefficients[0] + coefficients[1] * x + coefficients[2] * y + coefficients[3] * x * x + coefficients[4] * x * y + coefficients[5] * y * y;
+    }
+
+    inline bool IsFitted( ) const { return is_fitted; }
+
+    // The root mean square difference between the shifts of the patches and the model
+    inline float ReturnRMSDeviation( ) const { return rms_deviation; }
+
+  private:
+    bool   is_fitted;
+    int    number_of_frames;
+    float  rms_deviation;
+    double x_coefficients[number_of_spatial_terms][maximum_temporal_order];
+    double y_coefficients[number_of_spatial_terms][maximum_temporal_order];
+
+    // Time is counted from the middle frame, as a fraction of the movie
+    inline double ReturnTime(int frame_index) const { return double(frame_index - number_of_frames / 2) / double(number_of_frames); }
+};
+
+#endif /* _SRC_CORE_UNBLUR_DEFORMATION_MODEL_H_ */
@@ -0,0 +1,29 @@
+#include "core_headers.h"
+
+#include <thread>
+
+void StreamFramesFromFile(ImageFile& input_file, long first_frame, long last_frame, int max_threads, const std::function<void(Image&, long)>& process_frame) {
+    UnblurFrameQueue frame_queue(4);
+
+    std::thread reading_thread([&]( ) {
+        for ( long frame_number = first_frame; frame_number <= last_frame; frame_number++ ) {
+            Image* frame = new Image;
+            frame->ReadSlice(&input_file, frame_number);
+            frame_queue.Push(frame, frame_number);
+        }
+        frame_queue.Finish( );
+    });
+
+#pragma omp parallel default(shared) num_threads(max_threads)
+    {
+        Image* frame;
+        long   frame_number;
+
+        while ( frame_queue.Pop(frame, frame_number) == true ) {
+            process_frame(*frame, frame_number);
+            delete frame;
+        }
+    }
+
+    reading_thread.join( );
+}
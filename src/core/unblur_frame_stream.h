@@ -0,0 +1,89 @@
+#ifndef _SRC_CORE_UNBLUR_FRAME_STREAM_H_
+#define _SRC_CORE_UNBLUR_FRAME_STREAM_H_
+
+/*  \brief  Reading the frames of a movie on a thread of their own, while other threads process the frames that have already been read.
+
+	Unblur uses this to overlap reading with the gain correction, transforms and resampling of the frames, and, when only the binned
+	frames are kept in memory, to read the movie a second time for the final sum.
+*/
+
+#include <condition_variable>
+#include <mutex>
+
+// A bounded queue of frames, filled by the thread reading the movie and emptied by the threads processing the frames
+class UnblurFrameQueue {
+
+  public:
+    UnblurFrameQueue(int wanted_capacity) {
+        capacity    = std::max(wanted_capacity, 1);
+        is_finished = false;
+    }
+
+    // Waits while the queue is full
+    void Push(Image* frame, long frame_number) {
+        std::unique_lock<std::mutex> lock(mutex);
+        frame_was_removed.wait(lock, [this]( ) { return int(frames.size( )) < capacity; });
+        frames.emplace_back(frame, frame_number);
+        frame_was_added.notify_one( );
+    }
+
+    // Waits while the queue is empty, false once all frames have been taken
+    bool Pop(Image*& frame, long& frame_number) {
+        std::unique_lock<std::mutex> lock(mutex);
+        frame_was_added.wait(lock, [this]( ) { return frames.empty( ) == false || is_finished == true; });
+        if ( frames.empty( ) )
+            return false;
+
+        frame        = frames.front( ).first;
+        frame_number = frames.front( ).second;
+        frames.pop_front( );
+        frame_was_removed.notify_one( );
+        return true;
+    }
+
+    // No more frames will be pushed
+    void Finish( ) {
+        std::unique_lock<std::mutex> lock(mutex);
+        is_finished = true;
+        frame_was_added.notify_all( );
+    }
+
+  private:
+    std::mutex                          mutex;
+    std::condition_variable             frame_was_added;
+    std::condition_variable             frame_was_removed;
+    std::deque<std::pair<Image*, long>> frames;
+    int                                 capacity;
+    bool                                is_finished;
+};
+
+// Lets the threads of StreamFramesFromFile add their frames to the sums in the order of the frames, so the sums do not depend on the threads
+class UnblurFrameOrder {
+
+  public:
+    UnblurFrameOrder(long first_frame) { next_frame = first_frame; }
+
+    void WaitForTurnOf(long frame_number) {
+        std::unique_lock<std::mutex> lock(mutex);
+        turn_has_changed.wait(lock, [this, frame_number]( ) { return next_frame == frame_number; });
+    }
+
+    void FinishTurn( ) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            next_frame++;
+        }
+        turn_has_changed.notify_all( );
+    }
+
+  private:
+    std::mutex              mutex;
+    std::condition_variable turn_has_changed;
+    long                    next_frame;
+};
+
+// Reads frames first_frame to last_frame (counting from 1) on a thread of its own, while max_threads threads call process_frame( ) for the frames
+// that have been read. Only a few frames are read ahead of the processing, so the memory used does not grow with the number of frames.
+void StreamFramesFromFile(ImageFile& input_file, long first_frame, long last_frame, int max_threads, const std::function<void(Image&, long)>& process_frame);
+
+#endif
@@ -0,0 +1,40 @@
+#include "core_headers.h"
+
+WorkerCache& WorkerCache::GetInstance( ) {
+    static WorkerCache the_cache;
+    return the_cache;
+}
+
+WorkerCache::WorkerCache( ) {
+    is_enabled       = false;
+    number_of_hits   = 0;
+    number_of_misses = 0;
+
+    wxString persistent_worker;
+    if ( wxGetEnv("CISTEM_PERSISTENT_WORKER", &persistent_worker) ) {
+        is_enabled = persistent_worker == "1" || persistent_worker.IsSameAs("yes", false) || persistent_worker.IsSameAs("true", false);
+    }
+}
+
+void WorkerCache::Enable(bool wanted_is_enabled) {
+    is_enabled = wanted_is_enabled;
+    if ( ! is_enabled )
+        Clear( );
+}
+
+void WorkerCache::Clear( ) {
+    wxMutexLocker lock(cache_mutex);
+    MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+    cached_objects.clear( );
+}
+
+wxString WorkerCache::ReturnFileKey(wxString filename) {
+    wxFileName file_name(filename);
+    file_name.MakeAbsolute( );
+
+    wxDateTime modification_time;
+    if ( ! file_name.GetTimes(NULL, &modification_time, NULL) )
+        modification_time = wxDateTime::Now( ); // can't tell if the file changed, so make sure nothing is re-used
+
+    return wxString::Format("%s|%s|%s", file_name.GetFullPath( ), file_name.GetSize( ).ToString( ), modification_time.FormatISOCombined( ) + wxString::Format(".%03i", int(modification_time.GetMillisecond( ))));
+}
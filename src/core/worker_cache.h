@@ -0,0 +1,92 @@
+#ifndef _SRC_CORE_WORKER_CACHE_H_
+#define _SRC_CORE_WORKER_CACHE_H_
+
+/*  \brief  WorkerCache class - keeps expensive, read-only job setup (parsed star files, prepared references, projection caches...)
+	alive between the jobs of a JobPackage that are run by the same worker process.
+
+	A worker process runs DoCalculation( ) once for every job it is sent, and by default every job starts from scratch. When the
+	cache is enabled, a program can store what it has set up under a named slot together with a key that describes everything the
+	object was built from (file names, modification times, and the job arguments that went into it). A later job asking for the same
+	slot with an identical key gets the stored object back; a different key is a miss, and storing the new object replaces the old
+	one, so each slot holds at most one object.
+
+	Cached objects are shared, and must be treated as read-only by the jobs using them.
+
+	Environment variables (read on first use of the cache):
+	  CISTEM_PERSISTENT_WORKER   "1", "yes" or "true" - enable the cache (it is disabled by default)
+*/
+
+#include <memory>
+#include <typeindex>
+
+class WorkerCache {
+
+  public:
+    static WorkerCache& GetInstance( );
+
+    inline bool IsEnabled( ) const { return is_enabled; }
+
+    void Enable(bool wanted_is_enabled);
+    void Clear( );
+
+    // A key for a file on disk that changes whenever the file is rewritten
+    static wxString ReturnFileKey(wxString filename);
+
+    // Returns the object stored in wanted_slot if it was stored with an identical key (and type), and an empty pointer otherwise
+    template <class CachedType>
+    std::shared_ptr<CachedType> ReturnObject(const wxString& wanted_slot, const wxString& wanted_key) {
+        if ( ! is_enabled )
+            return std::shared_ptr<CachedType>( );
+
+        wxMutexLocker lock(cache_mutex);
+        MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+        auto cached_entry = cached_objects.find(wanted_slot);
+        if ( cached_entry == cached_objects.end( ) || cached_entry->second.key != wanted_key || cached_entry->second.object_type != std::type_index(typeid(CachedType)) ) {
+            number_of_misses++;
+            return std::shared_ptr<CachedType>( );
+        }
+
+        number_of_hits++;
+        return std::static_pointer_cast<CachedType>(cached_entry->second.object);
+    }
+
+    template <class CachedType>
+    void StoreObject(const wxString& wanted_slot, const wxString& wanted_key, std::shared_ptr<CachedType> object_to_store) {
+        if ( ! is_enabled )
+            return;
+
+        wxMutexLocker lock(cache_mutex);
+        MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+        CacheEntry& new_entry = cached_objects[wanted_slot];
+        new_entry.key         = wanted_key;
+        new_entry.object_type = std::type_index(typeid(CachedType));
+        new_entry.object      = std::static_pointer_cast<void>(object_to_store);
+    }
+
+    inline long ReturnNumberOfHits( ) const { return number_of_hits; }
+
+    inline long ReturnNumberOfMisses( ) const { return number_of_misses; }
+
+  private:
+    WorkerCache( );
+
+    WorkerCache(const WorkerCache&)            = delete;
+    WorkerCache& operator=(const WorkerCache&) = delete;
+
+    struct CacheEntry {
+        wxString              key;
+        std::type_index       object_type = std::type_index(typeid(void));
+        std::shared_ptr<void> object;
+    };
+
+    std::unordered_map<wxString, CacheEntry, wxStringHash, wxStringEqual> cached_objects;
+    wxMutex                                                               cache_mutex;
+
+    bool is_enabled;
+    long number_of_hits;
+    long number_of_misses;
+};
+
+#endif
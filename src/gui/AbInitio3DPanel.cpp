@@ -1416,7 +1416,9 @@ void AbInitioManager::SetupReconstructionJob( ) {
 
             int correct_ewald_sphere = 0;
 
-            my_parent->current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttii",
+            bool share_reconstruction_between_threads = false;
+
+            my_parent->current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttiib",
                                                   input_particle_stack.ToUTF8( ).data( ),
                                                   input_parameter_file.ToUTF8( ).data( ),
                                                   input_reconstruction.ToUTF8( ).data( ),
@@ -1450,7 +1452,8 @@ void AbInitioManager::SetupReconstructionJob( ) {
                                                   dump_file_1.ToUTF8( ).data( ),
                                                   dump_file_2.ToUTF8( ).data( ),
                                                   correct_ewald_sphere,
-                                                  max_threads);
+                                                  max_threads,
+                                                  share_reconstruction_between_threads);
         }
     }
 }
@@ -1550,7 +1553,9 @@ void AbInitioManager::SetupMerge3dJob( ) {
         //wiener_nominator = 50.0f;
         //my_parent->WriteInfoText(wxString::Format("weiner nominator = %f", wiener_nominator));
 
-        my_parent->current_job_package.AddJob("ttttfffttibtiff", output_reconstruction_1.ToUTF8( ).data( ),
+        int max_threads = 1; // overridden by the number of threads given on the command line
+
+        my_parent->current_job_package.AddJob("ttttfffttibtiffi", output_reconstruction_1.ToUTF8( ).data( ),
                                               output_reconstruction_2.ToUTF8( ).data( ),
                                               output_reconstruction_filtered.ToUTF8( ).data( ),
                                               output_resolution_statistics.ToUTF8( ).data( ),
@@ -1561,7 +1566,7 @@ void AbInitioManager::SetupMerge3dJob( ) {
                                               save_orthogonal_views_image,
                                               orthogonal_views_filename.ToUTF8( ).data( ),
                                               number_of_reconstruction_jobs,
-                                              wiener_nominator, alignment_res);
+                                              wiener_nominator, alignment_res, max_threads);
     }
 }
 
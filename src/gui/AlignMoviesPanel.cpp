@@ -698,11 +698,15 @@ void MyAlignMoviesPanel::StartAlignmentClick(wxCommandEvent& event) {
         number_of_frames_for_running_average = 1;
         max_threads                          = 1;
 
+        // local motion correction is not offered in the GUI yet
+        int number_of_patches_x = 0;
+        int number_of_patches_y = 0;
+
         bool        saved_aligned_frames    = false;
         std::string aligned_frames_filename = "/dev/null";
         std::string output_shift_text_file  = "/dev/null";
 
-        current_job_package.AddJob("ssfffbbfifbiifffbsbsfbfffbtbtiiiibttii", current_filename.c_str( ), //0
+        current_job_package.AddJob("ssfffbbfifbiifffbsbsfbfffbtbtiiiibttiiii", current_filename.c_str( ), //0
                                    output_filename.ToUTF8( ).data( ),
                                    current_pixel_size,
                                    float(minimum_shift),
@@ -739,7 +743,9 @@ void MyAlignMoviesPanel::StartAlignmentClick(wxCommandEvent& event) {
                                    aligned_frames_filename.c_str( ),
                                    output_shift_text_file.c_str( ),
                                    current_eer_frames_per_image,
-                                   current_eer_super_res_factor);
+                                   current_eer_super_res_factor,
+                                   number_of_patches_x,
+                                   number_of_patches_y);
 
         my_progress_dialog->Update(counter + 1);
     }
@@ -1051,7 +1051,9 @@ void AutoRefinementManager::SetupMerge3dJob( ) {
 
         float alignment_res = class_high_res_limits[class_counter];
 
-        my_parent->current_job_package.AddJob("ttttfffttibtiff", output_reconstruction_1.ToUTF8( ).data( ),
+        int max_threads = 1; // overridden by the number of threads given on the command line
+
+        my_parent->current_job_package.AddJob("ttttfffttibtiffi", output_reconstruction_1.ToUTF8( ).data( ),
                                               output_reconstruction_2.ToUTF8( ).data( ),
                                               output_reconstruction_filtered.ToUTF8( ).data( ),
                                               output_resolution_statistics.ToUTF8( ).data( ),
@@ -1061,7 +1063,7 @@ void AutoRefinementManager::SetupMerge3dJob( ) {
                                               class_counter + 1,
                                               save_orthogonal_views_image,
                                               orthogonal_views_filename.ToUTF8( ).data( ),
-                                              number_of_reconstruction_jobs, weiner_nominator, alignment_res);
+                                              number_of_reconstruction_jobs, weiner_nominator, alignment_res, max_threads);
     }
 }
 
@@ -1216,7 +1218,9 @@ void AutoRefinementManager::SetupReconstructionJob( ) {
 
             int correct_ewald_sphere = 0;
 
-            my_parent->current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttii",
+            bool share_reconstruction_between_threads = false;
+
+            my_parent->current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttiib",
                                                   input_particle_stack.ToUTF8( ).data( ),
                                                   input_parameter_file.ToUTF8( ).data( ),
                                                   input_reconstruction.ToUTF8( ).data( ),
@@ -1250,7 +1254,8 @@ void AutoRefinementManager::SetupReconstructionJob( ) {
                                                   dump_file_1.ToUTF8( ).data( ),
                                                   dump_file_2.ToUTF8( ).data( ),
                                                   correct_ewald_sphere,
-                                                  max_threads);
+                                                  max_threads,
+                                                  share_reconstruction_between_threads);
         }
     }
 }
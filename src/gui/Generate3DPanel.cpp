@@ -623,7 +623,9 @@ void Generate3DPanel::SetupReconstructionJob( ) {
                     correct_ewald_sphere = -1;
             }
 
-            current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttii",
+            bool share_reconstruction_between_threads = false;
+
+            current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttiib",
                                        input_particle_stack.ToUTF8( ).data( ),
                                        input_parameter_file.ToUTF8( ).data( ),
                                        input_reconstruction.ToUTF8( ).data( ),
@@ -657,7 +659,8 @@ void Generate3DPanel::SetupReconstructionJob( ) {
                                        dump_file_1.ToUTF8( ).data( ),
                                        dump_file_2.ToUTF8( ).data( ),
                                        correct_ewald_sphere,
-                                       max_threads);
+                                       max_threads,
+                                       share_reconstruction_between_threads);
         }
     }
 }
@@ -731,7 +734,10 @@ void Generate3DPanel::SetupMerge3dJob( ) {
         wxString orthogonal_views_filename   = main_frame->current_project.volume_asset_directory.GetFullPath( ) + wxString::Format("/OrthViews/generate3d_volume_%li_%li_%i.mrc", number_of_3d_jobs + 1, input_refinement->refinement_id, class_counter + 1);
         float    weiner_nominator            = 1.0f;
         float    alignment_res               = 5;
-        current_job_package.AddJob("ttttfffttibtiff", output_reconstruction_1.ToUTF8( ).data( ),
+
+        int max_threads = 1; // overridden by the number of threads given on the command line
+
+        current_job_package.AddJob("ttttfffttibtiffi", output_reconstruction_1.ToUTF8( ).data( ),
                                    output_reconstruction_2.ToUTF8( ).data( ),
                                    output_reconstruction_filtered.ToUTF8( ).data( ),
                                    output_resolution_statistics.ToUTF8( ).data( ),
@@ -741,7 +747,7 @@ void Generate3DPanel::SetupMerge3dJob( ) {
                                    class_counter + 1,
                                    save_orthogonal_views_image,
                                    orthogonal_views_filename.ToUTF8( ).data( ),
-                                   number_of_reconstruction_jobs, weiner_nominator, alignment_res);
+                                   number_of_reconstruction_jobs, weiner_nominator, alignment_res, max_threads);
     }
 }
 
@@ -1300,7 +1300,10 @@ void RefinementManager::SetupMerge3dJob( ) {
         wxString orthogonal_views_filename   = main_frame->current_project.volume_asset_directory.GetFullPath( ) + wxString::Format("/OrthViews/volume_%li_%i.mrc", output_refinement->refinement_id, class_counter + 1);
         float    weiner_nominator            = 1.0f;
         float    alignment_res               = 5;
-        my_parent->current_job_package.AddJob("ttttfffttibtiff", output_reconstruction_1.ToUTF8( ).data( ),
+
+        int max_threads = 1; // overridden by the number of threads given on the command line
+
+        my_parent->current_job_package.AddJob("ttttfffttibtiffi", output_reconstruction_1.ToUTF8( ).data( ),
                                               output_reconstruction_2.ToUTF8( ).data( ),
                                               output_reconstruction_filtered.ToUTF8( ).data( ),
                                               output_resolution_statistics.ToUTF8( ).data( ),
@@ -1310,7 +1313,7 @@ void RefinementManager::SetupMerge3dJob( ) {
                                               class_counter + 1,
                                               save_orthogonal_views_image,
                                               orthogonal_views_filename.ToUTF8( ).data( ),
-                                              number_of_reconstruction_jobs, weiner_nominator, alignment_res);
+                                              number_of_reconstruction_jobs, weiner_nominator, alignment_res, max_threads);
     }
 }
 
@@ -1437,7 +1440,9 @@ void RefinementManager::SetupReconstructionJob( ) {
             bool threshold_input_3d   = true;
             int  correct_ewald_sphere = 0;
 
-            my_parent->current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttii",
+            bool share_reconstruction_between_threads = false;
+
+            my_parent->current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttiib",
                                                   input_particle_stack.ToUTF8( ).data( ),
                                                   input_parameter_file.ToUTF8( ).data( ),
                                                   input_reconstruction.ToUTF8( ).data( ),
@@ -1471,7 +1476,8 @@ void RefinementManager::SetupReconstructionJob( ) {
                                                   dump_file_1.ToUTF8( ).data( ),
                                                   dump_file_2.ToUTF8( ).data( ),
                                                   correct_ewald_sphere,
-                                                  max_threads);
+                                                  max_threads,
+                                                  share_reconstruction_between_threads);
         }
     }
 }
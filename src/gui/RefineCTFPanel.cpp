@@ -996,7 +996,9 @@ void CTFRefinementManager::SetupMerge3dJob( ) {
         float    weiner_nominator            = 1.0f;
         float    alignment_res               = 5.0f;
 
-        my_parent->current_job_package.AddJob("ttttfffttibtiff", output_reconstruction_1.ToUTF8( ).data( ),
+        int max_threads = 1; // overridden by the number of threads given on the command line
+
+        my_parent->current_job_package.AddJob("ttttfffttibtiffi", output_reconstruction_1.ToUTF8( ).data( ),
                                               output_reconstruction_2.ToUTF8( ).data( ),
                                               output_reconstruction_filtered.ToUTF8( ).data( ),
                                               output_resolution_statistics.ToUTF8( ).data( ),
@@ -1010,7 +1012,8 @@ void CTFRefinementManager::SetupMerge3dJob( ) {
                                               orthogonal_views_filename.ToUTF8( ).data( ),
                                               number_of_reconstruction_jobs,
                                               weiner_nominator,
-                                              alignment_res);
+                                              alignment_res,
+                                              max_threads);
     }
 }
 
@@ -1143,7 +1146,9 @@ void CTFRefinementManager::SetupReconstructionJob( ) {
             bool threshold_input_3d   = true;
             int  correct_ewald_sphere = 0;
 
-            my_parent->current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttii",
+            bool share_reconstruction_between_threads = false;
+
+            my_parent->current_job_package.AddJob("ttttttttiiffffffffffbbbbbbbbbbttiib",
                                                   input_particle_stack.ToUTF8( ).data( ),
                                                   input_parameter_file.ToUTF8( ).data( ),
                                                   input_reconstruction.ToUTF8( ).data( ),
@@ -1177,7 +1182,8 @@ void CTFRefinementManager::SetupReconstructionJob( ) {
                                                   dump_file_1.ToUTF8( ).data( ),
                                                   dump_file_2.ToUTF8( ).data( ),
                                                   correct_ewald_sphere,
-                                                  max_threads);
+                                                  max_threads,
+                                                  share_reconstruction_between_threads);
         }
     }
 }
@@ -1265,6 +1271,7 @@ void CTFRefinementManager::SetupRefinementJob( ) {
     }
 
     wxString output_star_filename = wxString::Format("%s/refine_ctf_input_star_%li.cistem", main_frame->current_project.parameter_file_directory.GetFullPath( ), input_refinement->refinement_id);
+    output_parameters.write_statistics_to_file = true; // the jobs read the statistics of the whole dataset rather than calculating them
     output_parameters.WriteTocisTEMBinaryFile(output_star_filename);
 
     //	wxPrintf("Input refinement has %li particles\n", input_refinement->number_of_particles);
@@ -0,0 +1,588 @@
+#include "../../core/core_headers.h"
+
+#include <numeric>
+
+/*  cistem_bench - timings of the core Image / FFT / file reading primitives on synthetic data
+
+	Meant for catching performance regressions between releases and for sizing nodes. Every benchmark is run at each box size and
+	each thread count. With N threads, N copies of a benchmark run at the same time, each on its own data, so the throughput shows
+	how the operation scales on the node. Each copy makes one untimed warm-up call followed by the timed calls.
+
+	  cistem_bench --benchmarks=fft_forward,phase_shift --sizes=128,256,512 --threads=1,2,4,8 --repeats=20 --json=results.json
+
+	  --list          print the benchmark names and exit
+	  --benchmarks    comma separated benchmark names, or all (default)
+	  --sizes         comma separated box sizes (default 128,256,384,512). Volume benchmarks allocate box_size^3 voxels per thread.
+	  --threads       comma separated thread counts (default 1)
+	  --repeats       timed calls per thread (default 10)
+	  --json          also write the results to this file
+	  --eer-file      an EER movie for eer_read, which is skipped without one
+	  --scratch-dir   directory for the synthetic files of the reader benchmarks (default the system temporary directory)
+
+	The command line and the JSON layout are kept stable so that results of different releases can be compared by scripts; fields
+	are only ever added. The JSON file is {"format_version", "cistem_version", "host", "date", "results" : [{"benchmark",
+	"box_size", "threads", "repeats", "median_ms", "minimum_ms", "mean_ms", "calls_per_second"}, ...]}, where the times are per
+	call over all threads and calls_per_second is summed over the threads. box_size is 0 for benchmarks that do not use it.
+*/
+
+#define CISTEM_BENCH_FORMAT_VERSION 1
+
+class
+        CistemBenchApp : public MyApp {
+
+  public:
+    bool DoCalculation( );
+    void DoInteractiveUserInput( );
+    void AddCommandLineOptions( );
+
+  private:
+    std::vector<std::string> wanted_benchmarks;
+    std::vector<int>         wanted_box_sizes;
+    std::vector<int>         wanted_numbers_of_threads;
+    int                      number_of_repeats;
+    wxString                 json_filename;
+    wxString                 eer_filename;
+    wxString                 scratch_directory;
+    bool                     only_list_benchmarks;
+};
+
+IMPLEMENT_APP(CistemBenchApp)
+
+namespace {
+
+constexpr int number_of_slices_in_reader_files = 8;
+constexpr int number_of_lines_in_star_file     = 100000;
+constexpr int number_of_eer_frames_per_image   = 10;
+constexpr int default_number_of_repeats        = 10;
+const char*   default_box_sizes                = "128,256,384,512";
+const char*   default_numbers_of_threads       = "1";
+
+// All the data one thread needs for one benchmark at one box size. Only the members used by the benchmark are allocated.
+class BenchmarkData {
+
+  public:
+    int      box_size;
+    wxString scratch_filename;
+
+    Image reference_image;
+    Image work_image;
+    Image other_image;
+    Image volume;
+    Image other_volume;
+
+    CTF                   ctf;
+    AnglesAndShifts       angles;
+    RandomNumberGenerator random_generator;
+
+    std::vector<int>    shell_number;
+    std::vector<float>  computed_fsc;
+    std::vector<double> work_sum_of_squares;
+    std::vector<double> work_sum_of_other_squares;
+    std::vector<double> work_sum_of_cross_products;
+
+    Reconstruct3D reconstruction;
+    Particle      particle;
+
+    ImageFile        input_file;
+    int              current_slice;
+    cisTEMParameters parameters;
+
+    BenchmarkData( ) : random_generator(pi_v<float>) {
+        box_size      = 0;
+        current_slice = 0;
+    }
+
+    ~BenchmarkData( ) {
+        if ( input_file.IsOpen( ) )
+            input_file.CloseFile( );
+        if ( scratch_filename.IsEmpty( ) == false && wxFileExists(scratch_filename) )
+            wxRemoveFile(scratch_filename);
+    }
+
+    void AllocateNoiseImage(Image& image_to_allocate, int wanted_box_size, int wanted_z_size = 1) {
+        image_to_allocate.Allocate(wanted_box_size, wanted_box_size, wanted_z_size, true);
+        image_to_allocate.FillWithNoise(GAUSSIAN, 0.0f, 1.0f);
+    }
+
+    void NextRandomAngles( ) {
+        angles.Init(random_generator.GetUniformRandomSTD(0.0f, 360.0f), random_generator.GetUniformRandomSTD(0.0f, 180.0f), random_generator.GetUniformRandomSTD(0.0f, 360.0f), 0.0f, 0.0f);
+    }
+
+    void ReadNextSlice( ) {
+        current_slice = current_slice % input_file.ReturnNumberOfSlices( ) + 1;
+        work_image.ReadSlice(&input_file, current_slice);
+    }
+};
+
+struct BenchmarkDefinition {
+    std::string name;
+    std::string description;
+    bool        uses_box_size;
+
+    std::function<bool(BenchmarkData&)> setup; // untimed, once per thread, returns false if the benchmark cannot run
+    std::function<void(BenchmarkData&)> prepare_call; // untimed, before every call
+    std::function<void(BenchmarkData&)> timed_call;
+};
+
+struct BenchmarkResult {
+    std::string benchmark;
+    int         box_size;
+    int         number_of_threads;
+    int         number_of_repeats;
+    double      median_ms;
+    double      minimum_ms;
+    double      mean_ms;
+    double      calls_per_second;
+};
+
+void DoNothing(BenchmarkData&) {
+}
+
+// The shell of each voxel of a Fourier transformed volume, as used by Image::ComputeFSC( )
+void FillShellNumbers(BenchmarkData& data) {
+    Image& volume           = data.volume;
+    int    number_of_shells = data.box_size / 2;
+    long   pixel_counter    = 0;
+
+    data.shell_number.resize(volume.real_memory_allocated / 2);
+    data.computed_fsc.resize(number_of_shells);
+    data.work_sum_of_squares.resize(number_of_shells);
+    data.work_sum_of_other_squares.resize(number_of_shells);
+    data.work_sum_of_cross_products.resize(number_of_shells);
+
+    for ( int k = 0; k <= volume.physical_upper_bound_complex_z; k++ ) {
+        float z_coord = volume.ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k) * volume.fourier_voxel_size_z;
+        for ( int j = 0; j <= volume.physical_upper_bound_complex_y; j++ ) {
+            float y_coord = volume.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * volume.fourier_voxel_size_y;
+            for ( int i = 0; i <= volume.physical_upper_bound_complex_x; i++ ) {
+                float x_coord                    = i * volume.fourier_voxel_size_x;
+                int   shell                      = myroundint(sqrtf(x_coord * x_coord + y_coord * y_coord + z_coord * z_coord) * 2.0f * float(number_of_shells - 1));
+                data.shell_number[pixel_counter] = (shell < number_of_shells) ? shell : 0; // the corners beyond 0.5 are ignored
+                pixel_counter++;
+            }
+        }
+    }
+
+    for ( ; pixel_counter < long(data.shell_number.size( )); pixel_counter++ ) {
+        data.shell_number[pixel_counter] = 0;
+    }
+}
+
+// A stack of 8 bit, LZW compressed frames, as movies are usually stored
+bool WriteSyntheticTiffFile(BenchmarkData& data) {
+    TIFF* output_file = TIFFOpen(data.scratch_filename.ToStdString( ).c_str( ), "w");
+    if ( output_file == NULL )
+        return false;
+
+    std::vector<unsigned char> row(data.box_size);
+
+    for ( int slice_counter = 0; slice_counter < number_of_slices_in_reader_files; slice_counter++ ) {
+        TIFFSetField(output_file, TIFFTAG_IMAGEWIDTH, data.box_size);
+        TIFFSetField(output_file, TIFFTAG_IMAGELENGTH, data.box_size);
+        TIFFSetField(output_file, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(output_file, TIFFTAG_SAMPLESPERPIXEL, 1);
+        TIFFSetField(output_file, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
+        TIFFSetField(output_file, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+        TIFFSetField(output_file, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(output_file, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+        TIFFSetField(output_file, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(output_file, 0));
+
+        for ( int row_counter = 0; row_counter < data.box_size; row_counter++ ) {
+            for ( int column_counter = 0; column_counter < data.box_size; column_counter++ ) {
+                row[column_counter] = (unsigned char)(data.random_generator.GetPoissonRandomSTD(1.0f));
+            }
+            if ( TIFFWriteScanline(output_file, row.data( ), row_counter, 0) < 0 ) {
+                TIFFClose(output_file);
+                return false;
+            }
+        }
+
+        TIFFWriteDirectory(output_file);
+    }
+
+    TIFFClose(output_file);
+    return true;
+}
+
+std::vector<BenchmarkDefinition> ReturnBenchmarkDefinitions(const wxString& eer_filename) {
+    std::vector<BenchmarkDefinition> definitions;
+
+    definitions.push_back({"fft_forward", "Image::ForwardFFT of a 2D image", true,
+                           [](BenchmarkData& data) { data.AllocateNoiseImage(data.reference_image, data.box_size); return true; },
+                           [](BenchmarkData& data) { data.work_image.CopyFrom(&data.reference_image); },
+                           [](BenchmarkData& data) { data.work_image.ForwardFFT( ); }});
+
+    definitions.push_back({"fft_backward", "Image::BackwardFFT of a 2D image", true,
+                           [](BenchmarkData& data) { data.AllocateNoiseImage(data.reference_image, data.box_size); data.reference_image.ForwardFFT( ); return true; },
+                           [](BenchmarkData& data) { data.work_image.CopyFrom(&data.reference_image); },
+                           [](BenchmarkData& data) { data.work_image.BackwardFFT( ); }});
+
+    definitions.push_back({"extract_slice", "Image::ExtractSlice of a central section from a 3D transform, at random angles", true,
+                           [](BenchmarkData& data) {
+                               data.AllocateNoiseImage(data.volume, data.box_size, data.box_size);
+                               data.volume.ForwardFFT( );
+                               data.volume.SwapRealSpaceQuadrants( );
+                               data.work_image.Allocate(data.box_size, data.box_size, false);
+                               return true;
+                           },
+                           [](BenchmarkData& data) { data.NextRandomAngles( ); },
+                           [](BenchmarkData& data) { data.volume.ExtractSlice(data.work_image, data.angles); }});
+
+    definitions.push_back({"phase_shift", "Image::PhaseShift of a 2D transform", true,
+                           [](BenchmarkData& data) { data.AllocateNoiseImage(data.work_image, data.box_size); data.work_image.ForwardFFT( ); return true; },
+                           DoNothing,
+                           [](BenchmarkData& data) { data.work_image.PhaseShift(1.3f, -2.7f); }});
+
+    definitions.push_back({"apply_ctf", "Image::ApplyCTF to a 2D transform, astigmatic with beam tilt", true,
+                           [](BenchmarkData& data) {
+                               data.AllocateNoiseImage(data.reference_image, data.box_size);
+                               data.reference_image.ForwardFFT( );
+                               data.ctf.Init(300.0f, 2.7f, 0.07f, 15000.0f, 14500.0f, 35.0f, 1.0f, 0.0f);
+                               data.ctf.SetBeamTilt(0.001f, -0.0005f);
+                               return true;
+                           },
+                           [](BenchmarkData& data) { data.work_image.CopyFrom(&data.reference_image); },
+                           [](BenchmarkData& data) { data.work_image.ApplyCTF(data.ctf, false, true); }});
+
+    definitions.push_back({"clip_into", "Image::ClipInto a real space image twice the size", true,
+                           [](BenchmarkData& data) {
+                               data.AllocateNoiseImage(data.reference_image, data.box_size);
+                               data.work_image.Allocate(2 * data.box_size, 2 * data.box_size, true);
+                               return true;
+                           },
+                           DoNothing,
+                           [](BenchmarkData& data) { data.reference_image.ClipInto(&data.work_image); }});
+
+    definitions.push_back({"rotate_2d", "Image::Rotate2D of a real space image, at random angles", true,
+                           [](BenchmarkData& data) {
+                               data.AllocateNoiseImage(data.reference_image, data.box_size);
+                               data.work_image.Allocate(data.box_size, data.box_size, true);
+                               return true;
+                           },
+                           [](BenchmarkData& data) { data.NextRandomAngles( ); },
+                           [](BenchmarkData& data) { data.reference_image.Rotate2D(data.work_image, data.angles); }});
+
+    definitions.push_back({"cross_correlation", "Image::CalculateCrossCorrelationImageWith of two real space images, including the FFTs", true,
+                           [](BenchmarkData& data) {
+                               data.AllocateNoiseImage(data.reference_image, data.box_size);
+                               data.AllocateNoiseImage(data.other_image, data.box_size);
+                               return true;
+                           },
+                           [](BenchmarkData& data) { data.work_image.CopyFrom(&data.reference_image); },
+                           [](BenchmarkData& data) { data.work_image.CalculateCrossCorrelationImageWith(&data.other_image); }});
+
+    definitions.push_back({"compute_fsc", "Image::ComputeFSC of two 3D transforms", true,
+                           [](BenchmarkData& data) {
+                               data.AllocateNoiseImage(data.volume, data.box_size, data.box_size);
+                               data.AllocateNoiseImage(data.other_volume, data.box_size, data.box_size);
+                               data.volume.ForwardFFT( );
+                               data.other_volume.ForwardFFT( );
+                               FillShellNumbers(data);
+                               return true;
+                           },
+                           DoNothing,
+                           [](BenchmarkData& data) {
+                               data.volume.ComputeFSC(&data.other_volume, int(data.computed_fsc.size( )), data.shell_number.data( ), data.computed_fsc.data( ),
+                                                      data.work_sum_of_squares.data( ), data.work_sum_of_other_squares.data( ), data.work_sum_of_cross_products.data( ));
+                           }});
+
+    definitions.push_back({"insert_slice_with_ctf", "Reconstruct3D::InsertSliceWithCTF of a particle, at random angles", true,
+                           [](BenchmarkData& data) {
+                               cisTEMParameterLine parameter_averages;
+                               cisTEMParameterLine parameter_variances;
+                               parameter_averages.occupancy = 100.0f;
+                               parameter_averages.sigma     = 1.0f;
+
+                               data.reconstruction.Init(data.box_size, data.box_size, data.box_size, 1.0f, 100.0f, 0.0f, 0.0f);
+                               data.reconstruction.symmetry_matrices.Init("C1");
+                               data.particle.Allocate(data.box_size, data.box_size);
+                               data.particle.SetParameterStatistics(parameter_averages, parameter_variances);
+                               data.particle.pixel_size         = 1.0f;
+                               data.particle.particle_occupancy = 100.0f;
+                               data.particle.sigma_noise        = 1.0f;
+                               data.particle.particle_score     = 0.0f;
+                               data.particle.InitCTFImage(300.0f, 2.7f, 0.07f, 15000.0f, 14500.0f, 35.0f, 0.0f);
+                               data.AllocateNoiseImage(data.reference_image, data.box_size);
+                               data.reference_image.ForwardFFT( );
+                               return true;
+                           },
+                           [](BenchmarkData& data) {
+                               data.particle.particle_image->CopyFrom(&data.reference_image);
+                               data.NextRandomAngles( );
+                               data.particle.alignment_parameters = data.angles;
+                           },
+                           [](BenchmarkData& data) { data.reconstruction.InsertSliceWithCTF(data.particle); }});
+
+    definitions.push_back({"mrc_read", "Image::ReadSlice from an MRC stack of 2D images", true,
+                           [](BenchmarkData& data) {
+                               data.AllocateNoiseImage(data.reference_image, data.box_size);
+                               MRCFile output_file(data.scratch_filename.ToStdString( ), true);
+                               for ( int slice_counter = 1; slice_counter <= number_of_slices_in_reader_files; slice_counter++ ) {
+                                   data.reference_image.WriteSlice(&output_file, slice_counter);
+                               }
+                               output_file.SetPixelSizeAndWriteHeader(1.0f);
+                               output_file.CloseFile( );
+                               return data.input_file.OpenFile(data.scratch_filename.ToStdString( ), false);
+                           },
+                           DoNothing,
+                           [](BenchmarkData& data) { data.ReadNextSlice( ); }});
+
+    definitions.push_back({"tiff_read", "Image::ReadSlice from an 8 bit, LZW compressed TIFF stack", true,
+                           [](BenchmarkData& data) {
+                               data.scratch_filename = data.scratch_filename.BeforeLast('.') + ".tif";
+                               return WriteSyntheticTiffFile(data) && data.input_file.OpenFile(data.scratch_filename.ToStdString( ), false);
+                           },
+                           DoNothing,
+                           [](BenchmarkData& data) { data.ReadNextSlice( ); }});
+
+    definitions.push_back({"eer_read", wxString::Format("Image::ReadSlice of %i EER frames summed into an image (--eer-file)", number_of_eer_frames_per_image).ToStdString( ), false,
+                           [eer_filename](BenchmarkData& data) {
+                               data.scratch_filename.Clear( ); // the file belongs to the user
+                               if ( eer_filename.IsEmpty( ) || wxFileExists(eer_filename) == false )
+                                   return false;
+                               return data.input_file.OpenFile(eer_filename.ToStdString( ), false, false, false, 1, number_of_eer_frames_per_image);
+                           },
+                           DoNothing,
+                           [](BenchmarkData& data) { data.ReadNextSlice( ); }});
+
+    definitions.push_back({"star_read", wxString::Format("cisTEMParameters::ReadFromcisTEMStarFile of %i lines", number_of_lines_in_star_file).ToStdString( ), false,
+                           [](BenchmarkData& data) {
+                               cisTEMParameters    synthetic_parameters;
+                               cisTEMParameterLine line;
+
+                               data.scratch_filename = data.scratch_filename.BeforeLast('.') + ".star";
+                               for ( int line_counter = 0; line_counter < number_of_lines_in_star_file; line_counter++ ) {
+                                   line.position_in_stack = line_counter + 1;
+                                   line.psi               = data.random_generator.GetUniformRandomSTD(0.0f, 360.0f);
+                                   line.theta             = data.random_generator.GetUniformRandomSTD(0.0f, 180.0f);
+                                   line.phi               = data.random_generator.GetUniformRandomSTD(0.0f, 360.0f);
+                                   line.x_shift           = data.random_generator.GetNormalRandomSTD(0.0f, 2.0f);
+                                   line.y_shift           = data.random_generator.GetNormalRandomSTD(0.0f, 2.0f);
+                                   line.defocus_1         = data.random_generator.GetUniformRandomSTD(5000.0f, 25000.0f);
+                                   line.defocus_2         = line.defocus_1 - data.random_generator.GetUniformRandomSTD(0.0f, 500.0f);
+                                   line.score             = data.random_generator.GetUniformRandomSTD(0.0f, 40.0f);
+                                   line.stack_filename    = "particle_stack.mrc";
+                                   synthetic_parameters.all_parameters.Add(line);
+                               }
+                               synthetic_parameters.parameters_to_write.SetAllToTrue( );
+                               synthetic_parameters.WriteTocisTEMStarFile(data.scratch_filename);
+                               return wxFileExists(data.scratch_filename);
+                           },
+                           DoNothing,
+                           [](BenchmarkData& data) { data.parameters.ReadFromcisTEMStarFile(data.scratch_filename); }});
+
+    return definitions;
+}
+
+std::vector<int> ReturnIntegerList(const wxString& comma_separated_list) {
+    std::vector<int>  integers;
+    wxStringTokenizer tokenizer(comma_separated_list, ",");
+    long              value;
+
+    while ( tokenizer.HasMoreTokens( ) ) {
+        wxString token = tokenizer.GetNextToken( ).Trim( ).Trim(false);
+        if ( token.ToLong(&value) == false || value < 1 ) {
+            MyPrintWithDetails("Error: %s is not a positive integer\n", token);
+            DEBUG_ABORT;
+        }
+        integers.push_back(int(value));
+    }
+
+    return integers;
+}
+
+inline double MillisecondsSince(const std::chrono::steady_clock::time_point& start_time) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now( ) - start_time).count( );
+}
+
+// Run one benchmark on number_of_threads threads at once, returns false if it could not be set up
+bool RunBenchmark(const BenchmarkDefinition& definition, int box_size, int number_of_threads, int number_of_repeats, const wxString& scratch_directory, BenchmarkResult& result) {
+    BenchmarkData* thread_data  = new BenchmarkData[number_of_threads];
+    bool           setup_worked = true;
+
+    for ( int thread_counter = 0; thread_counter < number_of_threads && setup_worked; thread_counter++ ) {
+        thread_data[thread_counter].box_size         = box_size;
+        thread_data[thread_counter].scratch_filename = wxString::Format("%s/cistem_bench_%li_%i.mrc", scratch_directory, wxGetProcessId( ), thread_counter);
+        setup_worked                                 = definition.setup(thread_data[thread_counter]);
+    }
+
+    if ( setup_worked == false ) {
+        delete[] thread_data;
+        return false;
+    }
+
+    std::vector<double> call_milliseconds(long(number_of_threads) * number_of_repeats);
+    std::vector<double> thread_milliseconds(number_of_threads, 0.0);
+
+#pragma omp parallel for schedule(static, 1) num_threads(number_of_threads)
+    for ( int thread_counter = 0; thread_counter < number_of_threads; thread_counter++ ) {
+        BenchmarkData& data = thread_data[thread_counter];
+
+        definition.prepare_call(data);
+        definition.timed_call(data);
+
+        for ( int repeat_counter = 0; repeat_counter < number_of_repeats; repeat_counter++ ) {
+            definition.prepare_call(data);
+
+            std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now( );
+            definition.timed_call(data);
+            double elapsed_milliseconds = MillisecondsSince(start_time);
+
+            call_milliseconds[long(thread_counter) * number_of_repeats + repeat_counter] = elapsed_milliseconds;
+            thread_milliseconds[thread_counter] += elapsed_milliseconds;
+        }
+    }
+
+    delete[] thread_data;
+
+    result.benchmark         = definition.name;
+    result.box_size          = definition.uses_box_size ? box_size : 0;
+    result.number_of_threads = number_of_threads;
+    result.number_of_repeats = number_of_repeats;
+    result.mean_ms           = std::accumulate(call_milliseconds.begin( ), call_milliseconds.end( ), 0.0) / call_milliseconds.size( );
+    result.minimum_ms        = *std::min_element(call_milliseconds.begin( ), call_milliseconds.end( ));
+
+    std::nth_element(call_milliseconds.begin( ), call_milliseconds.begin( ) + call_milliseconds.size( ) / 2, call_milliseconds.end( ));
+    result.median_ms = call_milliseconds[call_milliseconds.size( ) / 2];
+
+    result.calls_per_second = 0.0;
+    for ( double milliseconds : thread_milliseconds ) {
+        if ( milliseconds > 0.0 )
+            result.calls_per_second += 1000.0 * number_of_repeats / milliseconds;
+    }
+
+    return true;
+}
+
+void WriteResultsToJSON(const wxString& wanted_filename, const std::vector<BenchmarkResult>& results) {
+    wxJSONValue root;
+
+    root["format_version"] = CISTEM_BENCH_FORMAT_VERSION;
+#ifdef CISTEM_VERSION_TEXT
+    root["cistem_version"] = wxString(CISTEM_VERSION_TEXT);
+#else
+    root["cistem_version"] = wxString("unknown");
+#endif
+    root["host"]    = wxGetHostName( );
+    root["date"]    = wxDateTime::Now( ).FormatISOCombined(' ');
+    root["results"] = wxJSONValue(wxJSONTYPE_ARRAY);
+
+    for ( const BenchmarkResult& result : results ) {
+        wxJSONValue entry;
+        entry["benchmark"]        = wxString(result.benchmark);
+        entry["box_size"]         = result.box_size;
+        entry["threads"]          = result.number_of_threads;
+        entry["repeats"]          = result.number_of_repeats;
+        entry["median_ms"]        = result.median_ms;
+        entry["minimum_ms"]       = result.minimum_ms;
+        entry["mean_ms"]          = result.mean_ms;
+        entry["calls_per_second"] = result.calls_per_second;
+        root["results"].Append(entry);
+    }
+
+    wxJSONWriter writer;
+    wxString     json_string;
+    writer.Write(root, json_string);
+
+    wxFile json_file;
+    if ( json_file.Open(wanted_filename, wxFile::write) == false ) {
+        MyPrintWithDetails("Error: Cannot open %s for writing\n", wanted_filename);
+        return;
+    }
+    json_file.Write(json_string);
+    json_file.Close( );
+}
+
+} // namespace
+
+void CistemBenchApp::AddCommandLineOptions( ) {
+    command_line_parser.AddLongSwitch("list", "Print the names of the benchmarks and exit");
+    command_line_parser.AddLongOption("benchmarks", "Comma separated names of the benchmarks to run, or all (default)", wxCMD_LINE_VAL_STRING);
+    command_line_parser.AddLongOption("sizes", wxString::Format("Comma separated box sizes (default %s)", default_box_sizes), wxCMD_LINE_VAL_STRING);
+    command_line_parser.AddLongOption("threads", wxString::Format("Comma separated numbers of threads (default %s)", default_numbers_of_threads), wxCMD_LINE_VAL_STRING);
+    command_line_parser.AddLongOption("repeats", wxString::Format("Timed calls per thread (default %i)", default_number_of_repeats), wxCMD_LINE_VAL_NUMBER);
+    command_line_parser.AddLongOption("json", "Also write the results to this JSON file", wxCMD_LINE_VAL_STRING);
+    command_line_parser.AddLongOption("eer-file", "EER movie used by the eer_read benchmark", wxCMD_LINE_VAL_STRING);
+    command_line_parser.AddLongOption("scratch-dir", "Directory for the synthetic files of the reader benchmarks", wxCMD_LINE_VAL_STRING);
+}
+
+// Everything comes from the command line, so that runs can be scripted and compared between releases
+
+void CistemBenchApp::DoInteractiveUserInput( ) {
+    wxString benchmark_list         = "all";
+    wxString box_size_list          = default_box_sizes;
+    wxString number_of_threads_list = default_numbers_of_threads;
+    long     temp_long              = default_number_of_repeats;
+
+    only_list_benchmarks = command_line_parser.FoundSwitch("list") == wxCMD_SWITCH_ON;
+    command_line_parser.Found("benchmarks", &benchmark_list);
+    command_line_parser.Found("sizes", &box_size_list);
+    command_line_parser.Found("threads", &number_of_threads_list);
+    command_line_parser.Found("repeats", &temp_long);
+    command_line_parser.Found("json", &json_filename);
+    command_line_parser.Found("eer-file", &eer_filename);
+
+    scratch_directory = wxFileName::GetTempDir( );
+    command_line_parser.Found("scratch-dir", &scratch_directory);
+
+    wanted_box_sizes          = ReturnIntegerList(box_size_list);
+    wanted_numbers_of_threads = ReturnIntegerList(number_of_threads_list);
+    number_of_repeats         = std::max(int(temp_long), 1);
+
+    wanted_benchmarks.clear( );
+    if ( benchmark_list.IsSameAs("all", false) == false ) {
+        wxStringTokenizer tokenizer(benchmark_list, ",");
+        while ( tokenizer.HasMoreTokens( ) ) {
+            wanted_benchmarks.push_back(tokenizer.GetNextToken( ).Trim( ).Trim(false).ToStdString( ));
+        }
+    }
+}
+
+bool CistemBenchApp::DoCalculation( ) {
+    std::vector<BenchmarkDefinition> definitions = ReturnBenchmarkDefinitions(eer_filename);
+    std::vector<BenchmarkResult>     results;
+    BenchmarkResult                  result;
+
+    if ( only_list_benchmarks ) {
+        for ( const BenchmarkDefinition& definition : definitions ) {
+            wxPrintf("%-24s %s\n", definition.name.c_str( ), definition.description.c_str( ));
+        }
+        return true;
+    }
+
+    for ( const std::string& wanted_name : wanted_benchmarks ) {
+        if ( std::none_of(definitions.begin( ), definitions.end( ), [&wanted_name](const BenchmarkDefinition& definition) { return definition.name == wanted_name; }) ) {
+            SendErrorAndCrash(wxString::Format("Unknown benchmark (%s), see --list", wanted_name.c_str( )));
+        }
+    }
+
+    wxPrintf("\n%-24s %8s %8s %12s %12s %12s %14s\n", "benchmark", "box", "threads", "median (ms)", "min (ms)", "mean (ms)", "calls/s");
+
+    for ( const BenchmarkDefinition& definition : definitions ) {
+        if ( wanted_benchmarks.empty( ) == false && std::find(wanted_benchmarks.begin( ), wanted_benchmarks.end( ), definition.name) == wanted_benchmarks.end( ) )
+            continue;
+
+        // Benchmarks that do not use the box size are run once per number of threads
+        std::vector<int> box_sizes = definition.uses_box_size ? wanted_box_sizes : std::vector<int>(1, 0);
+
+        for ( int box_size : box_sizes ) {
+            for ( int number_of_threads : wanted_numbers_of_threads ) {
+                if ( RunBenchmark(definition, box_size, number_of_threads, number_of_repeats, scratch_directory, result) == false ) {
+                    wxPrintf("%-24s %8i %8i %12s\n", definition.name.c_str( ), box_size, number_of_threads, "skipped");
+                    continue;
+                }
+
+                wxPrintf("%-24s %8i %8i %12.3f %12.3f %12.3f %14.1f\n", result.benchmark.c_str( ), result.box_size, result.number_of_threads, result.median_ms, result.minimum_ms, result.mean_ms, result.calls_per_second);
+                results.push_back(result);
+            }
+        }
+    }
+
+    if ( json_filename.IsEmpty( ) == false ) {
+        WriteResultsToJSON(json_filename, results);
+        wxPrintf("\nResults written to %s\n", json_filename);
+    }
+
+    wxPrintf("\n");
+    return true;
+}
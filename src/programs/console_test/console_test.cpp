@@ -89,6 +89,7 @@ class
     void TestMRCFunctions( );
     void TestAssignmentOperatorsAndFunctions( );
     void TestFFTFunctions( );
+    void TestConcurrentFFTs( );
     void TestScalingAndSizingFunctions( );
     void TestFilterFunctions( );
     void TestAlignmentFunctions( );
@@ -99,6 +100,7 @@ class
     void TestClipIntoFourier( );
     void TestMaskCentralCross( );
     void TestStarToBinaryFileConversion( );
+    void TestMappedStarFileReader( );
     void TestElectronExposureFilter( );
     void TestEmpiricalDistribution( );
     void TestEmpiricalDistributionThreadSafety( );
@@ -106,9 +108,21 @@ class
     void TestRandomVariableFunctions( );
     void TestIntegerShifts( );
     void TestDatabase( );
+    void TestRefinementResultIndex( );
     void TestRunProfileDiskOperations( );
+    void TestRequeueOfLostJobs( );
     void TestCTFNodes( );
+    void TestCTFImageRows( );
+    void TestProfiler( );
+    void TestProfilerInRefinementPrimitives( );
+    void TestReconstruct3DDumpFiles( );
+    void TestSharedReconstruction( );
+    void TestReconstructionTreeReduction( );
     void TestSpectrumImageMethods( );
+    void TestUnblurDeformationModel( );
+    void TestUnblurFrameStream( );
+    void TestBatchOfMicrographs( );
+    void TestWorkerCache( );
 #ifdef cisTEM_USING_LIBTORCH
     void TestLibTorch( );
 #endif
@@ -152,6 +166,7 @@ bool MyTestApp::DoCalculation( ) {
     TestAssignmentOperatorsAndFunctions( );
     TestImageArithmeticFunctions( );
     TestFFTFunctions( );
+    TestConcurrentFFTs( );
     TestScalingAndSizingFunctions( );
     TestFilterFunctions( );
     TestAlignmentFunctions( );
@@ -161,16 +176,29 @@ bool MyTestApp::DoCalculation( ) {
     TestClipIntoFourier( );
     TestMaskCentralCross( );
     TestStarToBinaryFileConversion( );
+    TestMappedStarFileReader( );
     TestElectronExposureFilter( );
     TestDatabase( );
+    TestRefinementResultIndex( );
     TestEmpiricalDistribution( );
     TestEmpiricalDistributionThreadSafety( );
     TestSumOfSquaresFourierAndFFTNormalization( );
     TestRandomVariableFunctions( );
     TestIntegerShifts( );
     TestRunProfileDiskOperations( );
+    TestRequeueOfLostJobs( );
     TestCTFNodes( );
+    TestCTFImageRows( );
+    TestProfiler( );
+    TestProfilerInRefinementPrimitives( );
+    TestReconstruct3DDumpFiles( );
+    TestSharedReconstruction( );
+    TestReconstructionTreeReduction( );
     TestSpectrumImageMethods( );
+    TestUnblurDeformationModel( );
+    TestUnblurFrameStream( );
+    TestBatchOfMicrographs( );
+    TestWorkerCache( );
 #ifdef cisTEM_USING_LIBTORCH
     TestLibTorch( );
 #endif
@@ -503,6 +531,172 @@ void MyTestApp::TestDatabase( ) {
     EndTest( );
 }
 
+void MyTestApp::TestRefinementResultIndex( ) {
+    BeginTest("Refinement::ReturnResultIndexByClassAndPositionInStack");
+
+    const long number_of_particles = 1000;
+
+    Refinement refinement;
+    refinement.SizeAndFillWithEmpty(number_of_particles, 2);
+
+    // class 0 has the positions 1..number_of_particles shuffled, with one of them replaced by a duplicate, so it is looked up
+    // through a table. Class 1 has positions far apart, so it is looked up through a hash map.
+
+    for ( long particle_counter = 0; particle_counter < number_of_particles; particle_counter++ ) {
+        refinement.class_refinement_results[0].particle_refinement_results[particle_counter].position_in_stack = (particle_counter * 37) % number_of_particles + 1;
+        refinement.class_refinement_results[1].particle_refinement_results[particle_counter].position_in_stack = particle_counter * 100000 + 7;
+        refinement.class_refinement_results[0].particle_refinement_results[particle_counter].psi               = float(particle_counter);
+    }
+    refinement.class_refinement_results[0].particle_refinement_results[number_of_particles - 1].position_in_stack = refinement.class_refinement_results[0].particle_refinement_results[3].position_in_stack;
+
+    auto linear_search = [&](int wanted_class, long wanted_position_in_stack) -> long {
+        for ( long particle_counter = 0; particle_counter < number_of_particles; particle_counter++ ) {
+            if ( refinement.class_refinement_results[wanted_class].particle_refinement_results[particle_counter].position_in_stack == wanted_position_in_stack )
+                return particle_counter;
+        }
+        return -1;
+    };
+
+    auto index_matches_linear_search = [&]( ) -> bool {
+        for ( long position_in_stack = 0; position_in_stack <= number_of_particles + 2; position_in_stack++ ) {
+            if ( refinement.ReturnResultIndexByClassAndPositionInStack(0, position_in_stack) != linear_search(0, position_in_stack) )
+                return false;
+        }
+        for ( long particle_counter = 0; particle_counter < number_of_particles; particle_counter++ ) {
+            long position_in_stack = refinement.class_refinement_results[1].particle_refinement_results[particle_counter].position_in_stack;
+            if ( refinement.ReturnResultIndexByClassAndPositionInStack(1, position_in_stack) != linear_search(1, position_in_stack) )
+                return false;
+            if ( refinement.ReturnResultIndexByClassAndPositionInStack(1, position_in_stack + 1) != -1 )
+                return false;
+        }
+        return true;
+    };
+
+    if ( index_matches_linear_search( ) == false )
+        FailTest;
+
+    // the index must follow changes made to the results after it was built
+
+    std::swap(refinement.class_refinement_results[0].particle_refinement_results[10].position_in_stack, refinement.class_refinement_results[0].particle_refinement_results[20].position_in_stack);
+    refinement.class_refinement_results[1].particle_refinement_results[500].position_in_stack = 123;
+
+    if ( index_matches_linear_search( ) == false )
+        FailTest;
+
+    long position_in_stack = refinement.class_refinement_results[0].particle_refinement_results[20].position_in_stack;
+    if ( refinement.ReturnRefinementResultByClassAndPositionInStack(0, position_in_stack).psi != 20.0f )
+        FailTest;
+
+    EndTest( );
+}
+
+void MyTestApp::TestMappedStarFileReader( ) {
+    BeginTest("Mapped Star File Reader");
+
+    // A star file of several chunks (> 1 MB), with comment and blank lines, whose data block is ended by a blank line part way
+    // through. The memory mapped parser must give the same parameters as the wxTextFile one, for every kind of line break.
+    cisTEMParameters    test_parameters;
+    cisTEMParameterLine temp_line;
+    const int           number_of_lines       = 12000;
+    const int           last_line_before_end  = 9000;
+    const int           comment_line_interval = 997;
+
+    for ( int counter = 0; counter < number_of_lines; counter++ ) {
+        temp_line.position_in_stack = counter + 1;
+        temp_line.phi               = global_random_number_generator.GetUniformRandom( ) * 180;
+        temp_line.theta             = global_random_number_generator.GetUniformRandom( ) * 180;
+        temp_line.psi               = global_random_number_generator.GetUniformRandom( ) * 180;
+        temp_line.x_shift           = global_random_number_generator.GetUniformRandom( ) * 50;
+        temp_line.y_shift           = global_random_number_generator.GetUniformRandom( ) * 50;
+        temp_line.defocus_1         = global_random_number_generator.GetUniformRandom( ) * 30000;
+        temp_line.defocus_2         = global_random_number_generator.GetUniformRandom( ) * 30000;
+        temp_line.phase_shift       = global_random_number_generator.GetUniformRandom( ) * 3.14;
+        temp_line.image_is_active   = myroundint(global_random_number_generator.GetUniformRandom( ));
+        temp_line.stack_filename    = wxString::Format("stack_%i.mrc", counter % 17);
+        test_parameters.all_parameters.Add(temp_line);
+    }
+    test_parameters.parameters_to_write.SetAllToTrue( );
+
+    temp_directory = wxFileName::GetTempDir( );
+
+    wxString    written_star_filename = temp_directory + "/mapped_reader_written.star";
+    wxString    edited_star_filename  = temp_directory + "/mapped_reader_edited.star";
+    wxString    mapped_output         = temp_directory + "/mapped_reader_mapped.star";
+    wxString    line_by_line_output   = temp_directory + "/mapped_reader_line_by_line.star";
+    const char* line_breaks[3]        = {"\n", "\r\n", "\r"};
+
+    test_parameters.WriteTocisTEMStarFile(written_star_filename);
+
+    // Returns the written file from its second line on, which holds the time it was written
+    auto return_file_without_first_line = [](const wxString& wanted_filename) {
+        std::ifstream input_file(wanted_filename.ToStdString( ));
+        std::string   contents((std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>( ));
+        return contents.substr(contents.find('\n') + 1);
+    };
+
+    for ( const char* line_break : line_breaks ) {
+        {
+            std::ifstream written_file(written_star_filename.ToStdString( ));
+            std::ofstream edited_file(edited_star_filename.ToStdString( ), std::fstream::out | std::fstream::binary);
+            std::string   current_line;
+            bool          in_header = false;
+            bool          in_data   = false;
+            int           data_line = 0;
+
+            while ( std::getline(written_file, current_line) ) {
+                if ( current_line.find("loop_") != std::string::npos )
+                    in_header = true;
+                else if ( in_header && current_line.find('_') == 0 ) {
+                    // blank lines between the labels are skipped
+                    edited_file << current_line << line_break << line_break;
+                    continue;
+                }
+                else if ( in_header && ! current_line.empty( ) && current_line[0] != '#' ) {
+                    in_header = false;
+                    in_data   = true;
+                }
+
+                if ( in_data ) {
+                    if ( data_line % comment_line_interval == 0 )
+                        edited_file << "# a comment in the data block" << line_break;
+                    if ( data_line == last_line_before_end )
+                        edited_file << "   " << line_break;
+                    data_line++;
+                }
+                edited_file << current_line << line_break;
+            }
+        }
+
+        cisTEMStarFileReader mapped_reader;
+        cisTEMStarFileReader line_by_line_reader;
+        cisTEMParameters     mapped_parameters;
+        cisTEMParameters     line_by_line_parameters;
+
+        if ( mapped_reader.ReadMappedTextFile(edited_star_filename, NULL, &mapped_parameters.all_parameters) == false )
+            FailTest;
+        if ( line_by_line_reader.ReadTextFileLineByLine(edited_star_filename, NULL, &line_by_line_parameters.all_parameters) == false )
+            FailTest;
+
+        if ( mapped_parameters.ReturnNumberofLines( ) != last_line_before_end || line_by_line_parameters.ReturnNumberofLines( ) != last_line_before_end )
+            FailTest;
+
+        mapped_parameters.parameters_to_write.SetAllToTrue( );
+        line_by_line_parameters.parameters_to_write.SetAllToTrue( );
+        mapped_parameters.WriteTocisTEMStarFile(mapped_output);
+        line_by_line_parameters.WriteTocisTEMStarFile(line_by_line_output);
+
+        if ( return_file_without_first_line(mapped_output) != return_file_without_first_line(line_by_line_output) )
+            FailTest;
+    }
+
+    wxRemoveFile(written_star_filename);
+    wxRemoveFile(edited_star_filename);
+    wxRemoveFile(mapped_output);
+    wxRemoveFile(line_by_line_output);
+
+    EndTest( );
+}
+
 void MyTestApp::TestStarToBinaryFileConversion( ) {
     BeginTest("Star File To Binary Conversion");
     // generate set of 10k random parameters
@@ -620,6 +814,94 @@ void MyTestApp::TestStarToBinaryFileConversion( ) {
         }
     }
 
+    // the columnar file holds the same values as the binary file, so a star file written from it must be identical too..
+
+    wxString columnar_filename           = temp_directory + "/columnar_file.cistemc";
+    wxString star_from_columnar_filename = temp_directory + "/star_file_converted_from_columnar.star";
+
+    test_parameters.parameters_to_write.SetAllToTrue( );
+    test_parameters.WriteTocisTEMColumnarFile(columnar_filename);
+    test_parameters.ClearAll( );
+    test_parameters.ReadFromcisTEMStarFile(columnar_filename);
+    test_parameters.parameters_to_write.SetAllToTrue( );
+    test_parameters.WriteTocisTEMStarFile(star_from_columnar_filename.ToStdString( ).c_str( ));
+
+    if ( ReturnFileSizeInBytes(star_from_columnar_filename.ToStdString( ).c_str( )) != original_star_size_in_bytes )
+        FailTest;
+
+    char star_file_from_columnar_file[original_star_size_in_bytes];
+
+    current_file = fopen(star_from_columnar_filename.ToStdString( ).c_str( ), "rb");
+    fread(star_file_from_columnar_file, 1, original_star_size_in_bytes, current_file);
+    fclose(current_file);
+
+    reading_first_line = true;
+    for ( long byte_counter = 0; byte_counter < original_star_size_in_bytes; byte_counter++ ) {
+        if ( reading_first_line ) {
+            if ( original_star_file[byte_counter] == '\n' ) {
+                reading_first_line = false;
+            }
+        }
+        else {
+            if ( original_star_file[byte_counter] != star_file_from_columnar_file[byte_counter] ) {
+                std::cerr << "failed on byte" << byte_counter << std::endl;
+                FailTest;
+            }
+        }
+    }
+
+    // ..and the range and statistics of the reader must agree with the lines that were read
+
+    cisTEMColumnarParameterReader columnar_reader;
+    std::vector<long>             lines_in_range;
+
+    if ( columnar_reader.Open(columnar_filename) == false )
+        FailTest;
+    if ( columnar_reader.ReturnNumberOfLines( ) != test_parameters.ReturnNumberofLines( ) )
+        FailTest;
+
+    columnar_reader.ReturnLinesInPositionRange(10, 19, lines_in_range);
+    if ( lines_in_range.size( ) != 10 || columnar_reader.ReturnPositionInStackColumn( )[lines_in_range[0]] != 10 )
+        FailTest;
+
+    // the sums are taken in a different order, so only agreement to float precision is expected
+    if ( fabsf(columnar_reader.ReturnParameterAverages( ).defocus_1 - test_parameters.ReturnParameterAverages( ).defocus_1) > 0.0001f * fabsf(test_parameters.ReturnParameterAverages( ).defocus_1) )
+        FailTest;
+    if ( fabsf(columnar_reader.ReturnAverageSigma(true) - test_parameters.ReturnAverageSigma(true)) > 0.0001f * fabsf(test_parameters.ReturnAverageSigma(true)) )
+        FailTest;
+
+    // statistics stored in a binary file are read back exactly as they are calculated from the lines..
+
+    wxString                  binary_with_statistics_filename = temp_directory + "/binary_file_with_statistics.cistem";
+    cisTEMParameterStatistics calculated_statistics           = test_parameters.ReturnParameterStatistics( );
+
+    test_parameters.write_statistics_to_file = true;
+    test_parameters.parameters_to_write.SetAllToTrue( );
+    test_parameters.WriteTocisTEMBinaryFile(binary_with_statistics_filename);
+    test_parameters.ClearAll( );
+    test_parameters.ReadFromcisTEMBinaryFile(binary_with_statistics_filename);
+
+    if ( test_parameters.statistics_were_read == false || test_parameters.statistics_from_file.number_of_lines != calculated_statistics.number_of_lines )
+        FailTest;
+    if ( test_parameters.statistics_from_file.averages.defocus_1 != calculated_statistics.averages.defocus_1 || test_parameters.statistics_from_file.variances.score != calculated_statistics.variances.score )
+        FailTest;
+    if ( test_parameters.ReturnParameterStatistics( ).averages.sigma != calculated_statistics.averages.sigma )
+        FailTest;
+
+    // ..and the statistics of a parallel reduction agree with a plain sum to float precision
+
+    double sum_of_defocus_1 = 0.0;
+    long   number_active    = 0;
+    for ( long line_counter = 0; line_counter < test_parameters.ReturnNumberofLines( ); line_counter++ ) {
+        if ( test_parameters.ReturnImageIsActive(line_counter) >= 0 ) {
+            sum_of_defocus_1 += test_parameters.ReturnDefocus1(line_counter);
+            number_active++;
+        }
+    }
+
+    if ( number_active != calculated_statistics.number_of_lines || fabsf(calculated_statistics.averages.defocus_1 - float(sum_of_defocus_1 / number_active)) > 0.0001f * fabsf(calculated_statistics.averages.defocus_1) )
+        FailTest;
+
     EndTest( );
 }
 
@@ -1466,6 +1748,28 @@ void MyTestApp::TestAlignmentFunctions( ) {
     if ( FloatsAreAlmostTheSame(test_image.ReturnRealPixelFromPhysicalCoord(79, 79, 0), 0.239702) == false )
         FailTest;
 
+    // The stack version gives each image its own shift
+    Image stack_of_images[2];
+    float stack_x_shifts[2] = {20.0f, -3.5f};
+    float stack_y_shifts[2] = {20.0f, 7.25f};
+
+    stack_of_images[0].QuickAndDirtyReadSlice(hiv_images_80x80x10_filename.ToStdString( ), 1);
+    stack_of_images[1].QuickAndDirtyReadSlice(hiv_images_80x80x10_filename.ToStdString( ), 1);
+    ref_image.QuickAndDirtyReadSlice(hiv_images_80x80x10_filename.ToStdString( ), 1);
+    ref_image.PhaseShift(stack_x_shifts[1], stack_y_shifts[1]);
+
+    Image::PhaseShiftStack(stack_of_images, 2, stack_x_shifts, stack_y_shifts, 2);
+
+    // Only the logical pixels, not the padding of the rows
+    for ( int j = 0; j < test_image.logical_y_dimension; j++ ) {
+        for ( int i = 0; i < test_image.logical_x_dimension; i++ ) {
+            if ( FloatsAreAlmostTheSame(stack_of_images[0].ReturnRealPixelFromPhysicalCoord(i, j, 0), test_image.ReturnRealPixelFromPhysicalCoord(i, j, 0)) == false )
+                FailTest;
+            if ( FloatsAreAlmostTheSame(stack_of_images[1].ReturnRealPixelFromPhysicalCoord(i, j, 0), ref_image.ReturnRealPixelFromPhysicalCoord(i, j, 0)) == false )
+                FailTest;
+        }
+    }
+
     EndTest( );
 
     // SwapRealSpaceQuadrants
@@ -1992,6 +2296,58 @@ void MyTestApp::TestFFTFunctions( ) {
     EndTest( );
 }
 
+void MyTestApp::TestConcurrentFFTs( ) {
+    BeginTest("Concurrent FFTs");
+    CheckDependencies({"Image::ForwardFFT", "Image::BackwardFFT"});
+
+    // Images of the same size allocated and transformed by several threads at once share the cached FFTW plans, and must give
+    // the same transforms as one thread does
+    const int number_of_images = 16;
+
+    std::vector<Image> input_images(number_of_images);
+    std::vector<Image> serial_transforms(number_of_images);
+    std::vector<Image> concurrent_transforms(number_of_images);
+    std::vector<Image> concurrent_round_trips(number_of_images);
+
+    for ( int image_counter = 0; image_counter < number_of_images; image_counter++ ) {
+        input_images[image_counter].Allocate(96, 80, 1);
+        input_images[image_counter].SetToConstant(0.0f);
+        input_images[image_counter].AddGaussianNoise(1.0f);
+        serial_transforms[image_counter].CopyFrom(&input_images[image_counter]);
+        serial_transforms[image_counter].ForwardFFT( );
+    }
+
+    const long number_of_cached_plans = FFTWPlanCache::GetInstance( ).ReturnNumberOfCachedPlans( );
+
+#pragma omp parallel for schedule(static, 1) num_threads(4)
+    for ( int image_counter = 0; image_counter < number_of_images; image_counter++ ) {
+        concurrent_transforms[image_counter].CopyFrom(&input_images[image_counter]);
+        concurrent_transforms[image_counter].ForwardFFT( );
+        concurrent_round_trips[image_counter].CopyFrom(&concurrent_transforms[image_counter]);
+        concurrent_round_trips[image_counter].BackwardFFT( );
+    }
+
+    // The size was already planned by the serial transforms
+    if ( FFTWPlanCache::GetInstance( ).ReturnNumberOfCachedPlans( ) != number_of_cached_plans )
+        FailTest;
+
+    for ( int image_counter = 0; image_counter < number_of_images; image_counter++ ) {
+        for ( long pixel_counter = 0; pixel_counter < serial_transforms[image_counter].real_memory_allocated / 2; pixel_counter++ ) {
+            if ( std::abs(concurrent_transforms[image_counter].complex_values[pixel_counter] - serial_transforms[image_counter].complex_values[pixel_counter]) > 0.00001f )
+                FailTest;
+        }
+        for ( int j = 0; j < input_images[image_counter].logical_y_dimension; j++ ) {
+            for ( int i = 0; i < input_images[image_counter].logical_x_dimension; i++ ) {
+                long address = input_images[image_counter].ReturnReal1DAddressFromPhysicalCoord(i, j, 0);
+                if ( fabsf(concurrent_round_trips[image_counter].real_values[address] - input_images[image_counter].real_values[address]) > 0.0001f )
+                    FailTest;
+            }
+        }
+    }
+
+    EndTest( );
+}
+
 void MyTestApp::TestRunProfileDiskOperations( ) {
     BeginTest("RunProfileManager Disk Operations");
 
@@ -2052,6 +2408,57 @@ void MyTestApp::TestRunProfileDiskOperations( ) {
     EndTest( );
 }
 
+void MyTestApp::TestRequeueOfLostJobs( ) {
+    BeginTest("JobPackage::AddUnfinishedJobsToQueue");
+
+    JobPackage      job_package(RunProfile( ), "test", 8);
+    std::deque<int> jobs_to_requeue;
+
+    // a worker was lost while it had jobs 2, 3 and 4, and job 3 had already been reported as finished
+
+    std::deque<int> jobs_on_first_worker;
+    jobs_on_first_worker.push_back(2);
+    jobs_on_first_worker.push_back(3);
+    jobs_on_first_worker.push_back(4);
+    job_package.jobs[3].has_been_run = true;
+
+    if ( job_package.AddUnfinishedJobsToQueue(jobs_on_first_worker, jobs_to_requeue) != 2 )
+        FailTest;
+    if ( jobs_to_requeue.size( ) != 2 || jobs_to_requeue[0] != 2 || jobs_to_requeue[1] != 4 )
+        FailTest;
+
+    // the same loss reported a second time must not queue the jobs again
+
+    if ( job_package.AddUnfinishedJobsToQueue(jobs_on_first_worker, jobs_to_requeue) != 0 || jobs_to_requeue.size( ) != 2 )
+        FailTest;
+
+    // job 2 is sent out again and finished, job 4 is sent to a second worker together with a new job, and that worker is lost as well
+
+    jobs_to_requeue.pop_front( );
+    job_package.jobs[2].has_been_run = true;
+    jobs_to_requeue.pop_front( );
+
+    std::deque<int> jobs_on_second_worker;
+    jobs_on_second_worker.push_back(4);
+    jobs_on_second_worker.push_back(5);
+
+    if ( job_package.AddUnfinishedJobsToQueue(jobs_on_second_worker, jobs_to_requeue) != 2 )
+        FailTest;
+    if ( jobs_to_requeue.size( ) != 2 || jobs_to_requeue[0] != 4 || jobs_to_requeue[1] != 5 )
+        FailTest;
+
+    // a lost worker with only finished jobs leaves nothing to rerun
+
+    std::deque<int> jobs_on_third_worker;
+    jobs_on_third_worker.push_back(2);
+    jobs_on_third_worker.push_back(3);
+
+    if ( job_package.AddUnfinishedJobsToQueue(jobs_on_third_worker, jobs_to_requeue) != 0 || jobs_to_requeue.size( ) != 2 )
+        FailTest;
+
+    EndTest( );
+}
+
 void MyTestApp::TestCTFNodes( ) {
     BeginTest("CTF Nodes");
 
@@ -2123,6 +2530,399 @@ void MyTestApp::TestCTFNodes( ) {
     EndTest( );
 }
 
+void MyTestApp::TestCTFImageRows( ) {
+    BeginTest("Image::CalculateCTFImage");
+
+    // Astigmatic, with beam tilt and an odd box, compared with the CTF evaluated pixel by pixel at the azimuth
+    CTF ctf1(300, 2.7, 0.07, 12000, 11000, 35.0, 1.0, 0.0);
+    ctf1.SetBeamTilt(0.002f, -0.001f, 0.5f, 0.25f);
+
+    Image ctf_image;
+    Image beam_tilt_image;
+    ctf_image.Allocate(75, 64, false);
+    beam_tilt_image.Allocate(75, 64, false);
+
+    ctf_image.CalculateCTFImage(ctf1);
+    beam_tilt_image.CalculateBeamTiltImage(ctf1);
+
+    long  pixel_counter = 0;
+    float x_coord;
+    float y_coord;
+    float azimuth;
+    float frequency_squared;
+
+    for ( int j = 0; j <= ctf_image.physical_upper_bound_complex_y; j++ ) {
+        y_coord = ctf_image.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j) * ctf_image.fourier_voxel_size_y;
+        for ( int i = 0; i <= ctf_image.physical_upper_bound_complex_x; i++ ) {
+            x_coord           = i * ctf_image.fourier_voxel_size_x;
+            azimuth           = (i == 0 && j == 0) ? 0.0f : atan2f(y_coord, x_coord);
+            frequency_squared = powf(x_coord, 2) + powf(y_coord, 2);
+
+            if ( fabsf(real(ctf_image.complex_values[pixel_counter]) - ctf1.Evaluate(frequency_squared, azimuth)) > 0.001f )
+                FailTest;
+            if ( std::abs(beam_tilt_image.complex_values[pixel_counter] - ctf1.EvaluateBeamTiltPhaseShift(frequency_squared, azimuth)) > 0.001f )
+                FailTest;
+            pixel_counter++;
+        }
+    }
+
+    // Applying the CTF to an image of ones gives the CTF image
+    long  number_of_pixels = pixel_counter;
+    Image constant_image;
+    constant_image.Allocate(75, 64, false);
+    for ( pixel_counter = 0; pixel_counter < number_of_pixels; pixel_counter++ ) {
+        constant_image.complex_values[pixel_counter] = 1.0f + I * 0.0f;
+    }
+    constant_image.ApplyCTF(ctf1);
+
+    for ( pixel_counter = 0; pixel_counter < number_of_pixels; pixel_counter++ ) {
+        if ( std::abs(constant_image.complex_values[pixel_counter] - ctf_image.complex_values[pixel_counter]) > 0.0001f )
+            FailTest;
+    }
+
+    EndTest( );
+}
+
+void MyTestApp::TestProfiler( ) {
+    BeginTest("Profiler");
+
+    bool profiler_was_enabled = cistem_timer::Profiler::IsEnabled( );
+    cistem_timer::Profiler::Enable(true);
+    cistem_timer::Profiler::Reset( );
+
+    // Nested scopes, and an event timed elsewhere, which is recorded under the open scope
+    for ( int counter = 0; counter < 3; counter++ ) {
+        cistem_timer::ProfileScope outer_scope("test_outer");
+        {
+            cistem_timer::ProfileScope inner_scope("test_inner");
+        }
+        cistem_timer::Profiler::RecordCompletedEvent("test_event", 1000000);
+    }
+
+    // Every thread records into its own buffer
+#pragma omp parallel for num_threads(4)
+    for ( int counter = 0; counter < 400; counter++ ) {
+        cistem_timer::ProfileScope parallel_scope("test_parallel");
+    }
+
+    cistem_timer::ProfileSummary summary = cistem_timer::Profiler::ReturnSummary( );
+
+    if ( summary.statistics_per_path.size( ) != 4 )
+        FailTest;
+    if ( summary.statistics_per_path["test_outer"].number_of_calls != 3 )
+        FailTest;
+    if ( summary.statistics_per_path["test_outer/test_inner"].number_of_calls != 3 )
+        FailTest;
+    if ( summary.statistics_per_path["test_outer/test_event"].total_nanoseconds != 3000000 )
+        FailTest;
+    if ( summary.statistics_per_path["test_parallel"].number_of_calls != 400 )
+        FailTest;
+
+    // The summary survives the trip through a string, as it is sent from the workers to the master
+    cistem_timer::ProfileSummary received_summary;
+    if ( received_summary.SetFromString(summary.ReturnAsString( )) == false )
+        FailTest;
+    if ( received_summary.ReturnAsString( ) != summary.ReturnAsString( ) )
+        FailTest;
+
+    // Percentiles from the histogram are within a bin (< 25%) of the exact ones
+    cistem_timer::ProfileStatistics statistics;
+    for ( int counter = 1; counter <= 1000; counter++ ) {
+        statistics.AddDuration(uint64_t(counter) * 1000);
+    }
+    if ( fabs(statistics.ReturnPercentileInNanoseconds(50.0) - 500000.0) > 0.25 * 500000.0 )
+        FailTest;
+    if ( fabs(statistics.ReturnPercentileInNanoseconds(99.0) - 990000.0) > 0.25 * 990000.0 )
+        FailTest;
+    if ( statistics.ReturnPercentileInNanoseconds(100.0) != 1000000.0 )
+        FailTest;
+
+    temp_directory          = wxFileName::GetTempDir( );
+    wxString trace_filename = temp_directory + "/profile_trace.json";
+    if ( cistem_timer::Profiler::WriteChromeTrace(trace_filename) == false || wxFileExists(trace_filename) == false )
+        FailTest;
+    wxRemoveFile(trace_filename);
+
+    cistem_timer::Profiler::Reset( );
+    cistem_timer::Profiler::Enable(profiler_was_enabled);
+
+    EndTest( );
+}
+
+void MyTestApp::TestProfilerInRefinementPrimitives( ) {
+    BeginTest("Profiler in refinement primitives");
+
+    bool profiler_was_enabled = cistem_timer::Profiler::IsEnabled( );
+    cistem_timer::Profiler::Enable(true);
+    cistem_timer::Profiler::Reset( );
+
+    // The same calls that refine3d and reconstruct3d make inside DoCalculation must show up below it, not only as the top-level scope
+    wxString dump_filename = wxFileName::GetTempDir( ) + "/profiler_test_dump.dat";
+    {
+        cistem_timer::ProfileScope profile_scope("DoCalculation");
+
+        Reconstruct3D reconstruction(16, 16, 16, 1.0f, 1.0f, 1.0f, 1.0f, "C1");
+        reconstruction.DumpArrays(dump_filename, true);
+        reconstruction.AddArraysFromFile(dump_filename);
+
+        Image           volume;
+        Image           slice;
+        AnglesAndShifts angles(10.0f, 20.0f, 30.0f, 0.0f, 0.0f);
+        volume.Allocate(16, 16, 16);
+        volume.SetToConstant(1.0f);
+        volume.ForwardFFT(false);
+        volume.SwapRealSpaceQuadrants( );
+        slice.Allocate(16, 16, 1, false);
+        volume.ExtractSlice(slice, angles);
+    }
+    wxRemoveFile(dump_filename);
+
+    cistem_timer::ProfileSummary summary = cistem_timer::Profiler::ReturnSummary( );
+
+    if ( summary.statistics_per_path.size( ) <= 1 )
+        FailTest;
+    if ( summary.statistics_per_path["DoCalculation"].number_of_calls != 1 )
+        FailTest;
+    if ( summary.statistics_per_path["DoCalculation/DumpArrays"].number_of_calls != 1 )
+        FailTest;
+    if ( summary.statistics_per_path["DoCalculation/AddArraysFromFile"].number_of_calls != 1 )
+        FailTest;
+    if ( summary.statistics_per_path["DoCalculation/ExtractSlice"].number_of_calls != 1 )
+        FailTest;
+
+    cistem_timer::Profiler::Reset( );
+    cistem_timer::Profiler::Enable(profiler_was_enabled);
+
+    EndTest( );
+}
+
+void MyTestApp::TestReconstruct3DDumpFiles( ) {
+    BeginTest("Reconstruct3D dump files");
+
+    // Only the voxels within 5 Fourier pixels of the origin are set, so that the dump also has to leave out the rest
+    Reconstruct3D reconstruction(16, 16, 16, 1.5f, 0.5f, 0.25f, 0.125f, "C2");
+    reconstruction.images_processed = 7;
+    reconstruction.center_mass      = true;
+
+    long pixel_counter = 0;
+    for ( int k = 0; k <= reconstruction.image_reconstruction.physical_upper_bound_complex_z; k++ ) {
+        int logical_z = reconstruction.image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Z(k);
+        for ( int j = 0; j <= reconstruction.image_reconstruction.physical_upper_bound_complex_y; j++ ) {
+            int logical_y = reconstruction.image_reconstruction.ReturnFourierLogicalCoordGivenPhysicalCoord_Y(j);
+            for ( int i = 0; i <= reconstruction.image_reconstruction.physical_upper_bound_complex_x; i++ ) {
+                if ( i * i + logical_y * logical_y + logical_z * logical_z <= 25 ) {
+                    reconstruction.image_reconstruction.complex_values[pixel_counter] = std::complex<float>(float(pixel_counter % 7), -0.5f * float(pixel_counter % 5));
+                    reconstruction.ctf_reconstruction[pixel_counter]                  = 0.25f * float(pixel_counter % 3 + 1);
+                }
+                else {
+                    reconstruction.image_reconstruction.complex_values[pixel_counter] = 0.0f;
+                    reconstruction.ctf_reconstruction[pixel_counter]                  = 0.0f;
+                }
+                pixel_counter++;
+            }
+        }
+    }
+    const long number_of_voxels = pixel_counter;
+
+    auto arrays_are_equal = [&](Reconstruct3D& other_reconstruction) {
+        for ( long voxel_counter = 0; voxel_counter < number_of_voxels; voxel_counter++ ) {
+            if ( other_reconstruction.image_reconstruction.complex_values[voxel_counter] != reconstruction.image_reconstruction.complex_values[voxel_counter] )
+                return false;
+            if ( other_reconstruction.ctf_reconstruction[voxel_counter] != reconstruction.ctf_reconstruction[voxel_counter] )
+                return false;
+        }
+        return true;
+    };
+
+    wxString dump_filename[2] = {wxFileName::GetTempDir( ) + "/reconstruct3d_dump_raw.dat", wxFileName::GetTempDir( ) + "/reconstruct3d_dump_deflated.dat"};
+
+    int      logical_x_dimension, logical_y_dimension, logical_z_dimension;
+    int      original_x_dimension, original_y_dimension, original_z_dimension;
+    int      images_processed;
+    float    pixel_size, original_pixel_size, average_occupancy, average_score, score_weights_conversion;
+    wxString symmetry_symbol;
+    bool     insert_even, center_mass;
+
+    for ( int compress_arrays = 0; compress_arrays < 2; compress_arrays++ ) {
+        reconstruction.DumpArrays(dump_filename[compress_arrays], true, compress_arrays == 1);
+
+        Reconstruct3D read_reconstruction(16, 16, 16, 1.5f, 0.0f, 0.0f, 0.0f, "C1");
+        read_reconstruction.ReadArrayHeader(dump_filename[compress_arrays], logical_x_dimension, logical_y_dimension, logical_z_dimension, original_x_dimension, original_y_dimension, original_z_dimension,
+                                            images_processed, pixel_size, original_pixel_size, average_occupancy, average_score, score_weights_conversion, symmetry_symbol, insert_even, center_mass);
+        if ( logical_x_dimension != 16 || logical_y_dimension != 16 || logical_z_dimension != 16 || original_x_dimension != reconstruction.original_x_dimension )
+            FailTest;
+        if ( images_processed != 7 || pixel_size != 1.5f || original_pixel_size != reconstruction.original_pixel_size )
+            FailTest;
+        if ( average_occupancy != 0.5f || average_score != 0.25f || score_weights_conversion != 0.125f )
+            FailTest;
+        if ( symmetry_symbol.Trim( ) != "C2" || insert_even == false || center_mass == false )
+            FailTest;
+
+        read_reconstruction.ReadArrays(dump_filename[compress_arrays]);
+        if ( read_reconstruction.images_processed != 7 || ! arrays_are_equal(read_reconstruction) )
+            FailTest;
+    }
+
+    // The deflated chunks must actually be smaller
+    if ( wxFileName::GetSize(dump_filename[1]) >= wxFileName::GetSize(dump_filename[0]) )
+        FailTest;
+
+    // A version 1 dump, as written before the chunked format: no magic, the header, then the complete arrays
+    wxString legacy_filename = wxFileName::GetTempDir( ) + "/reconstruct3d_dump_v1.dat";
+    {
+        std::ofstream legacy_file(legacy_filename.ToStdString( ), std::fstream::out | std::fstream::binary);
+        int           header_ints[7]   = {16, 16, 16, reconstruction.original_x_dimension, reconstruction.original_y_dimension, reconstruction.original_z_dimension, 7};
+        float         header_floats[5] = {1.5f, reconstruction.original_pixel_size, 0.5f, 0.25f, 0.125f};
+        int           oddeven          = 2;
+        int           center           = 2;
+        legacy_file.write((char*)header_ints, sizeof(header_ints));
+        legacy_file.write((char*)header_floats, sizeof(header_floats));
+        legacy_file.write("C2  ", 4);
+        legacy_file.write((char*)&oddeven, sizeof(int));
+        legacy_file.write((char*)&center, sizeof(int));
+        legacy_file.write((char*)reconstruction.image_reconstruction.real_values, sizeof(float) * reconstruction.image_reconstruction.real_memory_allocated);
+        legacy_file.write((char*)reconstruction.ctf_reconstruction, sizeof(float) * reconstruction.image_reconstruction.real_memory_allocated / 2);
+    }
+
+    Reconstruct3D legacy_reconstruction(16, 16, 16, 1.5f, 0.0f, 0.0f, 0.0f, "C1");
+    legacy_reconstruction.ReadArrays(legacy_filename);
+    if ( legacy_reconstruction.images_processed != 7 || ! arrays_are_equal(legacy_reconstruction) )
+        FailTest;
+
+    // Truncated dumps of every kind are rejected rather than read past their end
+    wxString truncated_filename = wxFileName::GetTempDir( ) + "/reconstruct3d_dump_truncated.dat";
+    wxString filenames_to_truncate[3] = {dump_filename[0], dump_filename[1], legacy_filename};
+    for ( auto& filename_to_truncate : filenames_to_truncate ) {
+        std::ifstream     complete_file(filename_to_truncate.ToStdString( ), std::fstream::in | std::fstream::binary);
+        std::vector<char> file_bytes((std::istreambuf_iterator<char>(complete_file)), std::istreambuf_iterator<char>( ));
+        {
+            std::ofstream truncated_file(truncated_filename.ToStdString( ), std::fstream::out | std::fstream::binary);
+            truncated_file.write(file_bytes.data( ), file_bytes.size( ) - 16);
+        }
+
+        Reconstruct3D truncated_reconstruction(16, 16, 16, 1.5f, 0.0f, 0.0f, 0.0f, "C1");
+        if ( truncated_reconstruction.TryToAddArraysFromFile(truncated_filename) == true )
+            FailTest;
+    }
+
+    // So is a dump of a reconstruction of a different size
+    Reconstruct3D other_size_reconstruction(18, 18, 18, 1.5f, 0.0f, 0.0f, 0.0f, "C1");
+    if ( other_size_reconstruction.TryToAddArraysFromFile(dump_filename[1]) == true )
+        FailTest;
+
+    wxRemoveFile(dump_filename[0]);
+    wxRemoveFile(dump_filename[1]);
+    wxRemoveFile(legacy_filename);
+    wxRemoveFile(truncated_filename);
+
+    EndTest( );
+}
+
+void MyTestApp::TestSharedReconstruction( ) {
+    BeginTest("Reconstruct3D shared between threads");
+
+    // Values inserted by several threads into one shared reconstruction must add up to the same arrays as per-thread
+    // reconstructions that are summed afterwards, as reconstruct3d does without sharing. Positive and negative X coordinates
+    // are used, so that the Friedel mates are written too.
+    const int number_of_threads    = 4;
+    const int number_of_insertions = 4000;
+
+    std::vector<float>               x_coordinates(number_of_insertions);
+    std::vector<float>               y_coordinates(number_of_insertions);
+    std::vector<float>               z_coordinates(number_of_insertions);
+    std::vector<std::complex<float>> values(number_of_insertions);
+    std::vector<std::complex<float>> ctf_values(number_of_insertions);
+
+    for ( int insertion_counter = 0; insertion_counter < number_of_insertions; insertion_counter++ ) {
+        x_coordinates[insertion_counter] = 6.0f * global_random_number_generator.GetUniformRandom( );
+        y_coordinates[insertion_counter] = 6.0f * global_random_number_generator.GetUniformRandom( );
+        z_coordinates[insertion_counter] = 6.0f * global_random_number_generator.GetUniformRandom( );
+        values[insertion_counter]        = std::complex<float>(global_random_number_generator.GetUniformRandom( ), global_random_number_generator.GetUniformRandom( ));
+        ctf_values[insertion_counter]    = std::complex<float>(global_random_number_generator.GetUniformRandom( ), 0.0f);
+    }
+
+    Reconstruct3D shared_reconstruction(16, 16, 16, 1.0f, 1.0f, 1.0f, 1.0f, "C1");
+    Reconstruct3D summed_reconstruction(16, 16, 16, 1.0f, 1.0f, 1.0f, 1.0f, "C1");
+    shared_reconstruction.is_shared_between_threads = true;
+
+#pragma omp parallel for schedule(static) num_threads(number_of_threads)
+    for ( int insertion_counter = 0; insertion_counter < number_of_insertions; insertion_counter++ ) {
+        float               x_coordinate = x_coordinates[insertion_counter];
+        float               y_coordinate = y_coordinates[insertion_counter];
+        float               z_coordinate = z_coordinates[insertion_counter];
+        std::complex<float> value        = values[insertion_counter];
+        std::complex<float> ctf_value    = ctf_values[insertion_counter];
+        shared_reconstruction.AddByLinearInterpolation(x_coordinate, y_coordinate, z_coordinate, value, ctf_value, 1.0f);
+    }
+
+    // The same insertions, split between per-thread reconstructions as a static schedule would split them
+    const int insertions_per_thread = number_of_insertions / number_of_threads;
+    for ( int thread_counter = 0; thread_counter < number_of_threads; thread_counter++ ) {
+        Reconstruct3D thread_reconstruction(16, 16, 16, 1.0f, 1.0f, 1.0f, 1.0f, "C1");
+        for ( int insertion_counter = thread_counter * insertions_per_thread; insertion_counter < (thread_counter + 1) * insertions_per_thread; insertion_counter++ ) {
+            thread_reconstruction.AddByLinearInterpolation(x_coordinates[insertion_counter], y_coordinates[insertion_counter], z_coordinates[insertion_counter], values[insertion_counter], ctf_values[insertion_counter], 1.0f);
+        }
+        summed_reconstruction += thread_reconstruction;
+    }
+
+    // Only the order of the additions differs
+    for ( long voxel_counter = 0; voxel_counter < shared_reconstruction.image_reconstruction.real_memory_allocated / 2; voxel_counter++ ) {
+        if ( std::abs(shared_reconstruction.image_reconstruction.complex_values[voxel_counter] - summed_reconstruction.image_reconstruction.complex_values[voxel_counter]) > 0.001f )
+            FailTest;
+        if ( fabsf(shared_reconstruction.ctf_reconstruction[voxel_counter] - summed_reconstruction.ctf_reconstruction[voxel_counter]) > 0.001f )
+            FailTest;
+    }
+
+    EndTest( );
+}
+
+void MyTestApp::TestReconstructionTreeReduction( ) {
+    BeginTest("Reconstruct3D tree reduction");
+
+    // Partial sums added pairwise in a tree, as merge3d does with several threads, must give the sum of adding them one after the
+    // other. An odd number of partial sums leaves one without a partner at the first level.
+    const int number_of_partial_sums = 5;
+
+    Reconstruct3D               tree_sum(16, 16, 16, 1.0f, 1.0f, 1.0f, 1.0f, "C1");
+    Reconstruct3D               sequential_sum(16, 16, 16, 1.0f, 1.0f, 1.0f, 1.0f, "C1");
+    std::vector<Reconstruct3D*> partial_sums(number_of_partial_sums);
+    const long                  number_of_voxels = tree_sum.image_reconstruction.real_memory_allocated / 2;
+
+    partial_sums[0] = &tree_sum;
+    for ( int sum_counter = 1; sum_counter < number_of_partial_sums; sum_counter++ ) {
+        partial_sums[sum_counter] = new Reconstruct3D(16, 16, 16, 1.0f, 1.0f, 1.0f, 1.0f, "C1");
+    }
+
+    for ( int sum_counter = 0; sum_counter < number_of_partial_sums; sum_counter++ ) {
+        Reconstruct3D* partial_sum = partial_sums[sum_counter];
+        for ( long voxel_counter = 0; voxel_counter < number_of_voxels; voxel_counter++ ) {
+            partial_sum->image_reconstruction.complex_values[voxel_counter] = std::complex<float>(global_random_number_generator.GetUniformRandom( ), global_random_number_generator.GetUniformRandom( ));
+            partial_sum->ctf_reconstruction[voxel_counter]                  = 0.5f * (global_random_number_generator.GetUniformRandom( ) + 1.0f);
+        }
+        partial_sum->images_processed = 10 * (sum_counter + 1);
+        sequential_sum += partial_sum;
+    }
+
+    Reconstruct3D::AddPartialSumsInTree(partial_sums, 4);
+
+    for ( int sum_counter = 1; sum_counter < number_of_partial_sums; sum_counter++ ) {
+        if ( partial_sums[sum_counter] != NULL )
+            FailTest;
+    }
+    if ( tree_sum.images_processed != 150 )
+        FailTest;
+
+    // Only the order of the additions differs
+    for ( long voxel_counter = 0; voxel_counter < number_of_voxels; voxel_counter++ ) {
+        if ( std::abs(tree_sum.image_reconstruction.complex_values[voxel_counter] - sequential_sum.image_reconstruction.complex_values[voxel_counter]) > 0.0001f )
+            FailTest;
+        if ( fabsf(tree_sum.ctf_reconstruction[voxel_counter] - sequential_sum.ctf_reconstruction[voxel_counter]) > 0.0001f )
+            FailTest;
+    }
+
+    EndTest( );
+}
+
 void MyTestApp::TestSpectrumImageMethods( ) {
     BeginTest("Spectrum Image Methods");
     // FindRotationalAlignmentBetweenTwoStacksOfImages
@@ -2146,6 +2946,457 @@ void MyTestApp::TestSpectrumImageMethods( ) {
     }
 
     EndTest( );
+
+    BeginTest("SpectrumImage::ComputeTiledAmplitudeSpectrum");
+
+    // For white noise, the tiled spectrum must have the power of the spectrum of the whole image at every frequency
+    Image noise_image;
+    Image full_spectrum;
+    noise_image.Allocate(512, 512, 1);
+    noise_image.SetToConstant(0.0f);
+    noise_image.AddGaussianNoise(1.0f);
+
+    SpectrumImage tiled_spectrum;
+    SpectrumImage threaded_tiled_spectrum;
+    if ( tiled_spectrum.ComputeTiledAmplitudeSpectrum(&noise_image, 128, 1) != 49 )
+        FailTest;
+    if ( threaded_tiled_spectrum.ComputeTiledAmplitudeSpectrum(&noise_image, 128, 4) != 49 )
+        FailTest;
+
+    full_spectrum.Allocate(512, 512, 1);
+    noise_image.ForwardFFT(false);
+    noise_image.ComputeAmplitudeSpectrumFull2D(&full_spectrum);
+
+    // The radial averages of the powers, in fractions of the sampling frequency
+    Curve full_average;
+    Curve full_number_of_values;
+    Curve tiled_average;
+    Curve tiled_number_of_values;
+    full_average.SetupXAxis(0.0f, 0.5f, 11);
+    full_number_of_values.SetupXAxis(0.0f, 0.5f, 11);
+    tiled_average.SetupXAxis(0.0f, 0.5f, 11);
+    tiled_number_of_values.SetupXAxis(0.0f, 0.5f, 11);
+
+    Image tiled_power;
+    tiled_power.CopyFrom(&tiled_spectrum);
+    tiled_power.SquareRealValues( );
+    full_spectrum.SquareRealValues( );
+    tiled_power.Compute1DRotationalAverage(tiled_average, tiled_number_of_values, true);
+    full_spectrum.Compute1DRotationalAverage(full_average, full_number_of_values, true);
+
+    // Leave out the origin, which the tiles have removed, and the corners
+    for ( int counter = 2; counter < 10; counter++ ) {
+        if ( fabsf(tiled_average.data_y[counter] / full_average.data_y[counter] - 1.0f) > 0.1f )
+            FailTest;
+    }
+
+    // The number of threads only changes the order of the sums
+    for ( int j = 0; j < tiled_spectrum.logical_y_dimension; j++ ) {
+        for ( int i = 0; i < tiled_spectrum.logical_x_dimension; i++ ) {
+            long address = tiled_spectrum.ReturnReal1DAddressFromPhysicalCoord(i, j, 0);
+            if ( fabsf(tiled_spectrum.real_values[address] - threaded_tiled_spectrum.real_values[address]) > 0.0001f * fabsf(tiled_spectrum.real_values[address]) )
+                FailTest;
+        }
+    }
+
+    // A rectangular micrograph padded into a square, as ctffind does, must give the tiles of the micrograph alone. Only the
+    // scaling differs, which follows the number of pixels of the whole (padded) image
+    Image rectangular_image;
+    Image padded_image;
+    rectangular_image.Allocate(512, 320, 1);
+    rectangular_image.SetToConstant(0.0f);
+    rectangular_image.AddGaussianNoise(1.0f);
+    padded_image.Allocate(512, 512, 1);
+    rectangular_image.ClipIntoLargerRealSpace2D(&padded_image, rectangular_image.ReturnAverageOfRealValues( ));
+
+    SpectrumImage rectangular_spectrum;
+    SpectrumImage padded_spectrum;
+    if ( rectangular_spectrum.ComputeTiledAmplitudeSpectrum(&rectangular_image, 128, 1) != 28 )
+        FailTest;
+    if ( padded_spectrum.ComputeTiledAmplitudeSpectrum(&padded_image, 128, 4, 512, 320) != 28 )
+        FailTest;
+
+    const float padding_scale_factor = sqrtf(512.0f / 320.0f);
+    for ( int j = 0; j < rectangular_spectrum.logical_y_dimension; j++ ) {
+        for ( int i = 0; i < rectangular_spectrum.logical_x_dimension; i++ ) {
+            long address = rectangular_spectrum.ReturnReal1DAddressFromPhysicalCoord(i, j, 0);
+            if ( fabsf(rectangular_spectrum.real_values[address] * padding_scale_factor - padded_spectrum.real_values[address]) > 0.0001f * fabsf(padded_spectrum.real_values[address]) )
+                FailTest;
+        }
+    }
+
+    EndTest( );
+}
+
+void MyTestApp::TestUnblurDeformationModel( ) {
+    BeginTest("Unblur Deformation Model");
+
+    // Patch shifts generated from a known model, on a 4 x 4 grid of patches, must give back the same model
+    const int number_of_frames  = 12;
+    const int number_of_patches = 4;
+
+    double known_x_coefficients[UnblurDeformationModel::number_of_spatial_terms][UnblurDeformationModel::maximum_temporal_order];
+    double known_y_coefficients[UnblurDeformationModel::number_of_spatial_terms][UnblurDeformationModel::maximum_temporal_order];
+
+    for ( int spatial_term = 0; spatial_term < UnblurDeformationModel::number_of_spatial_terms; spatial_term++ ) {
+        for ( int temporal_order = 0; temporal_order < UnblurDeformationModel::maximum_temporal_order; temporal_order++ ) {
+            known_x_coefficients[spatial_term][temporal_order] = 0.5 * (spatial_term + 1) - 0.7 * temporal_order;
+            known_y_coefficients[spatial_term][temporal_order] = 0.3 * temporal_order - 0.2 * spatial_term + 0.1;
+        }
+    }
+
+    // The model at one frame, as in UnblurDeformationModel: time from the middle frame as a fraction of the movie, and no constant term in time
+    auto return_known_coefficients = [&](int frame_index, float* x_coefficients, float* y_coefficients) {
+        double time = double(frame_index - number_of_frames / 2) / double(number_of_frames);
+        for ( int spatial_term = 0; spatial_term < UnblurDeformationModel::number_of_spatial_terms; spatial_term++ ) {
+            x_coefficients[spatial_term] = 0.0f;
+            y_coefficients[spatial_term] = 0.0f;
+            for ( int temporal_order = 0; temporal_order < UnblurDeformationModel::maximum_temporal_order; temporal_order++ ) {
+                x_coefficients[spatial_term] += float(known_x_coefficients[spatial_term][temporal_order] * pow(time, temporal_order + 1));
+                y_coefficients[spatial_term] += float(known_y_coefficients[spatial_term][temporal_order] * pow(time, temporal_order + 1));
+            }
+        }
+    };
+
+    std::vector<float>              patch_x_coordinates;
+    std::vector<float>              patch_y_coordinates;
+    std::vector<std::vector<float>> patch_x_shifts;
+    std::vector<std::vector<float>> patch_y_shifts;
+    float                           x_coefficients[UnblurDeformationModel::number_of_spatial_terms];
+    float                           y_coefficients[UnblurDeformationModel::number_of_spatial_terms];
+
+    for ( int patch_y = 0; patch_y < number_of_patches; patch_y++ ) {
+        for ( int patch_x = 0; patch_x < number_of_patches; patch_x++ ) {
+            patch_x_coordinates.push_back((patch_x + 0.5f) / number_of_patches - 0.5f);
+            patch_y_coordinates.push_back((patch_y + 0.5f) / number_of_patches - 0.5f);
+            patch_x_shifts.push_back(std::vector<float>(number_of_frames));
+            patch_y_shifts.push_back(std::vector<float>(number_of_frames));
+        }
+    }
+
+    for ( int frame_counter = 0; frame_counter < number_of_frames; frame_counter++ ) {
+        return_known_coefficients(frame_counter, x_coefficients, y_coefficients);
+        for ( size_t patch_counter = 0; patch_counter < patch_x_coordinates.size( ); patch_counter++ ) {
+            patch_x_shifts[patch_counter][frame_counter] = UnblurDeformationModel::EvaluateSpatialPolynomial(x_coefficients, patch_x_coordinates[patch_counter], patch_y_coordinates[patch_counter]);
+            patch_y_shifts[patch_counter][frame_counter] = UnblurDeformationModel::EvaluateSpatialPolynomial(y_coefficients, patch_x_coordinates[patch_counter], patch_y_coordinates[patch_counter]);
+        }
+    }
+
+    UnblurDeformationModel deformation_model;
+    if ( deformation_model.FitToPatchShifts(patch_x_coordinates, patch_y_coordinates, patch_x_shifts, patch_y_shifts) == false )
+        FailTest;
+    if ( deformation_model.ReturnRMSDeviation( ) > 0.001f )
+        FailTest;
+
+    float known_x_coefficients_of_frame[UnblurDeformationModel::number_of_spatial_terms];
+    float known_y_coefficients_of_frame[UnblurDeformationModel::number_of_spatial_terms];
+
+    for ( int frame_counter = 0; frame_counter < number_of_frames; frame_counter++ ) {
+        deformation_model.ReturnSpatialCoefficients(frame_counter, x_coefficients, y_coefficients);
+        return_known_coefficients(frame_counter, known_x_coefficients_of_frame, known_y_coefficients_of_frame);
+        for ( int spatial_term = 0; spatial_term < UnblurDeformationModel::number_of_spatial_terms; spatial_term++ ) {
+            if ( fabsf(x_coefficients[spatial_term] - known_x_coefficients_of_frame[spatial_term]) > 0.001f )
+                FailTest;
+            if ( fabsf(y_coefficients[spatial_term] - known_y_coefficients_of_frame[spatial_term]) > 0.001f )
+                FailTest;
+        }
+    }
+
+    // A model fitted to zero shifts must leave the frames unchanged
+    for ( size_t patch_counter = 0; patch_counter < patch_x_coordinates.size( ); patch_counter++ ) {
+        std::fill(patch_x_shifts[patch_counter].begin( ), patch_x_shifts[patch_counter].end( ), 0.0f);
+        std::fill(patch_y_shifts[patch_counter].begin( ), patch_y_shifts[patch_counter].end( ), 0.0f);
+    }
+    if ( deformation_model.FitToPatchShifts(patch_x_coordinates, patch_y_coordinates, patch_x_shifts, patch_y_shifts) == false )
+        FailTest;
+
+    Image frame;
+    Image original_frame;
+    frame.Allocate(64, 48, 1);
+    frame.SetToConstant(0.0f);
+    frame.AddGaussianNoise(1.0f);
+    original_frame.CopyFrom(&frame);
+
+    frame.ForwardFFT( );
+    deformation_model.ResampleFrame(frame, 0);
+    if ( frame.is_in_real_space == true )
+        FailTest;
+    frame.BackwardFFT( );
+
+    for ( int j = 0; j < frame.logical_y_dimension; j++ ) {
+        for ( int i = 0; i < frame.logical_x_dimension; i++ ) {
+            long address = frame.ReturnReal1DAddressFromPhysicalCoord(i, j, 0);
+            if ( fabsf(frame.real_values[address] - original_frame.real_values[address]) > 0.0001f )
+                FailTest;
+        }
+    }
+
+    // A uniform drift, linear in time, moves the first frame by a whole number of pixels, (3, -2). The resampled frame must then
+    // match the frame moved by the same shift with RealSpaceIntegerShift and PhaseShift, which pins the sign and the units of the
+    // model. ResampleFrame repeats the edge pixels rather than wrapping around, so the comparison leaves out the edges.
+    const int   x_shift_of_first_frame = 3;
+    const int   y_shift_of_first_frame = -2;
+    const float time_of_first_frame    = float(0 - number_of_frames / 2) / float(number_of_frames);
+
+    for ( size_t patch_counter = 0; patch_counter < patch_x_coordinates.size( ); patch_counter++ ) {
+        for ( int frame_counter = 0; frame_counter < number_of_frames; frame_counter++ ) {
+            float time_of_frame                          = float(frame_counter - number_of_frames / 2) / float(number_of_frames);
+            patch_x_shifts[patch_counter][frame_counter] = x_shift_of_first_frame * time_of_frame / time_of_first_frame;
+            patch_y_shifts[patch_counter][frame_counter] = y_shift_of_first_frame * time_of_frame / time_of_first_frame;
+        }
+    }
+    if ( deformation_model.FitToPatchShifts(patch_x_coordinates, patch_y_coordinates, patch_x_shifts, patch_y_shifts) == false )
+        FailTest;
+
+    Image integer_shifted_frame;
+    Image phase_shifted_frame;
+    integer_shifted_frame.CopyFrom(&original_frame);
+    integer_shifted_frame.RealSpaceIntegerShift(x_shift_of_first_frame, y_shift_of_first_frame, 0);
+    phase_shifted_frame.CopyFrom(&original_frame);
+    phase_shifted_frame.PhaseShift(x_shift_of_first_frame, y_shift_of_first_frame, 0.0f);
+
+    frame.CopyFrom(&original_frame);
+    frame.ForwardFFT( );
+    deformation_model.ResampleFrame(frame, 0);
+    frame.BackwardFFT( );
+
+    const int edge_width = std::max(abs(x_shift_of_first_frame), abs(y_shift_of_first_frame)) + 2;
+    for ( int j = edge_width; j < frame.logical_y_dimension - edge_width; j++ ) {
+        for ( int i = edge_width; i < frame.logical_x_dimension - edge_width; i++ ) {
+            long address = frame.ReturnReal1DAddressFromPhysicalCoord(i, j, 0);
+            if ( fabsf(frame.real_values[address] - integer_shifted_frame.real_values[address]) > 0.001f )
+                FailTest;
+            if ( fabsf(frame.real_values[address] - phase_shifted_frame.real_values[address]) > 0.001f )
+                FailTest;
+        }
+    }
+
+    EndTest( );
+}
+
+void MyTestApp::TestUnblurFrameStream( ) {
+    BeginTest("Unblur Frame Stream");
+
+    // Shifting, weighting and summing the frames as they are streamed from disk on several threads, in the way unblur makes its final
+    // sum when it keeps only the binned frames, must give the same sum as doing it on the frames read one after the other
+
+    ImageFile input_file(hiv_images_80x80x10_filename.ToStdString( ), false);
+    const int number_of_frames = input_file.ReturnNumberOfSlices( );
+    const int first_frame      = 2;
+
+    auto process_frame = [](Image& frame, long frame_number) {
+        frame.ForwardFFT( );
+        frame.PhaseShift(0.7f * frame_number - 3.0f, 1.0f - 0.4f * frame_number);
+        frame.MultiplyByConstant(1.0f / float(frame_number));
+    };
+
+    Image frame;
+    Image in_memory_sum;
+    Image streamed_sum;
+
+    in_memory_sum.Allocate(input_file.ReturnXSize( ), input_file.ReturnYSize( ), false);
+    in_memory_sum.SetToConstant(0.0f);
+    streamed_sum.Allocate(input_file.ReturnXSize( ), input_file.ReturnYSize( ), false);
+    streamed_sum.SetToConstant(0.0f);
+
+    for ( long frame_number = first_frame; frame_number <= number_of_frames; frame_number++ ) {
+        frame.ReadSlice(&input_file, frame_number);
+        process_frame(frame, frame_number);
+        in_memory_sum.AddImage(&frame);
+    }
+
+    UnblurFrameOrder frame_order(first_frame);
+    std::vector<int> number_of_times_processed(number_of_frames + 1, 0);
+
+    StreamFramesFromFile(input_file, first_frame, number_of_frames, 4, [&](Image& streamed_frame, long frame_number) {
+        process_frame(streamed_frame, frame_number);
+
+        frame_order.WaitForTurnOf(frame_number);
+        streamed_sum.AddImage(&streamed_frame);
+        number_of_times_processed[frame_number]++;
+        frame_order.FinishTurn( );
+    });
+
+    for ( int frame_number = 1; frame_number <= number_of_frames; frame_number++ ) {
+        if ( number_of_times_processed[frame_number] != ((frame_number < first_frame) ? 0 : 1) )
+            FailTest;
+    }
+
+    for ( long pixel_counter = 0; pixel_counter < in_memory_sum.real_memory_allocated; pixel_counter++ ) {
+        if ( fabsf(streamed_sum.real_values[pixel_counter] - in_memory_sum.real_values[pixel_counter]) > 1e-5f * std::max(1.0f, fabsf(in_memory_sum.real_values[pixel_counter])) )
+            FailTest;
+    }
+
+    input_file.CloseFile( );
+
+    EndTest( );
+}
+
+void MyTestApp::TestBatchOfMicrographs( ) {
+    BeginTest("ReadBatchOfMicrographs");
+
+    wxString batch_directory = wxFileName::GetTempDir( ) + "/batch_of_micrographs_test";
+    wxFileName::Mkdir(batch_directory, 0777, wxPATH_MKDIR_FULL);
+
+    wxArrayString micrograph_filenames;
+
+    // A list, with a comment and blank lines
+    std::string list_filename = (batch_directory + "/micrographs.txt").ToStdString( );
+    {
+        std::ofstream list_file(list_filename);
+        list_file << "# micrographs\n"
+                  << "mic_1.mrc\n"
+                  << "\n"
+                  << "  mic_2.mrc  \n";
+    }
+    if ( InputIsABatchOfMicrographs(list_filename) == false )
+        FailTest;
+    if ( ReadBatchOfMicrographs(list_filename, micrograph_filenames) == false )
+        FailTest;
+    if ( micrograph_filenames.GetCount( ) != 2 || micrograph_filenames[0] != "mic_1.mrc" || micrograph_filenames[1] != "mic_2.mrc" )
+        FailTest;
+
+    // A RELION 3.1 star file, whose optics block comes before the loop with the micrographs
+    std::string star_filename = (batch_directory + "/micrographs.star").ToStdString( );
+    {
+        std::ofstream star_file(star_filename);
+        star_file << "\n# version 30001\n\ndata_optics\n\nloop_\n"
+                  << "_rlnOpticsGroupName #1\n"
+                  << "_rlnOpticsGroup #2\n"
+                  << "_rlnMicrographPixelSize #3\n"
+                  << "opticsGroup1 1 1.0\n"
+                  << "\n# version 30001\n\ndata_micrographs\n\nloop_\n"
+                  << "_rlnCtfImage #1\n"
+                  << "_rlnMicrographName #2\n"
+                  << "_rlnOpticsGroup #3\n"
+                  << "ctf_1.ctf MotionCorr/mic_1.mrc 1\n"
+                  << "ctf_2.ctf MotionCorr/mic_2.mrc 1\n"
+                  << "ctf_3.ctf MotionCorr/mic_3.mrc 1\n"
+                  << "\n";
+    }
+    if ( InputIsABatchOfMicrographs(star_filename) == false )
+        FailTest;
+    if ( ReadBatchOfMicrographs(star_filename, micrograph_filenames) == false )
+        FailTest;
+    if ( micrograph_filenames.GetCount( ) != 3 || micrograph_filenames[0] != "MotionCorr/mic_1.mrc" || micrograph_filenames[2] != "MotionCorr/mic_3.mrc" )
+        FailTest;
+
+    // A wildcard pattern, which only matches the micrographs, sorted
+    for ( int counter = 3; counter > 0; counter-- ) {
+        std::ofstream micrograph_file((batch_directory + wxString::Format("/mic_%i.mrc", counter)).ToStdString( ));
+    }
+    std::string pattern = (batch_directory + "/mic_*.mrc").ToStdString( );
+    if ( InputIsABatchOfMicrographs(pattern) == false )
+        FailTest;
+    if ( ReadBatchOfMicrographs(pattern, micrograph_filenames) == false )
+        FailTest;
+    if ( micrograph_filenames.GetCount( ) != 3 || wxFileName(micrograph_filenames[0]).GetFullName( ) != "mic_1.mrc" || wxFileName(micrograph_filenames[2]).GetFullName( ) != "mic_3.mrc" )
+        FailTest;
+
+    // A single micrograph is not a batch, and a pattern that matches nothing is an empty one
+    if ( InputIsABatchOfMicrographs((batch_directory + "/mic_1.mrc").ToStdString( )) == true )
+        FailTest;
+    if ( ReadBatchOfMicrographs((batch_directory + "/none_*.mrc").ToStdString( ), micrograph_filenames) == true )
+        FailTest;
+
+    for ( int counter = 1; counter <= 3; counter++ ) {
+        wxRemoveFile(batch_directory + wxString::Format("/mic_%i.mrc", counter));
+    }
+    wxRemoveFile(list_filename);
+    wxRemoveFile(star_filename);
+    wxRmdir(batch_directory);
+
+    EndTest( );
+
+    BeginTest("ReturnBatchOutputFilenames");
+
+    // Each micrograph gets an output named after it, without its directory and extension
+    std::vector<std::string> output_filenames;
+    std::string              duplicate_output_filename;
+    micrograph_filenames.Clear( );
+    micrograph_filenames.Add("MotionCorr/mic_1.mrc");
+    micrograph_filenames.Add("mic_2.tif");
+    if ( ReturnBatchOutputFilenames("ctf/diagnostic.mrc", micrograph_filenames, output_filenames, duplicate_output_filename) == false )
+        FailTest;
+    if ( output_filenames.size( ) != 2 || output_filenames[0] != "ctf/diagnostic_mic_1.mrc" || output_filenames[1] != "ctf/diagnostic_mic_2.mrc" || ! duplicate_output_filename.empty( ) )
+        FailTest;
+
+    // Micrographs of the same name in different directories, or with different extensions, would overwrite each other's outputs
+    micrograph_filenames.Add("Other/mic_1.tif");
+    if ( ReturnBatchOutputFilenames("ctf/diagnostic.mrc", micrograph_filenames, output_filenames, duplicate_output_filename) == true )
+        FailTest;
+    if ( duplicate_output_filename != "ctf/diagnostic_mic_1.mrc" )
+        FailTest;
+
+    EndTest( );
+}
+
+void MyTestApp::TestWorkerCache( ) {
+    BeginTest("WorkerCache");
+
+    WorkerCache& worker_cache       = WorkerCache::GetInstance( );
+    const bool   cache_was_enabled  = worker_cache.IsEnabled( );
+    wxString     reference_filename = wxFileName::GetTempDir( ) + "/worker_cache_test_reference.mrc";
+    const char*  reference_slot     = "console_test reference";
+
+    auto write_reference_file = [&](const char* contents) {
+        std::ofstream reference_file(reference_filename.ToStdString( ), std::fstream::out | std::fstream::binary);
+        reference_file << contents;
+    };
+
+    write_reference_file("first reference");
+
+    // Nothing is kept while the cache is disabled
+    worker_cache.Enable(false);
+    worker_cache.StoreObject(reference_slot, WorkerCache::ReturnFileKey(reference_filename), std::make_shared<int>(1));
+    if ( worker_cache.ReturnObject<int>(reference_slot, WorkerCache::ReturnFileKey(reference_filename)) )
+        FailTest;
+
+    // A later job asking for the same file gets the same object back, as long as it asks for the same type
+    worker_cache.Enable(true);
+    std::shared_ptr<int> stored_reference = std::make_shared<int>(2);
+    worker_cache.StoreObject(reference_slot, WorkerCache::ReturnFileKey(reference_filename), stored_reference);
+
+    long number_of_hits = worker_cache.ReturnNumberOfHits( );
+    if ( worker_cache.ReturnObject<int>(reference_slot, WorkerCache::ReturnFileKey(reference_filename)) != stored_reference )
+        FailTest;
+    if ( worker_cache.ReturnNumberOfHits( ) != number_of_hits + 1 )
+        FailTest;
+    if ( worker_cache.ReturnObject<float>(reference_slot, WorkerCache::ReturnFileKey(reference_filename)) )
+        FailTest;
+
+    // Rewriting the file, even with the same size, must invalidate the object. The modification time is moved on explicitly, as
+    // the file system may not resolve the time between the two writes.
+    wxString   key_before_rewrite = WorkerCache::ReturnFileKey(reference_filename);
+    wxDateTime modification_time;
+    wxFileName(reference_filename).GetTimes(NULL, &modification_time, NULL);
+    write_reference_file("other reference");
+    modification_time += wxTimeSpan::Seconds(10);
+    wxFileName(reference_filename).SetTimes(NULL, &modification_time, NULL);
+
+    if ( WorkerCache::ReturnFileKey(reference_filename) == key_before_rewrite )
+        FailTest;
+    if ( worker_cache.ReturnObject<int>(reference_slot, WorkerCache::ReturnFileKey(reference_filename)) )
+        FailTest;
+
+    // And so must a change of size
+    write_reference_file("a longer reference");
+    if ( worker_cache.ReturnObject<int>(reference_slot, WorkerCache::ReturnFileKey(reference_filename)) )
+        FailTest;
+
+    // Storing the new object replaces the old one in its slot
+    std::shared_ptr<int> new_reference = std::make_shared<int>(3);
+    worker_cache.StoreObject(reference_slot, WorkerCache::ReturnFileKey(reference_filename), new_reference);
+    if ( worker_cache.ReturnObject<int>(reference_slot, WorkerCache::ReturnFileKey(reference_filename)) != new_reference )
+        FailTest;
+    if ( worker_cache.ReturnObject<int>(reference_slot, key_before_rewrite) )
+        FailTest;
+
+    worker_cache.Clear( );
+    worker_cache.Enable(cache_was_enabled);
+    wxRemoveFile(reference_filename);
+
+    EndTest( );
 }
 
 #ifdef cisTEM_USING_LIBTORCH
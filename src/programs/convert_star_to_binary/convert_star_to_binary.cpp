@@ -18,7 +18,7 @@ void ConvertStarToBin::DoInteractiveUserInput( ) {
     UserInput* my_input = new UserInput("ConvertStarToBin", 1.0);
 
     std::string input_filename  = my_input->GetFilenameFromUser("Input cisTEM STAR file", "Filename of cisTEM STAR file to convert", "input.star", true);
-    std::string output_filename = my_input->GetFilenameFromUser("Output cisTEM binary file", "converted output in the cisTEM binary format", "output.cistem", false);
+    std::string output_filename = my_input->GetFilenameFromUser("Output cisTEM binary file", "converted output in the cisTEM binary format, or the columnar format if the extension is .cistemc", "output.cistem", false);
 
     delete my_input;
 
@@ -37,7 +37,10 @@ bool ConvertStarToBin::DoCalculation( ) {
     cisTEMParameters converted_params;
     converted_params.ReadFromcisTEMStarFile(input_filename);
     converted_params.parameters_to_write = converted_params.parameters_that_were_read;
-    converted_params.WriteTocisTEMBinaryFile(output_filename);
+    if ( cisTEMColumnarParameterReader::IsColumnarFile(output_filename) == true )
+        converted_params.WriteTocisTEMColumnarFile(output_filename);
+    else
+        converted_params.WriteTocisTEMBinaryFile(output_filename);
     wxPrintf("\n\n");
 
     return true;
@@ -64,6 +64,13 @@ class
     void AddCommandLineOptions( );
 
   private:
+    bool EstimateCTF(RunJob& current_job, JobResult& current_result, bool running_as_part_of_batch);
+    bool DoBatchCalculation( );
+    bool ArgumentsAreValid(RunJob& current_job);
+
+    // In batch mode, the gain and dark references are read once and shared by all micrographs
+    Image batch_gain_reference;
+    Image batch_dark_reference;
 };
 
 float PixelSizeForFitting(bool resample_if_pixel_too_small, float pixel_size_of_input_image, float target_pixel_size_after_resampling,
@@ -429,15 +436,33 @@ void CtffindApp::DoInteractiveUserInput( ) {
 
         UserInput* my_input = new UserInput("Ctffind", ctffind_version);
 
-        input_filename = my_input->GetFilenameFromUser("Input image file name", "Filename of input image", "input.mrc", true);
+        // A batch of micrographs may be a wildcard pattern, so its existence can only be checked once it has been expanded
+        input_filename = my_input->GetFilenameFromUser("Input image file name", "Filename of input image. To process many micrographs in one go, give a text file with one filename per line, a star file with a _rlnMicrographName column, or a wildcard pattern such as micrographs/*.mrc", "input.mrc", false);
+
+        // For a batch, the first micrograph stands in for all of them
+        std::string   first_input_filename = input_filename;
+        wxArrayString micrograph_filenames;
+        if ( InputIsABatchOfMicrographs(input_filename) ) {
+            if ( ! ReadBatchOfMicrographs(input_filename, micrograph_filenames) ) {
+                SendError(wxString::Format("Error: no micrographs found in %s", input_filename));
+                ExitMainLoop( );
+                return;
+            }
+            first_input_filename = micrograph_filenames[0].ToStdString( );
+        }
+        if ( ! wxFileName::FileExists(first_input_filename) ) {
+            SendError(wxString::Format("Error: input file %s does not exist", first_input_filename));
+            ExitMainLoop( );
+            return;
+        }
 
         ImageFile input_file;
-        if ( FilenameExtensionMatches(input_filename, "eer") ) {
+        if ( FilenameExtensionMatches(first_input_filename, "eer") ) {
             // If the input file is EER format, we will find out how many EER frames to average per image only later, so for now we have no way of knowing the logical Z dimension, but we know it's a movie
             input_is_a_movie = true;
         }
         else {
-            input_file.OpenFile(input_filename, false);
+            input_file.OpenFile(first_input_filename, false);
             if ( input_file.ReturnZSize( ) > 1 ) {
                 input_is_a_movie = my_input->GetYesNoFromUser("Input is a movie (stack of frames)", "Answer yes if the input file is a stack of frames from a dose-fractionated movie. If not, each image will be processed separately", "No");
             }
@@ -663,68 +688,213 @@ void CtffindApp::AddCommandLineOptions( ) {
     command_line_parser.AddLongSwitch("amplitude-spectrum-input", "The input image is an amplitude spectrum, not a real-space image");
     command_line_parser.AddLongSwitch("filtered-amplitude-spectrum-input", "The input image is filtered (background-subtracted) amplitude spectrum");
     command_line_parser.AddLongSwitch("fast", "Skip computation of fit statistics as well as spectrum contrast enhancement");
-    command_line_parser.AddOption("j", "", "Desired number of threads. Overrides interactive user input. Is overriden by env var OMP_NUM_THREADS", wxCMD_LINE_VAL_NUMBER);
+    command_line_parser.AddLongSwitch("tiled-spectrum", "Average the spectra of overlapping tiles of the size of the spectrum (computed in parallel), rather than computing the spectrum of the whole micrograph");
+    command_line_parser.AddOption("j", "", "Desired number of threads (in batch mode, the number of micrographs processed at a time). Overrides interactive user input", wxCMD_LINE_VAL_NUMBER);
     command_line_parser.AddLongSwitch("debug", "Write debug information to disk");
 }
 
 // override the do calculation method which will be what is actually run..
 
 bool CtffindApp::DoCalculation( ) {
+    const std::string input_filename   = my_current_job.arguments[0].ReturnStringArgument( );
+    const bool        old_school_input = command_line_parser.FoundSwitch("old-school-input") || command_line_parser.FoundSwitch("old-school-input-ctffind4");
+
+    if ( is_running_locally && ! old_school_input && InputIsABatchOfMicrographs(input_filename) ) {
+        return DoBatchCalculation( );
+    }
+    else {
+        return EstimateCTF(my_current_job, my_result, false);
+    }
+}
+
+// Checks the arguments that do not depend on the micrograph, so that a batch of micrographs only checks them once
+bool CtffindApp::ArgumentsAreValid(RunJob& current_job) {
+    const float minimum_resolution          = current_job.arguments[9].ReturnFloatArgument( );
+    const float maximum_resolution          = current_job.arguments[10].ReturnFloatArgument( );
+    const float minimum_defocus             = current_job.arguments[11].ReturnFloatArgument( );
+    const float maximum_defocus             = current_job.arguments[12].ReturnFloatArgument( );
+    const bool  find_additional_phase_shift = current_job.arguments[16].ReturnBoolArgument( );
+    const bool  determine_tilt              = current_job.arguments[36].ReturnBoolArgument( );
+
+    const bool amplitude_spectrum_input          = command_line_parser.FoundSwitch("amplitude-spectrum-input");
+    const bool filtered_amplitude_spectrum_input = command_line_parser.FoundSwitch("filtered-amplitude-spectrum-input");
+
+    if ( determine_tilt && find_additional_phase_shift ) {
+        SendError(wxString::Format("Error: Finding additional phase shift and determining sample tilt cannot be active at the same time. Terminating."));
+        ExitMainLoop( );
+        return false;
+    }
+    if ( determine_tilt && (amplitude_spectrum_input || filtered_amplitude_spectrum_input) ) {
+        SendError(wxString::Format("Error: Determining sample tilt cannot be run with either amplitude-spectrum-input or filtered-amplitude-spectrum-input. Terminating."));
+        DEBUG_ABORT; // THis applies to CLI not GUI
+    }
+    if ( minimum_resolution < maximum_resolution ) {
+        SendError(wxString::Format("Error: Minimum resolution (%f) higher than maximum resolution (%f). Terminating.", minimum_resolution, maximum_resolution));
+        ExitMainLoop( );
+        return false;
+    }
+    if ( minimum_defocus > maximum_defocus ) {
+        SendError(wxString::Format("Minimum defocus must be less than maximum defocus. Terminating."));
+        ExitMainLoop( );
+        return false;
+    }
+
+    return true;
+}
+
+// Estimate the CTF of every micrograph of a list in this process, several micrographs at a time. Each micrograph gets
+// the same outputs as when it is processed on its own, named after the given diagnostic filename with the name of the micrograph added.
+bool CtffindApp::DoBatchCalculation( ) {
+    const std::string input_filename             = my_current_job.arguments[0].ReturnStringArgument( );
+    const bool        input_is_a_movie           = my_current_job.arguments[1].ReturnBoolArgument( );
+    const std::string output_diagnostic_filename = my_current_job.arguments[3].ReturnStringArgument( );
+    const bool        movie_is_gain_corrected    = my_current_job.arguments[24].ReturnBoolArgument( );
+    const wxString    gain_filename              = my_current_job.arguments[25].ReturnStringArgument( );
+    const bool        movie_is_dark_corrected    = my_current_job.arguments[26].ReturnBoolArgument( );
+    const wxString    dark_filename              = my_current_job.arguments[27].ReturnStringArgument( );
+    int               number_of_threads          = my_current_job.arguments[37].ReturnIntegerArgument( );
+
+    long command_line_desired_number_of_threads;
+    if ( command_line_parser.Found("j", &command_line_desired_number_of_threads) ) {
+        number_of_threads = command_line_desired_number_of_threads;
+    }
+
+    wxArrayString micrograph_filenames;
+    if ( ! ReadBatchOfMicrographs(input_filename, micrograph_filenames) ) {
+        SendError(wxString::Format("Error: no micrographs found in %s. Terminating.", input_filename));
+        ExitMainLoop( );
+        return false;
+    }
+
+    const int number_of_micrographs = micrograph_filenames.GetCount( );
+
+    // Every micrograph gets its own diagnostic image, and with it its own summary and avrot files
+    std::vector<std::string> diagnostic_filenames;
+    std::string              duplicate_diagnostic_filename;
+    if ( ! ReturnBatchOutputFilenames(output_diagnostic_filename, micrograph_filenames, diagnostic_filenames, duplicate_diagnostic_filename) ) {
+        SendError(wxString::Format("Error: more than one micrograph would be written to %s, please give micrographs unique names. Terminating.", duplicate_diagnostic_filename));
+        ExitMainLoop( );
+        return false;
+    }
+
+    // The arguments are the same for every micrograph, so they are checked once rather than by every thread
+    if ( ! ArgumentsAreValid(my_current_job) ) {
+        return false;
+    }
+
+    // Read the references once, rather than once per micrograph
+    ImageFile reference_file;
+    if ( input_is_a_movie && ! movie_is_gain_corrected ) {
+        reference_file.OpenFile(gain_filename.ToStdString( ), false);
+        batch_gain_reference.ReadSlice(&reference_file, 1);
+        reference_file.CloseFile( );
+    }
+    if ( input_is_a_movie && ! movie_is_dark_corrected ) {
+        reference_file.OpenFile(dark_filename.ToStdString( ), false);
+        batch_dark_reference.ReadSlice(&reference_file, 1);
+        reference_file.CloseFile( );
+    }
+
+    // Each micrograph is processed by a single thread. FFT plans and CTF frequency grids are cached for the whole process,
+    // so that they are only made for the first micrograph of each size.
+    number_of_threads = CheckNumberOfThreads(std::max(1, std::min(number_of_threads, number_of_micrographs)));
+
+    wxPrintf("\nWill estimate the CTF parameters for %i micrographs, %i at a time.\n\n", number_of_micrographs, number_of_threads);
+
+    int number_of_micrographs_done = 0;
+
+#pragma omp parallel for schedule(dynamic) num_threads(number_of_threads)
+    for ( int micrograph_counter = 0; micrograph_counter < number_of_micrographs; micrograph_counter++ ) {
+        RunJob    micrograph_job;
+        JobResult micrograph_result;
+
+        micrograph_job = my_current_job;
+        micrograph_job.arguments[0].SetStringArgument(micrograph_filenames[micrograph_counter].ToStdString( ).c_str( ));
+        micrograph_job.arguments[3].SetStringArgument(diagnostic_filenames[micrograph_counter].c_str( ));
+        micrograph_job.arguments[37].SetIntArgument(1);
+
+        EstimateCTF(micrograph_job, micrograph_result, true);
+
+#pragma omp critical(ctffind_batch_output)
+        {
+            number_of_micrographs_done++;
+            if ( micrograph_result.result_size > 4 ) {
+                wxPrintf("%5i of %i : %s : defocus %0.2f , %0.2f A ; azimuth %0.2f deg ; score %0.5f ; fit to %0.1f A\n", number_of_micrographs_done, number_of_micrographs, micrograph_filenames[micrograph_counter],
+                         micrograph_result.result_data[0], micrograph_result.result_data[1], micrograph_result.result_data[2], micrograph_result.result_data[4], micrograph_result.result_data[5]);
+            }
+        }
+    }
+
+    wxPrintf("\n\nSummary of results  : %s\n", FilenameReplaceExtension(FilenameAddSuffix(output_diagnostic_filename, "_*"), "txt"));
+    wxPrintf("Diagnostic images   : %s\n\n\n", FilenameAddSuffix(output_diagnostic_filename, "_*"));
+
+    batch_gain_reference.Deallocate( );
+    batch_dark_reference.Deallocate( );
+
+    return true;
+}
+
+bool CtffindApp::EstimateCTF(RunJob& current_job, JobResult& current_result, bool running_as_part_of_batch) {
 
     cistem_timer::StopWatch ctffind_timing;
     ctffind_timing.start("Initialization");
     StopWatch profile_timing;
     // Arguments for this job
 
-    const std::string input_filename                     = my_current_job.arguments[0].ReturnStringArgument( );
-    const bool        input_is_a_movie                   = my_current_job.arguments[1].ReturnBoolArgument( );
-    const int         number_of_frames_to_average        = my_current_job.arguments[2].ReturnIntegerArgument( );
-    const std::string output_diagnostic_filename         = my_current_job.arguments[3].ReturnStringArgument( );
-    float             pixel_size_of_input_image          = my_current_job.arguments[4].ReturnFloatArgument( ); // no longer const, as the mag distortion can change it.
-    const float       acceleration_voltage               = my_current_job.arguments[5].ReturnFloatArgument( );
-    const float       spherical_aberration               = my_current_job.arguments[6].ReturnFloatArgument( );
-    const float       amplitude_contrast                 = my_current_job.arguments[7].ReturnFloatArgument( );
-    const int         box_size                           = my_current_job.arguments[8].ReturnIntegerArgument( );
-    const float       minimum_resolution                 = my_current_job.arguments[9].ReturnFloatArgument( );
-    const float       maximum_resolution                 = my_current_job.arguments[10].ReturnFloatArgument( );
-    const float       minimum_defocus                    = my_current_job.arguments[11].ReturnFloatArgument( );
-    const float       maximum_defocus                    = my_current_job.arguments[12].ReturnFloatArgument( );
-    const float       defocus_search_step                = my_current_job.arguments[13].ReturnFloatArgument( );
-    const bool        slower_search                      = my_current_job.arguments[14].ReturnBoolArgument( );
-    const float       astigmatism_tolerance              = my_current_job.arguments[15].ReturnFloatArgument( );
-    const bool        find_additional_phase_shift        = my_current_job.arguments[16].ReturnBoolArgument( );
-    const float       minimum_additional_phase_shift     = my_current_job.arguments[17].ReturnFloatArgument( );
-    const float       maximum_additional_phase_shift     = my_current_job.arguments[18].ReturnFloatArgument( );
-    const float       additional_phase_shift_search_step = my_current_job.arguments[19].ReturnFloatArgument( );
-    const bool        astigmatism_is_known               = my_current_job.arguments[20].ReturnBoolArgument( );
-    const float       known_astigmatism                  = my_current_job.arguments[21].ReturnFloatArgument( );
-    const float       known_astigmatism_angle            = my_current_job.arguments[22].ReturnFloatArgument( );
-    const bool        resample_if_pixel_too_small        = my_current_job.arguments[23].ReturnBoolArgument( );
-    const bool        movie_is_gain_corrected            = my_current_job.arguments[24].ReturnBoolArgument( );
-    const wxString    gain_filename                      = my_current_job.arguments[25].ReturnStringArgument( );
-    const bool        movie_is_dark_corrected            = my_current_job.arguments[26].ReturnBoolArgument( );
-    const wxString    dark_filename                      = my_current_job.arguments[27].ReturnStringArgument( );
-    const bool        correct_movie_mag_distortion       = my_current_job.arguments[28].ReturnBoolArgument( );
-    const float       movie_mag_distortion_angle         = my_current_job.arguments[29].ReturnFloatArgument( );
-    const float       movie_mag_distortion_major_scale   = my_current_job.arguments[30].ReturnFloatArgument( );
-    const float       movie_mag_distortion_minor_scale   = my_current_job.arguments[31].ReturnFloatArgument( );
-    const bool        defocus_is_known                   = my_current_job.arguments[32].ReturnBoolArgument( );
-    const float       known_defocus_1                    = my_current_job.arguments[33].ReturnFloatArgument( );
-    const float       known_defocus_2                    = my_current_job.arguments[34].ReturnFloatArgument( );
-    const float       known_phase_shift                  = my_current_job.arguments[35].ReturnFloatArgument( );
-    const bool        determine_tilt                     = my_current_job.arguments[36].ReturnBoolArgument( );
-    int               desired_number_of_threads          = my_current_job.arguments[37].ReturnIntegerArgument( );
-    int               eer_frames_per_image               = my_current_job.arguments[38].ReturnIntegerArgument( );
-    int               eer_super_res_factor               = my_current_job.arguments[39].ReturnIntegerArgument( );
-    bool              filter_lowres_signal               = my_current_job.arguments[40].ReturnBoolArgument( );
-    bool              fit_nodes                          = my_current_job.arguments[41].ReturnBoolArgument( );
-    bool              fit_nodes_1D_brute_force           = my_current_job.arguments[42].ReturnBoolArgument( );
-    bool              fit_nodes_2D_refine                = my_current_job.arguments[43].ReturnBoolArgument( );
-    float             fit_nodes_low_resolution_limit     = my_current_job.arguments[44].ReturnFloatArgument( );
-    float             fit_nodes_high_resolution_limit    = my_current_job.arguments[45].ReturnFloatArgument( );
-    float             target_pixel_size_after_resampling = my_current_job.arguments[46].ReturnFloatArgument( );
-    bool              fit_nodes_use_rounded_square       = my_current_job.arguments[47].ReturnBoolArgument( );
-    bool              fit_nodes_downweight_nodes         = my_current_job.arguments[48].ReturnBoolArgument( );
+    const std::string input_filename                     = current_job.arguments[0].ReturnStringArgument( );
+    const bool        input_is_a_movie                   = current_job.arguments[1].ReturnBoolArgument( );
+    const int         number_of_frames_to_average        = current_job.arguments[2].ReturnIntegerArgument( );
+    const std::string output_diagnostic_filename         = current_job.arguments[3].ReturnStringArgument( );
+    float             pixel_size_of_input_image          = current_job.arguments[4].ReturnFloatArgument( ); // no longer const, as the mag distortion can change it.
+    const float       acceleration_voltage               = current_job.arguments[5].ReturnFloatArgument( );
+    const float       spherical_aberration               = current_job.arguments[6].ReturnFloatArgument( );
+    const float       amplitude_contrast                 = current_job.arguments[7].ReturnFloatArgument( );
+    const int         box_size                           = current_job.arguments[8].ReturnIntegerArgument( );
+    const float       minimum_resolution                 = current_job.arguments[9].ReturnFloatArgument( );
+    const float       maximum_resolution                 = current_job.arguments[10].ReturnFloatArgument( );
+    const float       minimum_defocus                    = current_job.arguments[11].ReturnFloatArgument( );
+    const float       maximum_defocus                    = current_job.arguments[12].ReturnFloatArgument( );
+    const float       defocus_search_step                = current_job.arguments[13].ReturnFloatArgument( );
+    const bool        slower_search                      = current_job.arguments[14].ReturnBoolArgument( );
+    const float       astigmatism_tolerance              = current_job.arguments[15].ReturnFloatArgument( );
+    const bool        find_additional_phase_shift        = current_job.arguments[16].ReturnBoolArgument( );
+    const float       minimum_additional_phase_shift     = current_job.arguments[17].ReturnFloatArgument( );
+    const float       maximum_additional_phase_shift     = current_job.arguments[18].ReturnFloatArgument( );
+    const float       additional_phase_shift_search_step = current_job.arguments[19].ReturnFloatArgument( );
+    const bool        astigmatism_is_known               = current_job.arguments[20].ReturnBoolArgument( );
+    const float       known_astigmatism                  = current_job.arguments[21].ReturnFloatArgument( );
+    const float       known_astigmatism_angle            = current_job.arguments[22].ReturnFloatArgument( );
+    const bool        resample_if_pixel_too_small        = current_job.arguments[23].ReturnBoolArgument( );
+    const bool        movie_is_gain_corrected            = current_job.arguments[24].ReturnBoolArgument( );
+    const wxString    gain_filename                      = current_job.arguments[25].ReturnStringArgument( );
+    const bool        movie_is_dark_corrected            = current_job.arguments[26].ReturnBoolArgument( );
+    const wxString    dark_filename                      = current_job.arguments[27].ReturnStringArgument( );
+    const bool        correct_movie_mag_distortion       = current_job.arguments[28].ReturnBoolArgument( );
+    const float       movie_mag_distortion_angle         = current_job.arguments[29].ReturnFloatArgument( );
+    const float       movie_mag_distortion_major_scale   = current_job.arguments[30].ReturnFloatArgument( );
+    const float       movie_mag_distortion_minor_scale   = current_job.arguments[31].ReturnFloatArgument( );
+    const bool        defocus_is_known                   = current_job.arguments[32].ReturnBoolArgument( );
+    const float       known_defocus_1                    = current_job.arguments[33].ReturnFloatArgument( );
+    const float       known_defocus_2                    = current_job.arguments[34].ReturnFloatArgument( );
+    const float       known_phase_shift                  = current_job.arguments[35].ReturnFloatArgument( );
+    const bool        determine_tilt                     = current_job.arguments[36].ReturnBoolArgument( );
+    int               desired_number_of_threads          = current_job.arguments[37].ReturnIntegerArgument( );
+    int               eer_frames_per_image               = current_job.arguments[38].ReturnIntegerArgument( );
+    int               eer_super_res_factor               = current_job.arguments[39].ReturnIntegerArgument( );
+    bool              filter_lowres_signal               = current_job.arguments[40].ReturnBoolArgument( );
+    bool              fit_nodes                          = current_job.arguments[41].ReturnBoolArgument( );
+    bool              fit_nodes_1D_brute_force           = current_job.arguments[42].ReturnBoolArgument( );
+    bool              fit_nodes_2D_refine                = current_job.arguments[43].ReturnBoolArgument( );
+    float             fit_nodes_low_resolution_limit     = current_job.arguments[44].ReturnFloatArgument( );
+    float             fit_nodes_high_resolution_limit    = current_job.arguments[45].ReturnFloatArgument( );
+    float             target_pixel_size_after_resampling = current_job.arguments[46].ReturnFloatArgument( );
+    bool              fit_nodes_use_rounded_square       = current_job.arguments[47].ReturnBoolArgument( );
+    bool              fit_nodes_downweight_nodes         = current_job.arguments[48].ReturnBoolArgument( );
+
+    // In a batch, the arguments have already been checked by DoBatchCalculation
+    if ( ! running_as_part_of_batch && ! ArgumentsAreValid(current_job) ) {
+        return false;
+    }
 
     // if we are applying a mag distortion, it can change the pixel size, so do that here to make sure it is used forever onwards..
 
@@ -738,12 +908,16 @@ bool CtffindApp::DoCalculation( ) {
     const bool filtered_amplitude_spectrum_input = command_line_parser.FoundSwitch("filtered-amplitude-spectrum-input");
     const bool compute_extra_stats               = ! command_line_parser.FoundSwitch("fast");
     const bool boost_ring_contrast               = ! command_line_parser.FoundSwitch("fast");
+    const bool compute_tiled_spectrum            = command_line_parser.FoundSwitch("tiled-spectrum");
     long       command_line_desired_number_of_threads;
-    if ( command_line_parser.Found("j", &command_line_desired_number_of_threads) ) {
+    if ( ! running_as_part_of_batch && command_line_parser.Found("j", &command_line_desired_number_of_threads) ) {
         // Command-line argument overrides
         desired_number_of_threads = command_line_desired_number_of_threads;
     }
 
+    // In batch mode, micrographs are processed concurrently, so only their result lines are printed (by DoBatchCalculation)
+    const bool print_to_terminal = is_running_locally && ! running_as_part_of_batch;
+
     // Resampling of input images to ensure that the pixel size isn't too small
     if ( target_pixel_size_after_resampling <= 0.0 ) {
         target_pixel_size_after_resampling = 1.4f;
@@ -791,6 +965,8 @@ bool CtffindApp::DoCalculation( ) {
     Image*           current_input_image        = new Image( );
     Image*           current_input_image_square = new Image( );
     int              micrograph_square_dimension;
+    int              micrograph_x_dimension_before_squaring;
+    int              micrograph_y_dimension_before_squaring;
     Image*           temp_image               = new Image( );
     Image*           sum_image                = new Image( );
     Image*           resampled_power_spectrum = new Image( );
@@ -843,28 +1019,10 @@ bool CtffindApp::DoCalculation( ) {
     if ( ! input_file_is_valid ) {
         SendInfo(wxString::Format("Input movie %s seems to be corrupt. Ctffind results may not be meaningful.\n", input_filename));
     }
-    else {
+    else if ( print_to_terminal ) {
         wxPrintf("Input file looks OK, proceeding\n");
     }
 
-    // Some argument checking
-    if ( determine_tilt && find_additional_phase_shift ) {
-        SendError(wxString::Format("Error: Finding additional phase shift and determining sample tilt cannot be active at the same time. Terminating."));
-        ExitMainLoop( );
-    }
-    if ( determine_tilt && (amplitude_spectrum_input || filtered_amplitude_spectrum_input) ) {
-        SendError(wxString::Format("Error: Determining sample tilt cannot be run with either amplitude-spectrum-input or filtered-amplitude-spectrum-input. Terminating."));
-        DEBUG_ABORT; // THis applies to CLI not GUI
-    }
-    if ( minimum_resolution < maximum_resolution ) {
-        SendError(wxString::Format("Error: Minimum resolution (%f) higher than maximum resolution (%f). Terminating.", minimum_resolution, maximum_resolution));
-        ExitMainLoop( );
-    }
-    if ( minimum_defocus > maximum_defocus ) {
-        SendError(wxString::Format("Minimum defocus must be less than maximum defocus. Terminating."));
-        ExitMainLoop( );
-    }
-
     // How many micrographs are we dealing with
     if ( input_is_a_movie ) {
         // We only support 1 movie per file
@@ -876,7 +1034,7 @@ bool CtffindApp::DoCalculation( ) {
         number_of_micrographs  = input_file.ReturnZSize( );
     }
 
-    if ( is_running_locally ) {
+    if ( print_to_terminal ) {
         // Print out information about input file
         input_file.PrintInfo( );
     }
@@ -898,7 +1056,7 @@ bool CtffindApp::DoCalculation( ) {
     // Prepare a text file with 1D rotational average spectra
     output_text_fn = FilenameAddSuffix(output_text_fn.ToStdString( ), "_avrot");
 
-    if ( ! old_school_input && number_of_micrographs > 1 && is_running_locally ) {
+    if ( ! old_school_input && number_of_micrographs > 1 && print_to_terminal ) {
         wxPrintf("Will estimate the CTF parameters for %i micrographs.\n", number_of_micrographs);
         wxPrintf("Results will be written to this file: %s\n", output_text->ReturnFilename( ));
         wxPrintf("\nEstimating CTF parameters...\n\n");
@@ -911,24 +1069,44 @@ bool CtffindApp::DoCalculation( ) {
     // Prepare the dark/gain_reference
     if ( input_is_a_movie && ! movie_is_gain_corrected ) {
         profile_timing.start("Read gain reference");
-        gain_file.OpenFile(gain_filename.ToStdString( ), false);
-        gain->ReadSlice(&gain_file, 1);
+        if ( running_as_part_of_batch && batch_gain_reference.is_in_memory ) {
+            gain->CopyFrom(&batch_gain_reference);
+        }
+        else {
+            gain_file.OpenFile(gain_filename.ToStdString( ), false);
+            gain->ReadSlice(&gain_file, 1);
+        }
         profile_timing.lap("Read gain reference");
     }
 
     if ( input_is_a_movie && ! movie_is_dark_corrected ) {
         profile_timing.start("Read dark reference");
-        dark_file.OpenFile(dark_filename.ToStdString( ), false);
-        dark->ReadSlice(&dark_file, 1);
+        if ( running_as_part_of_batch && batch_dark_reference.is_in_memory ) {
+            dark->CopyFrom(&batch_dark_reference);
+        }
+        else {
+            dark_file.OpenFile(dark_filename.ToStdString( ), false);
+            dark->ReadSlice(&dark_file, 1);
+        }
         profile_timing.lap("Read dark reference");
     }
 
     // Prepare the average spectrum image
     average_spectrum->Allocate(box_size, box_size, true);
 
+    // Tiled spectra are computed at the size that the spectrum of the whole micrograph would be resampled to, before it is clipped to the box size
+    int spectrum_tile_size = box_size;
+    if ( resample_if_pixel_too_small && pixel_size_of_input_image < target_pixel_size_after_resampling ) {
+        spectrum_tile_size = myroundint(float(box_size) / pixel_size_of_input_image * target_pixel_size_after_resampling);
+        if ( IsOdd(spectrum_tile_size) )
+            spectrum_tile_size++;
+    }
+    // The tiles are processed by parallel threads, checked once here rather than for every frame
+    const int number_of_threads_for_tiles = (compute_tiled_spectrum && desired_number_of_threads > 1) ? CheckNumberOfThreads(desired_number_of_threads) : 1;
+
     // Loop over micrographs
     for ( current_micrograph_number = 1; current_micrograph_number <= number_of_micrographs; current_micrograph_number++ ) {
-        if ( is_running_locally && (old_school_input || number_of_micrographs == 1) )
+        if ( print_to_terminal && (old_school_input || number_of_micrographs == 1) )
             wxPrintf("Working on micrograph %i of %i\n", current_micrograph_number, number_of_micrographs);
 
         number_of_tiles_used = 0;
@@ -958,8 +1136,8 @@ bool CtffindApp::DoCalculation( ) {
                     current_input_image->ReadSlice(&input_file, current_input_location);
                     if ( current_input_image->IsConstant( ) ) {
 
-                        if ( is_running_locally == false ) {
-                            // don't crash, as this will lead to the gui job never finishing, instead send a blank result..
+                        if ( is_running_locally == false || running_as_part_of_batch ) {
+                            // don't crash, as this will lead to the gui job (or the rest of the batch) never finishing, instead send a blank result..
                             SendError(wxString::Format("Error: location %i of input file %s is blank, defocus parameters will be set to 0", current_input_location, input_filename));
 
                             float results_array[10];
@@ -974,7 +1152,7 @@ bool CtffindApp::DoCalculation( ) {
                             results_array[8] = 0.0;
                             results_array[9] = 0.0;
 
-                            my_result.SetResult(10, results_array);
+                            current_result.SetResult(10, results_array);
 
                             delete average_spectrum;
                             delete average_spectrum_masked;
@@ -989,6 +1167,8 @@ bool CtffindApp::DoCalculation( ) {
                             delete gain;
                             delete dark;
                             delete[] values_to_write_out;
+                            if ( is_running_locally )
+                                delete output_text;
 
                             return true;
                         }
@@ -1027,8 +1207,10 @@ bool CtffindApp::DoCalculation( ) {
                         current_input_image->CorrectMagnificationDistortion(movie_mag_distortion_angle, movie_mag_distortion_major_scale, movie_mag_distortion_minor_scale);
                         profile_timing.lap("Correct mag distortion");
                     }
-                    // Make the image square
+                    // Make the image square, remembering the area that holds the micrograph for the tiled spectrum
                     profile_timing.start("Crop image to largest dimension");
+                    micrograph_x_dimension_before_squaring = current_input_image->logical_x_dimension;
+                    micrograph_y_dimension_before_squaring = current_input_image->logical_y_dimension;
                     micrograph_square_dimension = std::max(current_input_image->logical_x_dimension, current_input_image->logical_y_dimension);
                     if ( IsOdd((micrograph_square_dimension)) )
                         micrograph_square_dimension++;
@@ -1065,10 +1247,16 @@ bool CtffindApp::DoCalculation( ) {
                 }
                 else {
                     profile_timing.start("Compute amplitude spectrum");
-                    // Compute the amplitude spectrum
-                    current_power_spectrum->Allocate(current_input_image->logical_x_dimension, current_input_image->logical_y_dimension, true);
-                    current_input_image->ForwardFFT(false);
-                    current_input_image->ComputeAmplitudeSpectrumFull2D(current_power_spectrum);
+                    // Compute the amplitude spectrum, from tiles if wanted and the micrograph is large enough. The tiles only cover the
+                    // micrograph itself, not the padding added to make it square
+                    if ( compute_tiled_spectrum && spectrum_tile_size <= micrograph_x_dimension_before_squaring && spectrum_tile_size <= micrograph_y_dimension_before_squaring ) {
+                        current_power_spectrum->ComputeTiledAmplitudeSpectrum(current_input_image, spectrum_tile_size, number_of_threads_for_tiles, micrograph_x_dimension_before_squaring, micrograph_y_dimension_before_squaring);
+                    }
+                    else {
+                        current_power_spectrum->Allocate(current_input_image->logical_x_dimension, current_input_image->logical_y_dimension, true);
+                        current_input_image->ForwardFFT(false);
+                        current_input_image->ComputeAmplitudeSpectrumFull2D(current_power_spectrum);
+                    }
 
                     //current_power_spectrum->QuickAndDirtyWriteSlice("dbg_spec_before_resampling.mrc",1);
 
@@ -1410,7 +1598,7 @@ bool CtffindApp::DoCalculation( ) {
                 profile_timing.start("Perform 2D search");
                 // Actually run the BF search (we run a local minimizer at every grid point only if this is a refinement search following 1D search (otherwise the full brute-force search would get too long)
                 brute_force_search = new BruteForceSearch( );
-                brute_force_search->Init(&CtffindObjectiveFunction, &comparison_object_2D, number_of_search_dimensions, bf_midpoint, bf_halfrange, bf_stepsize, ! slower_search, is_running_locally, desired_number_of_threads);
+                brute_force_search->Init(&CtffindObjectiveFunction, &comparison_object_2D, number_of_search_dimensions, bf_midpoint, bf_halfrange, bf_stepsize, ! slower_search, print_to_terminal, desired_number_of_threads);
                 brute_force_search->Run( );
 
                 profile_timing.lap("Perform 2D search");
@@ -1814,10 +2002,12 @@ bool CtffindApp::DoCalculation( ) {
         profile_timing.lap("Write diagnostic image");
         // Keep track of time
         ctffind_timing.lap("Diagnostics");
-        ctffind_timing.print_times( );
-        profile_timing.print_times( );
+        if ( ! running_as_part_of_batch ) {
+            ctffind_timing.print_times( );
+            profile_timing.print_times( );
+        }
         // Print more detailed results to terminal
-        if ( is_running_locally && number_of_micrographs == 1 ) {
+        if ( print_to_terminal && number_of_micrographs == 1 ) {
 
             wxPrintf("\n\nEstimated defocus values        : %0.2f , %0.2f Angstroms\nEstimated azimuth of astigmatism: %0.2f degrees\n", current_ctf->GetDefocus1( ) * pixel_size_for_fitting, current_ctf->GetDefocus2( ) * pixel_size_for_fitting, current_ctf->GetAstigmatismAzimuth( ) / PIf * 180.0);
             if ( find_additional_phase_shift ) {
@@ -1841,7 +2031,7 @@ bool CtffindApp::DoCalculation( ) {
         }
         // Warn the user if significant aliasing occurred within the fit range
         if ( compute_extra_stats && last_bin_without_aliasing != 0 && spatial_frequency[last_bin_without_aliasing] < current_ctf->GetHighestFrequencyForFitting( ) ) {
-            if ( is_running_locally && number_of_micrographs == 1 ) {
+            if ( print_to_terminal && number_of_micrographs == 1 ) {
                 MyPrintfRed("Warning: CTF aliasing occurred within your CTF fitting range. Consider computing a larger spectrum (current size = %i).\n", box_size);
             }
             else {
@@ -1878,7 +2068,7 @@ bool CtffindApp::DoCalculation( ) {
             }
             output_text->WriteLine(values_to_write_out);
 
-            if ( (! old_school_input) && number_of_micrographs > 1 && is_running_locally )
+            if ( (! old_school_input) && number_of_micrographs > 1 && print_to_terminal )
                 my_progress_bar->Update(current_micrograph_number);
         }
         // Write out avrot
@@ -1906,13 +2096,13 @@ bool CtffindApp::DoCalculation( ) {
         }
         //delete comparison_object_2D;
     } // End of loop over micrographs
-    if ( is_running_locally && (! old_school_input) && number_of_micrographs > 1 ) {
+    if ( print_to_terminal && (! old_school_input) && number_of_micrographs > 1 ) {
         delete my_progress_bar;
         wxPrintf("\n");
     }
 
     // Tell the user where the outputs are
-    if ( is_running_locally ) {
+    if ( print_to_terminal ) {
 
         wxPrintf("\n\nSummary of results                          : %s\n", output_text->ReturnFilename( ));
         wxPrintf("Diagnostic images                           : %s\n", output_diagnostic_filename);
@@ -1949,7 +2139,7 @@ bool CtffindApp::DoCalculation( ) {
     results_array[8]  = tilt_angle;
     results_array[9]  = tilt_axis;
     results_array[10] = current_ctf->GetSampleThickness( ) * pixel_size_for_fitting; // Sample thickness (Angstroms)
-    my_result.SetResult(11, results_array);
+    current_result.SetResult(11, results_array);
     // Cleanup
     delete current_ctf;
     delete average_spectrum;
@@ -0,0 +1,187 @@
+#include "../../core/core_headers.h"
+
+#include <chrono>
+
+// Writes a synthetic refinement to a new project database, reads it back and runs random lookups against it, reporting
+// the insert rate and the query latencies for the chosen database performance profile.
+
+class
+        DatabaseBenchmark : public MyApp {
+
+  public:
+    bool DoCalculation( );
+    void DoInteractiveUserInput( );
+
+  private:
+};
+
+IMPLEMENT_APP(DatabaseBenchmark)
+
+namespace {
+
+inline double SecondsSince(const std::chrono::steady_clock::time_point& start_time) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now( ) - start_time).count( );
+}
+
+} // namespace
+
+// override the DoInteractiveUserInput
+
+void DatabaseBenchmark::DoInteractiveUserInput( ) {
+    UserInput* my_input = new UserInput("DatabaseBenchmark", 1.0);
+
+    std::string database_filename   = my_input->GetFilenameFromUser("Output database file", "The database to create, an existing file is overwritten", "benchmark.db", false);
+    int         number_of_particles = my_input->GetIntFromUser("Number of particles", "Number of rows in each refinement result table", "1000000", 1);
+    int         number_of_classes   = my_input->GetIntFromUser("Number of classes", "Number of refinement result tables", "1", 1);
+    std::string profile_name        = my_input->GetStringFromUser("Performance profile (default or fast)", "The sqlite settings used for the database", "default");
+    int         number_of_lookups   = my_input->GetIntFromUser("Number of random lookups", "Number of single particle queries to time", "10000", 1);
+
+    delete my_input;
+
+    my_current_job.Reset(5);
+    my_current_job.ManualSetArguments("tiiti", database_filename.c_str( ), number_of_particles, number_of_classes, profile_name.c_str( ), number_of_lookups);
+}
+
+// override the do calculation method which will be what is actually run..
+
+bool DatabaseBenchmark::DoCalculation( ) {
+    wxString database_filename   = my_current_job.arguments[0].ReturnStringArgument( );
+    long     number_of_particles = my_current_job.arguments[1].ReturnIntegerArgument( );
+    int      number_of_classes   = my_current_job.arguments[2].ReturnIntegerArgument( );
+    wxString profile_name        = my_current_job.arguments[3].ReturnStringArgument( );
+    int      number_of_lookups   = my_current_job.arguments[4].ReturnIntegerArgument( );
+
+    Database              database;
+    Refinement            synthetic_refinement;
+    RandomNumberGenerator random_generator(pi_v<float>);
+
+    long   class_counter;
+    long   particle_counter;
+    double elapsed_seconds;
+
+    if ( profile_name.IsSameAs("fast", false) )
+        database.SetPerformanceProfile(DatabasePerformanceProfile::ReturnFastProfile( ));
+    else if ( profile_name.IsSameAs("default", false) )
+        database.SetPerformanceProfile(DatabasePerformanceProfile::ReturnDefaultProfile( ));
+    else {
+        SendErrorAndCrash(wxString::Format("Unknown performance profile (%s), it should be default or fast", profile_name));
+    }
+
+    if ( wxFileExists(database_filename) )
+        wxRemoveFile(database_filename);
+
+    if ( database.CreateNewDatabase(database_filename) == false || database.CreateAllTables( ) == false ) {
+        SendErrorAndCrash(wxString::Format("Could not create database %s", database_filename));
+    }
+
+    wxPrintf("\nProfile %s, WAL journal %s\n", profile_name, database.JournalIsWAL( ) ? "on" : "off");
+
+    // synthetic refinement
+
+    synthetic_refinement.refinement_id                       = 1;
+    synthetic_refinement.refinement_package_asset_id         = 1;
+    synthetic_refinement.name                                = "Benchmark";
+    synthetic_refinement.resolution_statistics_are_generated = true;
+    synthetic_refinement.datetime_of_run                     = wxDateTime::Now( );
+    synthetic_refinement.starting_refinement_id              = 1;
+    synthetic_refinement.resolution_statistics_box_size      = 256;
+    synthetic_refinement.resolution_statistics_pixel_size    = 1.0f;
+    synthetic_refinement.percent_used                        = 100.0f;
+
+    synthetic_refinement.SizeAndFillWithEmpty(number_of_particles, number_of_classes);
+
+    for ( class_counter = 0; class_counter < number_of_classes; class_counter++ ) {
+        synthetic_refinement.class_refinement_results[class_counter].class_resolution_statistics.Init(synthetic_refinement.resolution_statistics_pixel_size, synthetic_refinement.resolution_statistics_box_size);
+        synthetic_refinement.class_refinement_results[class_counter].class_resolution_statistics.GenerateDefaultStatistics(300.0f);
+
+        for ( particle_counter = 0; particle_counter < number_of_particles; particle_counter++ ) {
+            RefinementResult& current_result = synthetic_refinement.class_refinement_results[class_counter].particle_refinement_results[particle_counter];
+
+            current_result.position_in_stack = particle_counter + 1;
+            current_result.psi               = random_generator.GetUniformRandomSTD(0.0f, 360.0f);
+            current_result.theta             = random_generator.GetUniformRandomSTD(0.0f, 180.0f);
+            current_result.phi               = random_generator.GetUniformRandomSTD(0.0f, 360.0f);
+            current_result.xshift            = random_generator.GetNormalRandomSTD(0.0f, 2.0f);
+            current_result.yshift            = random_generator.GetNormalRandomSTD(0.0f, 2.0f);
+            current_result.defocus1          = random_generator.GetUniformRandomSTD(5000.0f, 25000.0f);
+            current_result.defocus2          = current_result.defocus1 - random_generator.GetUniformRandomSTD(0.0f, 500.0f);
+            current_result.defocus_angle     = random_generator.GetUniformRandomSTD(-90.0f, 90.0f);
+            current_result.occupancy         = 100.0f / number_of_classes;
+            current_result.logp              = random_generator.GetNormalRandomSTD(-5000.0f, 100.0f);
+            current_result.sigma             = random_generator.GetUniformRandomSTD(5.0f, 15.0f);
+            current_result.score             = random_generator.GetUniformRandomSTD(0.0f, 40.0f);
+            current_result.image_is_active   = 1;
+            current_result.assigned_subset   = particle_counter % 2 + 1;
+        }
+    }
+
+    // inserts
+
+    wxPrintf("\nWriting %li classes of %li particles...\n", long(number_of_classes), number_of_particles);
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now( );
+    database.AddRefinement(&synthetic_refinement);
+    elapsed_seconds = SecondsSince(start_time);
+
+    wxPrintf("Inserted %li rows in %.2f s (%.0f inserts/s)\n", number_of_particles * number_of_classes, elapsed_seconds, double(number_of_particles * number_of_classes) / elapsed_seconds);
+
+    // full read back, as the GUI does
+
+    start_time                    = std::chrono::steady_clock::now( );
+    Refinement* loaded_refinement = database.GetRefinementByID(1);
+    elapsed_seconds               = SecondsSince(start_time);
+
+    wxPrintf("Read back %li rows in %.2f s (%.0f rows/s)\n", number_of_particles * number_of_classes, elapsed_seconds, double(number_of_particles * number_of_classes) / elapsed_seconds);
+    delete loaded_refinement;
+
+    // single particle lookups
+
+    std::vector<double> lookup_latencies(number_of_lookups);
+    sqlite3_stmt*       lookup_statement;
+    double              sum_of_psi = 0.0;
+
+    database.Prepare("SELECT PSI, THETA, PHI, XSHIFT, YSHIFT, SCORE FROM REFINEMENT_RESULT_1_1 WHERE POSITION_IN_STACK = ?;", &lookup_statement);
+
+    for ( int lookup_counter = 0; lookup_counter < number_of_lookups; lookup_counter++ ) {
+        long wanted_position = random_generator.GetUniformRandomSTD(1L, number_of_particles);
+
+        start_time = std::chrono::steady_clock::now( );
+        sqlite3_bind_int64(lookup_statement, 1, wanted_position);
+        if ( database.Step(lookup_statement) == SQLITE_ROW )
+            sum_of_psi += sqlite3_column_double(lookup_statement, 0);
+        sqlite3_reset(lookup_statement);
+        lookup_latencies[lookup_counter] = SecondsSince(start_time);
+    }
+
+    database.Finalize(lookup_statement);
+
+    std::sort(lookup_latencies.begin( ), lookup_latencies.end( ));
+
+    double sum_of_latencies = 0.0;
+    for ( double latency : lookup_latencies ) {
+        sum_of_latencies += latency;
+    }
+
+    wxPrintf("Random lookups (%i) : mean %.1f us, median %.1f us, 99th percentile %.1f us, max %.1f us (checksum %g)\n", number_of_lookups,
+             1.0e6 * sum_of_latencies / number_of_lookups,
+             1.0e6 * lookup_latencies[number_of_lookups / 2],
+             1.0e6 * lookup_latencies[std::min(number_of_lookups - 1, int(0.99 * number_of_lookups))],
+             1.0e6 * lookup_latencies.back( ),
+             sum_of_psi);
+
+    // aggregate over a whole table
+
+    start_time               = std::chrono::steady_clock::now( );
+    double average_occupancy = database.ReturnSingleDoubleFromSelectCommand("SELECT AVG(OCCUPANCY) FROM REFINEMENT_RESULT_1_1 WHERE IMAGE_IS_ACTIVE >= 0;");
+    elapsed_seconds          = SecondsSince(start_time);
+
+    wxPrintf("Table scan : %.1f ms (average occupancy %.2f)\n", 1.0e3 * elapsed_seconds, average_occupancy);
+
+    start_time = std::chrono::steady_clock::now( );
+    database.Close( );
+    elapsed_seconds = SecondsSince(start_time);
+
+    wxPrintf("Close : %.1f ms, database size %s\n\n", 1.0e3 * elapsed_seconds, wxFileName::GetHumanReadableSize(wxFileName::GetSize(database_filename)));
+
+    return true;
+}
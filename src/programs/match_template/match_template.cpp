@@ -20,6 +20,7 @@
 #endif
 
 #include "template_matching_data_sizer.h"
+#include "template_matching_cpu_batch.h"
 
 // The profiling for development is under conrtol of --enable-profiling.
 #ifdef CISTEM_PROFILING
@@ -407,8 +408,11 @@ void MatchTemplateApp::DoInteractiveUserInput( ) {
  * - GPU Path: Each OpenMP thread gets its own `TemplateMatchingCore` instance, which encapsulates GPU resources and operations for that thread.
  *   Shared GPU data (input image, 3D template) is managed with `std::shared_ptr` and accessed read-only by projection/correlation kernels.
  *   Aggregation of results from different GPU threads into shared host arrays (e.g., global MIP, `correlation_pixel_sum`) is protected by an `#pragma omp critical` section.
- * - CPU Path: If `max_threads` > 1 is specified for CPU, it's currently a warning, and `max_threads` is reset to 1, as the CPU path is serial within `DoCalculation`.
- *   Parallelism in a CPU-only distributed job is achieved by running multiple `MatchTemplateApp` processes, each handling a subset of images or search angles, with results collated by a master process.
+ * - CPU Path: The (search position, psi) pairs are shared out dynamically, in batches of `cpu_batch_size`, over `max_threads` OpenMP threads. Each thread owns a `TemplateMatchingCpuBatch`,
+ *   which correlates a whole batch of projections with batched FFTs and keeps private MIP, best angle, sum, sum of squares and histogram buffers. These are reduced into the shared
+ *   host arrays in an `#pragma omp critical` section once the thread has finished its share of the current defocus / pixel size step, mirroring the per `TemplateMatchingCore`
+ *   reduction of the GPU path. Local normalization is restricted to one thread.
+ *   Parallelism in a CPU-only distributed job can additionally be achieved by running multiple `MatchTemplateApp` processes, each handling a subset of images or search angles, with results collated by a master process.
  *
  * @return True if the calculation completes successfully, false otherwise.
  */
@@ -539,8 +543,9 @@ bool MatchTemplateApp::DoCalculation( ) {
     if ( use_gpu && max_threads <= 1 ) {
         SendInfo("Warning, you are only using one thread on the GPU. Suggested minimum is 2. Check compute saturation using nvidia-smi -l 1\n");
     }
-    if ( ! use_gpu && max_threads > 1 ) {
-        SendInfo("Using more than one thread only works in the GPU implementation\nSet No. of threads per copy to 1 in your Run Profile\n.");
+    if ( ! use_gpu && max_threads > 1 && use_local_normalization ) {
+        // The running (Welford) statistics are updated in search order, so they cannot be split over threads.
+        SendInfo("Local normalization on the CPU only works with one thread\nSet No. of threads per copy to 1 in your Run Profile\n.");
         max_threads = 1;
     }
 
@@ -877,7 +882,10 @@ bool MatchTemplateApp::DoCalculation( ) {
 
     number_of_rotations = 0;
 
+    // The in-plane angles are listed once, so that the CPU threads can index them directly and see exactly the values the serial loop produced.
+    std::vector<float> psi_values;
     for ( current_psi = psi_start; current_psi <= psi_max; current_psi += psi_step ) {
+        psi_values.push_back(current_psi);
         number_of_rotations++;
     }
 
@@ -987,6 +995,12 @@ bool MatchTemplateApp::DoCalculation( ) {
 #endif
     }
 
+    // Each CPU thread correlates its projections in batches, see TemplateMatchingCpuBatch
+    TemplateMatchingCpuBatch* cpu_batch = NULL;
+    if ( ! use_gpu ) {
+        cpu_batch = new TemplateMatchingCpuBatch[max_threads];
+    }
+
     // Initialize progress bar if running locally
     if ( is_running_locally == true ) {
         my_progress = new ProgressBar(number_of_search_positions_per_thread);
@@ -1201,159 +1215,182 @@ bool MatchTemplateApp::DoCalculation( ) {
 
 #endif
             }
-            else { // CPU execution path (serial within this function call)
+            else { // CPU execution path, the orientations are shared out over the threads in batches
                 profile_timing.start("RunInnerLoop cpu");
-                // Loop over Euler search positions
-                for ( current_search_position = first_search_position; current_search_position <= last_search_position; current_search_position++ ) {
-                    //loop over each in-plane rotation angle (psi)
-
-                    //current_rotation = 0;
-                    for ( current_psi = psi_start; current_psi <= psi_max; current_psi += psi_step ) {
-
-                        angles.Init(global_euler_search.list_of_search_parameters[current_search_position][0], global_euler_search.list_of_search_parameters[current_search_position][1], current_psi, 0.0, 0.0);
-                        //                    angles.Init(130.0, 30.0, 199.5, 0.0, 0.0);
-
-                        // Extract 2D projection from 3D template
-                        if ( padding != 1.0f ) {
-                            template_reconstruction.ExtractSlice(padded_projection, angles, 1.0f, false);
-                            padded_projection.SwapRealSpaceQuadrants( );
-                            padded_projection.BackwardFFT( );
-                            padded_projection.ClipInto(&current_projection);
-                            current_projection.ForwardFFT( );
-                        }
-                        else {
-                            template_reconstruction.ExtractSlice(current_projection, angles, 1.0f, false);
-                            current_projection.SwapRealSpaceQuadrants( );
-                        }
 
-                        // Apply projection filter (CTF * whitening)
-                        current_projection.MultiplyPixelWise(projection_filter);
+                long number_of_orientations_to_search = long(last_search_position - first_search_position + 1) * long(psi_values.size( ));
+                long number_of_batches_to_search      = (number_of_orientations_to_search + cpu_batch_size - 1) / cpu_batch_size;
 
-                        // Inverse FFT to get cross-correlation map (CCM)
-                        current_projection.BackwardFFT( );
-                        //current_projection.ReplaceOutliersWithMean(6.0f);
+#pragma omp parallel num_threads(max_threads) default(shared)
+                {
+                    // The batch (and its FFTW plans) is set up once per thread and re-used for every defocus / pixel size step
+                    TemplateMatchingCpuBatch& thread_batch = cpu_batch[ReturnThreadNumberOfCurrentThread( )];
+                    if ( ! thread_batch.IsInitialized( ) )
+                        thread_batch.Init(input_image, cpu_batch_size, data_sizer.GetPrePaddingX( ), data_sizer.GetPrePaddingY( ), data_sizer.GetRoiX( ), data_sizer.GetRoiY( ));
+                    thread_batch.ResetResults( );
+
+                    Image thread_current_projection;
+                    Image thread_padded_projection;
+
+                    thread_current_projection.Allocate(current_projection.logical_x_dimension, current_projection.logical_y_dimension, false);
+                    if ( padding != 1.0f )
+                        thread_padded_projection.Allocate(padded_projection.logical_x_dimension, padded_projection.logical_y_dimension, false);
+
+                    AnglesAndShifts thread_angles;
+                    float           thread_variance;
+                    long            thread_correlation_position;
+
+#pragma omp for schedule(dynamic, 1)
+                    for ( long batch_counter = 0; batch_counter < number_of_batches_to_search; batch_counter++ ) {
+                        long first_orientation = batch_counter * cpu_batch_size;
+                        long last_orientation  = std::min(first_orientation + cpu_batch_size, number_of_orientations_to_search) - 1;
+
+                        for ( long orientation_counter = first_orientation; orientation_counter <= last_orientation; orientation_counter++ ) {
+                            int   search_position = first_search_position + int(orientation_counter / long(psi_values.size( )));
+                            float psi             = psi_values[orientation_counter % long(psi_values.size( ))];
+
+                            thread_angles.Init(global_euler_search.list_of_search_parameters[search_position][0], global_euler_search.list_of_search_parameters[search_position][1], psi, 0.0, 0.0);
+
+                            // Extract 2D projection from 3D template
+                            if ( padding != 1.0f ) {
+                                template_reconstruction.ExtractSlice(thread_padded_projection, thread_angles, 1.0f, false);
+                                thread_padded_projection.SwapRealSpaceQuadrants( );
+                                thread_padded_projection.BackwardFFT( );
+                                thread_padded_projection.ClipInto(&thread_current_projection);
+                                thread_current_projection.ForwardFFT( );
+                            }
+                            else {
+                                template_reconstruction.ExtractSlice(thread_current_projection, thread_angles, 1.0f, false);
+                                thread_current_projection.SwapRealSpaceQuadrants( );
+                            }
 
-                        current_projection.AddConstant(-current_projection.ReturnAverageOfRealValuesOnEdges( ));
+                            // Apply projection filter (CTF * whitening)
+                            thread_current_projection.MultiplyPixelWise(projection_filter);
 
-                        // Normalize projection
-                        // We want a variance of 1 in the padded FFT. Scale the small SumOfSquares (which is already divided by n) and then re-divide by N.
-                        variance = current_projection.ReturnSumOfSquares( ) * current_projection.number_of_real_space_pixels / padded_reference.number_of_real_space_pixels - powf(current_projection.ReturnAverageOfRealValues( ) * current_projection.number_of_real_space_pixels / padded_reference.number_of_real_space_pixels, 2);
-                        current_projection.DivideByConstant(sqrtf(variance));
-                        current_projection.ClipIntoLargerRealSpace2D(&padded_reference); // Padded_reference now holds the normalized template projection
+                            thread_current_projection.BackwardFFT( );
 
-                        // Forward FFT the padded reference (template projection)
-                        // Note: The real space variance is set to 1.0 (for the padded size image) and that results in a variance of N in the FFT do to the scaling of the FFT,
-                        // but the FFT values are divided by 1/N so the variance becomes N / (N^2) = is 1/N
-                        padded_reference.ForwardFFT( );
-                        // Zeroing the central pixel is probably not doing anything useful...
-                        padded_reference.ZeroCentralPixel( );
+                            thread_current_projection.AddConstant(-thread_current_projection.ReturnAverageOfRealValuesOnEdges( ));
 
-#ifdef MKL
-                        // Use the MKL
-                        vmcMulByConj(padded_reference.real_memory_allocated / 2, reinterpret_cast<MKL_Complex8*>(input_image.complex_values), reinterpret_cast<MKL_Complex8*>(padded_reference.complex_values), reinterpret_cast<MKL_Complex8*>(padded_reference.complex_values), VML_EP | VML_FTZDAZ_ON | VML_ERRMODE_IGNORE);
-#else
-                        for ( pixel_counter = 0; pixel_counter < padded_reference.real_memory_allocated / 2; pixel_counter++ ) {
-                            padded_reference.complex_values[pixel_counter] = conj(padded_reference.complex_values[pixel_counter]) * input_image.complex_values[pixel_counter];
+                            // Normalize projection
+                            // We want a variance of 1 in the padded FFT. Scale the small SumOfSquares (which is already divided by n) and then re-divide by N.
+                            thread_variance = thread_current_projection.ReturnSumOfSquares( ) * thread_current_projection.number_of_real_space_pixels / padded_reference.number_of_real_space_pixels - powf(thread_current_projection.ReturnAverageOfRealValues( ) * thread_current_projection.number_of_real_space_pixels / padded_reference.number_of_real_space_pixels, 2);
+                            thread_current_projection.DivideByConstant(sqrtf(thread_variance));
+
+                            // The batch pads the normalized projection to the search image size
+                            thread_batch.AddProjection(thread_current_projection,
+                                                       psi,
+                                                       global_euler_search.list_of_search_parameters[search_position][1],
+                                                       global_euler_search.list_of_search_parameters[search_position][0]);
+
+                            thread_current_projection.is_in_real_space = false;
                         }
+
+                        // Cross correlate the whole batch with the input image, and update this thread's mip, statistics and histogram
+                        thread_batch.ProcessBatch(! use_local_normalization);
+
+                        // Note: this one is outside the ifdefs so we can leave the "normal" stats images in places.
+                        if ( use_local_normalization ) {
+                            // Local normalization
+#ifdef TEST_LOCAL_NORMALIZATION
+                            for ( int member = 0; member < thread_batch.ReturnNumberInBatch( ); member++ ) {
+                                const float* correlation_map = thread_batch.ReturnPointerToCorrelationMap(member);
+                                for ( int current_y = data_sizer.GetPrePaddingY( ); current_y < data_sizer.GetPrePaddingY( ) + data_sizer.GetRoiY( ); current_y++ ) {
+                                    for ( int current_x = data_sizer.GetPrePaddingX( ); current_x < data_sizer.GetPrePaddingX( ) + data_sizer.GetRoiX( ); current_x++ ) {
+                                        long  address = max_intensity_projection.ReturnReal1DAddressFromPhysicalCoord(current_x, current_y, 0);
+                                        float value   = correlation_map[address]; //* (float)sqrt_input_pixels;
+                                        // Welford's algorithm for trimming
+                                        // For the GPU implementation we'll have at least 10 (though currently 20) mip values the first time we go through a stack, so
+                                        // rather than just skipping the first 10 and assuming no outliers, we can probably be more clever.
+                                        if ( n_image[address] < BUFFER_SIZE ) {
+                                            // Buffering phase
+                                            n_image[address]++;
+                                            float delta = value - mean_image[address];
+                                            mean_image[address] += delta / n_image[address];
+                                            float delta2 = value - mean_image[address];
+                                            M2_image[address] += delta * delta2;
+                                        }
+                                        else {
+                                            // Outlier trimming
+                                            variance_image[address] = M2_image[address] / (n_image[address] - 1);
+                                            stddev_image[address]   = std::sqrt(variance_image[address]);
+                                            if ( std::abs(value - mean_image[address]) > OUTLIER_THRESHOLD * stddev_image[address] ) {
+                                                // Skip outlier
+
+                                                continue;
+                                            }
+
+                                            // Update running statistics for non-outliers
+                                            n_image[address]++;
+                                            float delta = value - mean_image[address];
+                                            mean_image[address] += delta / n_image[address];
+                                            float delta2 = value - mean_image[address];
+                                            M2_image[address] += delta * delta2;
+                                        }
+                                    }
+                                }
+                            }
 #endif
+                        }
 
-                        // Note: the cross correlation will have variance 1/N (the product of variance of the two FFTs assuming the means are both zero and the distributions independent.)
-                        // Taking the inverse FFT scales this variance by N resulting in a MIP with variance 1
-                        padded_reference.BackwardFFT( );
+                        for ( int member = 0; member < thread_batch.ReturnNumberInBatch( ); member++ ) {
+#pragma omp atomic capture
+                            thread_correlation_position = ++current_correlation_position;
 
-                        // update mip, and histogram..
+                            // The progress bar is not thread safe, so only the first thread draws it.
+                            if ( is_running_locally == true && ReturnThreadNumberOfCurrentThread( ) == 0 )
+                                my_progress->Update(thread_correlation_position);
 
+                            if ( is_running_locally == false ) {
+
+                                // Currently there is no subsampling in the CPU implementation
+                                float      thread_result_value = thread_correlation_position;
+                                JobResult* temp_result         = new JobResult;
+                                temp_result->SetResult(1, &thread_result_value);
+                                AddJobToResultQueue(temp_result);
+                            }
+                        }
+                    }
+
+                    // Aggregate this thread's results into the shared host arrays
+#pragma omp critical
+                    {
                         for ( int current_y = data_sizer.GetPrePaddingY( ); current_y < data_sizer.GetPrePaddingY( ) + data_sizer.GetRoiY( ); current_y++ ) {
                             for ( int current_x = data_sizer.GetPrePaddingX( ); current_x < data_sizer.GetPrePaddingX( ) + data_sizer.GetRoiX( ); current_x++ ) {
-                                // first mip
                                 long address = max_intensity_projection.ReturnReal1DAddressFromPhysicalCoord(current_x, current_y, 0);
-                                if ( padded_reference.real_values[address] > max_intensity_projection.real_values[address] ) {
-                                    max_intensity_projection.real_values[address] = padded_reference.real_values[address];
-                                    best_psi.real_values[address]                 = current_psi;
-                                    best_theta.real_values[address]               = global_euler_search.list_of_search_parameters[current_search_position][1];
-                                    best_phi.real_values[address]                 = global_euler_search.list_of_search_parameters[current_search_position][0];
+
+                                if ( thread_batch.max_intensity_projection[address] > max_intensity_projection.real_values[address] ) {
+                                    max_intensity_projection.real_values[address] = thread_batch.max_intensity_projection[address];
+                                    best_psi.real_values[address]                 = thread_batch.best_psi[address];
+                                    best_theta.real_values[address]               = thread_batch.best_theta[address];
+                                    best_phi.real_values[address]                 = thread_batch.best_phi[address];
                                     best_defocus.real_values[address]             = float(defocus_i) * defocus_step;
                                     best_pixel_size.real_values[address]          = float(size_i) * pixel_size_step;
-                                    //                                if (size_i != 0) wxPrintf("size_i = %i\n", size_i);
-                                    //                                correlation_pixel_sum[pixel_counter] = variance;
                                 }
 
-                                // histogram
-                                float mip_value = padded_reference.real_values[address];
-                                current_bin     = int((mip_value - histogram_min) / histogram_step);
-                                //current_bin = int(double((padded_reference.real_values[address]) - histogram_min) / histogram_step);
-
-                                if ( current_bin >= 0 && current_bin <= histogram_number_of_points ) {
-                                    histogram_data[current_bin] += 1;
-                                }
-
-                                // Note: this one is outside the ifdefs so we can leave the "normal" stats images in places.
-                                if ( use_local_normalization ) {
-                                    // Local normalization
-#ifdef TEST_LOCAL_NORMALIZATION
-                                    float value = padded_reference.real_values[address]; //* (float)sqrt_input_pixels;
-                                    // Welford's algorithm for trimming
-                                    // For the GPU implementation we'll have at least 10 (though currently 20) mip values the first time we go through a stack, so
-                                    // rather than just skipping the first 10 and assuming no outliers, we can probably be more clever.
-                                    if ( n_image[address] < BUFFER_SIZE ) {
-                                        // Buffering phase
-                                        n_image[address]++;
-                                        float delta = value - mean_image[address];
-                                        mean_image[address] += delta / n_image[address];
-                                        float delta2 = value - mean_image[address];
-                                        M2_image[address] += delta * delta2;
-                                    }
-                                    else {
-                                        // Outlier trimming
-                                        variance_image[address] = M2_image[address] / (n_image[address] - 1);
-                                        stddev_image[address]   = std::sqrt(variance_image[address]);
-                                        if ( std::abs(value - mean_image[address]) > OUTLIER_THRESHOLD * stddev_image[address] ) {
-                                            // Skip outlier
-
-                                            continue;
-                                        }
-
-                                        // Update running statistics for non-outliers
-                                        n_image[address]++;
-                                        float delta = value - mean_image[address];
-                                        mean_image[address] += delta / n_image[address];
-                                        float delta2 = value - mean_image[address];
-                                        M2_image[address] += delta * delta2;
-                                    }
-
-#endif
-                                }
-                                else {
-                                    correlation_pixel_sum[address] += mip_value;
-                                    correlation_pixel_sum_of_squares[address] += mip_value * mip_value;
-                                }
+                                correlation_pixel_sum[address] += thread_batch.correlation_pixel_sum[address];
+                                correlation_pixel_sum_of_squares[address] += thread_batch.correlation_pixel_sum_of_squares[address];
                             }
                         }
 
-                        current_projection.is_in_real_space = false;
-                        padded_reference.is_in_real_space   = true;
-
-                        current_correlation_position++;
-                        if ( is_running_locally == true )
-                            my_progress->Update(current_correlation_position);
-
-                        actual_number_of_angles_searched++;
+                        for ( int counter = 0; counter < histogram_number_of_points; counter++ ) {
+                            histogram_data[counter] += thread_batch.histogram[counter];
+                        }
 
-                        if ( is_running_locally == false ) {
+                        actual_number_of_angles_searched += float(thread_batch.total_number_of_cccs_calculated);
+                    } // end of omp critical block
+                } // end of parallel block
 
-                            // Currently there is no subsampling in the CPU implementation
-                            temp_float             = current_correlation_position;
-                            JobResult* temp_result = new JobResult;
-                            temp_result->SetResult(1, &temp_float);
-                            AddJobToResultQueue(temp_result);
-                        }
-                    }
-                }
                 profile_timing.lap("RunInnerLoop cpu");
             } // if/else on use_gpu for inner loop
         } // defocus loop
     } // pixel size loop
 
+    // The batches hold a padded copy of the search image per projection, so give the memory back before the results are resized
+    if ( cpu_batch != NULL ) {
+        delete[] cpu_batch;
+        cpu_batch = NULL;
+    }
+
     // Most of the time we can get away without synchronizing here, however,
 
     wxPrintf("\n\n\tTimings: Overall: %s\n", (wxDateTime::Now( ) - overall_start).Format( ));
@@ -0,0 +1,205 @@
+#include "../../core/core_headers.h"
+
+#include "../../constants/constants.h"
+
+#include "template_matching_cpu_batch.h"
+
+// Number of complex values of the search spectrum applied to every member of the batch before moving on, 32 KB of std::complex<float>
+constexpr long complex_values_per_cache_block = 4096;
+
+TemplateMatchingCpuBatch::TemplateMatchingCpuBatch( ) {
+    input_image_ptr                 = NULL;
+    plan_fwd_many                   = NULL;
+    plan_bwd_many                   = NULL;
+    batch_size                      = 0;
+    number_in_batch                 = 0;
+    real_values_per_member          = 0;
+    complex_values_per_member       = 0;
+    first_x                         = 0;
+    first_y                         = 0;
+    roi_x                           = 0;
+    roi_y                           = 0;
+    total_number_of_cccs_calculated = 0;
+    is_initialized                  = false;
+    batch_was_processed             = false;
+}
+
+TemplateMatchingCpuBatch::~TemplateMatchingCpuBatch( ) {
+    if ( plan_fwd_many != NULL || plan_bwd_many != NULL ) {
+        wxMutexLocker lock(Image::s_mutexProtectingFFTW); // the mutex will be unlocked when this object is destroyed (when it goes out of scope)
+        MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+        if ( plan_fwd_many != NULL )
+            fftwf_destroy_plan(plan_fwd_many);
+        if ( plan_bwd_many != NULL )
+            fftwf_destroy_plan(plan_bwd_many);
+    }
+}
+
+void TemplateMatchingCpuBatch::Init(Image& input_image, int wanted_batch_size, int wanted_first_x, int wanted_first_y, int wanted_roi_x, int wanted_roi_y) {
+    MyDebugAssertFalse(is_initialized, "TemplateMatchingCpuBatch is already initialized");
+    MyDebugAssertTrue(input_image.is_in_memory, "Input image not allocated");
+    MyDebugAssertFalse(input_image.is_in_real_space, "Input image must be in Fourier space");
+    MyDebugAssertTrue(input_image.logical_z_dimension == 1, "Input image must be 2D");
+    MyDebugAssertTrue(wanted_batch_size > 0, "Batch size must be positive (%i)", wanted_batch_size);
+
+    input_image_ptr = &input_image;
+    batch_size      = wanted_batch_size;
+    first_x         = wanted_first_x;
+    first_y         = wanted_first_y;
+    roi_x           = wanted_roi_x;
+    roi_y           = wanted_roi_y;
+
+    // The slices of a 3D image are laid out exactly like a stack of in-place 2D transforms
+    batch_of_references.Allocate(input_image.logical_x_dimension, input_image.logical_y_dimension, batch_size, true, false);
+    batch_of_references.SetToConstant(0.0f);
+    real_values_per_member    = batch_of_references.real_memory_allocated / batch_size;
+    complex_values_per_member = real_values_per_member / 2;
+
+    int dimensions[2]               = {input_image.logical_y_dimension, input_image.logical_x_dimension};
+    int real_embedded_dimensions[2] = {input_image.logical_y_dimension, int(real_values_per_member / input_image.logical_y_dimension)};
+    int complex_embedded_dims[2]    = {input_image.logical_y_dimension, int(complex_values_per_member / input_image.logical_y_dimension)};
+
+    {
+        wxMutexLocker lock(Image::s_mutexProtectingFFTW); // the mutex will be unlocked when this object is destroyed (when it goes out of scope)
+        MyDebugAssertTrue(lock.IsOk( ), "Mutex locking failed");
+
+        plan_fwd_many = fftwf_plan_many_dft_r2c(2, dimensions, batch_size,
+                                                batch_of_references.real_values, real_embedded_dimensions, 1, int(real_values_per_member),
+                                                reinterpret_cast<fftwf_complex*>(batch_of_references.complex_values), complex_embedded_dims, 1, int(complex_values_per_member),
+                                                FFTW_ESTIMATE);
+        plan_bwd_many = fftwf_plan_many_dft_c2r(2, dimensions, batch_size,
+                                                reinterpret_cast<fftwf_complex*>(batch_of_references.complex_values), complex_embedded_dims, 1, int(complex_values_per_member),
+                                                batch_of_references.real_values, real_embedded_dimensions, 1, int(real_values_per_member),
+                                                FFTW_ESTIMATE);
+    }
+
+    if ( plan_fwd_many == NULL || plan_bwd_many == NULL ) {
+        MyPrintWithDetails("Error in FFT Planning for a batch of %i x %i x %i\n", input_image.logical_x_dimension, input_image.logical_y_dimension, batch_size);
+        DEBUG_ABORT;
+    }
+
+    member_psi.resize(batch_size);
+    member_theta.resize(batch_size);
+    member_phi.resize(batch_size);
+
+    max_intensity_projection.resize(input_image.real_memory_allocated);
+    best_psi.resize(input_image.real_memory_allocated);
+    best_theta.resize(input_image.real_memory_allocated);
+    best_phi.resize(input_image.real_memory_allocated);
+    correlation_pixel_sum.resize(input_image.real_memory_allocated);
+    correlation_pixel_sum_of_squares.resize(input_image.real_memory_allocated);
+    histogram.resize(cistem::match_template::histogram_number_of_points);
+
+    is_initialized = true;
+    ResetResults( );
+}
+
+void TemplateMatchingCpuBatch::ResetResults( ) {
+    MyDebugAssertTrue(is_initialized, "TemplateMatchingCpuBatch is not initialized");
+
+    // The MIP starts at zero, as the one in match_template does, so only values that could also win there are ever offered
+    std::fill(max_intensity_projection.begin( ), max_intensity_projection.end( ), 0.0f);
+    std::fill(best_psi.begin( ), best_psi.end( ), 0.0f);
+    std::fill(best_theta.begin( ), best_theta.end( ), 0.0f);
+    std::fill(best_phi.begin( ), best_phi.end( ), 0.0f);
+    std::fill(correlation_pixel_sum.begin( ), correlation_pixel_sum.end( ), 0.0);
+    std::fill(correlation_pixel_sum_of_squares.begin( ), correlation_pixel_sum_of_squares.end( ), 0.0);
+    std::fill(histogram.begin( ), histogram.end( ), 0);
+    total_number_of_cccs_calculated = 0;
+    number_in_batch                 = 0;
+    batch_was_processed             = false;
+}
+
+void TemplateMatchingCpuBatch::AddProjection(Image& normalized_projection, float wanted_psi, float wanted_theta, float wanted_phi) {
+    MyDebugAssertTrue(is_initialized, "TemplateMatchingCpuBatch is not initialized");
+
+    if ( batch_was_processed ) {
+        number_in_batch     = 0;
+        batch_was_processed = false;
+    }
+
+    MyDebugAssertFalse(IsFull( ), "The batch is already full");
+
+    batch_member.AllocateAsPointingToSliceIn3D(&batch_of_references, number_in_batch + 1);
+    batch_member.is_in_real_space         = true;
+    batch_member.object_is_centred_in_box = true;
+    normalized_projection.ClipIntoLargerRealSpace2D(&batch_member);
+
+    member_psi[number_in_batch]   = wanted_psi;
+    member_theta[number_in_batch] = wanted_theta;
+    member_phi[number_in_batch]   = wanted_phi;
+    number_in_batch++;
+}
+
+void TemplateMatchingCpuBatch::ProcessBatch(bool accumulate_sums) {
+    using namespace cistem::match_template;
+
+    MyDebugAssertTrue(is_initialized, "TemplateMatchingCpuBatch is not initialized");
+    MyDebugAssertFalse(batch_was_processed, "This batch has already been processed");
+
+    if ( number_in_batch == 0 )
+        return;
+
+    // A partial batch is still transformed as a whole, which is cheaper than keeping a plan per batch size. The unused slots are cleared so that stale maps are not transformed over and over.
+    if ( number_in_batch < batch_size ) {
+        std::fill(batch_of_references.real_values + number_in_batch * real_values_per_member, batch_of_references.real_values + batch_size * real_values_per_member, 0.0f);
+    }
+
+    fftwf_execute_dft_r2c(plan_fwd_many, batch_of_references.real_values, reinterpret_cast<fftwf_complex*>(batch_of_references.complex_values));
+
+    // Fused forward scaling, zeroing of the central pixel and conjugate multiplication with the search image.
+    // Note: as in the unbatched search, the padded projection has variance 1 in real space, so after the scaled forward transform it has variance 1/N
+    // and the inverse transform of the product gives a cross correlation with variance 1.
+    const float                forward_scale  = 1.0f / float(long(input_image_ptr->logical_x_dimension) * long(input_image_ptr->logical_y_dimension));
+    const std::complex<float>* input_spectrum = input_image_ptr->complex_values;
+
+    for ( long block_start = 0; block_start < complex_values_per_member; block_start += complex_values_per_cache_block ) {
+        long block_end = std::min(block_start + complex_values_per_cache_block, complex_values_per_member);
+        for ( int member = 0; member < number_in_batch; member++ ) {
+            std::complex<float>* member_spectrum = batch_of_references.complex_values + member * complex_values_per_member;
+            for ( long complex_counter = block_start; complex_counter < block_end; complex_counter++ ) {
+                member_spectrum[complex_counter] = conj(member_spectrum[complex_counter]) * input_spectrum[complex_counter] * forward_scale;
+            }
+        }
+    }
+
+    for ( int member = 0; member < number_in_batch; member++ ) {
+        batch_of_references.complex_values[member * complex_values_per_member] = 0.0f * I + 0.0f;
+    }
+
+    fftwf_execute_dft_c2r(plan_bwd_many, reinterpret_cast<fftwf_complex*>(batch_of_references.complex_values), batch_of_references.real_values);
+
+    // Fused MIP / statistics / histogram update. Each row of the private buffers stays in cache while every member of the batch is folded in.
+    for ( int current_y = first_y; current_y < first_y + roi_y; current_y++ ) {
+        long row_start = input_image_ptr->ReturnReal1DAddressFromPhysicalCoord(first_x, current_y, 0);
+        for ( int member = 0; member < number_in_batch; member++ ) {
+            const float* correlation_map = batch_of_references.real_values + member * real_values_per_member;
+            const float  psi             = member_psi[member];
+            const float  theta           = member_theta[member];
+            const float  phi             = member_phi[member];
+
+            for ( long address = row_start; address < row_start + roi_x; address++ ) {
+                float mip_value = correlation_map[address];
+                if ( mip_value > max_intensity_projection[address] ) {
+                    max_intensity_projection[address] = mip_value;
+                    best_psi[address]                 = psi;
+                    best_theta[address]               = theta;
+                    best_phi[address]                 = phi;
+                }
+
+                int current_bin = int((mip_value - histogram_min) / histogram_step);
+                if ( current_bin >= 0 && current_bin < histogram_number_of_points ) {
+                    histogram[current_bin]++;
+                }
+
+                if ( accumulate_sums ) {
+                    correlation_pixel_sum[address] += mip_value;
+                    correlation_pixel_sum_of_squares[address] += mip_value * mip_value;
+                }
+            }
+        }
+    }
+
+    total_number_of_cccs_calculated += number_in_batch;
+    batch_was_processed = true;
+}
@@ -0,0 +1,89 @@
+#ifndef __SRC_PROGRAMS_MATCH_TEMPLATE_TEMPLATE_MATCHING_CPU_BATCH_H_
+#define __SRC_PROGRAMS_MATCH_TEMPLATE_TEMPLATE_MATCHING_CPU_BATCH_H_
+
+/**
+ * @brief CPU counterpart of TemplateMatchingCore: correlates a batch of template projections with the search image at once.
+ *
+ * The padded, normalized projections are stored as the slices of one 3D image, so that a single FFTW "many" plan transforms
+ * the whole batch in each direction. The scaling of the forward transform, the zeroing of the central pixel and the conjugate
+ * multiplication with the search image spectrum are fused into one pass that is blocked so the search spectrum is read from cache
+ * for every member of the batch. The MIP, best angle, sum, sum of squares and histogram updates are fused into a second pass that
+ * walks the region of interest row by row, visiting every member of the batch before moving on.
+ *
+ * Each instance owns private results, and is meant to be used by one thread. The results are reduced by the caller.
+ *
+ */
+class TemplateMatchingCpuBatch {
+
+    Image* input_image_ptr; // not owned, the whitened search image in Fourier space
+
+    Image batch_of_references;
+    Image batch_member;
+
+    fftwf_plan plan_fwd_many;
+    fftwf_plan plan_bwd_many;
+
+    int  batch_size;
+    int  number_in_batch;
+    long real_values_per_member;
+    long complex_values_per_member;
+
+    int first_x;
+    int first_y;
+    int roi_x;
+    int roi_y;
+
+    std::vector<float> member_psi;
+    std::vector<float> member_theta;
+    std::vector<float> member_phi;
+
+    bool is_initialized;
+    bool batch_was_processed;
+
+  public:
+    TemplateMatchingCpuBatch( );
+    ~TemplateMatchingCpuBatch( );
+
+    TemplateMatchingCpuBatch(const TemplateMatchingCpuBatch&)            = delete;
+    TemplateMatchingCpuBatch& operator=(const TemplateMatchingCpuBatch&) = delete;
+
+    // Private results, addressed like the real values of the search image
+    std::vector<float>  max_intensity_projection;
+    std::vector<float>  best_psi;
+    std::vector<float>  best_theta;
+    std::vector<float>  best_phi;
+    std::vector<double> correlation_pixel_sum;
+    std::vector<double> correlation_pixel_sum_of_squares;
+    std::vector<long>   histogram;
+    long                total_number_of_cccs_calculated;
+
+    void Init(Image& input_image, int wanted_batch_size, int wanted_first_x, int wanted_first_y, int wanted_roi_x, int wanted_roi_y);
+    void ResetResults( );
+
+    // Clip a normalized, real space projection into the next free slot of the batch.
+    void AddProjection(Image& normalized_projection, float wanted_psi, float wanted_theta, float wanted_phi);
+
+    // Correlate every member of the batch with the search image and fold the results into the private buffers.
+    // With accumulate_sums false, the sums are left alone so that the caller may gather its own statistics from the correlation maps.
+    void ProcessBatch(bool accumulate_sums = true);
+
+    // Only valid after ProcessBatch( ), until the next call to AddProjection( )
+    inline const float* ReturnPointerToCorrelationMap(int member) const {
+        MyDebugAssertTrue(member >= 0 && member < number_in_batch, "Member %i is not in the batch (%i)", member, number_in_batch);
+        return batch_of_references.real_values + member * real_values_per_member;
+    }
+
+    inline bool IsInitialized( ) const { return is_initialized; }
+
+    inline bool IsFull( ) const { return number_in_batch == batch_size; }
+
+    inline int ReturnNumberInBatch( ) const { return number_in_batch; }
+
+    inline float ReturnPsi(int member) const { return member_psi[member]; }
+
+    inline float ReturnTheta(int member) const { return member_theta[member]; }
+
+    inline float ReturnPhi(int member) const { return member_phi[member]; }
+};
+
+#endif
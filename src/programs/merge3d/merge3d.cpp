@@ -7,6 +7,7 @@ class
     void DoInteractiveUserInput( );
 
   private:
+    void AddDumpFiles(Reconstruct3D& accumulator, wxString dump_file_seed, wxString extension, int number_of_dump_files, int max_threads);
 };
 
 IMPLEMENT_APP(Merge3DApp)
@@ -24,6 +25,7 @@ void Merge3DApp::DoInteractiveUserInput( ) {
     wxString dump_file_seed_1;
     wxString dump_file_seed_2;
     int      number_of_dump_files;
+    int      max_threads;
 
     UserInput* my_input = new UserInput("Merge3D", 1.01);
 
@@ -38,6 +40,12 @@ void Merge3DApp::DoInteractiveUserInput( ) {
     dump_file_seed_2               = my_input->GetFilenameFromUser("Seed for input dump filenames for even particles", "The seed name of the second dump files with the intermediate reconstruction arrays", "dump_file_seed_2_.dat", false);
     number_of_dump_files           = my_input->GetIntFromUser("Number of dump files", "The number of dump files that should be read from disk and merged", "1", 1);
 
+#ifdef _OPENMP
+    max_threads = my_input->GetIntFromUser("Max. threads to use for calculation", "When threading, what is the max threads to run. Each thread beyond the first needs memory for one more pair of 3D arrays", "1", 1);
+#else
+    max_threads = 1;
+#endif
+
     delete my_input;
 
     int      class_number_for_gui        = 1;
@@ -46,7 +54,7 @@ void Merge3DApp::DoInteractiveUserInput( ) {
     float    weiner_nominator            = 1.0f;
     float    alignment_res               = 5.0f;
     //	my_current_job.Reset(14);
-    my_current_job.ManualSetArguments("ttttfffttibtiff", output_reconstruction_1.ToUTF8( ).data( ),
+    my_current_job.ManualSetArguments("ttttfffttibtiffi", output_reconstruction_1.ToUTF8( ).data( ),
                                       output_reconstruction_2.ToUTF8( ).data( ),
                                       output_reconstruction_filtered.ToUTF8( ).data( ),
                                       output_resolution_statistics.ToUTF8( ).data( ),
@@ -60,7 +68,8 @@ void Merge3DApp::DoInteractiveUserInput( ) {
                                       orthogonal_views_filename.ToUTF8( ).data( ),
                                       number_of_dump_files,
                                       weiner_nominator,
-                                      alignment_res);
+                                      alignment_res,
+                                      max_threads);
 }
 
 // override the do calculation method which will be what is actually run..
@@ -82,6 +91,10 @@ bool Merge3DApp::DoCalculation( ) {
     float    weiner_nominator               = my_current_job.arguments[13].ReturnFloatArgument( );
     // FOR LOCRES HACK..
     float alignment_res = my_current_job.arguments[14].ReturnFloatArgument( );
+    int   max_threads   = my_current_job.arguments[15].ReturnIntegerArgument( );
+
+    if ( is_running_locally == false )
+        max_threads = number_of_threads_requested_on_command_line; // OVERRIDE FOR THE GUI, AS IT HAS TO BE SET ON THE COMMAND LINE...
 
     ResolutionStatistics* resolution_statistics = NULL;
     resolution_statistics                       = new ResolutionStatistics;
@@ -150,39 +163,13 @@ bool Merge3DApp::DoCalculation( ) {
                                         original_x_dimension, original_y_dimension, original_z_dimension, images_processed, pixel_size, original_pixel_size,
                                         average_occupancy, average_sigma, sigma_bfactor_conversion, my_symmetry, insert_even, center_mass);
     wxPrintf("\nReconstruction dimensions = %i, %i, %i, pixel size = %f, symmetry = %s\n", logical_x_dimension, logical_y_dimension, logical_z_dimension, pixel_size, my_symmetry);
-    temp_reconstruction.Init(logical_x_dimension, logical_y_dimension, logical_z_dimension, pixel_size, average_occupancy, average_sigma, sigma_bfactor_conversion);
     Reconstruct3D my_reconstruction_1(logical_x_dimension, logical_y_dimension, logical_z_dimension, pixel_size, average_occupancy, average_sigma, sigma_bfactor_conversion, my_symmetry);
     Reconstruct3D my_reconstruction_2(logical_x_dimension, logical_y_dimension, logical_z_dimension, pixel_size, average_occupancy, average_sigma, sigma_bfactor_conversion, my_symmetry);
 
     wxPrintf("\nReading reconstruction arrays...\n\n");
 
-    for ( count = 1; count <= number_of_dump_files; count++ ) {
-        dump_file = wxFileName::StripExtension(dump_file_seed_1) + wxString::Format("%i", count) + "." + extension;
-        wxPrintf("%s\n", dump_file);
-        if ( (is_running_locally && DoesFileExist(dump_file)) || (! is_running_locally && DoesFileExistWithWait(dump_file, 90)) ) // C++ standard says if LHS of OR is true, RHS never gets evaluated
-        {
-            temp_reconstruction.ReadArrays(dump_file);
-            my_reconstruction_1 += temp_reconstruction;
-        }
-        else {
-            SendError(wxString::Format("Error: Dump file %s not found\n", dump_file));
-            exit(-1);
-        }
-    }
-
-    for ( count = 1; count <= number_of_dump_files; count++ ) {
-        dump_file = wxFileName::StripExtension(dump_file_seed_2) + wxString::Format("%i", count) + "." + extension;
-        wxPrintf("%s\n", dump_file);
-        if ( (is_running_locally && DoesFileExist(dump_file)) || (! is_running_locally && DoesFileExistWithWait(dump_file, 90)) ) // C++ standard says if LHS of OR is true, RHS never gets evaluated
-        {
-            temp_reconstruction.ReadArrays(dump_file);
-            my_reconstruction_2 += temp_reconstruction;
-        }
-        else {
-            SendError(wxString::Format("Error: Dump file %s not found\n", dump_file));
-            exit(-1);
-        }
-    }
+    AddDumpFiles(my_reconstruction_1, dump_file_seed_1, extension, number_of_dump_files, max_threads);
+    AddDumpFiles(my_reconstruction_2, dump_file_seed_2, extension, number_of_dump_files, max_threads);
 
     wxPrintf("\nFinished reading arrays\n");
 
@@ -192,7 +179,9 @@ bool Merge3DApp::DoCalculation( ) {
                               inner_mask_radius, outer_mask_radius, mask_falloff, output_reconstruction_2);
 
     output_3d.mask_volume_in_voxels = output_3d1.mask_volume_in_voxels;
-    my_reconstruction_1 += my_reconstruction_2;
+    std::vector<Reconstruct3D*> final_target(1, &my_reconstruction_1);
+    std::vector<Reconstruct3D*> final_source(1, &my_reconstruction_2);
+    Reconstruct3D::AddInZSlabs(final_target, final_source, std::max(max_threads, 1));
     my_reconstruction_2.FreeMemory( );
 
     output_3d.FinalizeOptimal(my_reconstruction_1, output_3d1.density_map, output_3d2.density_map,
@@ -552,3 +541,48 @@ bool Merge3DApp::DoCalculation( ) {
     delete resolution_statistics;
     return true;
 }
+
+// Add all dump files of one half set to the accumulator. With several threads, each thread sums a subset of the files into its
+// own partial sum (the first thread uses the accumulator itself), and the partial sums are then combined in a tree.
+void Merge3DApp::AddDumpFiles(Reconstruct3D& accumulator, wxString dump_file_seed, wxString extension, int number_of_dump_files, int max_threads) {
+    int                   count;
+    std::vector<wxString> dump_files(number_of_dump_files);
+
+    // All files are checked (and waited for) up front, so that the threads below never have to report a missing file
+    for ( count = 1; count <= number_of_dump_files; count++ ) {
+        dump_files[count - 1] = wxFileName::StripExtension(dump_file_seed) + wxString::Format("%i", count) + "." + extension;
+        wxPrintf("%s\n", dump_files[count - 1]);
+        if ( (is_running_locally && DoesFileExist(dump_files[count - 1])) || (! is_running_locally && DoesFileExistWithWait(dump_files[count - 1], 90)) ) // C++ standard says if LHS of OR is true, RHS never gets evaluated
+        {
+            //
+        }
+        else {
+            SendError(wxString::Format("Error: Dump file %s not found\n", dump_files[count - 1]));
+            exit(-1);
+        }
+    }
+
+    int number_of_threads = std::max(1, std::min(max_threads, number_of_dump_files));
+
+    if ( number_of_threads == 1 ) {
+        for ( count = 0; count < number_of_dump_files; count++ ) {
+            accumulator.AddArraysFromFile(dump_files[count]);
+        }
+        return;
+    }
+
+    std::vector<Reconstruct3D*> partial_sums(number_of_threads);
+    partial_sums[0] = &accumulator;
+    for ( int thread_counter = 1; thread_counter < number_of_threads; thread_counter++ ) {
+        partial_sums[thread_counter] = new Reconstruct3D(accumulator.logical_x_dimension, accumulator.logical_y_dimension, accumulator.logical_z_dimension, accumulator.pixel_size,
+                                                         accumulator.average_occupancy, accumulator.average_score, accumulator.score_weights_conversion, accumulator.symmetry_matrices.symmetry_symbol);
+    }
+
+#pragma omp parallel for num_threads(number_of_threads) schedule(dynamic, 1)
+    for ( count = 0; count < number_of_dump_files; count++ ) {
+        partial_sums[ReturnThreadNumberOfCurrentThread( )]->AddArraysFromFile(dump_files[count]);
+    }
+
+    // Pairwise tree reduction, freeing each partial sum as soon as it has been added
+    Reconstruct3D::AddPartialSumsInTree(partial_sums, number_of_threads);
+}
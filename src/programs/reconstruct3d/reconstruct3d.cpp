@@ -55,7 +55,8 @@ void Reconstruct3DApp::DoInteractiveUserInput( ) {
     bool     dump_arrays              = false;
     wxString dump_file_1;
     wxString dump_file_2;
-    int      max_threads = 1;
+    int      max_threads                          = 1;
+    bool     share_reconstruction_between_threads = false;
 
     UserInput* my_input = new UserInput("Reconstruct3D", 1.05);
 
@@ -101,16 +102,18 @@ void Reconstruct3DApp::DoInteractiveUserInput( ) {
     dump_file_2 = my_input->GetFilenameFromUser("Output dump filename for even particles", "The name of the second dump file with the intermediate reconstruction arrays", "dump_file_2.dat", false);
 
 #ifdef _OPENMP
-    max_threads = my_input->GetIntFromUser("Max. threads to use for calculation", "When threading, what is the max threads to run", "1", 1);
+    max_threads                          = my_input->GetIntFromUser("Max. threads to use for calculation", "When threading, what is the max threads to run", "1", 1);
+    share_reconstruction_between_threads = my_input->GetYesNoFromUser("Share 3D arrays between threads", "Should all threads insert into the same 3D arrays? This keeps memory use independent of the number of threads, at the cost of slower insertion", "No");
 #else
-    max_threads = 1;
+    max_threads                          = 1;
+    share_reconstruction_between_threads = false;
 #endif
 
     delete my_input;
 
     //	my_current_job.Reset(33);
     //	my_current_job.ManualSetArguments("ttttttttiifffffffffffffbbbbbbbbbibtt",	input_particle_stack.ToUTF8().data(),
-    my_current_job.ManualSetArguments("ttttttttiiffffffffffbbbbbbbbbbttii", input_particle_stack.ToUTF8( ).data( ),
+    my_current_job.ManualSetArguments("ttttttttiiffffffffffbbbbbbbbbbttiib", input_particle_stack.ToUTF8( ).data( ),
                                       input_star_filename.ToUTF8( ).data( ),
                                       input_reconstruction.ToUTF8( ).data( ),
                                       output_reconstruction_1.ToUTF8( ).data( ),
@@ -128,7 +131,8 @@ void Reconstruct3DApp::DoInteractiveUserInput( ) {
                                       dump_file_1.ToUTF8( ).data( ),
                                       dump_file_2.ToUTF8( ).data( ),
                                       correct_ewald_sphere,
-                                      max_threads);
+                                      max_threads,
+                                      share_reconstruction_between_threads);
 }
 
 // override the do calculation method which will be what is actually run..
@@ -164,11 +168,12 @@ bool Reconstruct3DApp::DoCalculation( ) {
     bool     use_input_reconstruction       = my_current_job.arguments[27].ReturnBoolArgument( );
     bool     threshold_input_3d             = my_current_job.arguments[28].ReturnBoolArgument( );
     //	int		 correct_ewald_sphere				= my_current_job.arguments[32].ReturnIntegerArgument();
-    bool     dump_arrays          = my_current_job.arguments[29].ReturnBoolArgument( );
-    wxString dump_file_1          = my_current_job.arguments[30].ReturnStringArgument( );
-    wxString dump_file_2          = my_current_job.arguments[31].ReturnStringArgument( );
-    int      correct_ewald_sphere = my_current_job.arguments[32].ReturnIntegerArgument( );
-    int      max_threads          = my_current_job.arguments[33].ReturnIntegerArgument( );
+    bool     dump_arrays                          = my_current_job.arguments[29].ReturnBoolArgument( );
+    wxString dump_file_1                          = my_current_job.arguments[30].ReturnStringArgument( );
+    wxString dump_file_2                          = my_current_job.arguments[31].ReturnStringArgument( );
+    int      correct_ewald_sphere                 = my_current_job.arguments[32].ReturnIntegerArgument( );
+    int      max_threads                          = my_current_job.arguments[33].ReturnIntegerArgument( );
+    bool     share_reconstruction_between_threads = my_current_job.arguments[34].ReturnBoolArgument( );
 
     // When multiple particle groups are present this boolean will be set true via a call to star_file.ReturnTrueIfThereAreMultipleParticleGroups).
     // We need to apply the exposure filter during reconstruction. For now, this is only used in reconstruction 3d's from tilt series data.
@@ -259,6 +264,7 @@ bool Reconstruct3DApp::DoCalculation( ) {
         exit(-1);
     }
     MRCFile  input_stack(input_particle_stack.ToStdString( ), false);
+    input_stack.MapFileIntoMemory( ); // particles are only read, share the page cache with the other jobs on this node
     MRCFile* input_3d_file;
     if ( use_input_reconstruction ) {
         if ( ! DoesFileExist(input_reconstruction) ) {
@@ -486,8 +492,11 @@ bool Reconstruct3DApp::DoCalculation( ) {
 		parameter_variance[i] -= powf(parameter_average[i],2);
 	}*/
 
-    parameter_averages  = input_star_file.ReturnParameterAverages( );
-    parameter_variances = input_star_file.ReturnParameterVariances( );
+    // the outliers have been removed and the scores adjusted above, so the statistics are calculated rather than taken from the file
+    cisTEMParameterStatistics parameter_statistics = input_star_file.ReturnParameterStatistics( );
+
+    parameter_averages  = parameter_statistics.averages;
+    parameter_variances = parameter_statistics.variances;
 
     input_particle.SetParameterStatistics(parameter_averages, parameter_variances);
     input_particle.mask_radius  = outer_mask_radius;
@@ -700,6 +709,9 @@ bool Reconstruct3DApp::DoCalculation( ) {
         }
     }
 
+    my_reconstruction_1.is_shared_between_threads = share_reconstruction_between_threads && max_threads > 1;
+    my_reconstruction_2.is_shared_between_threads = share_reconstruction_between_threads && max_threads > 1;
+
     wxPrintf("\nCalculating reconstruction...\n\n");
     images_to_process_per_thread = std::max(images_to_process / max_threads, 4);
     if ( is_running_locally == true )
@@ -711,7 +723,7 @@ bool Reconstruct3DApp::DoCalculation( ) {
                                                                    pixel_size, my_progress, outer_mask_radius, mask_falloff, current_image, padded_box_size, binning_factor,                                                                                                                                        \
                                                                    rotational_blurring, number_of_rotations, psi_step, psi_start, smoothing_factor, intermediate_box_size, original_pixel_size, calculate_complex_ctf, parameter_averages,                                                                          \
                                                                    parameter_variances, fsc_particle_repeat, score_weight_conversion, my_symmetry, correct_ewald_sphere, my_reconstruction_1, my_reconstruction_2, center_mass,                                                                                     \
-                                                                   images_to_process_per_thread, apply_exposure_filter_during_reconstruction) private(i, j, image_counter, input_particle, current_image_local, input_parameters, temp_float, input_ctf, variance, average, current_ctf,                            \
+                                                                   images_to_process_per_thread, apply_exposure_filter_during_reconstruction, share_reconstruction_between_threads) private(i, j, image_counter, input_particle, current_image_local, input_parameters, temp_float, input_ctf, variance, average, current_ctf,                            \
                                                                                                                                                       input_image_local, projection_image, padded_projection_image, temp3_image_local, padded_image, cropped_projection_image, temp_image_local, temp2_image_local, \
                                                                                                                                                       current_ctf_image, current_beamtilt_image, unmasked_image, ssq_X, psi, rotation_angle, rotation_cache)
     { // for omp
@@ -744,18 +756,27 @@ bool Reconstruct3DApp::DoCalculation( ) {
         input_particle.SetParameterStatistics(parameter_averages, parameter_variances);
         input_particle.mask_radius  = outer_mask_radius;
         input_particle.mask_falloff = mask_falloff;
-        Reconstruct3D my_reconstruction_1_local(box_size, box_size, box_size, pixel_size, parameter_averages.occupancy, parameter_averages.score, score_weight_conversion, my_symmetry, correct_ewald_sphere);
-        Reconstruct3D my_reconstruction_2_local(box_size, box_size, box_size, pixel_size, parameter_averages.occupancy, parameter_averages.score, score_weight_conversion, my_symmetry, correct_ewald_sphere);
-        my_reconstruction_1_local.original_x_dimension = original_box_size;
-        my_reconstruction_1_local.original_y_dimension = original_box_size;
-        my_reconstruction_1_local.original_z_dimension = original_box_size;
-        my_reconstruction_1_local.original_pixel_size  = original_pixel_size;
-        my_reconstruction_1_local.center_mass          = center_mass;
-        my_reconstruction_2_local.original_x_dimension = original_box_size;
-        my_reconstruction_2_local.original_y_dimension = original_box_size;
-        my_reconstruction_2_local.original_z_dimension = original_box_size;
-        my_reconstruction_2_local.original_pixel_size  = original_pixel_size;
-        my_reconstruction_2_local.center_mass          = center_mass;
+        // Unless the threads share the final reconstructions, each thread inserts into its own pair and adds them up at the end
+        Reconstruct3D  my_reconstruction_1_local(pixel_size, parameter_averages.occupancy, parameter_averages.score, score_weight_conversion, my_symmetry, correct_ewald_sphere);
+        Reconstruct3D  my_reconstruction_2_local(pixel_size, parameter_averages.occupancy, parameter_averages.score, score_weight_conversion, my_symmetry, correct_ewald_sphere);
+        Reconstruct3D* reconstruction_1_to_insert_into = &my_reconstruction_1;
+        Reconstruct3D* reconstruction_2_to_insert_into = &my_reconstruction_2;
+        if ( ! share_reconstruction_between_threads ) {
+            my_reconstruction_1_local.Init(box_size, box_size, box_size, pixel_size, parameter_averages.occupancy, parameter_averages.score, score_weight_conversion, correct_ewald_sphere);
+            my_reconstruction_2_local.Init(box_size, box_size, box_size, pixel_size, parameter_averages.occupancy, parameter_averages.score, score_weight_conversion, correct_ewald_sphere);
+            my_reconstruction_1_local.original_x_dimension = original_box_size;
+            my_reconstruction_1_local.original_y_dimension = original_box_size;
+            my_reconstruction_1_local.original_z_dimension = original_box_size;
+            my_reconstruction_1_local.original_pixel_size  = original_pixel_size;
+            my_reconstruction_1_local.center_mass          = center_mass;
+            my_reconstruction_2_local.original_x_dimension = original_box_size;
+            my_reconstruction_2_local.original_y_dimension = original_box_size;
+            my_reconstruction_2_local.original_z_dimension = original_box_size;
+            my_reconstruction_2_local.original_pixel_size  = original_pixel_size;
+            my_reconstruction_2_local.center_mass          = center_mass;
+            reconstruction_1_to_insert_into                = &my_reconstruction_1_local;
+            reconstruction_2_to_insert_into                = &my_reconstruction_2_local;
+        }
 
         image_counter = 0;
 
@@ -772,10 +793,12 @@ bool Reconstruct3DApp::DoCalculation( ) {
                 //input_parameters.image_shift_y = -input_parameters.image_shift_y;
 
                 current_image++;
-                if ( input_parameters.position_in_stack >= first_particle && input_parameters.position_in_stack <= last_particle ) {
-                    input_image_local.ReadSlice(&input_stack, input_parameters.position_in_stack);
-                    input_image_local.ChangePixelSize(&input_image_local, original_pixel_size / input_parameters.pixel_size, 0.001f);
-                }
+            }
+
+            if ( input_parameters.position_in_stack >= first_particle && input_parameters.position_in_stack <= last_particle ) {
+                cistem_timer::ProfileScope profile_scope("ReadParticle");
+                input_image_local.ReadSliceThreadSafe(&input_stack, input_parameters.position_in_stack);
+                input_image_local.ChangePixelSize(&input_image_local, original_pixel_size / input_parameters.pixel_size, 0.001f);
             }
 
             if ( input_parameters.position_in_stack < first_particle || input_parameters.position_in_stack > last_particle )
@@ -1209,14 +1232,14 @@ bool Reconstruct3DApp::DoCalculation( ) {
 		 * Insert the particle image into one of the two half maps
 		 */
             if ( input_particle.insert_even ) {
-                my_reconstruction_2_local.InsertSliceWithCTF(input_particle, symmetry_weight);
+                reconstruction_2_to_insert_into->InsertSliceWithCTF(input_particle, symmetry_weight);
             }
             else {
                 //			for (i = 0; i < input_particle.particle_image->real_memory_allocated / 2; i++) input_particle.particle_image->complex_values[i] = 1.0f + I * 0.0f;
                 //			for (i = 0; i < input_particle.ctf_image->real_memory_allocated / 2; i++) input_particle.ctf_image->complex_values[i] = 1.0f + I * 0.0f;
                 //			wxPrintf("2D central pixel = %g\n", std::abs(input_particle.particle_image->complex_values[0]));
                 //			wxPrintf("2D central CTF   = %g\n", std::abs(input_particle.ctf_image->complex_values[0]));
-                my_reconstruction_1_local.InsertSliceWithCTF(input_particle, symmetry_weight);
+                reconstruction_1_to_insert_into->InsertSliceWithCTF(input_particle, symmetry_weight);
                 //			wxPrintf("3D central pixel = %g ratio = %g\n", std::abs(my_reconstruction_1.image_reconstruction.complex_values[0]), std::abs(my_reconstruction_1.image_reconstruction.complex_values[0])/std::abs(input_particle.particle_image->complex_values[0]));
                 //			wxPrintf("3D central CTF   = %g\n", std::abs(my_reconstruction_1.ctf_reconstruction[0]));
             }
@@ -1233,10 +1256,12 @@ bool Reconstruct3DApp::DoCalculation( ) {
                 my_progress->Update(std::min(images_to_process_per_thread, image_counter));
         }
 
+        if ( ! share_reconstruction_between_threads ) {
 #pragma omp critical
-        {
-            my_reconstruction_1 += my_reconstruction_1_local;
-            my_reconstruction_2 += my_reconstruction_2_local;
+            {
+                my_reconstruction_1 += my_reconstruction_1_local;
+                my_reconstruction_2 += my_reconstruction_2_local;
+            }
         }
 
         input_image_local.Deallocate( );
@@ -1263,6 +1288,9 @@ bool Reconstruct3DApp::DoCalculation( ) {
 
     } // end omp section
 
+    my_reconstruction_1.is_shared_between_threads = false;
+    my_reconstruction_2.is_shared_between_threads = false;
+
     if ( is_running_locally == true )
         delete my_progress;
 
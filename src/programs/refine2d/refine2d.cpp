@@ -239,12 +239,15 @@ bool Refine2DApp::DoCalculation( ) {
 
     input_star_file.ReadFromcisTEMStarFile(input_star_filename);
 
-    // Read whole parameter file to work out average values and variances
+    // Average values and variances over the whole parameter file, as stored in the file when it was written for this classification
 
-    parameter_average  = input_star_file.ReturnParameterAverages( );
-    parameter_variance = input_star_file.ReturnParameterVariances( );
+    cisTEMParameterStatistics parameter_statistics = input_star_file.ReturnStoredOrCalculatedParameterStatistics( );
+
+    parameter_average  = parameter_statistics.averages;
+    parameter_variance = parameter_statistics.variances;
 
     MRCFile input_stack(input_particle_images.ToStdString( ), false);
+    input_stack.MapFileIntoMemory( ); // particles are only read, share the page cache with the other jobs on this node
     //	FrealignParameterFile input_par_file(input_parameter_file, OPEN_TO_READ);
     //	FrealignParameterFile output_par_file(ouput_parameter_file, OPEN_TO_WRITE);
     MRCFile* input_classes  = NULL;
@@ -930,7 +933,10 @@ bool Refine2DApp::DoCalculation( ) {
                 continue;
             }
 
-            input_image_local.ReadSlice(&input_stack, input_parameters.position_in_stack);
+            {
+                cistem_timer::ProfileScope profile_scope("ReadParticle");
+                input_image_local.ReadSliceThreadSafe(&input_stack, input_parameters.position_in_stack);
+            }
 
             if ( exclude_blank_edges && (input_image_local.ContainsBlankEdges(mask_radius / input_parameters.pixel_size) || input_image_local.ContainsRepeatedLineEdges( )) ) {
                 number_of_blank_edges_local++;
@@ -1029,6 +1035,7 @@ bool Refine2DApp::DoCalculation( ) {
             //???		input_particle_local.mask_volume = padded_image.CosineMask(padded_image.physical_address_of_box_center_x - mask_falloff / pixel_size, mask_falloff / pixel_size);
 
             for ( i = 0; i < number_of_rotations; i++ ) {
+                cistem_timer::ProfileScope profile_scope("Rotate2DSample");
                 psi = i * psi_step + psi_start;
                 rotation_angle.GenerateRotationMatrix2D(psi);
                 padded_image.Rotate2DSample(rotation_cache[i], rotation_angle);
@@ -1240,6 +1247,7 @@ bool Refine2DApp::DoCalculation( ) {
 }
 
 void Refine2DApp::DumpArrays( ) {
+    cistem_timer::ProfileScope profile_scope("DumpArrays");
     int   i;
     int   count = 0;
     char  temp_char[4 * sizeof(int) + 6 * sizeof(float)];
@@ -32,6 +32,58 @@ class ImageProjectionComparison {
     //	Image						*temp_image;
 };
 
+// Everything refine3d prepares from the input reconstruction. With the WorkerCache enabled, this is kept for the following jobs of the
+// same package, which then skip reading, masking, padding and transforming the references and generating the projection cache.
+class Refine3DReferences {
+  public:
+    ReconstructedVolume input_3d;
+    ReconstructedVolume search_reference_3d;
+    int                 search_box_size;
+    int                 binned_search_image_box_size;
+    int                 best_parameters_to_keep;
+    bool                skip_local_refinement;
+    float               binning_factor_search;
+    float               mask_radius_search;
+    float               angular_step;
+    float               psi_max;
+    float               psi_step;
+    float               psi_start;
+    EulerSearch         global_euler_search;
+    Image*              projection_cache;
+
+    Refine3DReferences( ) {
+        search_box_size              = 0;
+        binned_search_image_box_size = 0;
+        best_parameters_to_keep      = 0;
+        skip_local_refinement        = false;
+        binning_factor_search        = 0.0f;
+        mask_radius_search           = 0.0f;
+        angular_step                 = 0.0f;
+        psi_max                      = 0.0f;
+        psi_step                     = 0.0f;
+        psi_start                    = 0.0f;
+        projection_cache             = NULL;
+    }
+
+    ~Refine3DReferences( ) {
+        if ( projection_cache != NULL )
+            delete[] projection_cache;
+    }
+};
+
+// Let volume_to_fill use the density map of other_volume, without taking ownership of it
+static void BorrowVolume(ReconstructedVolume& other_volume, ReconstructedVolume& volume_to_fill) {
+    volume_to_fill.CopyAllButVolume(&other_volume);
+    volume_to_fill.density_map = other_volume.density_map;
+}
+
+// As BorrowVolume, but new_owner also takes over the density map, which other_volume may keep using for as long as new_owner exists
+static void HandOverVolume(ReconstructedVolume& other_volume, ReconstructedVolume& new_owner) {
+    BorrowVolume(other_volume, new_owner);
+    new_owner.volume_initialized    = other_volume.volume_initialized;
+    other_volume.volume_initialized = false;
+}
+
 ImageProjectionComparison::ImageProjectionComparison( ) {
     x_shift_limit      = FLT_MAX;
     y_shift_limit      = FLT_MAX;
@@ -501,6 +553,7 @@ bool Refine3DApp::DoCalculation( ) {
     cisTEMParameterLine search_parameters;
     cisTEMParameterLine parameter_average;
     cisTEMParameterLine parameter_variance;
+    float               average_sigma;
     cisTEMParameterLine output_parameter_change;
 
     float cg_starting_point[17];
@@ -561,14 +614,46 @@ bool Refine3DApp::DoCalculation( ) {
     //	wxPrintf("\nOpening input file %s.\n", input_parameter_file);
 
     //FrealignParameterFile input_par_file(input_parameter_file, OPEN_TO_READ);
-    cisTEMParameters input_star_file;
+    // A columnar parameter file is memory mapped, the statistics over the whole dataset are taken from its columns and only the
+    // particles of this job are read (once the range is known, below). Any other file is read whole.
+    cisTEMColumnarParameterReader     columnar_reader;
+    bool                              input_is_columnar = cisTEMColumnarParameterReader::IsColumnarFile(input_star_filename);
+    std::shared_ptr<cisTEMParameters> cached_star_file;
+
+    // Jobs of the same package that run in this process can share the parsed star file and the references (see WorkerCache)
+    WorkerCache& worker_cache = WorkerCache::GetInstance( );
+
+    if ( input_is_columnar ) {
+        if ( columnar_reader.Open(input_star_filename) == false ) {
+            SendErrorAndCrash(wxString::Format("Error: Can't read columnar parameter file %s\n", input_star_filename));
+        }
+        cached_star_file = std::make_shared<cisTEMParameters>( );
 
-    input_star_file.ReadFromcisTEMStarFile(input_star_filename);
+        parameter_average  = columnar_reader.ReturnParameterAverages( );
+        parameter_variance = columnar_reader.ReturnParameterVariances( );
+        average_sigma      = columnar_reader.ReturnAverageSigma(true);
+    }
+    else {
+        wxString star_file_key;
+        if ( worker_cache.IsEnabled( ) ) {
+            star_file_key    = WorkerCache::ReturnFileKey(input_star_filename);
+            cached_star_file = worker_cache.ReturnObject<cisTEMParameters>("refine3d star file", star_file_key);
+        }
+        if ( ! cached_star_file ) {
+            cached_star_file = std::make_shared<cisTEMParameters>( );
+            cached_star_file->ReadFromcisTEMStarFile(input_star_filename);
+            worker_cache.StoreObject("refine3d star file", star_file_key, cached_star_file);
+        }
+
+        // Average values and variances over the whole parameter file, as stored in the file when it was written for this refinement
 
-    // Read whole parameter file to work out average values and variances
+        cisTEMParameterStatistics parameter_statistics = cached_star_file->ReturnStoredOrCalculatedParameterStatistics( );
 
-    parameter_average  = input_star_file.ReturnParameterAverages( );
-    parameter_variance = input_star_file.ReturnParameterVariances( );
+        parameter_average  = parameter_statistics.averages;
+        parameter_variance = parameter_statistics.variances;
+        average_sigma      = parameter_statistics.averages.sigma;
+    }
+    cisTEMParameters& input_star_file = *cached_star_file;
 
     defocus_lower_limit = 15000.0 * sqrtf(parameter_average.microscope_voltage_kv / 300.0);
     defocus_upper_limit = 25000.0 * sqrtf(parameter_average.microscope_voltage_kv / 300.0);
@@ -576,6 +661,7 @@ bool Refine3DApp::DoCalculation( ) {
     defocus_range_std   = 0.5 * (defocus_upper_limit - defocus_lower_limit);
 
     MRCFile input_stack(input_particle_images.ToStdString( ), false);
+    input_stack.MapFileIntoMemory( ); // particles are only read, share the page cache with the other jobs on this node
 
     if ( last_particle == 0 )
         last_particle = input_stack.ReturnZSize( );
@@ -584,22 +670,46 @@ bool Refine3DApp::DoCalculation( ) {
     if ( last_particle > input_stack.ReturnZSize( ) )
         last_particle = input_stack.ReturnZSize( );
 
+    if ( input_is_columnar ) {
+        input_star_file.ReadFromcisTEMColumnarFile(input_star_filename, false, first_particle, last_particle);
+    }
+
     for ( current_line = 0; current_line < input_star_file.ReturnNumberofLines( ); current_line++ ) {
         if ( input_star_file.ReturnPositionInStack(current_line) >= first_particle && input_star_file.ReturnPositionInStack(current_line) <= last_particle )
             images_to_process++;
     }
 
     //input_par_file.ReadFile(false, input_stack.ReturnZSize());
-    random_particle.SetSeed(int(10000.0 * fabsf(input_star_file.ReturnAverageSigma(true))) % 10000);
-    if ( defocus_bias ) {
-        float* buffer_array = new float[input_star_file.ReturnNumberofLines( )];
-        for ( current_line = 0; current_line < input_star_file.ReturnNumberofLines( ); current_line++ ) {
-            buffer_array[current_line] = expf(-powf(0.25 * (fabsf(input_star_file.ReturnDefocus1(current_line)) + fabsf(input_star_file.ReturnDefocus2(current_line)) - defocus_range_mean2) / defocus_range_std, 2.0));
+    random_particle.SetSeed(int(10000.0 * fabsf(average_sigma)) % 10000);
+    if ( defocus_bias && input_is_columnar ) {
+        // the median is over the whole dataset, as below, so it comes from the defocus columns rather than the lines of this job
+        const float* defocus_1_column = columnar_reader.ReturnFloatColumn(DEFOCUS_1);
+        const float* defocus_2_column = columnar_reader.ReturnFloatColumn(DEFOCUS_2);
+        long         number_of_lines  = columnar_reader.ReturnNumberOfLines( );
+        float*       buffer_array     = new float[number_of_lines];
+#pragma omp parallel for num_threads(max_threads)
+        for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+            float defocus_1            = (defocus_1_column == NULL) ? 0.0f : defocus_1_column[line_counter];
+            float defocus_2            = (defocus_2_column == NULL) ? 0.0f : defocus_2_column[line_counter];
+            buffer_array[line_counter] = expf(-powf(0.25 * (fabsf(defocus_1) + fabsf(defocus_2) - defocus_range_mean2) / defocus_range_std, 2.0));
+        }
+        // the median, as below
+        std::nth_element(buffer_array, buffer_array + number_of_lines / 2, buffer_array + number_of_lines - 1);
+        defocus_mean_score = buffer_array[number_of_lines / 2];
+        delete[] buffer_array;
+    }
+    else if ( defocus_bias ) {
+        long   number_of_lines = input_star_file.ReturnNumberofLines( );
+        float* buffer_array    = new float[number_of_lines];
+#pragma omp parallel for num_threads(max_threads)
+        for ( long line_counter = 0; line_counter < number_of_lines; line_counter++ ) {
+            buffer_array[line_counter] = expf(-powf(0.25 * (fabsf(input_star_file.ReturnDefocus1(line_counter)) + fabsf(input_star_file.ReturnDefocus2(line_counter)) - defocus_range_mean2) / defocus_range_std, 2.0));
             //			defocus_mean_score += expf(- powf(0.25 * (fabsf(input_par_file.ReadParameter(current_line, 8)) + fabsf(input_par_file.ReadParameter(current_line, 9)) - defocus_range_mean2) / defocus_range_std, 2.0));
             //			wxPrintf("df, score = %i %g %g\n", current_line, input_par_file.ReadParameter(current_line, 8), buffer_array[current_line]);
         }
-        std::sort(buffer_array, buffer_array + input_star_file.ReturnNumberofLines( ) - 1);
-        defocus_mean_score = buffer_array[input_star_file.ReturnNumberofLines( ) / 2];
+        // the median, without sorting the rest. As before, the last line is left out of the ordering.
+        std::nth_element(buffer_array, buffer_array + number_of_lines / 2, buffer_array + number_of_lines - 1);
+        defocus_mean_score = buffer_array[number_of_lines / 2];
         //		wxPrintf("median = %g\n", defocus_mean_score);
         //		defocus_mean_score /= current_line;
         delete[] buffer_array;
@@ -739,9 +849,7 @@ bool Refine3DApp::DoCalculation( ) {
     if ( mask_radius_search > float(input_stack.ReturnXSize( )) / 2.0 * pixel_size - mask_falloff )
         mask_radius_search = float(input_stack.ReturnXSize( )) / 2.0 * pixel_size - mask_falloff;
 
-    input_3d.InitWithDimensions(input_file.ReturnXSize( ), input_file.ReturnYSize( ), input_file.ReturnZSize( ), pixel_size, my_symmetry);
-    input_3d.molecular_mass_in_kDa = molecular_mass_kDa;
-    ResolutionStatistics input_statistics(pixel_size, input_3d.density_map->logical_y_dimension);
+    ResolutionStatistics input_statistics(pixel_size, input_file.ReturnYSize( ));
     ResolutionStatistics search_statistics;
     ResolutionStatistics refine_statistics;
     if ( use_statistics ) {
@@ -760,70 +868,126 @@ bool Refine3DApp::DoCalculation( ) {
         input_statistics.GenerateDefaultStatistics(molecular_mass_kDa);
     }
     refine_statistics = input_statistics;
-    input_3d.density_map->ReadSlices(&input_file, 1, input_3d.density_map->logical_z_dimension);
-    //!!! This line is incompatible with ML !!!
-    //	input_3d.density_map->CosineMask(outer_mask_radius / pixel_size, mask_falloff / pixel_size);
-    //	input_3d.density_map->AddConstant(- input_3d.density_map->ReturnAverageOfRealValuesOnEdges());
-    // Remove masking here to avoid edge artifacts later
-    input_3d.density_map->CosineMask(outer_mask_radius / pixel_size, mask_falloff / pixel_size, false, true, 0.0);
-    if ( inner_mask_radius > 0.0 )
-        input_3d.density_map->CosineMask(inner_mask_radius / pixel_size, mask_falloff / pixel_size, true);
-    //	for (i = 0; i < input_3d.density_map->real_memory_allocated; i++) if (input_3d.density_map->real_values[i] < 0.0) input_3d.density_map->real_values[i] = -log(-input_3d.density_map->real_values[i] + 1.0);
-    if ( threshold_input_3d ) {
-        average_density_max = input_3d.density_map->ReturnAverageOfMaxN(100, outer_mask_radius / pixel_size);
-        input_3d.density_map->SetMinimumValue(-0.3 * average_density_max);
-        //		input_3d.density_map->SetMinimumValue(0.0);
-    }
 
-    //	input_image.Allocate(input_stack.ReturnXSize(), input_stack.ReturnYSize(), true);
-    //	if (outer_mask_radius > input_image.physical_address_of_box_center_x * pixel_size- mask_falloff) outer_mask_radius = input_image.physical_address_of_box_center_x * pixel_size - mask_falloff;
-    //	if (mask_radius_search > input_image.physical_address_of_box_center_x * pixel_size- mask_falloff) mask_radius_search = input_image.physical_address_of_box_center_x * pixel_size - mask_falloff;
-    input_3d.mask_radius = outer_mask_radius;
+    // The prepared references only depend on the reconstruction and on arguments that are the same for all jobs of a package
+    wxString                            references_key;
+    std::shared_ptr<Refine3DReferences> cached_references;
+    bool                                projection_cache_is_cached = false;
+    if ( worker_cache.IsEnabled( ) ) {
+        references_key = WorkerCache::ReturnFileKey(input_reconstruction);
+        references_key += wxString::Format("|%f|%s|%f|%f|%f|%f|%f|%f|%i", pixel_size, my_symmetry, molecular_mass_kDa, inner_mask_radius, outer_mask_radius, mask_falloff, mask_radius_search, padding, int(threshold_input_3d));
+        references_key += wxString::Format("|%i|%f|%f|%f|%f|%f|%f|%i", int(global_search), low_resolution_limit, high_resolution_limit, high_resolution_limit_search, angular_step, max_search_x, max_search_y, best_parameters_to_keep);
+        references_key += wxString::Format("|%i|%i|%i|%i|%i", int(refine_particle.parameter_map.psi), int(refine_particle.parameter_map.theta), int(refine_particle.parameter_map.phi),
+                                           int(refine_particle.parameter_map.x_shift), int(refine_particle.parameter_map.y_shift));
+        cached_references = worker_cache.ReturnObject<Refine3DReferences>("refine3d references", references_key);
+    }
 
-    if ( global_search ) {
-        if ( best_parameters_to_keep == 0 ) {
-            best_parameters_to_keep = 1;
-            skip_local_refinement   = true;
+    if ( cached_references ) {
+        wxPrintf("\nRe-using the references prepared by an earlier job\n");
+        BorrowVolume(cached_references->input_3d, input_3d);
+        if ( global_search ) {
+            BorrowVolume(cached_references->search_reference_3d, search_reference_3d);
+            search_statistics            = input_statistics;
+            search_box_size              = cached_references->search_box_size;
+            binned_search_image_box_size = cached_references->binned_search_image_box_size;
+            best_parameters_to_keep      = cached_references->best_parameters_to_keep;
+            skip_local_refinement        = cached_references->skip_local_refinement;
+            binning_factor_search        = cached_references->binning_factor_search;
+            mask_radius_search           = cached_references->mask_radius_search;
+            angular_step                 = cached_references->angular_step;
+            psi_max                      = cached_references->psi_max;
+            psi_step                     = cached_references->psi_step;
+            psi_start                    = cached_references->psi_start;
         }
-        // Assume square particles
-        search_reference_3d = input_3d;
-        search_statistics   = input_statistics;
-        search_box_size     = ReturnClosestFactorizedUpper(myroundint(2.0 / pixel_size * (std::max(max_search_x, max_search_y) + mask_radius_search)), 3, true);
-        if ( search_box_size > search_reference_3d.density_map->logical_x_dimension )
-            search_box_size = search_reference_3d.density_map->logical_x_dimension;
-        if ( search_box_size != search_reference_3d.density_map->logical_x_dimension * padding )
-            search_reference_3d.density_map->Resize(search_box_size * padding, search_box_size * padding, search_box_size * padding);
-        if ( mask_radius_search > float(search_box_size) / 2.0 * pixel_size - mask_falloff )
-            mask_radius_search = float(search_box_size) / 2.0 * pixel_size - mask_falloff;
-        //		search_reference_3d.PrepareForProjections(high_resolution_limit_search, true);
-        search_reference_3d.PrepareForProjections(low_resolution_limit, high_resolution_limit_search, true);
-        //		search_statistics.Init(search_reference_3d.pixel_size, search_reference_3d.density_map->logical_y_dimension / 2 + 1);
-        binning_factor_search        = search_reference_3d.pixel_size / pixel_size;
-        binned_search_image_box_size = myroundint(search_reference_3d.density_map->logical_x_dimension / padding);
-        //		search_particle.Allocate(binned_search_image_box_size, binned_search_image_box_size);
-        //		search_projection_image.Allocate(search_reference_3d.density_map->logical_x_dimension, search_reference_3d.density_map->logical_y_dimension, false);
-        //		temp_image2.Allocate(search_box_size, search_box_size, true);
-        //Scale to make projections compatible with images for ML calculation
-        search_reference_3d.density_map->MultiplyByConstant(powf(powf(binning_factor_search, 1.0 / 3.0), 2));
-        //if (angular_step <= 0) angular_step = 360.0 * high_resolution_limit_search / PI / outer_mask_radius;
-        if ( angular_step <= 0 )
-            angular_step = CalculateAngularStep(high_resolution_limit_search, outer_mask_radius);
-        psi_step  = rad_2_deg(search_reference_3d.pixel_size / outer_mask_radius);
-        psi_step  = 360.0 / int(360.0 / psi_step + 0.5);
-        psi_start = psi_step / 2.0 * global_random_number_generator.GetUniformRandom( );
-        psi_max   = 0.0;
-        if ( refine_particle.parameter_map.psi )
-            psi_max = 360.0;
-        wxPrintf("\nBox size for search = %i, binning factor = %f, new pixel size = %f, resolution limit = %f\nAngular step size = %f, in-plane = %f\n", search_reference_3d.density_map->logical_x_dimension, binning_factor_search, search_reference_3d.pixel_size, search_reference_3d.pixel_size * 2.0, angular_step, psi_step);
     }
+    else {
+        input_3d.InitWithDimensions(input_file.ReturnXSize( ), input_file.ReturnYSize( ), input_file.ReturnZSize( ), pixel_size, my_symmetry);
+        input_3d.molecular_mass_in_kDa = molecular_mass_kDa;
+        input_3d.density_map->ReadSlices(&input_file, 1, input_3d.density_map->logical_z_dimension);
+        //!!! This line is incompatible with ML !!!
+        //	input_3d.density_map->CosineMask(outer_mask_radius / pixel_size, mask_falloff / pixel_size);
+        //	input_3d.density_map->AddConstant(- input_3d.density_map->ReturnAverageOfRealValuesOnEdges());
+        // Remove masking here to avoid edge artifacts later
+        input_3d.density_map->CosineMask(outer_mask_radius / pixel_size, mask_falloff / pixel_size, false, true, 0.0);
+        if ( inner_mask_radius > 0.0 )
+            input_3d.density_map->CosineMask(inner_mask_radius / pixel_size, mask_falloff / pixel_size, true);
+        //	for (i = 0; i < input_3d.density_map->real_memory_allocated; i++) if (input_3d.density_map->real_values[i] < 0.0) input_3d.density_map->real_values[i] = -log(-input_3d.density_map->real_values[i] + 1.0);
+        if ( threshold_input_3d ) {
+            average_density_max = input_3d.density_map->ReturnAverageOfMaxN(100, outer_mask_radius / pixel_size);
+            input_3d.density_map->SetMinimumValue(-0.3 * average_density_max);
+            //		input_3d.density_map->SetMinimumValue(0.0);
+        }
+
+        //	input_image.Allocate(input_stack.ReturnXSize(), input_stack.ReturnYSize(), true);
+        //	if (outer_mask_radius > input_image.physical_address_of_box_center_x * pixel_size- mask_falloff) outer_mask_radius = input_image.physical_address_of_box_center_x * pixel_size - mask_falloff;
+        //	if (mask_radius_search > input_image.physical_address_of_box_center_x * pixel_size- mask_falloff) mask_radius_search = input_image.physical_address_of_box_center_x * pixel_size - mask_falloff;
+        input_3d.mask_radius = outer_mask_radius;
+
+        if ( global_search ) {
+            if ( best_parameters_to_keep == 0 ) {
+                best_parameters_to_keep = 1;
+                skip_local_refinement   = true;
+            }
+            // Assume square particles
+            search_reference_3d = input_3d;
+            search_statistics   = input_statistics;
+            search_box_size     = ReturnClosestFactorizedUpper(myroundint(2.0 / pixel_size * (std::max(max_search_x, max_search_y) + mask_radius_search)), 3, true);
+            if ( search_box_size > search_reference_3d.density_map->logical_x_dimension )
+                search_box_size = search_reference_3d.density_map->logical_x_dimension;
+            if ( search_box_size != search_reference_3d.density_map->logical_x_dimension * padding )
+                search_reference_3d.density_map->Resize(search_box_size * padding, search_box_size * padding, search_box_size * padding);
+            if ( mask_radius_search > float(search_box_size) / 2.0 * pixel_size - mask_falloff )
+                mask_radius_search = float(search_box_size) / 2.0 * pixel_size - mask_falloff;
+            //		search_reference_3d.PrepareForProjections(high_resolution_limit_search, true);
+            search_reference_3d.PrepareForProjections(low_resolution_limit, high_resolution_limit_search, true);
+            //		search_statistics.Init(search_reference_3d.pixel_size, search_reference_3d.density_map->logical_y_dimension / 2 + 1);
+            binning_factor_search        = search_reference_3d.pixel_size / pixel_size;
+            binned_search_image_box_size = myroundint(search_reference_3d.density_map->logical_x_dimension / padding);
+            //		search_particle.Allocate(binned_search_image_box_size, binned_search_image_box_size);
+            //		search_projection_image.Allocate(search_reference_3d.density_map->logical_x_dimension, search_reference_3d.density_map->logical_y_dimension, false);
+            //		temp_image2.Allocate(search_box_size, search_box_size, true);
+            //Scale to make projections compatible with images for ML calculation
+            search_reference_3d.density_map->MultiplyByConstant(powf(powf(binning_factor_search, 1.0 / 3.0), 2));
+            //if (angular_step <= 0) angular_step = 360.0 * high_resolution_limit_search / PI / outer_mask_radius;
+            if ( angular_step <= 0 )
+                angular_step = CalculateAngularStep(high_resolution_limit_search, outer_mask_radius);
+            psi_step  = rad_2_deg(search_reference_3d.pixel_size / outer_mask_radius);
+            psi_step  = 360.0 / int(360.0 / psi_step + 0.5);
+            psi_start = psi_step / 2.0 * global_random_number_generator.GetUniformRandom( );
+            psi_max   = 0.0;
+            if ( refine_particle.parameter_map.psi )
+                psi_max = 360.0;
+            wxPrintf("\nBox size for search = %i, binning factor = %f, new pixel size = %f, resolution limit = %f\nAngular step size = %f, in-plane = %f\n", search_reference_3d.density_map->logical_x_dimension, binning_factor_search, search_reference_3d.pixel_size, search_reference_3d.pixel_size * 2.0, angular_step, psi_step);
+        }
+
+        if ( padding != 1.0 ) {
+            input_3d.density_map->Resize(input_3d.density_map->logical_x_dimension * padding, input_3d.density_map->logical_y_dimension * padding, input_3d.density_map->logical_z_dimension * padding, input_3d.density_map->ReturnAverageOfRealValuesOnEdges( ));
+            //		refine_statistics.part_SSNR.ResampleCurve(&refine_statistics.part_SSNR, refine_statistics.part_SSNR.NumberOfPoints( ) * padding);
+        }
 
-    if ( padding != 1.0 ) {
-        input_3d.density_map->Resize(input_3d.density_map->logical_x_dimension * padding, input_3d.density_map->logical_y_dimension * padding, input_3d.density_map->logical_z_dimension * padding, input_3d.density_map->ReturnAverageOfRealValuesOnEdges( ));
-        //		refine_statistics.part_SSNR.ResampleCurve(&refine_statistics.part_SSNR, refine_statistics.part_SSNR.NumberOfPoints( ) * padding);
+        //	input_3d.PrepareForProjections(high_resolution_limit);
+        input_3d.PrepareForProjections(low_resolution_limit, high_resolution_limit);
+
+        if ( worker_cache.IsEnabled( ) ) {
+            cached_references = std::make_shared<Refine3DReferences>( );
+            HandOverVolume(input_3d, cached_references->input_3d);
+            if ( global_search ) {
+                HandOverVolume(search_reference_3d, cached_references->search_reference_3d);
+                cached_references->search_box_size              = search_box_size;
+                cached_references->binned_search_image_box_size = binned_search_image_box_size;
+                cached_references->best_parameters_to_keep      = best_parameters_to_keep;
+                cached_references->skip_local_refinement        = skip_local_refinement;
+                cached_references->binning_factor_search        = binning_factor_search;
+                cached_references->mask_radius_search           = mask_radius_search;
+                cached_references->angular_step                 = angular_step;
+                cached_references->psi_max                      = psi_max;
+                cached_references->psi_step                     = psi_step;
+                cached_references->psi_start                    = psi_start;
+            }
+            worker_cache.StoreObject("refine3d references", references_key, cached_references);
+        }
     }
 
-    //	input_3d.PrepareForProjections(high_resolution_limit);
-    input_3d.PrepareForProjections(low_resolution_limit, high_resolution_limit);
     binning_factor_refine = input_3d.pixel_size / pixel_size;
     binned_image_box_size = myroundint(input_stack.ReturnXSize( ) / binning_factor_refine);
     //Scale to make projections compatible with images for ML calculation
@@ -968,14 +1132,27 @@ bool Refine3DApp::DoCalculation( ) {
 
         // Use projection_cache only if both phi and theta are searched; otherwise calculate projections on the fly
         if ( search_particle.parameter_map.phi && search_particle.parameter_map.theta ) {
-            global_euler_search.InitGrid(my_symmetry, angular_step, 0.0, 0.0, psi_max, psi_step, psi_start, search_reference_3d.pixel_size / high_resolution_limit_search, search_particle.parameter_map, best_parameters_to_keep);
-            if ( global_euler_search.best_parameters_to_keep != best_parameters_to_keep )
+            if ( cached_references && cached_references->projection_cache != NULL ) {
+                global_euler_search     = cached_references->global_euler_search;
                 best_parameters_to_keep = global_euler_search.best_parameters_to_keep;
-            projection_cache = new Image[global_euler_search.number_of_search_positions];
-            for ( i = 0; i < global_euler_search.number_of_search_positions; i++ ) {
-                projection_cache[i].Allocate(binned_search_image_box_size, binned_search_image_box_size, false);
+                projection_cache        = cached_references->projection_cache;
+            }
+            else {
+                global_euler_search.InitGrid(my_symmetry, angular_step, 0.0, 0.0, psi_max, psi_step, psi_start, search_reference_3d.pixel_size / high_resolution_limit_search, search_particle.parameter_map, best_parameters_to_keep);
+                if ( global_euler_search.best_parameters_to_keep != best_parameters_to_keep )
+                    best_parameters_to_keep = global_euler_search.best_parameters_to_keep;
+                projection_cache = new Image[global_euler_search.number_of_search_positions];
+                for ( i = 0; i < global_euler_search.number_of_search_positions; i++ ) {
+                    projection_cache[i].Allocate(binned_search_image_box_size, binned_search_image_box_size, false);
+                }
+                search_reference_3d.density_map->GenerateReferenceProjections(projection_cache, global_euler_search, search_reference_3d.pixel_size / high_resolution_limit_search);
+                if ( cached_references ) {
+                    // The cache takes over the projections
+                    cached_references->global_euler_search = global_euler_search;
+                    cached_references->projection_cache    = projection_cache;
+                }
             }
-            search_reference_3d.density_map->GenerateReferenceProjections(projection_cache, global_euler_search, search_reference_3d.pixel_size / high_resolution_limit_search);
+            projection_cache_is_cached = cached_references && cached_references->projection_cache == projection_cache;
             wxPrintf("\nNumber of global search views = %i (best_parameters to keep = %i)\n", global_euler_search.number_of_search_positions, global_euler_search.best_parameters_to_keep);
         }
         //		search_projection_image.RotateFourier2DGenerateIndex(kernel_index, psi_max, psi_step, psi_start);
@@ -1011,6 +1188,9 @@ bool Refine3DApp::DoCalculation( ) {
                                                                                                                                                                     temp_image_local, search_parameters, istart, parameter_to_keep, conjugate_gradient_minimizer, i, final_image, input_3d_local, euler_search_local, frealign_score_local)
     { // for omp
 
+        // Scratch images for the global search, kept for all particles handled by this thread
+        EulerSearchWorkspace euler_search_workspace_local;
+
         //	input_3d_local = input_3d;
         input_3d_local.CopyAllButVolume(&input_3d);
         input_3d_local.density_map = input_3d.density_map;
@@ -1049,9 +1229,10 @@ bool Refine3DApp::DoCalculation( ) {
             if ( input_parameters.position_in_stack < first_particle || input_parameters.position_in_stack > last_particle )
                 continue;
 
-// ReadSlice requires omp critical to avoid parallel reads, which may lead to the wrong slice being read
-#pragma omp critical
-            input_image_local.ReadSlice(&input_stack, input_parameters.position_in_stack);
+            {
+                cistem_timer::ProfileScope profile_scope("ReadParticle");
+                input_image_local.ReadSliceThreadSafe(&input_stack, input_parameters.position_in_stack);
+            }
             MyDebugAssertFalse(input_image_local.HasNan( ), "Input image read from disk has NaN. Position in stack = %i\n", input_parameters.position_in_stack);
 
             image_counter++;
@@ -1218,6 +1399,7 @@ bool Refine3DApp::DoCalculation( ) {
             refine_particle_local.PhaseShiftInverse( );
 
             if ( ctf_refinement && high_resolution_limit <= 20.0 ) {
+                cistem_timer::ProfileScope profile_scope("CTFRefinement");
                 //			wxPrintf("\nRefining defocus for parameter line %i\n", current_line);
                 refine_particle_local.filter_radius_low = 30.0;
                 refine_particle_local.SetIndexForWeightedCorrelation( );
@@ -1283,6 +1465,7 @@ bool Refine3DApp::DoCalculation( ) {
             if ( (refine_particle_local.number_of_search_dimensions > 0) && (global_search_local || local_refinement_local) ) {
                 input_parameters.score = -100.0 * FrealignObjectiveFunction(&comparison_object, cg_starting_point);
                 if ( global_search_local ) {
+                    cistem_timer::ProfileScope profile_scope("GlobalSearch");
                     //				my_time_in = wxDateTime::UNow();
                     search_particle_local.ResetImageFlags( );
                     search_particle_local.pixel_size = search_reference_3d_local.pixel_size;
@@ -1334,7 +1517,7 @@ bool Refine3DApp::DoCalculation( ) {
                             best_parameters_to_keep = euler_search_local.best_parameters_to_keep;
                         if ( ! search_particle_local.parameter_map.phi )
                             euler_search_local.psi_start = 360.0 - input_parameters.phi;
-                        euler_search_local.Run(search_particle_local, *search_reference_3d_local.density_map, projection_cache);
+                        euler_search_local.Run(search_particle_local, *search_reference_3d_local.density_map, projection_cache, &euler_search_workspace_local);
                     }
                     else if ( ! search_particle_local.parameter_map.phi && search_particle_local.parameter_map.theta ) {
                         euler_search_local.InitGrid(my_symmetry, angular_step, input_parameters.psi, 0.0, psi_max, psi_step, psi_start, search_reference_3d_local.pixel_size / high_resolution_limit_search, search_particle_local.parameter_map, best_parameters_to_keep);
@@ -1342,7 +1525,7 @@ bool Refine3DApp::DoCalculation( ) {
                             best_parameters_to_keep = euler_search_local.best_parameters_to_keep;
                         if ( ! search_particle_local.parameter_map.psi )
                             euler_search_local.psi_start = 360.0 - input_parameters.phi;
-                        euler_search_local.Run(search_particle_local, *search_reference_3d_local.density_map, projection_cache);
+                        euler_search_local.Run(search_particle_local, *search_reference_3d_local.density_map, projection_cache, &euler_search_workspace_local);
                     }
                     else if ( search_particle_local.parameter_map.phi && search_particle_local.parameter_map.theta ) {
                         if ( ! search_particle_local.parameter_map.psi )
@@ -1352,13 +1535,13 @@ bool Refine3DApp::DoCalculation( ) {
                         //					for (i = 0; i < euler_search_local.number_of_search_positions; i++) {projection_cache[i].SwapRealSpaceQuadrants(); projection_cache[i].QuickAndDirtyWriteSlice("projection.mrc", i + 1);}
                         //					search_particle_local.particle_image->QuickAndDirtyWriteSlice("particle_image.mrc", 1);
                         //					exit(0);
-                        euler_search_local.Run(search_particle_local, *search_reference_3d_local.density_map, projection_cache);
+                        euler_search_local.Run(search_particle_local, *search_reference_3d_local.density_map, projection_cache, &euler_search_workspace_local);
                     }
                     else if ( search_particle_local.parameter_map.psi ) {
                         euler_search_local.InitGrid(my_symmetry, angular_step, 0.0, 0.0, psi_max, psi_step, psi_start, search_reference_3d_local.pixel_size / high_resolution_limit_search, search_particle_local.parameter_map, best_parameters_to_keep);
                         if ( euler_search_local.best_parameters_to_keep != best_parameters_to_keep )
                             best_parameters_to_keep = euler_search_local.best_parameters_to_keep;
-                        euler_search_local.Run(search_particle_local, *search_reference_3d_local.density_map, projection_cache);
+                        euler_search_local.Run(search_particle_local, *search_reference_3d_local.density_map, projection_cache, &euler_search_workspace_local);
                     }
                     else {
                         euler_search_local.InitGrid(my_symmetry, angular_step, 0.0, 0.0, psi_max, psi_step, psi_start, search_reference_3d_local.pixel_size / high_resolution_limit_search, search_particle_local.parameter_map, best_parameters_to_keep);
@@ -1496,6 +1679,7 @@ bool Refine3DApp::DoCalculation( ) {
                 }
 
                 if ( local_refinement_local ) {
+                    cistem_timer::ProfileScope profile_scope("LocalRefinement");
                     //				my_time_in = wxDateTime::UNow();
                     comparison_object.reference_volume = &input_3d_local;
                     comparison_object.projection_image = &projection_image_local;
@@ -1571,6 +1755,7 @@ bool Refine3DApp::DoCalculation( ) {
             //				/ refine_particle_local.mask_volume / projection_image_local.ReturnVarianceOfRealValues()) * binning_factor_refine;
 
             if ( calculate_matching_projections ) {
+                cistem_timer::ProfileScope profile_scope("MatchingProjection");
                 refine_particle_local.SetAlignmentParameters(output_parameters.phi, output_parameters.theta, output_parameters.psi, 0.0, 0.0);
                 current_projection++;
                 refine_particle_local.CalculateProjection(projection_image_local, input_3d_local);
@@ -1680,7 +1865,7 @@ bool Refine3DApp::DoCalculation( ) {
     output_star_file.WriteTocisTEMStarFile(output_star_filename, -1, -1, first_particle, last_particle);
     output_shifts_file.WriteTocisTEMStarFile(output_shift_filename, -1, -1, first_particle, last_particle);
     //	delete global_euler_search;
-    if ( global_search ) {
+    if ( global_search && ! projection_cache_is_cached ) {
         delete[] projection_cache;
         //		search_projection_image.RotateFourier2DDeleteIndex(kernel_index, psi_max, psi_step);
     }
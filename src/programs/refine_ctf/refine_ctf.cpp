@@ -392,6 +392,7 @@ bool RefineCTFApp::DoCalculation( ) {
     //	currently_open_3d_filename = all_reference_3d_filenames[0];
 
     MRCFile input_stack(input_particle_images.ToStdString( ), false);
+    input_stack.MapFileIntoMemory( ); // particles are only read, share the page cache with the other jobs on this node
 
     if ( last_particle == 0 )
         last_particle = input_stack.ReturnZSize( );
@@ -545,10 +546,12 @@ bool RefineCTFApp::DoCalculation( ) {
     sum_power.Allocate(input_stack.ReturnXSize( ), input_stack.ReturnYSize( ), false);
     //	refine_particle.Allocate(binned_image_box_size, binned_image_box_size);
 
-    // Read whole parameter file to work out average values and variances
+    // Average values and variances over the whole parameter file, as stored in the file when it was written for this refinement
 
-    parameter_average  = input_star_file.ReturnParameterAverages( );
-    parameter_variance = input_star_file.ReturnParameterVariances( );
+    cisTEMParameterStatistics parameter_statistics = input_star_file.ReturnStoredOrCalculatedParameterStatistics( );
+
+    parameter_average  = parameter_statistics.averages;
+    parameter_variance = parameter_statistics.variances;
 
     if ( parameter_variance.phi < 0.001 )
         refine_particle.constraints_used.phi = false;
@@ -728,9 +731,7 @@ bool RefineCTFApp::DoCalculation( ) {
                     continue;
                 }
 
-// ReadSlice requires omp critical to avoid parallel reads, which may lead to the wrong slice being read
-#pragma omp critical
-                input_image_local.ReadSlice(&input_stack, input_parameters.position_in_stack);
+                input_image_local.ReadSliceThreadSafe(&input_stack, input_parameters.position_in_stack);
 
                 image_counter++;
 
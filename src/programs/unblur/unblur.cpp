@@ -1,5 +1,19 @@
 #include "../../core/core_headers.h"
 
+// The frames are read on a thread of their own, while the other threads gain correct, transform and resample the frames that have
+// already been read, so that reading and processing overlap. Only a few frames are read ahead of the processing.
+//
+// With a number of patches set (expert options), the globally aligned frames are also cut into a grid of overlapping patches, which are
+// aligned concurrently on the frames already in memory. A smooth model of the local motion is fitted to the shifts of the patches
+// (see UnblurDeformationModel), and the frames are resampled accordingly before they are summed.
+//
+// Environment variables:
+//   CISTEM_UNBLUR_STREAMING          1 to keep only the binned frames used for the alignment in memory, and to read the movie a second
+//                                    time for the final sum. The alignment is then finished on the binned frames, rather than refined
+//                                    once more on the full size frames. Only makes a difference when the frames are binned for the
+//                                    alignment (output pixel size below 2.5 A).
+//   CISTEM_UNBLUR_MEMORY_BUDGET_MB   if set, streaming is also used for movies whose full size frames would need more memory than this.
+
 // The timing that unblur originally tracks is always on, by direct reference to cistem_timer::StopWatch
 // The profiling for development is under conrtol of --enable-profiling.
 #ifdef CISTEM_PROFILING
@@ -21,6 +35,8 @@ class
 
 void unblur_refine_alignment(Image* input_stack, int number_of_images, int max_iterations, float unitless_bfactor, bool mask_central_cross, int width_of_vertical_line, int width_of_horizontal_line, float inner_radius_for_peak_search, float outer_radius_for_peak_search, float max_shift_convergence_threshold, float pixel_size, int number_of_frames_for_running_average, int savitzy_golay_window_size, int max_threads, float* x_shifts, float* y_shifts, StopWatch& profile_timing_refinement_method);
 
+void unblur_align_patches(Image* input_stack, int number_of_images, int binning_factor, int& number_of_patches_x, int& number_of_patches_y, int max_iterations, float unitless_bfactor, bool mask_central_cross, int width_of_vertical_line, int width_of_horizontal_line, float outer_radius_for_peak_search, float max_shift_convergence_threshold, float pixel_size, int number_of_frames_for_running_average, int savitzy_golay_window_size, int max_threads, std::vector<float>& patch_x_coordinates, std::vector<float>& patch_y_coordinates, std::vector<std::vector<float>>& patch_x_shifts, std::vector<std::vector<float>>& patch_y_shifts);
+
 IMPLEMENT_APP(UnBlurApp)
 
 // override the DoInteractiveUserInput
@@ -61,6 +77,8 @@ void UnBlurApp::DoInteractiveUserInput( ) {
     int   max_threads;
     int   eer_frames_per_image = 0;
     int   eer_super_res_factor = 1;
+    int   number_of_patches_x;
+    int   number_of_patches_y;
 
     bool save_aligned_frames;
 
@@ -132,6 +150,14 @@ void UnBlurApp::DoInteractiveUserInput( ) {
             eer_frames_per_image = 0;
             eer_super_res_factor = 1;
         }
+
+        number_of_patches_x = my_input->GetIntFromUser("Number of patches in X (0 = global only)", "For local motion correction, the frames are divided into this many patches in X, which are aligned separately", "0", 0);
+        if ( number_of_patches_x > 0 ) {
+            number_of_patches_y = my_input->GetIntFromUser("Number of patches in Y", "For local motion correction, the frames are divided into this many patches in Y, which are aligned separately", "5", 1);
+        }
+        else {
+            number_of_patches_y = 0;
+        }
     }
     else {
         minimum_shift_in_angstroms           = original_pixel_size * output_binning_factor + 0.001;
@@ -153,6 +179,8 @@ void UnBlurApp::DoInteractiveUserInput( ) {
         aligned_frames_filename              = "";
         eer_frames_per_image                 = 0;
         eer_super_res_factor                 = 1;
+        number_of_patches_x                  = 0;
+        number_of_patches_y                  = 0;
     }
 
     correct_mag_distortion = my_input->GetYesNoFromUser("Correct Magnification Distortion?", "If yes, a magnification distortion can be corrected", "no");
@@ -183,7 +211,7 @@ void UnBlurApp::DoInteractiveUserInput( ) {
     bool        write_out_small_sum_image    = false;
     std::string small_sum_image_filename     = "/dev/null";
 
-    my_current_job.ManualSetArguments("ttfffbbfifbiifffbsbsfbfffbtbtiiiibttii", input_filename.c_str( ),
+    my_current_job.ManualSetArguments("ttfffbbfifbiifffbsbsfbfffbtbtiiiibttiiii", input_filename.c_str( ),
                                       output_filename.c_str( ),
                                       original_pixel_size,
                                       minimum_shift_in_angstroms,
@@ -220,7 +248,9 @@ void UnBlurApp::DoInteractiveUserInput( ) {
                                       aligned_frames_filename.c_str( ),
                                       output_shift_text_file.c_str( ),
                                       eer_frames_per_image,
-                                      eer_super_res_factor);
+                                      eer_super_res_factor,
+                                      number_of_patches_x,
+                                      number_of_patches_y);
 }
 
 // overide the do calculation method which will be what is actually run..
@@ -280,6 +310,8 @@ bool UnBlurApp::DoCalculation( ) {
     std::string output_shift_text_file               = my_current_job.arguments[35].ReturnStringArgument( );
     int         eer_frames_per_image                 = my_current_job.arguments[36].ReturnIntegerArgument( );
     int         eer_super_res_factor                 = my_current_job.arguments[37].ReturnIntegerArgument( );
+    int         number_of_patches_x                  = my_current_job.arguments[38].ReturnIntegerArgument( );
+    int         number_of_patches_y                  = my_current_job.arguments[39].ReturnIntegerArgument( );
 
     if ( is_running_locally == false )
         max_threads = number_of_threads_requested_on_command_line; // OVERRIDE FOR THE GUI, AS IT HAS TO BE SET ON THE COMMAND LINE...
@@ -310,6 +342,7 @@ bool UnBlurApp::DoCalculation( ) {
     else {
         wxPrintf("Input file looks OK, proceeding\n");
     }
+    input_file.SetNumberOfThreads(max_threads);
     //MRCFile output_file(output_filename, true); changed to quick and dirty write as the file is only used once, and this way it is not created until it is actually written, which is cleaner for cancelled / crashed jobs
 
     ImageFile gain_file;
@@ -375,6 +408,33 @@ bool UnBlurApp::DoCalculation( ) {
         output_pixel_size = ReturnMagDistortionCorrectedPixelSize(output_pixel_size, mag_distortion_major_scale, mag_distortion_minor_scale);
     }
 
+    // if we are binning - choose a binning factor..
+
+    pre_binning_factor = int(myround(5. / output_pixel_size));
+    if ( pre_binning_factor < 1 )
+        pre_binning_factor = 1;
+
+    //	wxPrintf("Prebinning factor = %i\n", pre_binning_factor);
+
+    // Only keep the binned frames, if asked to or if the full size frames would need more memory than allowed
+
+    bool     keep_only_binned_frames = false;
+    wxString environment_value;
+    long     memory_budget_in_megabytes;
+
+    if ( pre_binning_factor > 1 ) {
+        if ( wxGetEnv("CISTEM_UNBLUR_STREAMING", &environment_value) && environment_value == "1" ) {
+            keep_only_binned_frames = true;
+        }
+        else if ( wxGetEnv("CISTEM_UNBLUR_MEMORY_BUDGET_MB", &environment_value) && environment_value.ToLong(&memory_budget_in_megabytes) ) {
+            double megabytes_for_frames = double(number_of_input_images) * double(output_x_size + 2) * double(output_y_size) * sizeof(float) * (1.0 + 1.0 / double(pre_binning_factor * pre_binning_factor)) / 1048576.0;
+            keep_only_binned_frames     = megabytes_for_frames > double(memory_budget_in_megabytes);
+        }
+    }
+
+    if ( keep_only_binned_frames == true )
+        wxPrintf("Keeping only the frames binned by %i in memory, the movie is read again for the sum\n", pre_binning_factor);
+
     // Arrays to hold the shifts..
 
     float* x_shifts = new float[number_of_input_images];
@@ -385,12 +445,6 @@ bool UnBlurApp::DoCalculation( ) {
     float* dose_filter;
     float* dose_filter_sum_of_squares;
 
-    int first_frame_to_preprocess;
-    int last_frame_to_preprocess;
-    int number_of_preprocess_blocks;
-    int preprocess_block_counter;
-    int total_processed;
-
     profile_timing.start("allocate electron dose");
     // Electron dose object for if dose filtering..
 
@@ -420,106 +474,93 @@ bool UnBlurApp::DoCalculation( ) {
 
     // Read in, gain-correct, FFT and resample all the images..
 
-    unblur_timing.start("read frames");
-    // big loop over number of threads, so that far large number of frames you might save some memory..
-
-    // read in frames, non threaded..
-
-    number_of_preprocess_blocks = int(ceilf(float(number_of_input_images) / float(max_threads)));
-
-    first_frame_to_preprocess = 1;
-    last_frame_to_preprocess  = max_threads;
-    total_processed           = 0;
-
-    for ( preprocess_block_counter = 0; preprocess_block_counter < number_of_preprocess_blocks; preprocess_block_counter++ ) {
-        profile_timing.start("read in frames");
-        for ( image_counter = first_frame_to_preprocess; image_counter <= last_frame_to_preprocess; image_counter++ ) {
-            // Read from disk
-            image_stack[image_counter - 1].ReadSlice(&input_file, image_counter);
+    auto preprocess_frame = [&](Image& frame, long frame_number) {
+        // Dark correction
+        if ( ! movie_is_dark_corrected ) {
+            profile_timing.start("dark correct");
+            if ( ! frame.HasSameDimensionsAs(&dark_image) ) {
+                SendError(wxString::Format("Error: location %li of input file (%s) does not have same dimensions as the dark image (%s)", frame_number, input_filename, dark_filename));
+                wxSleep(10);
+                exit(-1);
+            }
+            //if (image_counter == 0) SendInfo(wxString::Format("Info: multiplying %s by gain %s\n",input_filename,gain_filename.ToStdString()));
+            frame.SubtractImage(&dark_image);
+            profile_timing.lap("dark correct");
         }
-        profile_timing.lap("read in frames");
 
-#pragma omp parallel for default(shared) num_threads(max_threads) private(image_counter)
-        for ( image_counter = first_frame_to_preprocess; image_counter <= last_frame_to_preprocess; image_counter++ ) {
-            // Dark correction
-            if ( ! movie_is_dark_corrected ) {
-                profile_timing.start("dark correct");
-                if ( ! image_stack[image_counter - 1].HasSameDimensionsAs(&dark_image) ) {
-                    SendError(wxString::Format("Error: location %li of input file (%s) does not have same dimensions as the dark image (%s)", image_counter, input_filename, dark_filename));
-                    wxSleep(10);
-                    exit(-1);
-                }
-                //if (image_counter == 0) SendInfo(wxString::Format("Info: multiplying %s by gain %s\n",input_filename,gain_filename.ToStdString()));
-                image_stack[image_counter - 1].SubtractImage(&dark_image);
-                profile_timing.lap("dark correct");
+        // Gain correction
+        if ( ! movie_is_gain_corrected ) {
+            profile_timing.start("gain correct");
+            if ( ! frame.HasSameDimensionsAs(&gain_image) ) {
+                SendError(wxString::Format("Error: location %li of input file (%s) does not have same dimensions as the gain image (%s)", frame_number, input_filename, gain_filename));
+                wxSleep(10);
+                exit(-1);
             }
+            //if (image_counter == 0) SendInfo(wxString::Format("Info: multiplying %s by gain %s\n",input_filename,gain_filename.ToStdString()));
+            frame.MultiplyPixelWise(gain_image);
+            profile_timing.lap("gain correct");
+        }
 
-            // Gain correction
-            if ( ! movie_is_gain_corrected ) {
-                profile_timing.start("gain correct");
-                if ( ! image_stack[image_counter - 1].HasSameDimensionsAs(&gain_image) ) {
-                    SendError(wxString::Format("Error: location %li of input file (%s) does not have same dimensions as the gain image (%s)", image_counter, input_filename, gain_filename));
-                    wxSleep(10);
-                    exit(-1);
-                }
-                //if (image_counter == 0) SendInfo(wxString::Format("Info: multiplying %s by gain %s\n",input_filename,gain_filename.ToStdString()));
-                image_stack[image_counter - 1].MultiplyPixelWise(gain_image);
-                profile_timing.lap("gain correct");
-            }
+        profile_timing.start("replace outliers");
+        frame.ReplaceOutliersWithMean(12);
+        profile_timing.lap("replace outliers");
 
-            profile_timing.start("replace outliers");
-            image_stack[image_counter - 1].ReplaceOutliersWithMean(12);
-            profile_timing.lap("replace outliers");
+        if ( correct_mag_distortion == true ) {
+            profile_timing.start("correct mag distortion");
+            frame.CorrectMagnificationDistortion(mag_distortion_angle, mag_distortion_major_scale, mag_distortion_minor_scale);
+            profile_timing.lap("correct mag distortion");
+        }
 
-            if ( correct_mag_distortion == true ) {
-                profile_timing.start("correct mag distortion");
-                image_stack[image_counter - 1].CorrectMagnificationDistortion(mag_distortion_angle, mag_distortion_major_scale, mag_distortion_minor_scale);
-                profile_timing.lap("correct mag distortion");
-            }
+        // FT
+        profile_timing.start("forward FFT");
+        frame.ForwardFFT(true);
+        frame.ZeroCentralPixel( );
+        profile_timing.lap("forward FFT");
+
+        // Resize the FT (binning)
+        if ( output_binning_factor > 1.0001 ) {
+            profile_timing.start("resize");
+            frame.Resize(myroundint(frame.logical_x_dimension / output_binning_factor), myroundint(frame.logical_y_dimension / output_binning_factor), 1);
+            profile_timing.lap("resize");
+        }
+    };
 
-            // FT
-            profile_timing.start("forward FFT");
-            image_stack[image_counter - 1].ForwardFFT(true);
-            image_stack[image_counter - 1].ZeroCentralPixel( );
-            profile_timing.lap("forward FFT");
-
-            // Resize the FT (binning)
-            if ( output_binning_factor > 1.0001 ) {
-                profile_timing.start("resize");
-                image_stack[image_counter - 1].Resize(myroundint(image_stack[image_counter - 1].logical_x_dimension / output_binning_factor), myroundint(image_stack[image_counter - 1].logical_y_dimension / output_binning_factor), 1);
-                profile_timing.lap("resize");
-            }
+    unblur_timing.start("read frames");
 
-            // Init shifts
-            x_shifts[image_counter - 1] = 0.0;
-            y_shifts[image_counter - 1] = 0.0;
-        } // end omp block
+    // the frames are read on one thread, while the others process them..
 
-        first_frame_to_preprocess += max_threads;
-        last_frame_to_preprocess += max_threads;
+    StreamFramesFromFile(input_file, 1, number_of_input_images, max_threads, [&](Image& frame, long frame_number) {
+        preprocess_frame(frame, frame_number);
+
+        if ( keep_only_binned_frames == true ) {
+            image_stack[frame_number - 1].Allocate(frame.logical_x_dimension / pre_binning_factor, frame.logical_y_dimension / pre_binning_factor, 1, false);
+            frame.ClipInto(&image_stack[frame_number - 1]);
+        }
+        else {
+            image_stack[frame_number - 1].Consume(&frame);
+        }
+    });
 
-        if ( first_frame_to_preprocess > number_of_input_images )
-            first_frame_to_preprocess = number_of_input_images;
-        if ( last_frame_to_preprocess > number_of_input_images )
-            last_frame_to_preprocess = number_of_input_images;
+    // Init shifts
+    for ( image_counter = 0; image_counter < number_of_input_images; image_counter++ ) {
+        x_shifts[image_counter] = 0.0;
+        y_shifts[image_counter] = 0.0;
     }
-    input_file.CloseFile( );
 
-    unblur_timing.lap("read frames");
-    // if we are binning - choose a binning factor..
+    // when only the binned frames are kept, the movie is read again for the sum
+    if ( keep_only_binned_frames == false )
+        input_file.CloseFile( );
 
-    pre_binning_factor = int(myround(5. / output_pixel_size));
-    if ( pre_binning_factor < 1 )
-        pre_binning_factor = 1;
-
-    //	wxPrintf("Prebinning factor = %i\n", pre_binning_factor);
+    unblur_timing.lap("read frames");
 
-    // if we are going to be binning, we need to allocate the unbinned array..
+    // if we are going to be binning, we need to allocate the unbinned array (unless the frames are already binned)..
 
     if ( pre_binning_factor > 1 ) {
-        unbinned_image_stack = image_stack;
-        image_stack          = new Image[number_of_input_images];
-        pixel_size           = output_pixel_size * pre_binning_factor;
+        if ( keep_only_binned_frames == false ) {
+            unbinned_image_stack = image_stack;
+            image_stack          = new Image[number_of_input_images];
+        }
+        pixel_size = output_pixel_size * pre_binning_factor;
     }
     else {
         pixel_size = output_pixel_size;
@@ -539,14 +580,16 @@ bool UnBlurApp::DoCalculation( ) {
         min_shift_in_pixels = 1.01; // we always want to ignore the central peak initially.
 
     if ( pre_binning_factor > 1 ) {
-        profile_timing.start("make prebinned stack");
+        if ( keep_only_binned_frames == false ) {
+            profile_timing.start("make prebinned stack");
 #pragma omp parallel for default(shared) num_threads(max_threads) private(image_counter)
-        for ( image_counter = 0; image_counter < number_of_input_images; image_counter++ ) {
-            image_stack[image_counter].Allocate(unbinned_image_stack[image_counter].logical_x_dimension / pre_binning_factor, unbinned_image_stack[image_counter].logical_y_dimension / pre_binning_factor, 1, false);
-            unbinned_image_stack[image_counter].ClipInto(&image_stack[image_counter]);
-            //image_stack[image_counter].QuickAndDirtyWriteSlice("binned.mrc", image_counter + 1);
+            for ( image_counter = 0; image_counter < number_of_input_images; image_counter++ ) {
+                image_stack[image_counter].Allocate(unbinned_image_stack[image_counter].logical_x_dimension / pre_binning_factor, unbinned_image_stack[image_counter].logical_y_dimension / pre_binning_factor, 1, false);
+                unbinned_image_stack[image_counter].ClipInto(&image_stack[image_counter]);
+                //image_stack[image_counter].QuickAndDirtyWriteSlice("binned.mrc", image_counter + 1);
+            }
+            profile_timing.lap("make prebinned stack");
         }
-        profile_timing.lap("make prebinned stack");
         // for the binned images, we don't want to insist on a super low termination factor.
 
         if ( termination_threshold_in_pixels < 1 && pre_binning_factor > 1 )
@@ -571,7 +614,17 @@ bool UnBlurApp::DoCalculation( ) {
 
     // if we have been using pre-binning, we need to do a refinment on the unbinned data..
     unblur_timing.start("final refine");
-    if ( pre_binning_factor > 1 ) {
+    if ( keep_only_binned_frames == true ) {
+        // there are no unbinned images to refine against, the shifts of the binned images are final..
+
+        for ( image_counter = 0; image_counter < number_of_input_images; image_counter++ ) {
+            x_shifts[image_counter] *= pre_binning_factor;
+            y_shifts[image_counter] *= pre_binning_factor;
+        }
+
+        pixel_size = output_pixel_size;
+    }
+    else if ( pre_binning_factor > 1 ) {
         // we don't need the binned images anymore..
 
         delete[] image_stack;
@@ -580,13 +633,12 @@ bool UnBlurApp::DoCalculation( ) {
 
         // Adjust the shifts, then phase shift the original images
         profile_timing.start("apply shifts 1");
-#pragma omp parallel for default(shared) num_threads(max_threads) private(image_counter)
         for ( image_counter = 0; image_counter < number_of_input_images; image_counter++ ) {
             x_shifts[image_counter] *= pre_binning_factor;
             y_shifts[image_counter] *= pre_binning_factor;
-
-            image_stack[image_counter].PhaseShift(x_shifts[image_counter], y_shifts[image_counter], 0.0);
         }
+
+        Image::PhaseShiftStack(image_stack, number_of_input_images, x_shifts, y_shifts, max_threads);
         profile_timing.lap("apply shifts 1");
 
         // convert parameters to pixels with new pixel size..
@@ -608,12 +660,119 @@ bool UnBlurApp::DoCalculation( ) {
     }
     unblur_timing.lap("final refine");
 
+    // if wanted, align a grid of patches of the globally aligned frames, and fit a smooth local motion to their shifts..
+
+    UnblurDeformationModel local_motion_model;
+
+    if ( number_of_patches_x > 0 && number_of_patches_y > 0 ) {
+        unblur_timing.start("patch refine");
+        profile_timing.start("patch refine");
+
+        // the patches are aligned at the binned pixel size, as the global alignment was
+        float patch_pixel_size                      = output_pixel_size * pre_binning_factor;
+        float patch_max_shift_in_pixels             = maximum_shift_in_angstroms / patch_pixel_size;
+        float patch_termination_threshold_in_pixels = termination_threshold_in_angstoms / patch_pixel_size;
+        float patch_unitless_bfactor                = bfactor_in_angstoms / powf(patch_pixel_size, 2);
+        int   patch_binning_factor                  = (keep_only_binned_frames == true) ? 1 : pre_binning_factor;
+
+        std::vector<float>              patch_x_coordinates;
+        std::vector<float>              patch_y_coordinates;
+        std::vector<std::vector<float>> patch_x_shifts;
+        std::vector<std::vector<float>> patch_y_shifts;
+
+        unblur_align_patches(image_stack, number_of_input_images, patch_binning_factor, number_of_patches_x, number_of_patches_y, max_iterations, patch_unitless_bfactor, should_mask_central_cross, vertical_mask_size, horizontal_mask_size, patch_max_shift_in_pixels, patch_termination_threshold_in_pixels, patch_pixel_size, number_of_frames_for_running_average, myroundint(5.0f / exposure_per_frame), max_threads, patch_x_coordinates, patch_y_coordinates, patch_x_shifts, patch_y_shifts);
+
+        // the model is fitted in the pixels of the output frames
+        for ( int patch_counter = 0; patch_counter < int(patch_x_shifts.size( )); patch_counter++ ) {
+            for ( image_counter = 0; image_counter < number_of_input_images; image_counter++ ) {
+                patch_x_shifts[patch_counter][image_counter] *= pre_binning_factor;
+                patch_y_shifts[patch_counter][image_counter] *= pre_binning_factor;
+            }
+        }
+
+        if ( local_motion_model.FitToPatchShifts(patch_x_coordinates, patch_y_coordinates, patch_x_shifts, patch_y_shifts) == true ) {
+            wxPrintf("Fitted local motion to %i x %i patches, rms deviation = %f A\n", number_of_patches_x, number_of_patches_y, local_motion_model.ReturnRMSDeviation( ) * output_pixel_size);
+        }
+        else {
+            SendInfo(wxString::Format("(%s) Too few patches or frames to fit the local motion, only the global alignment is applied\n", input_filename));
+        }
+
+        unblur_timing.lap("patch refine");
+        profile_timing.lap("patch refine");
+    }
+
     // we should be finished with alignment, now we just need to make the final sum..
 
-    sum_image.Allocate(image_stack[0].logical_x_dimension, image_stack[0].logical_y_dimension, false);
+    if ( keep_only_binned_frames == true )
+        sum_image.Allocate(output_x_size, output_y_size, false);
+    else
+        sum_image.Allocate(image_stack[0].logical_x_dimension, image_stack[0].logical_y_dimension, false);
     sum_image.SetToConstant(0.0);
 
-    if ( should_dose_filter == true ) {
+    // the frames in memory are corrected for the local motion here, those that are read again as they are read
+
+    if ( local_motion_model.IsFitted( ) == true && keep_only_binned_frames == false ) {
+        profile_timing.start("apply local shifts");
+#pragma omp parallel for default(shared) num_threads(max_threads) private(image_counter)
+        for ( image_counter = first_frame - 1; image_counter < last_frame; image_counter++ ) {
+            local_motion_model.ResampleFrame(image_stack[image_counter], image_counter);
+        }
+        profile_timing.lap("apply local shifts");
+    }
+
+    if ( keep_only_binned_frames == true ) {
+        // read the frames again, and shift, filter and add them as they come..
+        profile_timing.start("final sum");
+
+        if ( should_dose_filter == true ) {
+            dose_filter_sum_of_squares = new float[sum_image.real_memory_allocated / 2];
+            ZeroFloatArray(dose_filter_sum_of_squares, sum_image.real_memory_allocated / 2);
+        }
+
+        UnblurFrameOrder frame_order(first_frame);
+
+        StreamFramesFromFile(input_file, first_frame, last_frame, max_threads, [&](Image& frame, long frame_number) {
+            long               frame_index = frame_number - 1;
+            std::vector<float> frame_dose_filter;
+
+            preprocess_frame(frame, frame_number);
+            frame.PhaseShift(x_shifts[frame_index], y_shifts[frame_index]);
+
+            if ( local_motion_model.IsFitted( ) == true ) {
+                local_motion_model.ResampleFrame(frame, frame_index);
+            }
+
+            if ( should_dose_filter == true ) {
+                frame_dose_filter.resize(frame.real_memory_allocated / 2, 0.0f);
+                my_electron_dose->CalculateDoseFilterAs1DArray(&frame, frame_dose_filter.data( ), (frame_index * exposure_per_frame) + pre_exposure_amount, ((frame_index + 1) * exposure_per_frame) + pre_exposure_amount);
+
+                for ( long pixel = 0; pixel < frame.real_memory_allocated / 2; pixel++ ) {
+                    frame.complex_values[pixel] *= frame_dose_filter[pixel];
+                }
+            }
+
+            // the frames are added in order, as in the other branches
+            frame_order.WaitForTurnOf(frame_number);
+
+            sum_image.AddImage(&frame);
+
+            if ( should_dose_filter == true ) {
+                for ( long pixel = 0; pixel < frame.real_memory_allocated / 2; pixel++ ) {
+                    dose_filter_sum_of_squares[pixel] += powf(frame_dose_filter[pixel], 2);
+                }
+            }
+
+            if ( save_aligned_frames == true ) {
+                frame.QuickAndDirtyWriteSlice(aligned_frames_filename, frame_number);
+            }
+
+            frame_order.FinishTurn( );
+        });
+
+        input_file.CloseFile( );
+        profile_timing.lap("final sum");
+    }
+    else if ( should_dose_filter == true ) {
         if ( write_out_amplitude_spectrum == true ) {
             profile_timing.start("amplitude spectrum");
             sum_image_no_dose_filter.Allocate(image_stack[0].logical_x_dimension, image_stack[0].logical_y_dimension, false);
@@ -1061,15 +1220,14 @@ void unblur_refine_alignment(Image* input_stack, int number_of_images, int max_i
                 max_shift = total_shift;
         }
 
-// actually shift the images, also add the subtracted shifts to the overall shifts
-#pragma omp parallel for default(shared) num_threads(max_threads) private(image_counter)
-        for ( image_counter = 0; image_counter < number_of_images; image_counter++ ) {
-            profile_timing_refinement_method.start("shift image");
-            input_stack[image_counter].PhaseShift(current_x_shifts[image_counter], current_y_shifts[image_counter], 0.0);
+        // actually shift the images, also add the subtracted shifts to the overall shifts
+        profile_timing_refinement_method.start("shift image");
+        Image::PhaseShiftStack(input_stack, number_of_images, current_x_shifts, current_y_shifts, max_threads);
+        profile_timing_refinement_method.lap("shift image");
 
+        for ( image_counter = 0; image_counter < number_of_images; image_counter++ ) {
             x_shifts[image_counter] += current_x_shifts[image_counter];
             y_shifts[image_counter] += current_y_shifts[image_counter];
-            profile_timing_refinement_method.lap("shift image");
         }
 
         // check to see if the convergence criteria have been reached and return if so
@@ -1102,3 +1260,90 @@ void unblur_refine_alignment(Image* input_stack, int number_of_images, int max_i
     }
     profile_timing_refinement_method.mark_entry_or_exit_point( );
 }
+
+// Aligns a grid of overlapping patches of the (globally aligned, Fourier space) input stack, binned by binning_factor, with unblur_refine_alignment.
+// The patches are aligned concurrently, one per thread, so only max_threads patch stacks are held in addition to the binned frames. The
+// number of patches is reduced if the patches would otherwise be smaller than 64 pixels. The coordinates of the patch centres are returned
+// as fractions of the frame, and the shifts in binned pixels, relative to the middle frame.
+void unblur_align_patches(Image* input_stack, int number_of_images, int binning_factor, int& number_of_patches_x, int& number_of_patches_y, int max_iterations, float unitless_bfactor, bool mask_central_cross, int width_of_vertical_line, int width_of_horizontal_line, float outer_radius_for_peak_search, float max_shift_convergence_threshold, float pixel_size, int number_of_frames_for_running_average, int savitzy_golay_window_size, int max_threads, std::vector<float>& patch_x_coordinates, std::vector<float>& patch_y_coordinates, std::vector<std::vector<float>>& patch_x_shifts, std::vector<std::vector<float>>& patch_y_shifts) {
+    const int minimum_patch_size = 64;
+
+    long image_counter;
+    int  patch_counter;
+
+    int binned_x_size = input_stack[0].logical_x_dimension / binning_factor;
+    int binned_y_size = input_stack[0].logical_y_dimension / binning_factor;
+
+    // neighbouring patches overlap by half
+    auto return_patch_size = [](int binned_size, int number_of_patches) {
+        int patch_size = std::min(binned_size, myroundint(2.0f * float(binned_size) / float(number_of_patches + 1)));
+        if ( IsOdd(patch_size) == true )
+            patch_size--;
+        return patch_size;
+    };
+
+    while ( number_of_patches_x > 1 && return_patch_size(binned_x_size, number_of_patches_x) < minimum_patch_size ) {
+        number_of_patches_x--;
+    }
+    while ( number_of_patches_y > 1 && return_patch_size(binned_y_size, number_of_patches_y) < minimum_patch_size ) {
+        number_of_patches_y--;
+    }
+
+    int patch_x_size      = return_patch_size(binned_x_size, number_of_patches_x);
+    int patch_y_size      = return_patch_size(binned_y_size, number_of_patches_y);
+    int number_of_patches = number_of_patches_x * number_of_patches_y;
+
+    // the patches are cut from the binned frames in real space..
+
+    Image* binned_stack = new Image[number_of_images];
+
+#pragma omp parallel for default(shared) num_threads(max_threads) private(image_counter)
+    for ( image_counter = 0; image_counter < number_of_images; image_counter++ ) {
+        binned_stack[image_counter].Allocate(binned_x_size, binned_y_size, 1, false);
+        input_stack[image_counter].ClipInto(&binned_stack[image_counter]);
+        binned_stack[image_counter].BackwardFFT( );
+    }
+
+    // the offsets of the patch centres from the centre of the frame
+
+    std::vector<int> patch_x_offsets(number_of_patches);
+    std::vector<int> patch_y_offsets(number_of_patches);
+
+    patch_x_coordinates.resize(number_of_patches);
+    patch_y_coordinates.resize(number_of_patches);
+    patch_x_shifts.assign(number_of_patches, std::vector<float>(number_of_images, 0.0f));
+    patch_y_shifts.assign(number_of_patches, std::vector<float>(number_of_images, 0.0f));
+
+    for ( patch_counter = 0; patch_counter < number_of_patches; patch_counter++ ) {
+        int patch_x_index = patch_counter % number_of_patches_x;
+        int patch_y_index = patch_counter / number_of_patches_x;
+
+        patch_x_offsets[patch_counter] = (number_of_patches_x > 1) ? myroundint(float(binned_x_size - patch_x_size) * (float(patch_x_index) / float(number_of_patches_x - 1) - 0.5f)) : 0;
+        patch_y_offsets[patch_counter] = (number_of_patches_y > 1) ? myroundint(float(binned_y_size - patch_y_size) * (float(patch_y_index) / float(number_of_patches_y - 1) - 0.5f)) : 0;
+
+        patch_x_coordinates[patch_counter] = float(patch_x_offsets[patch_counter]) / float(binned_x_size);
+        patch_y_coordinates[patch_counter] = float(patch_y_offsets[patch_counter]) / float(binned_y_size);
+    }
+
+    // ..and aligned one per thread
+
+#pragma omp parallel for schedule(dynamic) default(shared) num_threads(max_threads) private(patch_counter, image_counter)
+    for ( patch_counter = 0; patch_counter < number_of_patches; patch_counter++ ) {
+        Image*    patch_stack = new Image[number_of_images];
+        StopWatch patch_timing;
+
+        for ( image_counter = 0; image_counter < number_of_images; image_counter++ ) {
+            patch_stack[image_counter].Allocate(patch_x_size, patch_y_size, 1, true);
+            binned_stack[image_counter].ClipInto(&patch_stack[image_counter], 0.0f, false, 1.0f, patch_x_offsets[patch_counter], patch_y_offsets[patch_counter], 0);
+            patch_stack[image_counter].TaperEdges( );
+            patch_stack[image_counter].ForwardFFT(true);
+            patch_stack[image_counter].ZeroCentralPixel( );
+        }
+
+        unblur_refine_alignment(patch_stack, number_of_images, max_iterations, unitless_bfactor, mask_central_cross, width_of_vertical_line, width_of_horizontal_line, 0.0f, std::min(outer_radius_for_peak_search, float(std::min(patch_x_size, patch_y_size)) / 4.0f), max_shift_convergence_threshold, pixel_size, number_of_frames_for_running_average, savitzy_golay_window_size, 1, patch_x_shifts[patch_counter].data( ), patch_y_shifts[patch_counter].data( ), patch_timing);
+
+        delete[] patch_stack;
+    }
+
+    delete[] binned_stack;
+}